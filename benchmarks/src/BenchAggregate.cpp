@@ -0,0 +1,53 @@
+#include "Benchmark.h"
+#include "catch.hpp"
+#include "SQLiteXX.h"
+
+#include <string>
+
+class SumAggregate {
+    public:
+    SumAggregate() :
+        m_sum(0)
+    {}
+
+    void step(int64_t val) {
+        m_sum += val;
+    }
+
+    int64_t finalize() {
+        return m_sum;
+    }
+
+    private:
+    int64_t m_sum;
+};
+
+static void run(const std::string& name, const sqlite::dbconnection& connection, const std::string& aggregate, const int64_t rows)
+{
+    sqlite::statement query(connection, "SELECT grp, " + aggregate + "(num) FROM groups GROUP BY grp");
+
+    const double seconds = benchmark::measure([&]() {
+        while (query.step()) {
+        }
+    });
+    benchmark::report(name, static_cast<double>(rows), seconds);
+}
+
+TEST_CASE("GROUP BY over high cardinality keys", "[Benchmark][Aggregate]") {
+    const int64_t rows = benchmark::row_count(2000000);
+    sqlite::dbconnection connection = sqlite::dbconnection::memory();
+
+    sqlite::execute(connection, "CREATE TABLE groups (grp INT, num INT)");
+    // About four rows per group so nearly every step starts a new group.
+    sqlite::execute(
+        connection,
+        "WITH RECURSIVE series(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM series WHERE x < ?) "
+        "INSERT INTO groups SELECT abs(random()) % (? / 4 + 1), x FROM series",
+        static_cast<int>(rows),
+        static_cast<int>(rows));
+
+    connection.create_aggregate<SumAggregate>("cpp_sum", true);
+
+    run("GROUP BY built-in sum", connection, "sum", rows);
+    run("GROUP BY create_aggregate sum", connection, "cpp_sum", rows);
+}
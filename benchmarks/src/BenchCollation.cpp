@@ -0,0 +1,65 @@
+#include "Benchmark.h"
+#include "catch.hpp"
+#include "SQLiteXX.h"
+
+#include <algorithm>
+#include <cctype>
+#include <string>
+#include <string_view>
+
+static void run(const std::string& name, const sqlite::dbconnection& connection, const std::string& collation, const int64_t rows)
+{
+    sqlite::statement query(connection, "SELECT string FROM words ORDER BY string COLLATE " + collation);
+
+    const double seconds = benchmark::measure([&]() {
+        while (query.step()) {
+        }
+    });
+    benchmark::report(name, static_cast<double>(rows), seconds);
+}
+
+static int fold_compare(std::string_view lhs, std::string_view rhs)
+{
+    const std::size_t length = std::min(lhs.size(), rhs.size());
+    for (std::size_t i = 0; i < length; ++i) {
+        const int l = tolower(static_cast<unsigned char>(lhs[i]));
+        const int r = tolower(static_cast<unsigned char>(rhs[i]));
+        if (l != r) {
+            return l < r ? -1 : 1;
+        }
+    }
+    return lhs.size() == rhs.size() ? 0 : (lhs.size() < rhs.size() ? -1 : 1);
+}
+
+TEST_CASE("ORDER BY with collations", "[Benchmark][Collation]") {
+    const int64_t rows = benchmark::row_count(10000000);
+    sqlite::dbconnection connection = sqlite::dbconnection::memory();
+
+    sqlite::execute(connection, "CREATE TABLE words (string TEXT)");
+    sqlite::execute(
+        connection,
+        "WITH RECURSIVE series(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM series WHERE x < ?) "
+        "INSERT INTO words SELECT (CASE WHEN x % 2 THEN 'Word' ELSE 'word' END) || hex(randomblob(6)) FROM series",
+        static_cast<int>(rows));
+
+    connection.create_collation("view_fold", fold_compare);
+    connection.create_collation(
+        "string_fold",
+        [](const std::string& lhs, const std::string& rhs) -> int { return fold_compare(lhs, rhs); });
+    const auto fold_key = [](std::string_view text) -> std::string {
+        std::string key(text);
+        for (char& c : key) {
+            c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+        }
+        return key;
+    };
+    connection.create_sortkey_collation("sortkey_fold", fold_key);
+    connection.create_sortkey_collation("sortkey_fold_all", fold_key, static_cast<std::size_t>(rows));
+
+    run("ORDER BY BINARY", connection, "BINARY", rows);
+    run("ORDER BY NOCASE", connection, "NOCASE", rows);
+    run("ORDER BY string_view collation", connection, "view_fold", rows);
+    run("ORDER BY std::string collation (adapted)", connection, "string_fold", rows);
+    run("ORDER BY sort key collation", connection, "sortkey_fold", rows);
+    run("ORDER BY sort key collation (all keys cached)", connection, "sortkey_fold_all", rows);
+}
@@ -0,0 +1,102 @@
+#include "Benchmark.h"
+#include "catch.hpp"
+#include "SQLiteXX.h"
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Rows look like application logs, text with a lot of repetition between and within pages.
+static const int kCacheSizeKiB = 2048;
+
+static double create_database(const std::string& filename, const std::string& vfs, const int64_t rows)
+{
+    remove(filename.c_str());
+    remove((filename + "-pagemap").c_str());
+    sqlite::dbconnection connection(filename, sqlite::openmode::read_write | sqlite::openmode::create, std::chrono::seconds(5), vfs);
+    sqlite::execute(connection, "CREATE TABLE test (id INTEGER PRIMARY KEY, message TEXT)");
+
+    return benchmark::measure([&]() {
+        sqlite::immediate_transaction transaction(connection);
+        sqlite::statement insert(connection, "INSERT INTO test VALUES (?, printf('{\"level\":\"%s\",\"service\":\"orders-%d\",\"message\":\"request %d "
+                                             "finished with status %d after %d ms\",\"user\":%d}', "
+                                             "CASE ?1 % 10 WHEN 0 THEN 'warning' ELSE 'info' END, ?1 % 8, ?1, 200 + (?1 % 3) * 100, ?1 % 997, ?1 % 5000))");
+        for (int i = 1; i <= rows; ++i) {
+            insert.reset();
+            insert.bind_all(i);
+            insert.execute();
+        }
+        transaction.commit();
+    });
+}
+
+static void report_size(const std::string& name, const std::string& filename)
+{
+    std::uintmax_t bytes = std::filesystem::file_size(filename);
+    if (std::filesystem::exists(filename + "-pagemap")) {
+        bytes += std::filesystem::file_size(filename + "-pagemap");
+    }
+    std::printf("%-48s %12.1f MiB\n", name.c_str(), static_cast<double>(bytes) / (1024.0 * 1024.0));
+}
+
+// Drops the files from the operating system page cache so the next scan reads from the disk.
+static void evict(const std::string& filename)
+{
+#ifdef __linux__
+    for (const std::string& name : {filename, filename + "-pagemap"}) {
+        const int descriptor = open(name.c_str(), O_RDONLY);
+        if (descriptor >= 0) {
+            fdatasync(descriptor);
+            posix_fadvise(descriptor, 0, 0, POSIX_FADV_DONTNEED);
+            close(descriptor);
+        }
+    }
+#else
+    (void)filename;
+#endif
+}
+
+static void full_scan(const std::string& name, const std::string& filename, const std::string& vfs, const int64_t rows, const bool cold)
+{
+    sqlite::dbconnection connection(filename, sqlite::openmode::read_only, std::chrono::seconds(5), vfs);
+    sqlite::execute(connection, "PRAGMA cache_size=-" + std::to_string(kCacheSizeKiB));
+    if (cold) {
+        evict(filename);
+    }
+
+    sqlite::statement query(connection, "SELECT count(*), sum(length(message)) FROM test");
+    long long count = 0;
+    const double seconds = benchmark::measure([&]() {
+        query.step();
+        count = query.get_int64(0);
+    });
+
+    REQUIRE(count == rows);
+    benchmark::report(name, static_cast<double>(rows), seconds);
+}
+
+TEST_CASE("Default VFS vs compressed VFS", "[Benchmark][CompressedVfs]") {
+    const std::string plain = "BenchPlainVfs.db";
+    const std::string compressed = "BenchCompressedVfs.db";
+    const int64_t rows = benchmark::row_count(1000000);
+
+    sqlite::compressed_vfs vfs("bench-compressed");
+    benchmark::report("insert rows (default VFS)", static_cast<double>(rows), create_database(plain, std::string(), rows));
+    benchmark::report("insert rows (compressed VFS)", static_cast<double>(rows), create_database(compressed, vfs.name(), rows));
+
+    report_size("size on disk (default VFS)", plain);
+    report_size("size on disk (compressed VFS)", compressed);
+
+    for (int run = 0; run < 2; ++run) {
+        full_scan("cold scan rows (default VFS)", plain, std::string(), rows, true);
+        full_scan("cold scan rows (compressed VFS)", compressed, vfs.name(), rows, true);
+    }
+    full_scan("warm scan rows (default VFS)", plain, std::string(), rows, false);
+    full_scan("warm scan rows (compressed VFS)", compressed, vfs.name(), rows, false);
+}
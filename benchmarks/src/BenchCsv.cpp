@@ -0,0 +1,80 @@
+#include "Benchmark.h"
+#include "catch.hpp"
+#include "SQLiteXX.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+static void create_csv(const std::string& path, const int64_t rows)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << "id,name,score,comment\n";
+    for (int64_t i = 1; i <= rows; ++i) {
+        file << i << ",name" << i << "," << (i % 1000) / 10.0 << ",\"comment, number " << i << "\"\n";
+    }
+}
+
+static int64_t count_rows(const sqlite::dbconnection& connection)
+{
+    sqlite::statement query(connection, "SELECT count(*) FROM target");
+    query.step();
+    return query.get_int64(0);
+}
+
+TEST_CASE("Loading a CSV file", "[Benchmark][Csv]") {
+    const int64_t rows = benchmark::row_count(1000000);
+    const std::string path = "BenchCsv.csv";
+    create_csv(path, rows);
+
+    {
+        sqlite::dbconnection connection = sqlite::dbconnection::memory();
+        sqlite::execute(connection, "CREATE TABLE target(id INTEGER, name TEXT, score REAL, comment TEXT)");
+
+        const double seconds = benchmark::measure([&]() {
+            sqlite::immediate_transaction transaction(connection);
+            sqlite::statement insert(connection, "INSERT INTO target VALUES (?, ?, ?, ?)");
+            std::ifstream file(path, std::ios::binary);
+            std::string line;
+            std::getline(file, line);
+            while (std::getline(file, line)) {
+                // The benchmark file has no newlines inside quotes, and only the last field is quoted.
+                const std::size_t first = line.find(',');
+                const std::size_t second = line.find(',', first + 1);
+                const std::size_t third = line.find(',', second + 1);
+                insert.reset();
+                insert.bind_all(
+                    std::stoi(line.substr(0, first)),
+                    line.substr(first + 1, second - first - 1),
+                    std::stod(line.substr(second + 1, third - second - 1)),
+                    line.substr(third + 2, line.size() - third - 3));
+                insert.execute();
+            }
+            transaction.commit();
+        });
+        REQUIRE(count_rows(connection) == rows);
+        benchmark::report("CSV getline and INSERT per row", static_cast<double>(rows), seconds);
+    }
+
+    for (const char* threads : {"1", "4"}) {
+        sqlite::dbconnection connection = sqlite::dbconnection::memory();
+        connection.create_csv_module();
+        sqlite::execute(connection, "CREATE TABLE target(id INTEGER, name TEXT, score REAL, comment TEXT)");
+
+        const double seconds = benchmark::measure([&]() {
+            sqlite::execute(connection, std::string("CREATE VIRTUAL TABLE temp.source USING csv('") + path + "', threads=" + threads + ")");
+            sqlite::execute(connection, "INSERT INTO target SELECT id, name, score, comment FROM source");
+        });
+        REQUIRE(count_rows(connection) == rows);
+        benchmark::report("CSV INSERT INTO SELECT FROM csv", static_cast<double>(rows), seconds);
+
+        sqlite::statement lookup(connection, "SELECT name FROM source WHERE rowid = ?", static_cast<int>(rows / 2));
+        const double indexing = benchmark::measure([&]() {
+            lookup.step();
+        });
+        REQUIRE(lookup.get_string(0) == "name" + std::to_string(rows / 2));
+        benchmark::report(std::string("CSV record index, threads=") + threads, static_cast<double>(rows), indexing);
+    }
+
+    remove(path.c_str());
+}
@@ -0,0 +1,91 @@
+#include "Benchmark.h"
+#include "catch.hpp"
+#include "SQLiteXX.h"
+
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+static const int kRows = 1000000;
+
+static void raw_multiply(sqlite3_context* context, int, sqlite3_value** values)
+{
+    sqlite3_result_int64(context, sqlite3_value_int64(values[0]) * sqlite3_value_int64(values[1]));
+}
+
+static void raw_length(sqlite3_context* context, int, sqlite3_value** values)
+{
+    sqlite3_value_text(values[0]);
+    sqlite3_result_int(context, sqlite3_value_bytes(values[0]));
+}
+
+static void run(const std::string& name, const sqlite::dbconnection& connection, const std::string& expression)
+{
+    sqlite::statement query(
+        connection,
+        "WITH RECURSIVE series(x, t) AS (SELECT 1, 'row' UNION ALL SELECT x + 1, t FROM series WHERE x < ?) "
+        "SELECT sum(" + expression + ") FROM series",
+        kRows);
+
+    const double seconds = benchmark::measure([&]() {
+        query.step();
+    });
+    benchmark::report(name, kRows, seconds);
+}
+
+TEST_CASE("Scalar function call overhead", "[Benchmark][Functions]") {
+    sqlite::dbconnection connection = sqlite::dbconnection::memory();
+
+    sqlite3_create_function_v2(connection.handle(), "raw_multiply", 2, SQLITE_UTF8 | SQLITE_DETERMINISTIC, nullptr, raw_multiply, nullptr, nullptr, nullptr);
+    sqlite3_create_function_v2(connection.handle(), "raw_length", 1, SQLITE_UTF8 | SQLITE_DETERMINISTIC, nullptr, raw_length, nullptr, nullptr, nullptr);
+
+    connection.create_function("multiply", [](int64_t x, int64_t y) -> int64_t { return x * y; }, true);
+    connection.create_general_function(
+        "general_multiply",
+        [](const std::vector<sqlite::value>& values) -> int64_t { return values[0].as_int64() * values[1].as_int64(); },
+        true);
+    connection.create_general_function(
+        "span_multiply",
+        [](sqlite::value_span values) -> int64_t { return values[0].as_int64() * values[1].as_int64(); },
+        true);
+    connection.create_function("view_length", [](std::string_view text) -> int { return static_cast<int>(text.size()); }, true);
+    connection.create_function("string_length", [](const std::string& text) -> int { return static_cast<int>(text.size()); }, true);
+
+    run("no function", connection, "x * x");
+    run("raw C multiply", connection, "raw_multiply(x, x)");
+    run("create_function multiply", connection, "multiply(x, x)");
+    run("create_general_function multiply (vector)", connection, "general_multiply(x, x)");
+    run("create_general_function multiply (span)", connection, "span_multiply(x, x)");
+    run("raw C length", connection, "raw_length(t)");
+    run("create_function length (string_view)", connection, "view_length(t)");
+    run("create_function length (std::string)", connection, "string_length(t)");
+}
+
+TEST_CASE("REGEXP with a cached pattern", "[Benchmark][Functions][Regexp]") {
+    const int64_t rows = benchmark::row_count(50000);
+    sqlite::dbconnection connection = sqlite::dbconnection::memory();
+
+    connection.create_regexp_function();
+    connection.create_function(
+        "regexp_uncached",
+        [](std::string_view pattern, std::string_view text) -> bool {
+            const std::regex compiled{std::string(pattern)};
+            return std::regex_search(text.begin(), text.end(), compiled);
+        },
+        true);
+
+    const std::string pattern = "'^row[0-9]*(1|3|5|7|9)$'";
+    for (const std::string function : {"regexp", "regexp_uncached"}) {
+        sqlite::statement query(
+            connection,
+            "WITH RECURSIVE series(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM series WHERE x < ?) "
+            "SELECT count(*) FROM series WHERE " + function + "(" + pattern + ", 'row' || x)",
+            static_cast<int>(rows));
+
+        const double seconds = benchmark::measure([&]() {
+            query.step();
+        });
+        benchmark::report(function, static_cast<double>(rows), seconds);
+    }
+}
@@ -0,0 +1,87 @@
+#include "Benchmark.h"
+#include "catch.hpp"
+#include "SQLiteXX.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// The database is far larger than the connection's page cache, so a full scan reads every page from the file.
+static const int kPayloadSize = 200;
+static const int kCacheSizeKiB = 2048;
+
+static void create_database(const std::string& filename, const int64_t rows)
+{
+    remove(filename.c_str());
+    sqlite::dbconnection connection(filename);
+    sqlite::execute(connection, "CREATE TABLE test (id INTEGER PRIMARY KEY, payload BLOB)");
+
+    sqlite::immediate_transaction transaction(connection);
+    sqlite::statement insert(connection, "INSERT INTO test VALUES (?, randomblob(?))");
+    for (int i = 1; i <= rows; ++i) {
+        insert.reset();
+        insert.bind_all(i, kPayloadSize);
+        insert.execute();
+    }
+    transaction.commit();
+}
+
+// Drops the file from the operating system page cache so the next scan reads from the disk.
+static void evict(const std::string& filename)
+{
+#ifdef __linux__
+    const int descriptor = open(filename.c_str(), O_RDONLY);
+    if (descriptor >= 0) {
+        fdatasync(descriptor);
+        posix_fadvise(descriptor, 0, 0, POSIX_FADV_DONTNEED);
+        close(descriptor);
+    }
+#else
+    (void)filename;
+#endif
+}
+
+static void full_scan(const std::string& name, const std::string& filename, const std::string& vfs, const int64_t rows, const bool cold)
+{
+    sqlite::dbconnection connection(filename, sqlite::openmode::read_only, std::chrono::seconds(5), vfs);
+    sqlite::execute(connection, "PRAGMA cache_size=-" + std::to_string(kCacheSizeKiB));
+    if (cold) {
+        evict(filename);
+    }
+
+    sqlite::statement query(connection, "SELECT sum(length(payload)) FROM test");
+    long long bytes = 0;
+    const double seconds = benchmark::measure([&]() {
+        query.step();
+        bytes = query.get_int64(0);
+    });
+
+    REQUIRE(bytes == rows * kPayloadSize);
+    benchmark::report(name, static_cast<double>(rows), seconds);
+}
+
+TEST_CASE("Default VFS vs Linux VFS", "[Benchmark][LinuxVfs]") {
+    const std::string filename = "BenchLinuxVfs.db";
+    const int64_t rows = benchmark::row_count(1000000);
+    create_database(filename, rows);
+
+    sqlite::linux_vfs readahead("bench-linux");
+    sqlite::linux_vfs_options options;
+    options.direct_io = true;
+    sqlite::linux_vfs direct("bench-linux-direct", options);
+
+    for (int run = 0; run < 2; ++run) {
+        full_scan("cold scan rows (default VFS)", filename, std::string(), rows, true);
+        full_scan("cold scan rows (readahead)", filename, readahead.name(), rows, true);
+        full_scan("cold scan rows (O_DIRECT)", filename, direct.name(), rows, true);
+    }
+
+    full_scan("warm scan rows (default VFS)", filename, std::string(), rows, false);
+    full_scan("warm scan rows (readahead)", filename, readahead.name(), rows, false);
+    full_scan("scan rows (O_DIRECT)", filename, direct.name(), rows, false);
+}
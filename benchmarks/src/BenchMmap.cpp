@@ -0,0 +1,103 @@
+#include "Benchmark.h"
+#include "catch.hpp"
+#include "SQLiteXX.h"
+
+#include <cstdio>
+#include <random>
+#include <string>
+
+// The database is made several times larger than the page cache of the
+// connections below so most page reads have to go to the file.
+static const int kRows = 200000;
+static const int kPayloadSize = 200;
+static const int kCacheSizeKiB = 2048;
+static const int kLookups = 200000;
+static const int kScans = 200;
+static const int kScanLength = 5000;
+
+static void create_database(const std::string& filename)
+{
+    remove(filename.c_str());
+    sqlite::dbconnection connection(filename);
+    sqlite::execute(connection, "CREATE TABLE test (id INTEGER PRIMARY KEY, payload BLOB)");
+
+    sqlite::immediate_transaction transaction(connection);
+    sqlite::statement insert(connection, "INSERT INTO test VALUES (?, randomblob(?))");
+    for (int i = 1; i <= kRows; ++i) {
+        insert.reset();
+        insert.bind_all(i, kPayloadSize);
+        insert.execute();
+    }
+    transaction.commit();
+}
+
+static sqlite::dbconnection open_database(const std::string& filename, const int64_t mmapSize)
+{
+    sqlite::dbconnection::memory_config config;
+    config.cache_size = -kCacheSizeKiB;
+    config.mmap_size = mmapSize;
+    return sqlite::dbconnection(filename, config, sqlite::openmode::read_only);
+}
+
+static void point_lookups(const std::string& name, const sqlite::dbconnection& connection)
+{
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<int> ids(1, kRows);
+
+    sqlite::statement query(connection, "SELECT length(payload) FROM test WHERE id = ?");
+    long long bytes = 0;
+    const double seconds = benchmark::measure([&]() {
+        for (int i = 0; i < kLookups; ++i) {
+            query.reset();
+            query.bind(1, ids(generator));
+            query.step();
+            bytes += query.get_int(0);
+        }
+    });
+
+    REQUIRE(bytes == static_cast<long long>(kLookups) * kPayloadSize);
+    benchmark::report(name, kLookups, seconds);
+}
+
+static void range_scans(const std::string& name, const sqlite::dbconnection& connection)
+{
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<int> starts(1, kRows - kScanLength);
+
+    sqlite::statement query(connection, "SELECT sum(length(payload)) FROM test WHERE id BETWEEN ? AND ?");
+    long long bytes = 0;
+    const double seconds = benchmark::measure([&]() {
+        for (int i = 0; i < kScans; ++i) {
+            const int start = starts(generator);
+            query.reset();
+            query.bind_all(start, start + kScanLength - 1);
+            query.step();
+            bytes += query.get_int64(0);
+        }
+    });
+
+    REQUIRE(bytes == static_cast<long long>(kScans) * kScanLength * kPayloadSize);
+    benchmark::report(name, static_cast<double>(kScans) * kScanLength, seconds);
+}
+
+TEST_CASE("pread vs mmap", "[Benchmark][mmap]") {
+    const std::string filename = "BenchMmap.db";
+    create_database(filename);
+
+    sqlite::dbconnection pread = open_database(filename, 0);
+    sqlite::dbconnection mmap = open_database(filename, sqlite::max_mmap_size());
+    REQUIRE(pread.mmap_size() == 0);
+    std::printf("mmap_size in effect: %lld bytes\n", static_cast<long long>(mmap.mmap_size()));
+
+    // Warm the operating system page cache so both variants read from memory.
+    range_scans("warm-up", pread);
+
+    point_lookups("point lookups (pread)", pread);
+    point_lookups("point lookups (mmap)", mmap);
+    range_scans("range scan rows (pread)", pread);
+    range_scans("range scan rows (mmap)", mmap);
+
+    sqlite::dbconnection::status_counters preadStatus = pread.status();
+    sqlite::dbconnection::status_counters mmapStatus = mmap.status();
+    std::printf("cache misses: pread %d, mmap %d\n", preadStatus.cache_miss, mmapStatus.cache_miss);
+}
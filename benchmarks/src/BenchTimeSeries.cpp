@@ -0,0 +1,79 @@
+#include "Benchmark.h"
+#include "catch.hpp"
+#include "SQLiteXX.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+static const int kBatch = 10000;
+
+TEST_CASE("Appending to a time series", "[Benchmark][TimeSeries]") {
+    const int64_t rows = benchmark::row_count(2000000);
+
+    {
+        remove("BenchTimeSeries.db");
+        sqlite::dbconnection connection("BenchTimeSeries.db");
+        sqlite::execute(connection, "CREATE TABLE metrics(time INTEGER, value REAL, count INTEGER)");
+        sqlite::execute(connection, "CREATE INDEX metrics_time ON metrics(time)");
+
+        const double seconds = benchmark::measure([&]() {
+            sqlite::immediate_transaction transaction(connection);
+            sqlite::statement insert(connection, "INSERT INTO metrics VALUES (?, ?, ?)");
+            for (int64_t i = 0; i < rows; ++i) {
+                insert.reset();
+                insert.bind_all(static_cast<int>(i), i * 0.5, static_cast<int>(i % 100));
+                insert.execute();
+            }
+            transaction.commit();
+        });
+        benchmark::report("Time series B-tree INSERT with time index", static_cast<double>(rows), seconds);
+
+        sqlite::statement range(connection, "SELECT sum(value) FROM metrics WHERE time BETWEEN ? AND ?", static_cast<int>(rows / 2), static_cast<int>(rows / 2 + 100000));
+        const double ranged = benchmark::measure([&]() {
+            range.step();
+        });
+        benchmark::report("Time series B-tree range of 100000 rows", 100001.0, ranged);
+    }
+    remove("BenchTimeSeries.db");
+
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "SQLiteXXBenchTimeSeries";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    {
+        std::shared_ptr<sqlite::timeseries_store> store = std::make_shared<sqlite::timeseries_store>(
+            directory.string(),
+            std::vector<sqlite::timeseries_column>{{"value", sqlite::datatype::floating}, {"count", sqlite::datatype::integer}});
+
+        std::vector<int64_t> times(kBatch);
+        std::vector<double> values(kBatch);
+        std::vector<int64_t> counts(kBatch);
+        const double seconds = benchmark::measure([&]() {
+            for (int64_t start = 0; start < rows; start += kBatch) {
+                const std::size_t count = static_cast<std::size_t>(std::min<int64_t>(kBatch, rows - start));
+                for (std::size_t j = 0; j < count; ++j) {
+                    const int64_t i = start + static_cast<int64_t>(j);
+                    times[j] = i;
+                    values[j] = i * 0.5;
+                    counts[j] = i % 100;
+                }
+                store->append(count, times.data(), {values.data(), counts.data()});
+            }
+            store->flush();
+        });
+        REQUIRE(store->row_count() == rows);
+        benchmark::report("Time series segment append", static_cast<double>(rows), seconds);
+
+        sqlite::dbconnection connection = sqlite::dbconnection::memory();
+        connection.create_timeseries_module("metrics", store);
+        sqlite::execute(connection, "CREATE VIRTUAL TABLE temp.metrics USING metrics");
+        sqlite::statement range(connection, "SELECT sum(value) FROM metrics WHERE time BETWEEN ? AND ?", static_cast<int>(rows / 2), static_cast<int>(rows / 2 + 100000));
+        const double ranged = benchmark::measure([&]() {
+            range.step();
+        });
+        benchmark::report("Time series segment range of 100000 rows", 100001.0, ranged);
+    }
+    std::filesystem::remove_all(directory);
+}
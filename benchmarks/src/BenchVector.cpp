@@ -0,0 +1,90 @@
+#include "Benchmark.h"
+#include "catch.hpp"
+#include "SQLiteXX.h"
+
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static const int kDimensions = 384;
+
+static const char* isa_name(const sqlite::vector_isa isa)
+{
+    switch (isa) {
+        case sqlite::vector_isa::avx512:
+            return "avx512";
+        case sqlite::vector_isa::avx2:
+            return "avx2";
+        case sqlite::vector_isa::sse2:
+            return "sse2";
+        default:
+            return "scalar";
+    }
+}
+
+static void run(const std::string& name, const sqlite::dbconnection& connection, const std::string& function, const sqlite::blob& probe, const int64_t rows)
+{
+    sqlite::statement query(connection, "SELECT max(" + function + "(embedding, ?)) FROM embeddings");
+    query.bind(1, probe);
+
+    const double seconds = benchmark::measure([&]() {
+        query.step();
+    });
+    benchmark::report(name, static_cast<double>(rows), seconds);
+}
+
+TEST_CASE("Vector distance throughput", "[Benchmark][VectorFunctions]") {
+    const int64_t rows = benchmark::row_count(20000);
+    sqlite::dbconnection connection = sqlite::dbconnection::memory();
+    connection.create_vector_functions();
+
+    // The same computation written the straightforward way, copying both blobs into sqlite::blob objects.
+    connection.create_function(
+        "copy_cosine",
+        [](const sqlite::blob& a, const sqlite::blob& b) -> double {
+            const size_t count = a.size() / sizeof(float);
+            std::vector<float> x(count);
+            std::vector<float> y(count);
+            std::memcpy(x.data(), a.data(), count * sizeof(float));
+            std::memcpy(y.data(), b.data(), count * sizeof(float));
+            double ab = 0.0, aa = 0.0, bb = 0.0;
+            for (size_t i = 0; i < count; ++i) {
+                ab += x[i] * y[i];
+                aa += x[i] * x[i];
+                bb += y[i] * y[i];
+            }
+            return ab / (std::sqrt(aa) * std::sqrt(bb));
+        },
+        true);
+
+    sqlite::execute(connection, "CREATE TABLE embeddings (embedding BLOB)");
+    {
+        sqlite::deferred_transaction transaction(connection);
+        sqlite::statement insert(connection, "INSERT INTO embeddings VALUES (?)");
+        std::vector<float> embedding(kDimensions);
+        for (int64_t row = 0; row < rows; ++row) {
+            for (int i = 0; i < kDimensions; ++i) {
+                embedding[i] = static_cast<float>(((row * 31 + i * 17) % 201) - 100) / 100.0f;
+            }
+            insert.reset();
+            insert.bind(1, sqlite::blob(embedding.data(), embedding.size() * sizeof(float)));
+            insert.step();
+        }
+        transaction.commit();
+    }
+
+    std::vector<float> probe(kDimensions, 0.5f);
+    const sqlite::blob probeBlob(probe.data(), probe.size() * sizeof(float));
+
+    const sqlite::vector_isa original = sqlite::active_vector_isa();
+    run("copy_cosine (create_function)", connection, "copy_cosine", probeBlob, rows);
+    for (int isa = 0; isa <= static_cast<int>(sqlite::supported_vector_isa()); ++isa) {
+        sqlite::use_vector_isa(static_cast<sqlite::vector_isa>(isa));
+        const std::string suffix = std::string(" (") + isa_name(static_cast<sqlite::vector_isa>(isa)) + ")";
+        run("vec_cosine" + suffix, connection, "vec_cosine", probeBlob, rows);
+        run("vec_dot" + suffix, connection, "vec_dot", probeBlob, rows);
+        run("vec_l2" + suffix, connection, "vec_l2", probeBlob, rows);
+    }
+    sqlite::use_vector_isa(original);
+}
@@ -0,0 +1,64 @@
+#include "Benchmark.h"
+#include "catch.hpp"
+#include "SQLiteXX.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Every insert is its own transaction with synchronous=FULL, so each commit waits for its syncs.
+static const int kThreads = 4;
+static const int kPayloadSize = 2000;
+
+static void concurrent_commits(const std::string& name, const std::string& vfs, const std::string& mode, const int64_t commits)
+{
+    const std::string filename = "BenchWriteBehind.db";
+    remove(filename.c_str());
+    remove((filename + "-wal").c_str());
+    {
+        sqlite::dbconnection connection(filename);
+        sqlite::statement(connection, "PRAGMA journal_mode=" + mode).step();
+        sqlite::execute(connection, "CREATE TABLE test (id INTEGER PRIMARY KEY, payload BLOB)");
+    }
+
+    const double seconds = benchmark::measure([&]() {
+        std::vector<std::thread> writers;
+        for (int i = 0; i < kThreads; ++i) {
+            writers.emplace_back([&]() {
+                sqlite::dbconnection connection(filename, sqlite::openmode::read_write, std::chrono::seconds(60), vfs);
+                sqlite::execute(connection, "PRAGMA synchronous=FULL");
+                sqlite::statement insert(connection, "INSERT INTO test (payload) VALUES (randomblob(?))");
+                for (int64_t j = 0; j < commits / kThreads; ++j) {
+                    insert.reset();
+                    insert.bind(1, kPayloadSize);
+                    insert.execute();
+                }
+            });
+        }
+        for (std::thread& writer : writers) {
+            writer.join();
+        }
+    });
+
+    sqlite::dbconnection connection(filename);
+    sqlite::statement count(connection, "SELECT count(*) FROM test");
+    count.step();
+    REQUIRE(count.get_int64(0) == commits / kThreads * kThreads);
+    benchmark::report(name, static_cast<double>(commits), seconds);
+}
+
+TEST_CASE("Default VFS vs write-behind VFS", "[Benchmark][WriteBehind]") {
+    const int64_t commits = benchmark::row_count(2000);
+    sqlite::write_behind_vfs vfs("bench-write-behind");
+
+    concurrent_commits("WAL commits (default VFS)", std::string(), "WAL", commits);
+    concurrent_commits("WAL commits (write-behind)", vfs.name(), "WAL", commits);
+    concurrent_commits("rollback journal commits (default VFS)", std::string(), "DELETE", commits);
+    concurrent_commits("rollback journal commits (write-behind)", vfs.name(), "DELETE", commits);
+
+    const sqlite::write_behind_stats stats = vfs.stats();
+    std::printf("write-behind: %llu writes, %llu sync requests, %llu syncs\n",
+                static_cast<unsigned long long>(stats.writes), static_cast<unsigned long long>(stats.sync_requests), static_cast<unsigned long long>(stats.syncs));
+}
@@ -0,0 +1,51 @@
+#ifndef __SQLITEXX_BENCHMARKS_BENCHMARK_H__
+#define __SQLITEXX_BENCHMARKS_BENCHMARK_H__
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace benchmark
+{
+    /** Runs a callable once and returns how long it took in seconds.
+     */
+    template <typename F>
+    double measure(F&& function)
+    {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        function();
+        const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double>(end - start).count();
+    }
+
+    /** Returns the number of rows a benchmark should work on.
+     * The SQLITEXX_BENCHMARK_ROWS environment variable overrides the default so large runs can be scaled down.
+     * @param[in] default_rows the row count to use when the environment variable is not set
+     * @returns the number of rows to use
+     */
+    inline int64_t row_count(const int64_t default_rows)
+    {
+        const char* rows = std::getenv("SQLITEXX_BENCHMARK_ROWS");
+        if (rows != nullptr) {
+            const long long parsed = std::strtoll(rows, nullptr, 10);
+            if (parsed > 0) {
+                return parsed;
+            }
+        }
+        return default_rows;
+    }
+
+    /** Prints the throughput of a benchmark run.
+     * @param[in] name       the name of the benchmark
+     * @param[in] operations the number of operations done in the run
+     * @param[in] seconds    how long the run took
+     */
+    inline void report(const std::string& name, const double operations, const double seconds)
+    {
+        std::printf("%-48s %12.0f ops/s %10.3f s\n", name.c_str(), operations / seconds, seconds);
+    }
+}
+
+#endif
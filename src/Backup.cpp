@@ -1,9 +1,19 @@
 #include "Backup.h"
 #include "Exception.h"
+#include "Statement.h"
+#include "Utilities.h"
+
+#include <algorithm>
 
 
 namespace sqlite
 {
+    namespace
+    {
+        // The shortest wait before a busy or locked source is tried again, so a pause of 0 does not spin.
+        const std::chrono::milliseconds busy_backoff(5);
+    }
+
     void save(const dbconnection& source, const std::string& filename)
     {
         dbconnection destination(filename);
@@ -57,4 +67,132 @@ namespace sqlite
     {
         return m_handle.get();
     }
+
+    background_backup::background_backup(
+        const dbconnection& source,
+        const dbconnection& destination,
+        const backup_pacing& pacing,
+        progress_callback progress,
+        const std::string& sourceName,
+        const std::string& destinationName) :
+        m_backup(new backup(source, destination, sourceName, destinationName)),
+        m_pacing(pacing),
+        m_progress(std::move(progress)),
+        m_page_size(0),
+        m_total(0),
+        m_remaining(-1),
+        m_finished(false),
+        m_completed(false),
+        m_error(),
+        m_cancelled(false)
+    {
+        statement page_size(source, "PRAGMA " + quote_identifier(sourceName) + ".page_size");
+        page_size.step();
+        m_page_size = page_size.get_int(0);
+
+        m_thread = std::thread(&background_backup::run, this);
+    }
+
+    background_backup::~background_backup()
+    {
+        cancel();
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+    }
+
+    void background_backup::cancel() noexcept
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_cancelled = true;
+        }
+        m_wake.notify_all();
+    }
+
+    bool background_backup::wait()
+    {
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+        if (m_error) {
+            std::rethrow_exception(m_error);
+        }
+        return m_completed;
+    }
+
+    bool background_backup::finished() const noexcept
+    {
+        return m_finished.load();
+    }
+
+    int background_backup::total_page_count() const noexcept
+    {
+        return m_total.load();
+    }
+
+    int background_backup::remaining_page_count() const noexcept
+    {
+        return m_remaining.load();
+    }
+
+    void background_backup::run()
+    {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        const double bytes_per_second = m_pacing.max_megabytes_per_second * 1e6;
+        double copied = 0.0;
+        try {
+            while (true) {
+                const int previous = m_remaining.load();
+                const int result = sqlite3_backup_step(m_backup->handle(), m_pacing.pages_per_step);
+                // Busy or locked sources are retried, unlike backup::step() which gives up.
+                if (result != SQLITE_OK && result != SQLITE_DONE && result != SQLITE_BUSY && result != SQLITE_LOCKED) {
+                    throw_error_code(result, sqlite3_errstr(result));
+                }
+
+                const int total = sqlite3_backup_pagecount(m_backup->handle());
+                const int remaining = sqlite3_backup_remaining(m_backup->handle());
+                m_total = total;
+                m_remaining = remaining;
+                if (result == SQLITE_OK || result == SQLITE_DONE) {
+                    // A backup restarted by a change to the source has more pages left than before.
+                    const int pages = previous < 0 || remaining > previous ? total - remaining : previous - remaining;
+                    copied += static_cast<double>(pages) * m_page_size;
+                    if (m_progress) {
+                        m_progress(remaining, total);
+                    }
+                }
+                if (result == SQLITE_DONE) {
+                    m_completed = true;
+                    break;
+                }
+
+                const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+                std::chrono::steady_clock::time_point next = now + m_pacing.pause;
+                if (result == SQLITE_BUSY || result == SQLITE_LOCKED) {
+                    next = std::max(next, now + busy_backoff);
+                }
+                if (bytes_per_second > 0.0) {
+                    const auto budget = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(copied / bytes_per_second));
+                    next = std::max(next, start + budget);
+                }
+                std::unique_lock<std::mutex> lock(m_mutex);
+                if (next > std::chrono::steady_clock::now()) {
+                    m_wake.wait_until(lock, next, [&]() { return m_cancelled; });
+                } else {
+                    lock.unlock();
+                    std::this_thread::yield();
+                    lock.lock();
+                }
+                if (m_cancelled) {
+                    break;
+                }
+            }
+        } catch (...) {
+            m_error = std::current_exception();
+        }
+        // Finished here, so the connections are free for other threads once the backup is.
+        m_backup.reset();
+        m_finished = true;
+    }
 }
@@ -7,7 +7,15 @@
 
 #include <sqlite3.h>
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
 
 namespace sqlite
 {
@@ -79,6 +87,99 @@ namespace sqlite
     };
 
     void save(const dbconnection& source, const std::string& filename);
+
+    /** How fast a sqlite::background_backup copies pages.
+     */
+    struct backup_pacing
+    {
+        int pages_per_step = 64;                 ///< pages copied per step, the source is read locked only during a step
+        std::chrono::milliseconds pause{10};     ///< the wait between two steps, the thread only yields if 0
+        double max_megabytes_per_second = 0.0;   ///< the average copy rate not to exceed in units of 10^6 bytes, 0 for no limit
+    };
+
+    /** Backs up a database on its own thread in small steps, so writers to the source are not stalled for the whole copy.
+     * Between two steps the thread waits for the pause of the sqlite::backup_pacing, longer if the rate limit needs it.
+     * A source that is busy or locked is retried after the pause, but not sooner than after a few milliseconds.
+     * Changes made through the source connection during the backup are copied as well. Changes made by
+     * other connections, or any change to an in-memory source, restart it, so such a source written
+     * constantly is never backed up.
+     * Both connections are used from the thread of the backup, they must be opened in serialized mode,
+     * the default, and the destination must not be used until the backup has finished.
+     * The destination is incomplete if the backup is cancelled or fails.
+     */
+    class background_backup
+    {
+        public:
+
+        /** Called after each step with the number of pages still to copy and the total number of pages of the source. */
+        using progress_callback = std::function<void(int remaining, int total)>;
+
+        /** Starts the backup.
+         * @param[in] source          the database that will be the source of copied information
+         * @param[in] destination     the database that will be backed up to
+         * @param[in] pacing          how fast the pages are copied
+         * @param[in] progress        called on the thread of the backup after each step, may be empty
+         * @param[in] sourceName      the source database name
+         * @param[in] destinationName the destination database name
+         * @throws sqlite::exception if the backup could not be started
+         */
+        background_backup(
+            const dbconnection& source,
+            const dbconnection& destination,
+            const backup_pacing& pacing = backup_pacing(),
+            progress_callback progress = progress_callback(),
+            const std::string& sourceName = "main",
+            const std::string& destinationName = "main");
+
+        /** Cancels the backup if it is still running and waits for its thread.
+         */
+        ~background_backup();
+
+        background_backup(const background_backup&) = delete;
+        background_backup& operator=(const background_backup&) = delete;
+
+        /** Asks the backup to stop after the current step.
+         */
+        void cancel() noexcept;
+
+        /** Waits until the backup has finished.
+         * @returns true if every page was copied, false if the backup was cancelled
+         * @throws sqlite::exception if a step failed, or whatever the progress callback threw
+         */
+        bool wait();
+
+        /** Returns true once the thread of the backup has stopped.
+         */
+        bool finished() const noexcept;
+
+        /** Returns the total number of pages in the source database as of the last step.
+         */
+        int total_page_count() const noexcept;
+
+        /** Returns the number of pages still to be backed up as of the last step, -1 before the first step.
+         */
+        int remaining_page_count() const noexcept;
+
+        private:
+        void run();
+
+        std::unique_ptr<backup> m_backup;
+        const backup_pacing m_pacing;
+        const progress_callback m_progress;
+        int m_page_size;
+
+        std::atomic<int> m_total;
+        std::atomic<int> m_remaining;
+        std::atomic<bool> m_finished;
+        bool m_completed;
+        std::exception_ptr m_error;
+
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        bool m_cancelled;
+
+        std::thread m_thread;
+    };
 }
 
 #endif
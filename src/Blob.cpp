@@ -48,5 +48,12 @@ namespace sqlite
     size_t blob::size() const {
         return m_size;
     }
-}
 
+    zeroblob::zeroblob(const uint64_t size) noexcept :
+        m_size(size)
+    {}
+
+    uint64_t zeroblob::size() const noexcept {
+        return m_size;
+    }
+}
@@ -6,6 +6,7 @@
 #include <sqlite3.h>
 
 #include <cassert>
+#include <cstdint>
 #include <cstring>
 #include <memory>
 #include <utility>
@@ -66,6 +67,27 @@ namespace sqlite
         std::unique_ptr<char[]> m_data;
         size_t m_size;
     };
+
+    /** A blob of a given size filled with zeros.
+     * Binding a zeroblob reserves space for a blob without allocating memory for its contents,
+     * which can then be filled in incrementally using a blob_stream.
+     */
+    class zeroblob
+    {
+        public:
+        /** Constructs a zeroblob object.
+         * @param[in] size the size in bytes of the blob
+         */
+        explicit zeroblob(const uint64_t size) noexcept;
+
+        /** Used to get the size of the 'blob'.
+         * @returns The size in bytes of the 'blob'.
+         */
+        uint64_t size() const noexcept;
+
+        private:
+        uint64_t m_size;
+    };
 }
 
 
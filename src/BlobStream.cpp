@@ -0,0 +1,245 @@
+#include "BlobStream.h"
+#include "Exception.h"
+
+#include <algorithm>
+
+namespace sqlite
+{
+    blob_stream::blob_stream(
+        const dbconnection& connection,
+        const std::string& table,
+        const std::string& column,
+        const int64_t row,
+        const bool writable,
+        const std::string& database) :
+        m_connection(connection),
+        m_handle(nullptr, sqlite3_blob_close)
+    {
+        sqlite3_blob* blob = nullptr;
+        if (SQLITE_OK != sqlite3_blob_open(
+                m_connection.handle(),
+                database.c_str(),
+                table.c_str(),
+                column.c_str(),
+                row,
+                writable ? 1 : 0,
+                &blob))
+        {
+            // A handle is not returned on failure but closing a null handle is a NOP.
+            sqlite3_blob_close(blob);
+            throw_error_code(m_connection.handle());
+        }
+
+        m_handle.reset(blob);
+    }
+
+    blob_stream::blob_stream(blob_stream&& other) noexcept :
+        m_connection(std::move(other.m_connection)),
+        m_handle(std::move(other.m_handle))
+    {}
+
+    blob_stream& blob_stream::operator=(blob_stream&& other) noexcept
+    {
+        assert(this != &other);
+        m_handle = std::move(other.m_handle);
+        m_connection = std::move(other.m_connection);
+        return *this;
+    }
+
+    int blob_stream::size() const noexcept
+    {
+        return sqlite3_blob_bytes(handle());
+    }
+
+    void blob_stream::read(void* buffer, const int size, const int offset) const
+    {
+        if (SQLITE_OK != sqlite3_blob_read(handle(), buffer, size, offset))
+        {
+            throw_error_code(m_connection.handle());
+        }
+    }
+
+    void blob_stream::write(const void* buffer, const int size, const int offset)
+    {
+        if (SQLITE_OK != sqlite3_blob_write(handle(), buffer, size, offset))
+        {
+            throw_error_code(m_connection.handle());
+        }
+    }
+
+    void blob_stream::reopen(const int64_t row)
+    {
+        if (SQLITE_OK != sqlite3_blob_reopen(handle(), row))
+        {
+            throw_error_code(m_connection.handle());
+        }
+    }
+
+    sqlite3_blob* blob_stream::handle() const noexcept
+    {
+        return m_handle.get();
+    }
+
+    blob_streambuf::blob_streambuf(blob_stream& stream, const std::size_t buffer_size) :
+        m_stream(stream),
+        m_buffer(new char[buffer_size]),
+        m_buffer_size(buffer_size),
+        m_offset(0)
+    {
+        assert(buffer_size > 0);
+    }
+
+    blob_streambuf::~blob_streambuf()
+    {
+        try {
+            flush();
+        } catch (const sqlite::exception&) {
+            // Don't throw exception in destructor. Call sync() or flush the
+            // owning stream to find out if writing the remaining data failed.
+        }
+    }
+
+    void blob_streambuf::reopen(const int64_t row)
+    {
+        flush();
+        m_stream.reopen(row);
+        m_offset = 0;
+    }
+
+    blob_streambuf::int_type blob_streambuf::underflow()
+    {
+        if (gptr() != nullptr && gptr() < egptr()) {
+            return traits_type::to_int_type(*gptr());
+        }
+
+        flush();
+        const int remaining = m_stream.size() - m_offset;
+        if (remaining <= 0) {
+            return traits_type::eof();
+        }
+
+        const int count = static_cast<int>(std::min<std::size_t>(m_buffer_size, remaining));
+        m_stream.read(m_buffer.get(), count, m_offset);
+        setg(m_buffer.get(), m_buffer.get(), m_buffer.get() + count);
+        return traits_type::to_int_type(*gptr());
+    }
+
+    blob_streambuf::int_type blob_streambuf::overflow(int_type ch)
+    {
+        flush();
+        if (traits_type::eq_int_type(ch, traits_type::eof())) {
+            return traits_type::not_eof(ch);
+        }
+
+        const int remaining = m_stream.size() - m_offset;
+        if (remaining <= 0) {
+            // Blobs can not grow in size.
+            return traits_type::eof();
+        }
+
+        const int count = static_cast<int>(std::min<std::size_t>(m_buffer_size, remaining));
+        setp(m_buffer.get(), m_buffer.get() + count);
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+        return ch;
+    }
+
+    int blob_streambuf::sync()
+    {
+        try {
+            flush();
+        } catch (const sqlite::exception&) {
+            return -1;
+        }
+        return 0;
+    }
+
+    std::streamsize blob_streambuf::showmanyc()
+    {
+        const int remaining = m_stream.size() - position();
+        return remaining > 0 ? remaining : -1;
+    }
+
+    std::streamsize blob_streambuf::xsgetn(char_type* s, std::streamsize count)
+    {
+        if (count < static_cast<std::streamsize>(m_buffer_size)) {
+            return std::streambuf::xsgetn(s, count);
+        }
+
+        // Large reads go straight to the blob instead of through the buffer.
+        flush();
+        const int remaining = std::max(m_stream.size() - m_offset, 0);
+        const int read = static_cast<int>(std::min<std::streamsize>(count, remaining));
+        m_stream.read(s, read, m_offset);
+        m_offset += read;
+        return read;
+    }
+
+    std::streamsize blob_streambuf::xsputn(const char_type* s, std::streamsize count)
+    {
+        if (count < static_cast<std::streamsize>(m_buffer_size)) {
+            return std::streambuf::xsputn(s, count);
+        }
+
+        // Large writes go straight to the blob instead of through the buffer.
+        flush();
+        const int remaining = std::max(m_stream.size() - m_offset, 0);
+        const int written = static_cast<int>(std::min<std::streamsize>(count, remaining));
+        m_stream.write(s, written, m_offset);
+        m_offset += written;
+        return written;
+    }
+
+    blob_streambuf::pos_type blob_streambuf::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which)
+    {
+        (void)which;
+
+        off_type base = 0;
+        if (dir == std::ios_base::cur) {
+            base = position();
+        } else if (dir == std::ios_base::end) {
+            base = m_stream.size();
+        }
+
+        const off_type target = base + off;
+        if (target < 0 || target > m_stream.size()) {
+            return pos_type(off_type(-1));
+        }
+
+        try {
+            flush();
+        } catch (const sqlite::exception&) {
+            return pos_type(off_type(-1));
+        }
+        m_offset = static_cast<int>(target);
+        return pos_type(target);
+    }
+
+    blob_streambuf::pos_type blob_streambuf::seekpos(pos_type pos, std::ios_base::openmode which)
+    {
+        return seekoff(off_type(pos), std::ios_base::beg, which);
+    }
+
+    int blob_streambuf::position() const noexcept
+    {
+        if (pbase() != nullptr) {
+            return m_offset + static_cast<int>(pptr() - pbase());
+        }
+        if (eback() != nullptr) {
+            return m_offset + static_cast<int>(gptr() - eback());
+        }
+        return m_offset;
+    }
+
+    void blob_streambuf::flush()
+    {
+        const int current = position();
+        if (pbase() != nullptr && pptr() > pbase()) {
+            m_stream.write(pbase(), static_cast<int>(pptr() - pbase()), m_offset);
+        }
+
+        setg(nullptr, nullptr, nullptr);
+        setp(nullptr, nullptr);
+        m_offset = current;
+    }
+}
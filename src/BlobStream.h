@@ -0,0 +1,152 @@
+/** @file */
+
+#ifndef __SQLITEXX_SQLITE_BLOBSTREAM_H__
+#define __SQLITEXX_SQLITE_BLOBSTREAM_H__
+
+#include "DBConnection.h"
+
+#include <sqlite3.h>
+
+#include <cstdint>
+#include <memory>
+#include <streambuf>
+#include <string>
+
+namespace sqlite
+{
+    /** Incremental I/O on a single blob stored in the database, aka "sqlite3_blob".
+     * A blob_stream reads and writes parts of a blob without loading the whole value into memory.
+     * The size of the blob can not be changed through a blob_stream, use a zeroblob
+     * to preallocate the blob with an "INSERT" or "UPDATE" statement first.
+     * If the row the blob_stream points to is modified by another statement the
+     * blob_stream is expired and every subsequent read or write throws.
+     */
+    class blob_stream
+    {
+        public:
+        /** Opens the blob located in the specified table, column and row.
+         * @param[in] connection the database connection the blob belongs to
+         * @param[in] table      the name of the table containing the blob
+         * @param[in] column     the name of the column containing the blob
+         * @param[in] row        the rowid of the row containing the blob
+         * @param[in] writable   if true the blob is opened for reading and writing, otherwise read-only
+         * @param[in] database   the symbolic name of the database containing the blob
+         * @throws sqlite::exception if the blob could not be opened
+         */
+        blob_stream(
+            const dbconnection& connection,
+            const std::string& table,
+            const std::string& column,
+            const int64_t row,
+            const bool writable = false,
+            const std::string& database = "main");
+
+        /** Move constructor.
+         * @param[in] other another blob_stream object to use as source to initialize object with.
+         */
+        blob_stream(blob_stream&& other) noexcept;
+
+        /** Move assignment operator.
+         * @param[in] other another blob_stream object to use as source to initialize object with.
+         * @returns *this
+         */
+        blob_stream& operator=(blob_stream&& other) noexcept;
+
+        /** Returns the size in bytes of the blob.
+         * @returns The size in bytes of the blob.
+         */
+        int size() const noexcept;
+
+        /** Reads bytes from the blob into a buffer.
+         * @param[out] buffer the buffer to copy the data into
+         * @param[in]  size   the number of bytes to read
+         * @param[in]  offset the offset within the blob to start reading from
+         * @throws sqlite::exception if offset + size is larger than the blob or the blob has expired
+         */
+        void read(void* buffer, const int size, const int offset) const;
+
+        /** Writes bytes from a buffer into the blob.
+         * @param[in] buffer the data to write
+         * @param[in] size   the number of bytes to write
+         * @param[in] offset the offset within the blob to start writing at
+         * @throws sqlite::exception if offset + size is larger than the blob, the blob
+         *                           was opened read-only or the blob has expired
+         */
+        void write(const void* buffer, const int size, const int offset);
+
+        /** Moves the blob_stream to the blob of another row of the same table and column.
+         * This is faster than opening a new blob_stream for every row.
+         * @param[in] row the rowid of the row containing the blob
+         * @throws sqlite::exception if the row does not exist or does not contain a blob or text value.
+         *                           The blob_stream can not be used again until reopened successfully.
+         */
+        void reopen(const int64_t row);
+
+        /** Returns pointer to the underlying "sqlite3_blob" object.
+         */
+        sqlite3_blob* handle() const noexcept;
+
+        private:
+        using blob_handle = std::unique_ptr<sqlite3_blob, decltype(&sqlite3_blob_close)>;
+        // Declared before m_handle so the blob is closed before the connection is released.
+        dbconnection m_connection;
+        blob_handle m_handle;
+
+        blob_stream(const blob_stream& other) = delete;
+        blob_stream& operator=(const blob_stream& other) = delete;
+    };
+
+    /** A [std::streambuf](http://en.cppreference.com/w/cpp/io/basic_streambuf) over a blob_stream.
+     * Use it with std::istream, std::ostream or std::iostream to read or write a blob in chunks
+     * of a fixed size so memory use stays constant no matter how large the blob is.
+     * Writing past the end of the blob fails since a blob can not grow.
+     */
+    class blob_streambuf : public std::streambuf
+    {
+        public:
+        /** Constructs a stream buffer over an opened blob_stream.
+         * @param[in] stream      the blob to read from and write to, must outlive the blob_streambuf
+         * @param[in] buffer_size the size in bytes of the chunks transferred to and from the blob
+         */
+        explicit blob_streambuf(blob_stream& stream, const std::size_t buffer_size = 4096);
+
+        /** Destructor.
+         * Writes any pending data to the blob.
+         */
+        ~blob_streambuf() override;
+
+        /** Writes pending data and moves the underlying blob_stream to another row.
+         * The position of the stream buffer is reset to the start of the blob.
+         * @param[in] row the rowid of the row containing the blob
+         */
+        void reopen(const int64_t row);
+
+        protected:
+        int_type underflow() override;
+        int_type overflow(int_type ch) override;
+        int sync() override;
+        std::streamsize showmanyc() override;
+        std::streamsize xsgetn(char_type* s, std::streamsize count) override;
+        std::streamsize xsputn(const char_type* s, std::streamsize count) override;
+        pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+        pos_type seekpos(pos_type pos, std::ios_base::openmode which) override;
+
+        private:
+        blob_stream& m_stream;
+        std::unique_ptr<char[]> m_buffer;
+        std::size_t m_buffer_size;
+
+        // Offset within the blob of the first byte of the get or put area.
+        int m_offset;
+
+        int position() const noexcept;
+
+        // Writes the put area to the blob and empties both the get and put areas.
+        void flush();
+
+        blob_streambuf(const blob_streambuf& other) = delete;
+        blob_streambuf& operator=(const blob_streambuf& other) = delete;
+    };
+}
+
+#endif
@@ -0,0 +1,916 @@
+#include "CompressedVfs.h"
+
+#include "Exception.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace sqlite
+{
+    namespace
+    {
+        constexpr std::size_t min_match = 4;
+        // The end of a page is always copied as literals, so a match never reads past it.
+        constexpr std::size_t last_literals = 5;
+        constexpr int hash_bits = 12;
+        constexpr std::size_t max_distance = 65535;
+
+        uint32_t read32(const unsigned char* data) noexcept
+        {
+            uint32_t value;
+            std::memcpy(&value, data, sizeof(value));
+            return value;
+        }
+
+        uint32_t hash_of(const uint32_t sequence) noexcept
+        {
+            return (sequence * 2654435761u) >> (32 - hash_bits);
+        }
+
+        // Appends the part of a length that does not fit into the token, 255 per byte.
+        bool put_length(unsigned char*& output, const unsigned char* end, std::size_t length) noexcept
+        {
+            for (; length >= 255; length -= 255) {
+                if (output == end) {
+                    return false;
+                }
+                *output++ = 255;
+            }
+            if (output == end) {
+                return false;
+            }
+            *output++ = static_cast<unsigned char>(length);
+            return true;
+        }
+
+        bool get_length(const unsigned char*& input, const unsigned char* end, std::size_t& length) noexcept
+        {
+            unsigned char byte = 0;
+            do {
+                if (input == end) {
+                    return false;
+                }
+                byte = *input++;
+                length += byte;
+            } while (byte == 255);
+            return true;
+        }
+
+        // Appends a sequence, the last one of a page has literals only.
+        bool put_sequence(unsigned char*& output, const unsigned char* end, const unsigned char* literals, const std::size_t literal_count,
+                          const std::size_t match_length, const std::size_t distance, const bool last) noexcept
+        {
+            if (output == end) {
+                return false;
+            }
+            unsigned char* token = output++;
+            *token = static_cast<unsigned char>(std::min<std::size_t>(literal_count, 15) << 4);
+            if (literal_count >= 15 && !put_length(output, end, literal_count - 15)) {
+                return false;
+            }
+            if (static_cast<std::size_t>(end - output) < literal_count) {
+                return false;
+            }
+            std::memcpy(output, literals, literal_count);
+            output += literal_count;
+            if (last) {
+                return true;
+            }
+
+            if (end - output < 2) {
+                return false;
+            }
+            *output++ = static_cast<unsigned char>(distance & 0xFF);
+            *output++ = static_cast<unsigned char>(distance >> 8);
+            const std::size_t length = match_length - min_match;
+            *token |= static_cast<unsigned char>(std::min<std::size_t>(length, 15));
+            return length < 15 || put_length(output, end, length - 15);
+        }
+    }
+
+    uint32_t lz_codec::id() const noexcept
+    {
+        return 0x4C5A5031; // "LZP1"
+    }
+
+    std::size_t lz_codec::compress(const char* input, const std::size_t size, char* output, const std::size_t capacity) const
+    {
+        const unsigned char* const in = reinterpret_cast<const unsigned char*>(input);
+        unsigned char* out = reinterpret_cast<unsigned char*>(output);
+        const unsigned char* const out_end = out + capacity;
+
+        // Positions plus one of the last 4-byte sequence with each hash, 0 for none.
+        std::vector<uint32_t> table(std::size_t(1) << hash_bits, 0);
+        std::size_t anchor = 0;
+        std::size_t position = 0;
+        if (size > min_match + last_literals) {
+            const std::size_t limit = size - last_literals - min_match;
+            std::size_t misses = 0;
+            while (position <= limit) {
+                const uint32_t sequence = read32(in + position);
+                uint32_t& entry = table[hash_of(sequence)];
+                const std::size_t candidate = entry;
+                entry = static_cast<uint32_t>(position + 1);
+                if (candidate == 0 || position - (candidate - 1) > max_distance || read32(in + candidate - 1) != sequence) {
+                    // Step faster through data that does not compress.
+                    position += 1 + (misses++ >> 6);
+                    continue;
+                }
+
+                const std::size_t match = candidate - 1;
+                std::size_t length = min_match;
+                while (position + length < size - last_literals && in[match + length] == in[position + length]) {
+                    ++length;
+                }
+                if (!put_sequence(out, out_end, in + anchor, position - anchor, length, position - match, false)) {
+                    return 0;
+                }
+                position += length;
+                anchor = position;
+                misses = 0;
+                if (position - 2 <= limit) {
+                    table[hash_of(read32(in + position - 2))] = static_cast<uint32_t>(position - 1);
+                }
+            }
+        }
+        if (!put_sequence(out, out_end, in + anchor, size - anchor, 0, 0, true)) {
+            return 0;
+        }
+        return static_cast<std::size_t>(out - reinterpret_cast<unsigned char*>(output));
+    }
+
+    bool lz_codec::decompress(const char* input, const std::size_t size, char* output, const std::size_t output_size) const
+    {
+        const unsigned char* in = reinterpret_cast<const unsigned char*>(input);
+        const unsigned char* const in_end = in + size;
+        unsigned char* const out_begin = reinterpret_cast<unsigned char*>(output);
+        unsigned char* out = out_begin;
+        const unsigned char* const out_end = out + output_size;
+
+        while (in != in_end) {
+            const unsigned char token = *in++;
+            std::size_t literals = token >> 4;
+            if (literals == 15 && !get_length(in, in_end, literals)) {
+                return false;
+            }
+            if (static_cast<std::size_t>(in_end - in) < literals || static_cast<std::size_t>(out_end - out) < literals) {
+                return false;
+            }
+            std::memcpy(out, in, literals);
+            in += literals;
+            out += literals;
+            if (in == in_end) {
+                return out == out_end;
+            }
+
+            if (in_end - in < 2) {
+                return false;
+            }
+            const std::size_t distance = static_cast<std::size_t>(in[0]) | (static_cast<std::size_t>(in[1]) << 8);
+            in += 2;
+            std::size_t length = token & 15;
+            if (length == 15 && !get_length(in, in_end, length)) {
+                return false;
+            }
+            length += min_match;
+            if (distance == 0 || distance > static_cast<std::size_t>(out - out_begin) || static_cast<std::size_t>(out_end - out) < length) {
+                return false;
+            }
+            const unsigned char* match = out - distance;
+            if (distance >= length) {
+                std::memcpy(out, match, length);
+                out += length;
+            } else {
+                // An overlapping match repeats the last distance bytes.
+                for (std::size_t i = 0; i < length; ++i) {
+                    *out++ = *match++;
+                }
+            }
+        }
+        return false;
+    }
+
+    namespace
+    {
+        // The page map starts with a header, followed by one entry per page.
+        constexpr char pagemap_magic[8] = {'S', 'Q', 'X', 'X', 'P', 'M', 'A', 'P'};
+        constexpr std::size_t header_size = 64;
+        constexpr std::size_t entry_size = 16;
+        constexpr std::size_t entries_per_write = 4096;
+        // Slots are rounded up so a page that grows a little after a rewrite keeps its slot.
+        constexpr uint32_t slot_granularity = 64;
+
+        void store32(unsigned char* data, const uint32_t value) noexcept
+        {
+            for (int i = 0; i < 4; ++i) {
+                data[i] = static_cast<unsigned char>(value >> (8 * i));
+            }
+        }
+
+        void store64(unsigned char* data, const uint64_t value) noexcept
+        {
+            for (int i = 0; i < 8; ++i) {
+                data[i] = static_cast<unsigned char>(value >> (8 * i));
+            }
+        }
+
+        uint32_t load32(const unsigned char* data) noexcept
+        {
+            uint32_t value = 0;
+            for (int i = 3; i >= 0; --i) {
+                value = (value << 8) | data[i];
+            }
+            return value;
+        }
+
+        uint64_t load64(const unsigned char* data) noexcept
+        {
+            uint64_t value = 0;
+            for (int i = 7; i >= 0; --i) {
+                value = (value << 8) | data[i];
+            }
+            return value;
+        }
+
+        bool valid_page_size(const int64_t size) noexcept
+        {
+            return size >= 512 && size <= 65536 && (size & (size - 1)) == 0;
+        }
+    }
+
+    /** The state of one compressed database, shared by every connection of the process that opened it. */
+    class compressed_vfs::database
+    {
+        public:
+        database(sqlite3_vfs* base, const std::string& name, sqlite3_file* data, const int flags,
+                 std::shared_ptr<const page_codec> codec, const std::size_t cache_pages) :
+            m_base(base),
+            m_codec(std::move(codec)),
+            m_cache_pages(cache_pages),
+            // Followed by an empty list of URI parameters, as the underlying VFS expects of a file name.
+            m_map_name(name + "-pagemap" + std::string(2, '\0'))
+        {
+            open(data, (flags & SQLITE_OPEN_READWRITE) != 0, name);
+        }
+
+        ~database()
+        {
+            close_map();
+        }
+
+        database(const database&) = delete;
+        database& operator=(const database&) = delete;
+
+        /** False if the database is stored without compression. */
+        bool compressed() const noexcept
+        {
+            return m_compressed.load();
+        }
+
+        /** Opens the page map for writing if only read-only connections opened the database so far. */
+        void make_writable(sqlite3_file* data, const std::string& name)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_writable) {
+                return;
+            }
+            if (m_map == nullptr) {
+                // An empty database is only compressed once a writer creates its map.
+                open(data, true, name);
+                return;
+            }
+            std::unique_ptr<char[]> storage;
+            sqlite3_file* map = open_map_file(true, storage, name);
+            close_map();
+            m_map_storage = std::move(storage);
+            m_map = map;
+            m_writable = true;
+        }
+
+        int read(sqlite3_file* data, void* buffer, const int amount, const int64_t offset)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            char* output = static_cast<char*>(buffer);
+            std::size_t remaining = static_cast<std::size_t>(amount);
+            uint64_t position = static_cast<uint64_t>(offset);
+            while (remaining > 0) {
+                const uint64_t page = m_page_size == 0 ? 0 : position / m_page_size;
+                if (m_page_size == 0 || page >= m_slots.size()) {
+                    std::memset(output, 0, remaining);
+                    return SQLITE_IOERR_SHORT_READ;
+                }
+                const char* plain = nullptr;
+                const int errorcode = page_of(data, static_cast<std::size_t>(page), plain);
+                if (errorcode != SQLITE_OK) {
+                    return errorcode;
+                }
+                const std::size_t within = static_cast<std::size_t>(position % m_page_size);
+                const std::size_t count = std::min<std::size_t>(remaining, m_page_size - within);
+                std::memcpy(output, plain + within, count);
+                output += count;
+                position += count;
+                remaining -= count;
+            }
+            return SQLITE_OK;
+        }
+
+        int write(sqlite3_file* data, const void* buffer, const int amount, const int64_t offset)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_page_size == 0) {
+                if (!valid_page_size(amount) || offset % amount != 0) {
+                    return SQLITE_IOERR_WRITE;
+                }
+                set_page_size(static_cast<uint32_t>(amount));
+                m_header_dirty = true;
+            }
+
+            const char* input = static_cast<const char*>(buffer);
+            std::size_t remaining = static_cast<std::size_t>(amount);
+            uint64_t position = static_cast<uint64_t>(offset);
+            while (remaining > 0) {
+                const std::size_t page = static_cast<std::size_t>(position / m_page_size);
+                const std::size_t within = static_cast<std::size_t>(position % m_page_size);
+                const std::size_t count = std::min<std::size_t>(remaining, m_page_size - within);
+                const char* plain = input;
+                if (count < m_page_size) {
+                    // Part of a page, which SQLite only does for the database header.
+                    const char* current = nullptr;
+                    if (page < m_slots.size()) {
+                        const int errorcode = page_of(data, page, current);
+                        if (errorcode != SQLITE_OK) {
+                            return errorcode;
+                        }
+                    }
+                    m_patch.assign(m_page_size, 0);
+                    if (current != nullptr) {
+                        std::memcpy(m_patch.data(), current, m_page_size);
+                    }
+                    std::memcpy(m_patch.data() + within, input, count);
+                    plain = m_patch.data();
+                }
+                const int errorcode = store(data, page, plain);
+                if (errorcode != SQLITE_OK) {
+                    return errorcode;
+                }
+                input += count;
+                position += count;
+                remaining -= count;
+            }
+            return SQLITE_OK;
+        }
+
+        int truncate(const int64_t size)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_page_size == 0) {
+                return SQLITE_OK;
+            }
+            const std::size_t pages = static_cast<std::size_t>((static_cast<uint64_t>(size) + m_page_size - 1) / m_page_size);
+            if (pages < m_slots.size()) {
+                m_slots.resize(pages);
+                m_dirty_from = std::min(m_dirty_from, pages);
+                m_dirty_to = std::min(m_dirty_to, pages);
+                m_header_dirty = true;
+                for (auto cached = m_cache.begin(); cached != m_cache.end();) {
+                    if (cached->first >= pages) {
+                        m_cache_index.erase(cached->first);
+                        cached = m_cache.erase(cached);
+                    } else {
+                        ++cached;
+                    }
+                }
+            }
+            return SQLITE_OK;
+        }
+
+        int64_t size()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return static_cast<int64_t>(m_slots.size()) * m_page_size;
+        }
+
+        /** Writes the changed part of the page map, and syncs it if flags is not 0. */
+        int flush(const int flags)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_header_dirty || m_dirty_from < m_dirty_to) {
+                unsigned char header[header_size] = {};
+                std::memcpy(header, pagemap_magic, sizeof(pagemap_magic));
+                store32(header + 8, m_codec->id());
+                store32(header + 12, m_page_size);
+                store64(header + 16, m_slots.size());
+                store64(header + 24, m_generation + 1);
+
+                // In chunks, the underlying VFS may not expect writes larger than a page.
+                std::vector<unsigned char> entries(std::min(m_dirty_to - std::min(m_dirty_from, m_dirty_to), entries_per_write) * entry_size);
+                for (std::size_t first = m_dirty_from; first < m_dirty_to; first += entries_per_write) {
+                    const std::size_t last = std::min(first + entries_per_write, m_dirty_to);
+                    for (std::size_t page = first; page < last; ++page) {
+                        unsigned char* entry = entries.data() + (page - first) * entry_size;
+                        store64(entry, m_slots[page].offset);
+                        store32(entry + 8, m_slots[page].size);
+                        store32(entry + 12, m_slots[page].capacity);
+                    }
+                    const int errorcode = m_map->pMethods->xWrite(m_map, entries.data(), static_cast<int>((last - first) * entry_size),
+                                                                  static_cast<sqlite3_int64>(header_size + first * entry_size));
+                    if (errorcode != SQLITE_OK) {
+                        return errorcode;
+                    }
+                }
+                const int errorcode = m_map->pMethods->xWrite(m_map, header, static_cast<int>(header_size), 0);
+                if (errorcode != SQLITE_OK) {
+                    return errorcode;
+                }
+                ++m_generation;
+                m_header_dirty = false;
+                m_dirty_from = SIZE_MAX;
+                m_dirty_to = 0;
+            }
+            return flags != 0 ? m_map->pMethods->xSync(m_map, flags) : SQLITE_OK;
+        }
+
+        /** Reloads the page map if another process changed it. */
+        int refresh(sqlite3_file* data)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_header_dirty || m_dirty_from < m_dirty_to) {
+                return SQLITE_OK;
+            }
+            unsigned char header[header_size];
+            const int errorcode = m_map->pMethods->xRead(m_map, header, static_cast<int>(header_size), 0);
+            if (errorcode == SQLITE_IOERR_SHORT_READ) {
+                return m_generation == 0 ? SQLITE_OK : load(data);
+            }
+            if (errorcode != SQLITE_OK) {
+                return errorcode;
+            }
+            return load64(header + 24) == m_generation ? SQLITE_OK : load(data);
+        }
+
+        private:
+        struct slot
+        {
+            uint64_t offset = 0;
+            uint32_t size = 0;     ///< page_size for a page stored uncompressed, 0 for a page never written
+            uint32_t capacity = 0;
+        };
+
+        // Opens the page map of a compressed database, the caller holds the mutex or constructs the object.
+        void open(sqlite3_file* data, const bool writable, const std::string& name)
+        {
+            int exists = 0;
+            int errorcode = m_base->xAccess(m_base, m_map_name.c_str(), SQLITE_ACCESS_EXISTS, &exists);
+            if (errorcode != SQLITE_OK) {
+                throw sqlite::exception(errorcode, "Unable to look for the page map of " + name);
+            }
+            sqlite3_int64 data_size = 0;
+            errorcode = data->pMethods->xFileSize(data, &data_size);
+            if (errorcode != SQLITE_OK) {
+                throw sqlite::exception(errorcode, "Unable to get the size of " + name);
+            }
+            if (!exists && (data_size > 0 || !writable)) {
+                m_writable = writable;
+                return;
+            }
+
+            std::unique_ptr<char[]> storage;
+            sqlite3_file* map = open_map_file(writable, storage, name);
+            m_map_storage = std::move(storage);
+            m_map = map;
+
+            // A map left behind by a database that was deleted or replaced does not describe the empty file.
+            if (data_size == 0 && writable) {
+                errorcode = m_map->pMethods->xTruncate(m_map, 0);
+                if (errorcode != SQLITE_OK) {
+                    close_map();
+                    throw sqlite::exception(errorcode, "Unable to reset the page map of " + name);
+                }
+            }
+
+            errorcode = load(data);
+            if (errorcode != SQLITE_OK) {
+                close_map();
+                throw sqlite::exception(errorcode, "Unable to read the page map of " + name);
+            }
+            m_writable = writable;
+            m_compressed = true;
+        }
+
+        sqlite3_file* open_map_file(const bool writable, std::unique_ptr<char[]>& storage, const std::string& name)
+        {
+            storage.reset(new char[static_cast<std::size_t>(m_base->szOsFile)]);
+            sqlite3_file* map = reinterpret_cast<sqlite3_file*>(storage.get());
+            map->pMethods = nullptr;
+            const int map_flags = SQLITE_OPEN_MAIN_JOURNAL | (writable ? SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE : SQLITE_OPEN_READONLY);
+            const int errorcode = m_base->xOpen(m_base, m_map_name.c_str(), map, map_flags, nullptr);
+            if (errorcode != SQLITE_OK) {
+                if (map->pMethods != nullptr) {
+                    map->pMethods->xClose(map);
+                }
+                throw sqlite::exception(errorcode, "Unable to open the page map of " + name);
+            }
+            return map;
+        }
+
+        void set_page_size(const uint32_t page_size)
+        {
+            m_page_size = page_size;
+            m_packed.resize(page_size);
+            m_stored.resize(page_size);
+            m_page.resize(page_size);
+        }
+
+        // Reads the whole page map and checks it against the data file, the caller holds the mutex.
+        int load(sqlite3_file* data)
+        {
+            sqlite3_int64 size = 0;
+            int errorcode = m_map->pMethods->xFileSize(m_map, &size);
+            if (errorcode != SQLITE_OK) {
+                return errorcode;
+            }
+            m_slots.clear();
+            m_cache.clear();
+            m_cache_index.clear();
+            m_end = 0;
+            m_generation = 0;
+            m_header_dirty = false;
+            m_dirty_from = SIZE_MAX;
+            m_dirty_to = 0;
+            if (size == 0) {
+                return SQLITE_OK;
+            }
+
+            unsigned char header[header_size];
+            errorcode = m_map->pMethods->xRead(m_map, header, static_cast<int>(header_size), 0);
+            if (errorcode != SQLITE_OK) {
+                return errorcode == SQLITE_IOERR_SHORT_READ ? SQLITE_CORRUPT : errorcode;
+            }
+            if (std::memcmp(header, pagemap_magic, sizeof(pagemap_magic)) != 0) {
+                return SQLITE_NOTADB;
+            }
+            if (load32(header + 8) != m_codec->id()) {
+                return SQLITE_CANTOPEN;
+            }
+            const uint32_t page_size = load32(header + 12);
+            const uint64_t pages = load64(header + 16);
+            if ((page_size != 0 && !valid_page_size(page_size)) || static_cast<uint64_t>(size) < header_size + pages * entry_size) {
+                return SQLITE_CORRUPT;
+            }
+            if (page_size != 0) {
+                set_page_size(page_size);
+            }
+            m_generation = load64(header + 24);
+
+            std::vector<unsigned char> entries(static_cast<std::size_t>(pages) * entry_size);
+            for (std::size_t first = 0; first < pages; first += entries_per_write) {
+                const std::size_t count = std::min<std::size_t>(static_cast<std::size_t>(pages) - first, entries_per_write);
+                errorcode = m_map->pMethods->xRead(m_map, entries.data() + first * entry_size, static_cast<int>(count * entry_size),
+                                                   static_cast<sqlite3_int64>(header_size + first * entry_size));
+                if (errorcode != SQLITE_OK) {
+                    return errorcode == SQLITE_IOERR_SHORT_READ ? SQLITE_CORRUPT : errorcode;
+                }
+            }
+            // Pages are written before the map, so a data file size read after the map covers every page in it.
+            sqlite3_int64 data_size = 0;
+            errorcode = data->pMethods->xFileSize(data, &data_size);
+            if (errorcode != SQLITE_OK) {
+                return errorcode;
+            }
+            m_slots.resize(static_cast<std::size_t>(pages));
+            for (std::size_t page = 0; page < m_slots.size(); ++page) {
+                const unsigned char* entry = entries.data() + page * entry_size;
+                slot& stored = m_slots[page];
+                stored.offset = load64(entry);
+                stored.size = load32(entry + 8);
+                stored.capacity = load32(entry + 12);
+                if (stored.size > m_page_size || stored.size > stored.capacity ||
+                    (stored.size != 0 && stored.offset + stored.size > static_cast<uint64_t>(data_size))) {
+                    return SQLITE_CORRUPT;
+                }
+                m_end = std::max(m_end, stored.offset + stored.capacity);
+            }
+            return SQLITE_OK;
+        }
+
+        // Points plain at the decompressed page, valid until the next call. The caller holds the mutex.
+        int page_of(sqlite3_file* data, const std::size_t page, const char*& plain)
+        {
+            const auto cached = m_cache_index.find(page);
+            if (cached != m_cache_index.end()) {
+                m_cache.splice(m_cache.begin(), m_cache, cached->second);
+                plain = cached->second->second.data();
+                return SQLITE_OK;
+            }
+
+            const slot& stored = m_slots[page];
+            if (stored.size == 0) {
+                std::fill(m_page.begin(), m_page.end(), 0);
+            } else {
+                const int errorcode = data->pMethods->xRead(data, m_stored.data(), static_cast<int>(stored.size), static_cast<sqlite3_int64>(stored.offset));
+                if (errorcode != SQLITE_OK) {
+                    return errorcode == SQLITE_IOERR_SHORT_READ ? SQLITE_CORRUPT : errorcode;
+                }
+                if (stored.size == m_page_size) {
+                    std::copy(m_stored.begin(), m_stored.end(), m_page.begin());
+                } else if (!m_codec->decompress(m_stored.data(), stored.size, m_page.data(), m_page_size)) {
+                    return SQLITE_CORRUPT;
+                }
+            }
+            plain = remember(page, m_page.data());
+            return SQLITE_OK;
+        }
+
+        // Compresses a page into its slot, or into a new one at the end of the file if it outgrew it.
+        int store(sqlite3_file* data, const std::size_t page, const char* plain)
+        {
+            const std::size_t packed = m_codec->compress(plain, m_page_size, m_packed.data(), m_page_size - 1);
+            const uint32_t size = packed > 0 && packed < m_page_size ? static_cast<uint32_t>(packed) : m_page_size;
+            const char* bytes = size < m_page_size ? m_packed.data() : plain;
+
+            if (page >= m_slots.size()) {
+                m_dirty_from = std::min(m_dirty_from, m_slots.size());
+                m_slots.resize(page + 1);
+                m_header_dirty = true;
+            }
+            slot target = m_slots[page];
+            if (size > target.capacity) {
+                target.offset = m_end;
+                target.capacity = std::min((size + slot_granularity - 1) / slot_granularity * slot_granularity, m_page_size);
+            }
+            const int errorcode = data->pMethods->xWrite(data, bytes, static_cast<int>(size), static_cast<sqlite3_int64>(target.offset));
+            if (errorcode != SQLITE_OK) {
+                return errorcode;
+            }
+            target.size = size;
+            m_slots[page] = target;
+            m_end = std::max(m_end, target.offset + target.capacity);
+            m_dirty_from = std::min(m_dirty_from, page);
+            m_dirty_to = std::max(m_dirty_to, page + 1);
+            remember(page, plain);
+            return SQLITE_OK;
+        }
+
+        // Puts a page into the cache, returns where it is kept.
+        const char* remember(const std::size_t page, const char* plain)
+        {
+            if (m_cache_pages == 0) {
+                return plain;
+            }
+            const auto cached = m_cache_index.find(page);
+            if (cached != m_cache_index.end()) {
+                m_cache.splice(m_cache.begin(), m_cache, cached->second);
+            } else if (m_cache.size() < m_cache_pages) {
+                m_cache.emplace_front(page, std::vector<char>(m_page_size));
+            } else {
+                // Reuse the buffer of the least recently used page.
+                m_cache_index.erase(m_cache.back().first);
+                m_cache.splice(m_cache.begin(), m_cache, std::prev(m_cache.end()));
+                m_cache.front().first = page;
+            }
+            m_cache_index[page] = m_cache.begin();
+            std::vector<char>& buffer = m_cache.front().second;
+            std::copy(plain, plain + m_page_size, buffer.begin());
+            return buffer.data();
+        }
+
+        void close_map() noexcept
+        {
+            if (m_map != nullptr) {
+                m_map->pMethods->xClose(m_map);
+                m_map = nullptr;
+            }
+        }
+
+        sqlite3_vfs* m_base;
+        std::shared_ptr<const page_codec> m_codec;
+        const std::size_t m_cache_pages;
+        const std::string m_map_name;
+        std::unique_ptr<char[]> m_map_storage;
+        sqlite3_file* m_map = nullptr;
+        bool m_writable = false;
+        std::atomic<bool> m_compressed{false};
+
+        std::mutex m_mutex;
+        uint32_t m_page_size = 0;
+        std::vector<slot> m_slots;
+        uint64_t m_end = 0;
+        uint64_t m_generation = 0;
+        bool m_header_dirty = false;
+        std::size_t m_dirty_from = SIZE_MAX;
+        std::size_t m_dirty_to = 0;
+
+        std::vector<char> m_packed;
+        std::vector<char> m_stored;
+        std::vector<char> m_page;
+        std::vector<char> m_patch;
+        std::list<std::pair<std::size_t, std::vector<char>>> m_cache;
+        std::unordered_map<std::size_t, std::list<std::pair<std::size_t, std::vector<char>>>::iterator> m_cache_index;
+    };
+
+    class compressed_vfs::file : public vfs_file
+    {
+        public:
+        file(sqlite3_file* base, const file_kind kind, compressed_vfs& vfs, std::string name, std::shared_ptr<database> stored) noexcept :
+            vfs_file(base, kind),
+            m_vfs(vfs),
+            m_name(std::move(name)),
+            m_database(std::move(stored))
+        {}
+
+        int close() override
+        {
+            if (m_database == nullptr) {
+                return vfs_file::close();
+            }
+            int errorcode = m_database->compressed() ? m_database->flush(0) : SQLITE_OK;
+            const int closed = vfs_file::close();
+            if (errorcode == SQLITE_OK) {
+                errorcode = closed;
+            }
+            m_database.reset();
+            m_vfs.detach(m_name);
+            return errorcode;
+        }
+
+        int read(void* buffer, const int amount, const int64_t offset) override
+        {
+            return compressed() ? m_database->read(base(), buffer, amount, offset) : vfs_file::read(buffer, amount, offset);
+        }
+
+        int write(const void* buffer, const int amount, const int64_t offset) override
+        {
+            return compressed() ? m_database->write(base(), buffer, amount, offset) : vfs_file::write(buffer, amount, offset);
+        }
+
+        int truncate(const int64_t size) override
+        {
+            return compressed() ? m_database->truncate(size) : vfs_file::truncate(size);
+        }
+
+        // The pages are on the disk before the map pointing at them.
+        int sync(const int flags) override
+        {
+            const int errorcode = vfs_file::sync(flags);
+            if (errorcode != SQLITE_OK || !compressed()) {
+                return errorcode;
+            }
+            return m_database->flush(flags);
+        }
+
+        int file_size(int64_t* size) override
+        {
+            if (!compressed()) {
+                return vfs_file::file_size(size);
+            }
+            *size = m_database->size();
+            return SQLITE_OK;
+        }
+
+        // A connection starting a transaction sees the pages other processes wrote.
+        int lock(const int level) override
+        {
+            const int errorcode = vfs_file::lock(level);
+            if (errorcode != SQLITE_OK || level != SQLITE_LOCK_SHARED || !compressed()) {
+                return errorcode;
+            }
+            const int refreshed = m_database->refresh(base());
+            if (refreshed != SQLITE_OK) {
+                vfs_file::unlock(SQLITE_LOCK_NONE);
+            }
+            return refreshed;
+        }
+
+        // The map is written before other processes can read the pages, even without syncs.
+        int unlock(const int level) override
+        {
+            const int errorcode = compressed() ? m_database->flush(0) : SQLITE_OK;
+            const int unlocked = vfs_file::unlock(level);
+            return errorcode != SQLITE_OK ? errorcode : unlocked;
+        }
+
+        int file_control(const int operation, void* argument) override
+        {
+            // The size of the compressed file is unknown in advance.
+            if (operation == SQLITE_FCNTL_SIZE_HINT && compressed()) {
+                return SQLITE_OK;
+            }
+            // Sent before a commit finalizes its journal, in place of xSync with synchronous=OFF.
+            if (operation == SQLITE_FCNTL_SYNC && compressed()) {
+                const int errorcode = m_database->flush(0);
+                if (errorcode != SQLITE_OK) {
+                    return errorcode;
+                }
+            }
+            return vfs_file::file_control(operation, argument);
+        }
+
+        int device_characteristics() override
+        {
+            const int characteristics = vfs_file::device_characteristics();
+            // Compressed pages are not written atomically.
+            return compressed() ? characteristics & (SQLITE_IOCAP_POWERSAFE_OVERWRITE | SQLITE_IOCAP_IMMUTABLE) : characteristics;
+        }
+
+        // In WAL mode a transaction starts with locks on the WAL index instead.
+        int shm_lock(const int offset, const int count, const int flags) override
+        {
+            if (!compressed()) {
+                return vfs_file::shm_lock(offset, count, flags);
+            }
+            if (flags & SQLITE_SHM_UNLOCK) {
+                const int errorcode = m_database->flush(0);
+                const int unlocked = vfs_file::shm_lock(offset, count, flags);
+                return errorcode != SQLITE_OK ? errorcode : unlocked;
+            }
+            const int errorcode = vfs_file::shm_lock(offset, count, flags);
+            if (errorcode != SQLITE_OK) {
+                return errorcode;
+            }
+            const int refreshed = m_database->refresh(base());
+            if (refreshed != SQLITE_OK) {
+                vfs_file::shm_lock(offset, count, (flags & ~SQLITE_SHM_LOCK) | SQLITE_SHM_UNLOCK);
+            }
+            return refreshed;
+        }
+
+        int fetch(const int64_t offset, const int amount, void** pointer) override
+        {
+            if (!compressed()) {
+                return vfs_file::fetch(offset, amount, pointer);
+            }
+            *pointer = nullptr;
+            return SQLITE_OK;
+        }
+
+        private:
+        bool compressed() const noexcept
+        {
+            return m_database != nullptr && m_database->compressed();
+        }
+
+        compressed_vfs& m_vfs;
+        const std::string m_name;
+        std::shared_ptr<database> m_database;
+    };
+
+    compressed_vfs::compressed_vfs(std::string name, std::shared_ptr<const page_codec> codec, const std::size_t cache_pages, const std::string& base) :
+        vfs_shim(std::move(name), base),
+        m_codec(codec != nullptr ? std::move(codec) : std::make_shared<lz_codec>()),
+        m_cache_pages(cache_pages)
+    {}
+
+    compressed_vfs::~compressed_vfs() = default;
+
+    const page_codec& compressed_vfs::codec() const noexcept
+    {
+        return *m_codec;
+    }
+
+    std::unique_ptr<vfs_file> compressed_vfs::wrap(sqlite3_file* base, const char* name, const int flags)
+    {
+        const file_kind kind = file_kind_of(flags);
+        if (kind == file_kind::main_database && name != nullptr) {
+            std::shared_ptr<database> stored = attach(name, base, flags);
+            try {
+                return std::unique_ptr<vfs_file>(new file(base, kind, *this, name, std::move(stored)));
+            } catch (...) {
+                detach(name);
+                throw;
+            }
+        }
+        return std::unique_ptr<vfs_file>(new file(base, kind, *this, std::string(), nullptr));
+    }
+
+    std::shared_ptr<compressed_vfs::database> compressed_vfs::attach(const std::string& name, sqlite3_file* data, const int flags)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::pair<std::shared_ptr<database>, int>& entry = m_databases[name];
+        if (entry.first == nullptr) {
+            try {
+                entry.first = std::make_shared<database>(vfs_shim::base(), name, data, flags, m_codec, m_cache_pages);
+            } catch (...) {
+                m_databases.erase(name);
+                throw;
+            }
+        } else if (flags & SQLITE_OPEN_READWRITE) {
+            entry.first->make_writable(data, name);
+        }
+        ++entry.second;
+        return entry.first;
+    }
+
+    void compressed_vfs::detach(const std::string& name)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const auto found = m_databases.find(name);
+        if (found != m_databases.end() && --found->second.second == 0) {
+            m_databases.erase(found);
+        }
+    }
+}
@@ -0,0 +1,119 @@
+/** @file */
+
+#ifndef __SQLITEXX_SQLITE_COMPRESSEDVFS_H__
+#define __SQLITEXX_SQLITE_COMPRESSEDVFS_H__
+
+#include "VfsShim.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace sqlite
+{
+    /**
+     * Compresses the pages of a database stored by sqlite::compressed_vfs.
+     * A codec is used from several threads at once, so its methods must not change shared state.
+     */
+    class page_codec
+    {
+        public:
+        virtual ~page_codec() = default;
+
+        /** Identifies the format, it is stored with the database so a database is never read with another codec.
+         */
+        virtual uint32_t id() const noexcept = 0;
+
+        /** Compresses a page.
+         * @param[in]  input    the page
+         * @param[in]  size     the size of the page
+         * @param[out] output   the compressed page
+         * @param[in]  capacity the room in output, smaller than size
+         * @returns the size of the compressed page, 0 if it does not fit into capacity
+         */
+        virtual std::size_t compress(const char* input, std::size_t size, char* output, std::size_t capacity) const = 0;
+
+        /** Decompresses a page.
+         * @param[in]  input       the compressed page
+         * @param[in]  size        the size of the compressed page
+         * @param[out] output      the page
+         * @param[in]  output_size the size of the page
+         * @returns false if input is not a compressed page of output_size bytes
+         */
+        virtual bool decompress(const char* input, std::size_t size, char* output, std::size_t output_size) const = 0;
+    };
+
+    /**
+     * A fast LZ77 codec in the style of LZ4 that needs no external library.
+     * Each sequence is a token byte holding the lengths of a literal run and a match, the literals,
+     * and a 16-bit distance back to the match, which is found through a hash of 4-byte prefixes.
+     */
+    class lz_codec : public page_codec
+    {
+        public:
+        uint32_t id() const noexcept override;
+
+        std::size_t compress(const char* input, std::size_t size, char* output, std::size_t capacity) const override;
+
+        bool decompress(const char* input, std::size_t size, char* output, std::size_t output_size) const override;
+    };
+
+    /**
+     * A VFS layered over the default VFS that stores the pages of main databases compressed.
+     * Each page is compressed on its own into a slot of the database file. A rewritten page stays in its slot
+     * if it still fits and moves to the end of the file otherwise; the space it leaves is not reclaimed,
+     * VACUUM INTO a new database compacts it.
+     * The slots are listed in a page map kept in the sidecar file "<database>-pagemap". The map is written
+     * after the pages and before SQLite finalizes the journal of a commit, even with synchronous=OFF, and synced
+     * with the pages, so a crash is repaired by SQLite's journal or WAL as usual.
+     * The first writable connection reopens a map that read-only connections opened for writing.
+     * Other processes notice a changed map when they start a transaction. A map next to an empty database file
+     * is left from a deleted database and is discarded, a map pointing past the end of the file is corrupt.
+     * Decompressed pages are kept in a cache shared by the connections of the process.
+     * Journals, WAL files and temporary files are not compressed, and an existing database without a page map
+     * is read and written uncompressed. The page size is fixed when the first page is written.
+     * Memory-mapped I/O is not used. The VFS must outlive the connections using it.
+     */
+    class compressed_vfs : public vfs_shim
+    {
+        public:
+
+        /** Registers the VFS.
+         * @param[in] name        the name of the VFS
+         * @param[in] codec       the codec compressing the pages, lz_codec when null
+         * @param[in] cache_pages the number of decompressed pages kept for each database
+         * @param[in] base        the name of the underlying VFS, the default VFS when empty
+         * @throws SQLiteXXException if the underlying VFS does not exist or the name is taken
+         * @throws sqlite::exception if the VFS could not be registered
+         */
+        explicit compressed_vfs(std::string name = "sqlitexx-compressed", std::shared_ptr<const page_codec> codec = nullptr,
+                                std::size_t cache_pages = 256, const std::string& base = std::string());
+
+        ~compressed_vfs() override;
+
+        /** Returns the codec compressing the pages.
+         */
+        const page_codec& codec() const noexcept;
+
+        protected:
+        std::unique_ptr<vfs_file> wrap(sqlite3_file* file, const char* name, int flags) override;
+
+        private:
+        class file;
+        class database;
+
+        std::shared_ptr<database> attach(const std::string& name, sqlite3_file* file, int flags);
+        void detach(const std::string& name);
+
+        std::shared_ptr<const page_codec> m_codec;
+        std::size_t m_cache_pages;
+
+        std::mutex m_mutex;
+        std::map<std::string, std::pair<std::shared_ptr<database>, int>> m_databases;
+    };
+}
+
+#endif
@@ -0,0 +1,34 @@
+#include "Config.h"
+#include "Exception.h"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace sqlite
+{
+    int64_t max_mmap_size() noexcept
+    {
+        static const char kOption[] = "MAX_MMAP_SIZE=";
+        const std::size_t optionLength = sizeof(kOption) - 1;
+
+        for (int i = 0; const char* option = sqlite3_compileoption_get(i); ++i) {
+            if (std::strncmp(option, kOption, optionLength) == 0) {
+                // The value is written the way it was given to the compiler, often in hex.
+                return std::strtoll(option + optionLength, nullptr, 0);
+            }
+        }
+
+        // Libraries built without compile option diagnostics do not list it,
+        // assume the SQLite default for platforms that support memory-mapped I/O.
+        return 0x7fff0000;
+    }
+
+    void configure_mmap_size(const int64_t default_size, const int64_t max_size)
+    {
+        const int errorcode = sqlite3_config(
+            SQLITE_CONFIG_MMAP_SIZE,
+            static_cast<sqlite3_int64>(default_size),
+            static_cast<sqlite3_int64>(max_size));
+        throw_error_code(errorcode, "The mmap size defaults can only be configured before SQLite is initialized");
+    }
+}
@@ -0,0 +1,32 @@
+/** @file */
+
+#ifndef __SQLITEXX_SQLITE_CONFIG_H__
+#define __SQLITEXX_SQLITE_CONFIG_H__
+
+#include <sqlite3.h>
+
+#include <cstdint>
+
+namespace sqlite
+{
+    /** Returns the largest memory-mapped I/O size the linked SQLite library allows.
+     * This is the SQLITE_MAX_MMAP_SIZE compile-time option of the library, which is
+     * not visible in sqlite3.h and is therefore read from the library's compile options.
+     * Requests for a larger mmap_size are silently reduced to this value.
+     * @returns The maximum mmap size in bytes, 0 if memory-mapped I/O is disabled in the library.
+     */
+    int64_t max_mmap_size() noexcept;
+
+    /** Sets the process wide memory-mapped I/O defaults, aka "SQLITE_CONFIG_MMAP_SIZE".
+     * New database connections start with default_size as their mmap_size, and no connection
+     * may raise its mmap_size above max_size. Both values are further limited by max_mmap_size().
+     * This must be called before the SQLite library is initialized, which happens implicitly
+     * when the first database connection is opened.
+     * @param[in] default_size the default mmap size in bytes for new database connections
+     * @param[in] max_size     the largest mmap size in bytes a database connection may use
+     * @throws sqlite::exception if the library has already been initialized
+     */
+    void configure_mmap_size(const int64_t default_size, const int64_t max_size);
+}
+
+#endif
@@ -0,0 +1,459 @@
+#include "CsvTable.h"
+
+#include "Exception.h"
+#include "Utilities.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <thread>
+
+namespace sqlite
+{
+    namespace
+    {
+        // Below this size per thread starting threads costs more than scanning.
+        const std::size_t minimum_index_chunk = 64 * 1024;
+
+        std::string_view trim(std::string_view text) noexcept
+        {
+            const std::size_t first = text.find_first_not_of(" \t\r\n");
+            if (first == std::string_view::npos) {
+                return std::string_view();
+            }
+            return text.substr(first, text.find_last_not_of(" \t\r\n") - first + 1);
+        }
+
+        // Removes SQL quotes from a module argument, undoubling the quotes inside.
+        std::string unquote(std::string_view text)
+        {
+            text = trim(text);
+            if (text.size() < 2 || (text.front() != '\'' && text.front() != '"') || text.back() != text.front()) {
+                return std::string(text);
+            }
+
+            const char quote = text.front();
+            std::string result;
+            for (std::size_t i = 1; i + 1 < text.size(); ++i) {
+                result += text[i];
+                if (text[i] == quote && text[i + 1] == quote) {
+                    ++i;
+                }
+            }
+            return result;
+        }
+
+        bool parse_boolean(const std::string& key, const std::string& text)
+        {
+            for (const char* yes : {"yes", "true", "on", "1"}) {
+                if (sqlite3_stricmp(text.c_str(), yes) == 0) {
+                    return true;
+                }
+            }
+            for (const char* no : {"no", "false", "off", "0"}) {
+                if (sqlite3_stricmp(text.c_str(), no) == 0) {
+                    return false;
+                }
+            }
+            throw SQLiteXXException("csv: " + key + " has to be yes or no, not " + text);
+        }
+
+        // Splits off the field starting at position within a record ending at end and moves position past its separator.
+        // Returns false when the field was the last one of the record.
+        bool next_field(const char* data, std::size_t& position, const std::size_t end, const char*& text, std::size_t& size, bool& escaped) noexcept
+        {
+            std::size_t after = position;
+            escaped = false;
+            if (position < end && data[position] == '"') {
+                const std::size_t begin = position + 1;
+                std::size_t close = end;
+                after = end;
+                std::size_t search = begin;
+                while (search < end) {
+                    const char* quote = static_cast<const char*>(std::memchr(data + search, '"', end - search));
+                    if (quote == nullptr) {
+                        break;
+                    }
+                    const std::size_t found = static_cast<std::size_t>(quote - data);
+                    if (found + 1 < end && data[found + 1] == '"') {
+                        escaped = true;
+                        search = found + 2;
+                        continue;
+                    }
+                    close = found;
+                    after = found + 1;
+                    break;
+                }
+                text = data + begin;
+                size = close - begin;
+            } else {
+                text = data + position;
+                const char* comma = static_cast<const char*>(std::memchr(data + position, ',', end - position));
+                size = (comma != nullptr ? static_cast<std::size_t>(comma - data) : end) - position;
+                after = position + size;
+            }
+
+            // Anything between a closing quote and the separator is ignored.
+            const char* comma = after < end ? static_cast<const char*>(std::memchr(data + after, ',', end - after)) : nullptr;
+            if (comma == nullptr) {
+                position = end;
+                return false;
+            }
+            position = static_cast<std::size_t>(comma - data) + 1;
+            return true;
+        }
+
+        void unescape(const char* text, const std::size_t size, std::string& result)
+        {
+            result.clear();
+            for (std::size_t i = 0; i < size; ++i) {
+                result += text[i];
+                if (text[i] == '"' && i + 1 < size && text[i + 1] == '"') {
+                    ++i;
+                }
+            }
+        }
+
+        std::size_t trimmed_end(const char* data, const std::size_t start, const std::size_t end) noexcept
+        {
+            return end > start && data[end - 1] == '\r' ? end - 1 : end;
+        }
+
+        std::vector<std::string> split_record(const char* data, std::size_t position, const std::size_t end)
+        {
+            std::vector<std::string> fields;
+            const char* text;
+            std::size_t size;
+            bool escaped;
+            bool more = true;
+            while (more) {
+                more = next_field(data, position, end, text, size, escaped);
+                fields.emplace_back();
+                if (escaped) {
+                    unescape(text, size, fields.back());
+                } else {
+                    fields.back().assign(text, size);
+                }
+            }
+            return fields;
+        }
+    }
+
+    std::size_t csv_record_end(const std::string_view data, std::size_t start) noexcept
+    {
+        const char* const bytes = data.data();
+        const std::size_t size = data.size();
+        while (start < size) {
+            const char* newline = static_cast<const char*>(std::memchr(bytes + start, '\n', size - start));
+            const std::size_t line_end = newline != nullptr ? static_cast<std::size_t>(newline - bytes) : size;
+            const char* quote = static_cast<const char*>(std::memchr(bytes + start, '"', line_end - start));
+            if (quote == nullptr) {
+                return line_end;
+            }
+
+            // Skip the quoted part, an escaped quote closes and reopens it.
+            const char* close = static_cast<const char*>(std::memchr(quote + 1, '"', size - static_cast<std::size_t>(quote + 1 - bytes)));
+            if (close == nullptr) {
+                return size;
+            }
+            start = static_cast<std::size_t>(close - bytes) + 1;
+        }
+        return size;
+    }
+
+    csv_table::csv_table(const std::vector<std::string>& arguments) :
+        m_first_record(0),
+        m_threads(std::max(1u, std::thread::hardware_concurrency()))
+    {
+        std::string filename;
+        bool header = true;
+        for (const std::string& argument : arguments) {
+            const std::string_view text = trim(argument);
+            const std::size_t equals = text.find('=');
+            if (text.empty()) {
+                continue;
+            } else if (text.front() == '\'' || text.front() == '"' || equals == std::string_view::npos) {
+                if (!filename.empty()) {
+                    throw SQLiteXXException("csv: unexpected argument " + argument);
+                }
+                filename = unquote(text);
+                continue;
+            }
+
+            const std::string key(trim(text.substr(0, equals)));
+            const std::string value = unquote(text.substr(equals + 1));
+            if (key == "filename") {
+                filename = value;
+            } else if (key == "header") {
+                header = parse_boolean(key, value);
+            } else if (key == "threads") {
+                const long threads = std::strtol(value.c_str(), nullptr, 10);
+                if (threads < 1) {
+                    throw SQLiteXXException("csv: threads has to be a positive number, not " + value);
+                }
+                m_threads = static_cast<unsigned>(threads);
+            } else {
+                throw SQLiteXXException("csv: unknown argument " + key);
+            }
+        }
+
+        if (filename.empty()) {
+            throw SQLiteXXException("csv: no filename given");
+        }
+        m_file = mapped_file(filename);
+
+        const char* data = m_file.data();
+        const std::size_t size = m_file.size();
+        if (size >= 3 && std::memcmp(data, "\xEF\xBB\xBF", 3) == 0) {
+            m_first_record = 3;
+        }
+        if (m_first_record >= size) {
+            throw SQLiteXXException("csv: " + filename + " is empty");
+        }
+
+        const std::size_t end = csv_record_end(m_file.view(), m_first_record);
+        std::vector<std::string> fields = split_record(data, m_first_record, trimmed_end(data, m_first_record, end));
+        for (std::size_t i = 0; i < fields.size(); ++i) {
+            const std::string name = header ? std::string(trim(fields[i])) : std::string();
+            m_columns.push_back(name.empty() ? "c" + std::to_string(i + 1) : name);
+        }
+        if (header) {
+            m_first_record = end + 1;
+        }
+    }
+
+    std::string csv_table::schema() const
+    {
+        std::string sql = "CREATE TABLE x(";
+        for (std::size_t i = 0; i < m_columns.size(); ++i) {
+            sql += (i == 0 ? "" : ", ") + quote_identifier(m_columns[i]) + " TEXT";
+        }
+        return sql + ")";
+    }
+
+    void csv_table::best_index(index_info& info) const
+    {
+        for (int i = 0; i < info.constraint_count(); ++i) {
+            const index_info::constraint term = info.get_constraint(i);
+            if (term.usable && term.column == -1 && term.op == constraint_op::eq) {
+                info.use_constraint(i, 0);
+                info.set_index_number(1);
+                info.set_estimated_cost(10);
+                info.set_estimated_rows(1);
+                info.set_unique(true);
+                return;
+            }
+        }
+
+        // Assume records of about 64 bytes.
+        info.set_index_number(0);
+        info.set_estimated_cost(static_cast<double>(m_file.size()) / 64 + 10);
+        info.set_estimated_rows(static_cast<int64_t>(m_file.size() / 64 + 1));
+    }
+
+    csv_table::cursor csv_table::open() const
+    {
+        return cursor(*this);
+    }
+
+    const std::vector<std::size_t>& csv_table::record_offsets() const
+    {
+        std::call_once(m_indexed, [this]() {
+            build_index();
+        });
+        return m_offsets;
+    }
+
+    const std::vector<std::string>& csv_table::columns() const noexcept
+    {
+        return m_columns;
+    }
+
+    void csv_table::build_index() const
+    {
+        // Every thread scans one slice and sorts its newlines by the parity of the quotes before them in the slice.
+        // Once the quote parity at the start of each slice is known, the newlines with the same parity end records
+        // and the others are inside quoted fields.
+        struct slice {
+            std::vector<std::size_t> newlines[2];
+            bool odd = false;
+        };
+
+        const char* data = m_file.data();
+        const std::size_t size = m_file.size();
+        const std::size_t begin = std::min(m_first_record, size);
+        const std::size_t length = size - begin;
+        const std::size_t count = std::max<std::size_t>(1, std::min<std::size_t>(m_threads, length / minimum_index_chunk));
+
+        std::vector<slice> slices(count);
+        std::vector<std::exception_ptr> errors(count);
+        auto scan = [&](const std::size_t index) {
+            try {
+                const std::size_t from = begin + length * index / count;
+                const std::size_t to = begin + length * (index + 1) / count;
+                slice& result = slices[index];
+                const char* const end = data + to;
+                auto find = [end](const char* from, const char c) {
+                    const char* found = static_cast<const char*>(std::memchr(from, c, static_cast<std::size_t>(end - from)));
+                    return found != nullptr ? found : end;
+                };
+
+                // Both characters are rare compared to the others, so jump between them with memchr.
+                unsigned parity = 0;
+                const char* quote = find(data + from, '"');
+                const char* newline = find(data + from, '\n');
+                while (newline != end || quote != end) {
+                    if (newline < quote) {
+                        result.newlines[parity].push_back(static_cast<std::size_t>(newline - data));
+                        newline = find(newline + 1, '\n');
+                    } else {
+                        parity ^= 1;
+                        quote = find(quote + 1, '"');
+                    }
+                }
+                result.odd = parity != 0;
+            } catch (...) {
+                errors[index] = std::current_exception();
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (std::size_t i = 1; i < count; ++i) {
+            threads.emplace_back(scan, i);
+        }
+        scan(0);
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        for (const std::exception_ptr& error : errors) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+
+        std::vector<std::size_t> offsets;
+        if (begin < size) {
+            offsets.push_back(begin);
+        }
+        unsigned parity = 0;
+        for (const slice& result : slices) {
+            for (const std::size_t newline : result.newlines[parity]) {
+                if (newline + 1 < size) {
+                    offsets.push_back(newline + 1);
+                }
+            }
+            parity ^= result.odd ? 1 : 0;
+        }
+        m_offsets = std::move(offsets);
+    }
+
+    csv_table::cursor::cursor(const csv_table& table) noexcept :
+        m_table(&table),
+        m_end(0),
+        m_next(0),
+        m_rowid(0),
+        m_single(false),
+        m_eof(true),
+        m_parsed(0),
+        m_complete(true)
+    {}
+
+    void csv_table::cursor::filter(const int index_number, std::string_view, value_span arguments)
+    {
+        m_eof = true;
+        m_single = index_number == 1;
+        if (!m_single) {
+            m_rowid = 1;
+            if (m_table->m_first_record < m_table->m_file.size()) {
+                read_record(m_table->m_first_record);
+                m_eof = false;
+            }
+            return;
+        }
+
+        sqlite3_value* argument = arguments[0].handle();
+        int64_t rowid;
+        switch (sqlite3_value_numeric_type(argument)) {
+            case SQLITE_INTEGER:
+                rowid = sqlite3_value_int64(argument);
+                break;
+            case SQLITE_FLOAT:
+                rowid = static_cast<int64_t>(sqlite3_value_double(argument));
+                if (static_cast<double>(rowid) != sqlite3_value_double(argument)) {
+                    return;
+                }
+                break;
+            default:
+                return;
+        }
+
+        const std::vector<std::size_t>& offsets = m_table->record_offsets();
+        if (rowid < 1 || static_cast<uint64_t>(rowid) > offsets.size()) {
+            return;
+        }
+        m_rowid = rowid;
+        read_record(offsets[static_cast<std::size_t>(rowid - 1)]);
+        m_eof = false;
+    }
+
+    void csv_table::cursor::next()
+    {
+        if (m_single || m_next >= m_table->m_file.size()) {
+            m_eof = true;
+            return;
+        }
+        read_record(m_next);
+        ++m_rowid;
+    }
+
+    bool csv_table::cursor::eof() const noexcept
+    {
+        return m_eof;
+    }
+
+    void csv_table::cursor::column(sqlite3_context* context, const int column) const
+    {
+        const std::size_t index = static_cast<std::size_t>(column);
+        while (m_fields.size() <= index && !m_complete) {
+            parse_field();
+        }
+        if (index >= m_fields.size()) {
+            sqlite3_result_null(context);
+            return;
+        }
+
+        const field& value = m_fields[index];
+        if (value.escaped) {
+            unescape(value.data, value.size, m_buffer);
+            sqlite3_result_text64(context, m_buffer.data(), m_buffer.size(), SQLITE_TRANSIENT, SQLITE_UTF8);
+        } else if (value.size == 0) {
+            sqlite3_result_text(context, "", 0, SQLITE_STATIC);
+        } else {
+            // The mapping lives as long as the table, which outlives every statement reading from it.
+            sqlite3_result_text64(context, value.data, value.size, SQLITE_STATIC, SQLITE_UTF8);
+        }
+    }
+
+    int64_t csv_table::cursor::rowid() const noexcept
+    {
+        return m_rowid;
+    }
+
+    void csv_table::cursor::read_record(const std::size_t start)
+    {
+        const std::size_t end = csv_record_end(m_table->m_file.view(), start);
+        m_next = end + 1;
+        m_end = trimmed_end(m_table->m_file.data(), start, end);
+        m_parsed = start;
+        m_complete = false;
+        m_fields.clear();
+    }
+
+    void csv_table::cursor::parse_field() const
+    {
+        field value;
+        m_complete = !next_field(m_table->m_file.data(), m_parsed, m_end, value.data, value.size, value.escaped);
+        m_fields.push_back(value);
+    }
+}
@@ -0,0 +1,120 @@
+/** @file */
+
+#ifndef __SQLITEXX_SQLITE_CSVTABLE_H__
+#define __SQLITEXX_SQLITE_CSVTABLE_H__
+
+#include "MappedFile.h"
+#include "Value.h"
+#include "VirtualTable.h"
+
+#include <sqlite3.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sqlite
+{
+    /**
+     * A read-only virtual table over a memory-mapped RFC 4180 CSV file.
+     * Tables are created with CREATE VIRTUAL TABLE name USING csv('file.csv', header=yes, threads=4), where
+     * - the first argument, or filename=..., is the path of the file
+     * - header=yes|no tells if the first line holds the column names, yes by default, otherwise they are c1, c2, ...
+     * - threads=N is the number of threads used to index the file, all cores by default
+     *
+     * Full scans parse the mapping front to back and only split a record into fields up to the last column the query reads.
+     * Fields are returned as TEXT pointing into the mapping, only quoted fields with escaped quotes are copied.
+     * The rowid is the number of the record, lookups by rowid use an index of the record offsets that is built in parallel
+     * the first time it is needed. The file must not change while the table exists.
+     */
+    class csv_table
+    {
+        public:
+
+        /** Opens the file and reads the columns.
+         * @param[in] arguments the module arguments
+         * @throws SQLiteXXException if an argument is invalid or the file can not be mapped
+         */
+        explicit csv_table(const std::vector<std::string>& arguments);
+
+        std::string schema() const;
+
+        void best_index(index_info& info) const;
+
+        /** Reads the records of the file one after the other.
+         */
+        class cursor
+        {
+            public:
+            explicit cursor(const csv_table& table) noexcept;
+
+            void filter(int index_number, std::string_view index_string, value_span arguments);
+
+            void next();
+
+            bool eof() const noexcept;
+
+            void column(sqlite3_context* context, int column) const;
+
+            int64_t rowid() const noexcept;
+
+            private:
+            struct field {
+                const char* data;
+                std::size_t size;
+                bool escaped;
+            };
+
+            void read_record(std::size_t start);
+
+            void parse_field() const;
+
+            const csv_table* m_table;
+            std::size_t m_end;
+            std::size_t m_next;
+            int64_t m_rowid;
+            bool m_single;
+            bool m_eof;
+
+            mutable std::vector<field> m_fields;
+            mutable std::size_t m_parsed;
+            mutable bool m_complete;
+            mutable std::string m_buffer;
+        };
+
+        cursor open() const;
+
+        /** Returns the offsets of the data records in the file, the header excluded.
+         * The index is built by the first call, splitting the file between the configured number of threads.
+         */
+        const std::vector<std::size_t>& record_offsets() const;
+
+        /** Returns the names of the columns.
+         */
+        const std::vector<std::string>& columns() const noexcept;
+
+        private:
+        void build_index() const;
+
+        mapped_file m_file;
+        std::vector<std::string> m_columns;
+        std::size_t m_first_record;
+        unsigned m_threads;
+
+        mutable std::once_flag m_indexed;
+        mutable std::vector<std::size_t> m_offsets;
+    };
+
+    /** Returns the position of the newline ending the CSV record starting at start, or data.size() for the last record.
+     * Newlines inside quoted fields are part of the record.
+     * @param[in] data  the contents of the file
+     * @param[in] start the offset of the first byte of the record
+     * @returns the offset one past the last byte of the record
+     */
+    std::size_t csv_record_end(std::string_view data, std::size_t start) noexcept;
+}
+
+#endif
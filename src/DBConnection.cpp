@@ -1,9 +1,55 @@
 #include "DBConnection.h"
 
+#include "MemoryVfs.h"
+#include "Utilities.h"
+#include "VectorFunctions.h"
+
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <regex>
+#include <string>
+
 namespace sqlite
 {
     const std::chrono::minutes dbconnection::DEFAULT_TIMEOUT(10);
 
+    const int64_t dbconnection::memory_config::use_default = std::numeric_limits<int64_t>::min();
+
+    namespace
+    {
+        void set_pragma(sqlite3* connection, const char* name, const int64_t value)
+        {
+            const std::string sql = std::string("PRAGMA ") + name + " = " + std::to_string(value);
+            if (SQLITE_OK != sqlite3_exec(connection, sql.c_str(), nullptr, nullptr, nullptr)) {
+                throw_error_code(connection);
+            }
+        }
+
+        int64_t query_pragma(sqlite3* connection, const std::string& sql)
+        {
+            sqlite3_stmt* statement = nullptr;
+            if (SQLITE_OK != sqlite3_prepare_v2(connection, sql.c_str(), -1, &statement, nullptr)) {
+                sqlite3_finalize(statement);
+                throw_error_code(connection);
+            }
+
+            const int result = sqlite3_step(statement);
+            const int64_t value = result == SQLITE_ROW ? sqlite3_column_int64(statement, 0) : 0;
+            sqlite3_finalize(statement);
+            if (result != SQLITE_ROW && result != SQLITE_DONE) {
+                throw_error_code(connection);
+            }
+            return value;
+        }
+
+        void db_status(sqlite3* connection, const int op, int& current, int& highwater, const bool reset)
+        {
+            const int errorcode = sqlite3_db_status(connection, op, &current, &highwater, reset ? 1 : 0);
+            throw_error_code(errorcode, "Unable to read database connection status");
+        }
+    }
+
     dbconnection::dbconnection() noexcept :
         m_handle()
     {}
@@ -35,9 +81,10 @@ namespace sqlite
     dbconnection::dbconnection(
         const std::string& filename,
         openmode mode,
-        const std::chrono::milliseconds timeout)
+        const std::chrono::milliseconds timeout,
+        const std::string& vfs)
     {
-        open(filename, mode);
+        open(filename, mode, vfs);
         sqlite3_busy_timeout(handle(), static_cast<int>(timeout.count()));
     }
 
@@ -49,6 +96,17 @@ namespace sqlite
         sqlite3_busy_timeout(handle(), static_cast<int>(timeout.count()));
     }
 
+    dbconnection::dbconnection(
+        const std::string& filename,
+        const memory_config& config,
+        openmode mode,
+        const std::chrono::milliseconds timeout)
+    {
+        open(filename, mode);
+        configure(config);
+        sqlite3_busy_timeout(handle(), static_cast<int>(timeout.count()));
+    }
+
     dbconnection::dbconnection(
         const std::u16string& filename,
         const std::chrono::milliseconds timeout)
@@ -62,6 +120,11 @@ namespace sqlite
         return dbconnection(":memory:");
     }
 
+    dbconnection dbconnection::shared_memory(const std::string& name, openmode mode, const std::chrono::milliseconds timeout)
+    {
+        return dbconnection(name, mode, timeout, memory_vfs());
+    }
+
     dbconnection dbconnection::wide_memory()
     {
         return dbconnection(u":memory:");
@@ -86,10 +149,10 @@ namespace sqlite
         return m_handle.get();
     }
 
-    void dbconnection::open(const std::string& filename, openmode mode)
+    void dbconnection::open(const std::string& filename, openmode mode, const std::string& vfs)
     {
         sqlite3 *connection;
-        if (SQLITE_OK != sqlite3_open_v2(filename.c_str(), &connection, static_cast<int>(mode), nullptr)) {
+        if (SQLITE_OK != sqlite3_open_v2(filename.c_str(), &connection, static_cast<int>(mode), vfs.empty() ? nullptr : vfs.c_str())) {
             const sqlite::exception exception(connection);
             sqlite3_close(connection);
             throw exception;
@@ -114,4 +177,193 @@ namespace sqlite
     {
         return sqlite3_last_insert_rowid(handle());
     }
+
+    void dbconnection::configure(const memory_config& config)
+    {
+        assert(m_handle);
+
+        const bool hasSlotSize = config.lookaside_slot_size != memory_config::use_default;
+        const bool hasSlotCount = config.lookaside_slot_count != memory_config::use_default;
+        if (hasSlotSize != hasSlotCount) {
+            throw SQLiteXXException("lookaside_slot_size and lookaside_slot_count must be set together.");
+        }
+
+        if (hasSlotSize) {
+            // Passing a null buffer lets SQLite allocate the lookaside memory itself.
+            const int errorcode = sqlite3_db_config(
+                handle(),
+                SQLITE_DBCONFIG_LOOKASIDE,
+                nullptr,
+                static_cast<int>(config.lookaside_slot_size),
+                static_cast<int>(config.lookaside_slot_count));
+            throw_error_code(errorcode, "Unable to configure lookaside memory while it is in use");
+        }
+
+        if (config.cache_size != memory_config::use_default) {
+            set_pragma(handle(), "cache_size", config.cache_size);
+        }
+
+        if (config.cache_spill != memory_config::use_default) {
+            set_pragma(handle(), "cache_spill", config.cache_spill);
+            if (config.cache_spill > 0) {
+                // SQLite derives the on/off flag from the low byte of N, so a threshold
+                // such as 512 would silently turn spilling off. Turn it back on explicitly.
+                if (SQLITE_OK != sqlite3_exec(handle(), "PRAGMA cache_spill = ON", nullptr, nullptr, nullptr)) {
+                    throw_error_code(handle());
+                }
+            }
+        }
+
+        if (config.mmap_size != memory_config::use_default) {
+            set_pragma(handle(), "mmap_size", config.mmap_size);
+        }
+    }
+
+    int64_t dbconnection::set_mmap_size(const int64_t size, const std::string& database)
+    {
+        assert(m_handle);
+
+        // Setting the pragma also returns the value that is in effect.
+        return query_pragma(handle(), "PRAGMA " + quote_identifier(database) + ".mmap_size = " + std::to_string(size));
+    }
+
+    int64_t dbconnection::mmap_size(const std::string& database) const
+    {
+        assert(m_handle);
+
+        return query_pragma(handle(), "PRAGMA " + quote_identifier(database) + ".mmap_size");
+    }
+
+    dbconnection::lookaside_counters dbconnection::lookaside(bool reset) const
+    {
+        assert(m_handle);
+
+        lookaside_counters counters;
+        int unused;
+        db_status(handle(), SQLITE_DBSTATUS_LOOKASIDE_USED, counters.used, counters.used_highwater, reset);
+        db_status(handle(), SQLITE_DBSTATUS_LOOKASIDE_HIT, unused, counters.hit, reset);
+        db_status(handle(), SQLITE_DBSTATUS_LOOKASIDE_MISS_SIZE, unused, counters.miss_size, reset);
+        db_status(handle(), SQLITE_DBSTATUS_LOOKASIDE_MISS_FULL, unused, counters.miss_full, reset);
+        return counters;
+    }
+
+    dbconnection::status_counters dbconnection::status(bool reset) const
+    {
+        assert(m_handle);
+
+        status_counters counters;
+        int unused;
+        counters.lookaside = lookaside(reset);
+        db_status(handle(), SQLITE_DBSTATUS_CACHE_USED, counters.cache_used, unused, reset);
+        db_status(handle(), SQLITE_DBSTATUS_CACHE_USED_SHARED, counters.cache_used_shared, unused, reset);
+        db_status(handle(), SQLITE_DBSTATUS_CACHE_HIT, counters.cache_hit, unused, reset);
+        db_status(handle(), SQLITE_DBSTATUS_CACHE_MISS, counters.cache_miss, unused, reset);
+        db_status(handle(), SQLITE_DBSTATUS_CACHE_WRITE, counters.cache_write, unused, reset);
+#ifdef SQLITE_DBSTATUS_CACHE_SPILL
+        db_status(handle(), SQLITE_DBSTATUS_CACHE_SPILL, counters.cache_spill, unused, reset);
+#else
+        counters.cache_spill = 0;
+#endif
+        db_status(handle(), SQLITE_DBSTATUS_SCHEMA_USED, counters.schema_used, unused, reset);
+        db_status(handle(), SQLITE_DBSTATUS_STMT_USED, counters.stmt_used, unused, reset);
+        db_status(handle(), SQLITE_DBSTATUS_DEFERRED_FKS, counters.deferred_fks, unused, reset);
+        return counters;
+    }
+
+    void dbconnection::create_regexp_function()
+    {
+        // "X REGEXP Y" calls regexp(Y, X) so the pattern is the first argument.
+        // Like the regexp extension of SQLite the result is NULL if either side is.
+        create_function(
+            "regexp",
+            [](const std::optional<cached<std::regex>>& pattern, std::optional<std::string_view> text) -> std::optional<bool> {
+                if (!pattern.has_value() || !text.has_value()) {
+                    return std::nullopt;
+                }
+                return std::regex_search(text->begin(), text->end(), pattern->get());
+            },
+            true);
+    }
+
+    void dbconnection::create_csv_module(const std::string& name)
+    {
+        create_module<csv_table>(name);
+    }
+
+    void dbconnection::create_timeseries_module(const std::string& name, std::shared_ptr<const timeseries_store> store)
+    {
+        create_module<timeseries_table>(name, [store = std::move(store)](const std::vector<std::string>&) {
+            return std::unique_ptr<timeseries_table>(new timeseries_table(store));
+        });
+    }
+
+    void dbconnection::create_vector_functions()
+    {
+        register_vector_functions(handle());
+    }
+
+#if SQLITE_VERSION_NUMBER >= 3036000 || defined(SQLITE_ENABLE_DESERIALIZE)
+    serialized_database dbconnection::serialize(const std::string& schema) const
+    {
+        sqlite3_int64 size = 0;
+        unsigned char* data = sqlite3_serialize(handle(), schema.c_str(), &size, SQLITE_SERIALIZE_NOCOPY);
+        if (data != nullptr) {
+            return serialized_database(data, static_cast<std::size_t>(size), false);
+        }
+
+        data = sqlite3_serialize(handle(), schema.c_str(), &size, 0);
+        if (data != nullptr) {
+            return serialized_database(data, static_cast<std::size_t>(size), true);
+        }
+        // SQLite sets the size before it allocates the copy, and returns nothing for a database without pages.
+        if (size == 0) {
+            return serialized_database();
+        }
+        throw_error_code(size < 0 ? SQLITE_ERROR : SQLITE_NOMEM, "Unable to serialize the database " + schema);
+        return serialized_database();
+    }
+
+    void dbconnection::deserialize(const void* data, const std::size_t size, const deserialize_mode mode, const std::string& schema)
+    {
+        if (mode == deserialize_mode::read_only) {
+            const int errorcode = sqlite3_deserialize(handle(), schema.c_str(), static_cast<unsigned char*>(const_cast<void*>(data)),
+                                                      static_cast<sqlite3_int64>(size), static_cast<sqlite3_int64>(size), SQLITE_DESERIALIZE_READONLY);
+            throw_error_code(errorcode, "Unable to deserialize the database " + schema);
+            return;
+        }
+
+        unsigned char* copy = nullptr;
+        if (size > 0) {
+            copy = static_cast<unsigned char*>(sqlite3_malloc64(size));
+            if (copy == nullptr) {
+                throw_error_code(SQLITE_NOMEM, "Unable to copy the image of the database " + schema);
+            }
+            std::memcpy(copy, data, size);
+        }
+        // SQLite frees the copy, also when it fails.
+        const int errorcode = sqlite3_deserialize(handle(), schema.c_str(), copy, static_cast<sqlite3_int64>(size), static_cast<sqlite3_int64>(size),
+                                                  SQLITE_DESERIALIZE_FREEONCLOSE | SQLITE_DESERIALIZE_RESIZEABLE);
+        throw_error_code(errorcode, "Unable to deserialize the database " + schema);
+    }
+
+    void dbconnection::deserialize(serialized_database&& image, const deserialize_mode mode, const std::string& schema)
+    {
+        const std::size_t size = image.size();
+        unsigned char* owned = image.release();
+        // A view is copied, the database it shows may change.
+        if (owned == nullptr && size > 0) {
+            owned = static_cast<unsigned char*>(sqlite3_malloc64(size));
+            if (owned == nullptr) {
+                throw_error_code(SQLITE_NOMEM, "Unable to copy the image of the database " + schema);
+            }
+            std::memcpy(owned, image.data(), size);
+            image = serialized_database();
+        }
+
+        const unsigned int flags = SQLITE_DESERIALIZE_FREEONCLOSE |
+            (mode == deserialize_mode::read_only ? SQLITE_DESERIALIZE_READONLY : SQLITE_DESERIALIZE_RESIZEABLE);
+        const int errorcode = sqlite3_deserialize(handle(), schema.c_str(), owned, static_cast<sqlite3_int64>(size), static_cast<sqlite3_int64>(size), flags);
+        throw_error_code(errorcode, "Unable to deserialize the database " + schema);
+    }
+#endif
 }
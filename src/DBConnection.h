@@ -3,17 +3,25 @@
 #ifndef __SQLITEXX_SQLITE_DBCONNECTION_H__
 #define __SQLITEXX_SQLITE_DBCONNECTION_H__
 
+#include "CsvTable.h"
 #include "Exception.h"
 #include "Functions.h"
 #include "Mutex.h"
 #include "Open.h"
+#include "RangeTable.h"
+#include "Serialize.h"
+#include "TableFunction.h"
+#include "TimeSeries.h"
+#include "VirtualTable.h"
 
 #include <sqlite3.h>
 
 #include <cassert>
 #include <chrono>
+#include <cstdint>
 #include <memory>
 #include <thread>
+#include <type_traits>
 
 
 namespace sqlite
@@ -25,6 +33,68 @@ namespace sqlite
     {
         public:
 
+        /** Per-connection memory settings that can be applied when a database is opened.
+         * Every member defaults to use_default which leaves the SQLite default in place.
+         */
+        struct memory_config
+        {
+            /** Sentinel used to leave a setting at the SQLite default. */
+            static const int64_t use_default;
+
+            /** Size in bytes of each lookaside slot (SQLITE_DBCONFIG_LOOKASIDE).
+             * Must be set together with lookaside_slot_count. A size of 0 disables lookaside.
+             */
+            int64_t lookaside_slot_size = use_default;
+
+            /** Number of lookaside slots (SQLITE_DBCONFIG_LOOKASIDE).
+             * Must be set together with lookaside_slot_size. A count of 0 disables lookaside.
+             */
+            int64_t lookaside_slot_count = use_default;
+
+            /** Suggested maximum number of pages held in memory (PRAGMA cache_size).
+             * A negative value means the page cache is limited to approximately abs(N*1024) bytes.
+             */
+            int64_t cache_size = use_default;
+
+            /** Number of pages the page cache may hold before dirty pages spill to the database file
+             * in the middle of a transaction (PRAGMA cache_spill). 0 disables cache spilling.
+             */
+            int64_t cache_spill = use_default;
+
+            /** Maximum number of bytes of the database file that may be accessed using
+             * memory-mapped I/O (PRAGMA mmap_size). 0 disables memory-mapped I/O.
+             */
+            int64_t mmap_size = use_default;
+        };
+
+        /** Lookaside memory allocator counters, aka SQLITE_DBSTATUS_LOOKASIDE_*.
+         */
+        struct lookaside_counters
+        {
+            int used;           ///< number of lookaside slots currently checked out
+            int used_highwater; ///< highest number of lookaside slots checked out at once
+            int hit;            ///< number of malloc attempts satisfied using lookaside memory
+            int miss_size;      ///< number of malloc attempts that failed because the requested size was too large
+            int miss_full;      ///< number of malloc attempts that failed because all lookaside memory was in use
+        };
+
+        /** Snapshot of the runtime status counters of a connection, aka "sqlite3_db_status".
+         * Memory values are in bytes.
+         */
+        struct status_counters
+        {
+            lookaside_counters lookaside; ///< lookaside memory allocator counters
+            int cache_used;               ///< heap memory used by all pager caches of the connection
+            int cache_used_shared;        ///< like cache_used but shared caches are divided evenly between the connections using them
+            int cache_hit;                ///< number of pager cache hits
+            int cache_miss;               ///< number of pager cache misses
+            int cache_write;              ///< number of dirty cache entries written to disk
+            int cache_spill;              ///< number of dirty cache entries written to disk in the middle of a transaction
+            int schema_used;              ///< heap memory used to store the schemas of all attached databases
+            int stmt_used;                ///< heap and lookaside memory used by all prepared statements
+            int deferred_fks;             ///< non-zero if there are unresolved deferred foreign key constraints
+        };
+
         /** Default constructor.
          */
         dbconnection() noexcept;
@@ -44,11 +114,13 @@ namespace sqlite
          * @param[in] filename UTF-8 path/uri to the database database file
          * @param[in] mode     file opening options specified by combination of openmode flags
          * @param[in] timeout  amount of milliseconds to wait before returning sqlite::busy_exception when a table is locked
+         * @param[in] vfs      name of the VFS to open the file with, the default VFS when empty
          */
         dbconnection(
             const std::string& filename,
             openmode mode = openmode::read_write | openmode::create,
-            const std::chrono::milliseconds timeout = DEFAULT_TIMEOUT);
+            const std::chrono::milliseconds timeout = DEFAULT_TIMEOUT,
+            const std::string& vfs = std::string());
 
         /** Open the provided database UTF-8 filename.
          * @param[in] filename UTF-8 path/uri to the database database file
@@ -56,6 +128,18 @@ namespace sqlite
          */
         dbconnection(const std::string& filename, const std::chrono::milliseconds timeout);
 
+        /** Open the provided database UTF-8 filename and apply the memory configuration.
+         * @param[in] filename UTF-8 path/uri to the database database file
+         * @param[in] config   memory settings to apply before the connection is used
+         * @param[in] mode     file opening options specified by combination of openmode flags
+         * @param[in] timeout  amount of milliseconds to wait before returning sqlite::busy_exception when a table is locked
+         */
+        dbconnection(
+            const std::string& filename,
+            const memory_config& config,
+            openmode mode = openmode::read_write | openmode::create,
+            const std::chrono::milliseconds timeout = DEFAULT_TIMEOUT);
+
         /** Open the provided database UTF-16 filename.
          * @param[in] filename UTF-16 path/uri to the database database file
          * @param[in] timeout  Amount of milliseconds to wait before returning sqlite::busy_exception when a table is locked
@@ -81,6 +165,19 @@ namespace sqlite
          */
         static dbconnection memory();
 
+        /** Open a named database kept in process memory by the memory VFS, see sqlite::memory_vfs.
+         * Every connection opened with the same name shares the database, which is freed when the last one is closed.
+         * Unlike shared cache, the connections can use WAL mode for concurrent readers next to a writer.
+         * @param[in] name    the name of the database
+         * @param[in] mode    file opening options specified by combination of openmode flags
+         * @param[in] timeout amount of milliseconds to wait before returning sqlite::busy_exception when a table is locked
+         * @returns a connection to the in memory database
+         */
+        static dbconnection shared_memory(
+            const std::string& name,
+            openmode mode = openmode::read_write | openmode::create,
+            const std::chrono::milliseconds timeout = DEFAULT_TIMEOUT);
+
         /** Create a purely in memory database with UTF-16 as the native byte order.
          * @returns a purely in memory sqlite::dbconnection
          */
@@ -104,8 +201,9 @@ namespace sqlite
         /** Open an SQLite database file as specified by the filename argument.
          * @param[in] filename path to SQLite file
          * @param[in] mode     specifies the privileges to use when opening the database.
+         * @param[in] vfs      name of the VFS to open the file with, the default VFS when empty
          */
-        void open(const std::string& filename, openmode mode = openmode::read_write | openmode::create);
+        void open(const std::string& filename, openmode mode = openmode::read_write | openmode::create, const std::string& vfs = std::string());
 
         /** Open an SQLite database file as specified by the filname argument.
          * The database file will have UTF-16 native byte order.
@@ -119,7 +217,52 @@ namespace sqlite
          */
         long long row_id() const noexcept;
 
+        /** Applies memory settings to the database connection.
+         * The lookaside settings can only be changed while no lookaside memory is in use,
+         * which is why they are best applied right after the connection is opened.
+         * @param[in] config memory settings to apply
+         * @throws sqlite::exception if SQLite rejects one of the settings
+         */
+        void configure(const memory_config& config);
+
+        /** Enables memory-mapped I/O for a database of the connection, aka "PRAGMA mmap_size".
+         * Reading pages through memory-mapped I/O avoids the copy from the operating system page cache
+         * that a regular read makes. The size is silently limited by sqlite::max_mmap_size() and by the
+         * max_size given to sqlite::configure_mmap_size().
+         * @param[in] size     maximum number of bytes of the database file to map, 0 disables memory-mapped I/O
+         * @param[in] database the symbolic name of the database to configure
+         * @returns The mmap size in bytes that is in effect after the limits were applied.
+         * @throws sqlite::exception if the setting could not be applied
+         */
+        int64_t set_mmap_size(const int64_t size, const std::string& database = "main");
+
+        /** Returns the memory-mapped I/O size in effect for a database of the connection.
+         * @param[in] database the symbolic name of the database to query
+         * @returns The mmap size in bytes, 0 if memory-mapped I/O is disabled.
+         * @throws sqlite::exception if the setting could not be read
+         */
+        int64_t mmap_size(const std::string& database = "main") const;
+
+        /** Returns the lookaside memory allocator counters for the connection.
+         * Use these to confirm whether a lookaside configuration helps a statement mix.
+         * @param[in] reset if true the highwater and hit/miss counters are reset after being read
+         * @returns The current lookaside counters.
+         */
+        lookaside_counters lookaside(bool reset = false) const;
+
+        /** Returns a snapshot of all the runtime status counters of the connection.
+         * When reset is true the resettable counters (cache hits, misses, writes, spills,
+         * lookaside hits/misses and highwater marks) are reset after being read, so successive calls
+         * return the delta since the previous call. This makes the method suitable to poll periodically
+         * from a metrics thread.
+         * @param[in] reset if true the resettable counters are reset after being read
+         * @returns The current status counters.
+         */
+        status_counters status(bool reset = false) const;
+
         /** Used to add SQL functions or redefine the behavior of existing SQL functions.
+         * The function receives all of its arguments at once, either as a sqlite::value_span,
+         * which does not allocate, or as a std::vector<sqlite::value>, which copies every argument on every call.
          * @tparam F The function type to use to create the function.
          * @param[in] name             the name of the function to be used in an SQL query
          * @param[in] function         the implementation to the function
@@ -135,8 +278,12 @@ namespace sqlite
             const textencoding encoding = textencoding::utf8,
             int nargs = -1)
         {
-            using FunctionType = typename SQLiteFunctionTraits<F>::f_type;
-            FunctionType *userFunction = new FunctionType(function);
+            using CallableType = typename std::decay<F>::type;
+            using FunctionType = typename std::conditional<
+                std::is_invocable<CallableType&, value_span>::value,
+                CallableType,
+                vector_function_adapter<CallableType>>::type;
+            FunctionType *userFunction = new FunctionType(CallableType(std::forward<F>(function)));
 
             int flags = static_cast<int>(encoding);
             if (is_deterministic) {
@@ -158,6 +305,8 @@ namespace sqlite
         }
 
         /** Used to add SQL functions or redefine the behavior of existing SQL functions.
+         * Parameters declared as sqlite::cached<T> are compiled into a T once per statement while the argument stays constant,
+         * instead of on every call, see sqlite::argument_compiler for how the T is built.
          * @tparam F The function type to use to create the function.
          * @param[in] name             the name of the function to be used in an SQL query
          * @param[in] function         the implementation to the function
@@ -171,8 +320,9 @@ namespace sqlite
             bool is_deterministic = false,
             const textencoding encoding = textencoding::utf8)
         {
-            using FunctionType = typename function_traits<F>::f_type;
-            FunctionType *userFunction = new FunctionType(function);
+            // The callable is stored by its own type so calling it is a direct call.
+            using FunctionType = typename std::decay<F>::type;
+            FunctionType *userFunction = new FunctionType(std::forward<F>(function));
 
             int flags = static_cast<int>(encoding);
             if (is_deterministic) {
@@ -182,7 +332,7 @@ namespace sqlite
             int errorcode = sqlite3_create_function_v2(
                 handle(),
                 name.c_str(),
-                function_traits<F>::nargs,
+                function_traits<FunctionType>::nargs,
                 flags,
                 (void*)userFunction,
                 &internal_scalar_function<FunctionType>,
@@ -193,7 +343,47 @@ namespace sqlite
             throw_error_code(errorcode, "");
         }
 
+        /** Used to add deterministic SQL functions whose results are cached across rows and statements.
+         * The most recently used results, keyed by the argument values, are kept in a cache owned by this registration
+         * so expensive functions over columns with few distinct values only run once per distinct value.
+         * The cache is locked only to look up and store results, it can be used from several threads when the connection
+         * is opened with openmode::full_mutex.
+         * @tparam F The function type to use to create the function.
+         * @param[in] name     the name of the function to be used in an SQL query
+         * @param[in] function the implementation to the function, it has to always return the same result for the same arguments
+         * @param[in] capacity the maximum number of results to keep
+         * @param[in] encoding specifies the text encoding the SQL function prefers for its parameters
+         * @returns the hit and miss counters of the cache, which stay valid after the function is replaced or the connection is closed
+         */
+        template <typename F>
+        std::shared_ptr<const memoization_counters> create_memoized_function(
+            const std::string& name,
+            F&& function,
+            const std::size_t capacity = 1024,
+            const textencoding encoding = textencoding::utf8)
+        {
+            using CallableType = typename std::decay<F>::type;
+            using FunctionType = memoized_function<CallableType>;
+            FunctionType *userFunction = new FunctionType(CallableType(std::forward<F>(function)), capacity);
+            std::shared_ptr<const memoization_counters> counters = userFunction->counters();
+
+            int errorcode = sqlite3_create_function_v2(
+                handle(),
+                name.c_str(),
+                function_traits<CallableType>::nargs,
+                static_cast<int>(encoding) | SQLITE_DETERMINISTIC,
+                (void*)userFunction,
+                &internal_scalar_function<FunctionType>,
+                nullptr,
+                nullptr,
+                &internal_delete<FunctionType>);
+
+            throw_error_code(errorcode, "");
+            return counters;
+        }
+
         /** Used to add  SQL aggregate functions or redefine the behavior of existing SQL aggregate functions.
+         * Each group gets its own default constructed instance of the class, which is destroyed once finalized.
          * @tparam A The class to use as the aggregate function.
          * @param[in] name             the name of the aggregate function to be used in an SQL query
          * @param[in] is_deterministic specifies if the function will always return the same result given the same inputs within a single SQL statement.
@@ -227,8 +417,56 @@ namespace sqlite
             throw_error_code(errorcode, "");
         }
 
+#if SQLITE_VERSION_NUMBER >= 3025000
+        /** Used to add SQL aggregate window functions or redefine the behavior of existing ones.
+         * Besides step() and finalize(), the class needs an inverse() member taking the same arguments as step()
+         * to remove a row that leaves the window frame, and a value() member returning the result for the current frame.
+         * Sliding frames are then updated one row at a time instead of being recomputed.
+         * Each window gets its own default constructed instance of the class.
+         * @tparam A The class to use as the window function.
+         * @param[in] name             the name of the window function to be used in an SQL query
+         * @param[in] is_deterministic specifies if the function will always return the same result given the same inputs within a single SQL statement.
+         * @param[in] encoding         specifies the test encoding the SQL function prefers for its parameters
+         */
+        template <typename A>
+        void create_window_function(
+            const std::string& name,
+            bool is_deterministic = false,
+            const textencoding encoding = textencoding::utf8)
+        {
+            static_assert(has_window_members<A>::value, "window functions need inverse() and value() members");
+            using StepFunctionType = function_traits<decltype(&A::step)>;
+            static_assert(
+                function_traits<decltype(&A::inverse)>::nargs == StepFunctionType::nargs,
+                "inverse() has to take the same arguments as step()");
+
+            aggregate_wrapper<A> *wrapper = new aggregate_wrapper<A>;
+
+            int flags = static_cast<int>(encoding);
+            if (is_deterministic) {
+                flags |= SQLITE_DETERMINISTIC;
+            }
+
+            int errorcode = sqlite3_create_window_function(
+                handle(),
+                name.c_str(),
+                StepFunctionType::nargs,
+                static_cast<int>(flags),
+                (void*)wrapper,
+                &internal_step<aggregate_wrapper<A> >,
+                &internal_final<aggregate_wrapper<A> >,
+                &internal_value<aggregate_wrapper<A> >,
+                &internal_inverse<aggregate_wrapper<A> >,
+                &internal_dispose<aggregate_wrapper<A> >);
+
+            throw_error_code(errorcode, "");
+        }
+#endif
+
         /** Used to add an SQL collation or redefine the behavior of existing SQL collations.
          * The function created should not throw an exception, if so the results is unknown.
+         * The function should take two std::string_view, which refer directly to the text being compared.
+         * Functions taking two const std::string& are still accepted but the text is copied for every comparison.
          *
          * @tparam F The function type to use to create the function.
          * @param[in] name             the name of the function to be used in an SQL query
@@ -241,22 +479,180 @@ namespace sqlite
             F&& function,
             const textencoding encoding = textencoding::utf8)
         {
-            using CollationType = typename collation_traits<F>::f_type;
-            CollationType *userFunction = new CollationType(function);
+            using CallableType = typename std::decay<F>::type;
+            using CollationType = typename collation_callable<CallableType>::type;
+            register_collation(name, new CollationType(CallableType(std::forward<F>(function))), encoding);
+        }
 
-            int flags = static_cast<int>(encoding);
+        /** Used to add an SQL collation that orders text by a normalized sort key.
+         * The key function turns a text into a key, for example by case folding it, and the keys are
+         * compared byte by byte. Keys are cached so a text that takes part in many comparisons,
+         * as happens in an "ORDER BY" or when building an index, is only normalized once.
+         * The key function should not throw an exception, if so the results is unknown.
+         *
+         * @tparam F The key function type, callable as std::string(std::string_view).
+         * @param[in] name           the name of the collation to be used in an SQL query
+         * @param[in] key_function   the function computing the sort key of a text
+         * @param[in] cache_capacity the maximum number of keys kept in the cache
+         * @param[in] encoding       specifies the test encoding the SQL function prefers for its parameters
+         */
+        template <typename F>
+        void create_sortkey_collation(
+            const std::string& name,
+            F&& key_function,
+            const std::size_t cache_capacity = 4096,
+            const textencoding encoding = textencoding::utf8)
+        {
+            using KeyFunctionType = typename std::decay<F>::type;
+            using CollationType = sortkey_collation<KeyFunctionType>;
+            register_collation(name, new CollationType(KeyFunctionType(std::forward<F>(key_function)), cache_capacity), encoding);
+        }
 
-            int errorcode = sqlite3_create_collation_v2(
+        /** Registers a virtual table module implemented by a C++ class, see sqlite::virtual_table_module for what the class provides.
+         * Tables are then created with CREATE VIRTUAL TABLE name USING module(arguments).
+         * @tparam VTab The class implementing the tables of the module.
+         * @param[in] name    the name of the module
+         * @param[in] factory a callable taking the module arguments as a const std::vector<std::string>& and returning a std::unique_ptr<VTab>
+         * @throws sqlite::exception if the module could not be registered
+         */
+        template <typename VTab, typename F>
+        void create_module(const std::string& name, F&& factory)
+        {
+            module_factory<VTab> *userFactory = new module_factory<VTab>(std::forward<F>(factory));
+
+            int errorcode = sqlite3_create_module_v2(
                 handle(),
                 name.c_str(),
-                flags,
-                (void*)userFunction,
-                &internal_collation_function<CollationType>,
-                &internal_delete<CollationType>);
+                virtual_table_module<VTab>(),
+                (void*)userFactory,
+                &internal_delete<module_factory<VTab> >);
 
             throw_error_code(errorcode, "");
         }
 
+        /** Registers a virtual table module whose tables are constructed from the module arguments.
+         * @tparam VTab The class implementing the tables of the module, constructible from a const std::vector<std::string>&.
+         * @param[in] name the name of the module
+         * @throws sqlite::exception if the module could not be registered
+         */
+        template <typename VTab>
+        void create_module(const std::string& name)
+        {
+            create_module<VTab>(name, [](const std::vector<std::string>& arguments) {
+                return std::unique_ptr<VTab>(new VTab(arguments));
+            });
+        }
+
+        /** Registers a module exposing a random-access range of structs as a read-only table without copying it, see sqlite::range_table.
+         * Tables are then created with CREATE VIRTUAL TABLE name USING module.
+         * The range has to outlive the connection and must not change while a statement reads from it.
+         * @param[in] name    the name of the module
+         * @param[in] range   the range to expose
+         * @param[in] columns the columns of the table
+         * @throws sqlite::exception if the module could not be registered
+         */
+        template <typename Range>
+        void create_range_module(const std::string& name, const Range& range, std::vector<range_column<range_element_t<Range> > > columns)
+        {
+            using TableType = range_table<Range>;
+            create_module<TableType>(name, [&range, columns = std::move(columns)](const std::vector<std::string>&) {
+                return std::unique_ptr<TableType>(new TableType(range, columns));
+            });
+        }
+
+#if SQLITE_VERSION_NUMBER >= 3009000
+        /** Registers a table-valued function implemented by a C++ callable, see sqlite::table_function.
+         * It is used like a table, e.g. SELECT * FROM split('a,b,c', ','), and the rows are produced as the query reads them.
+         * @param[in] name       the name of the function
+         * @param[in] columns    the names of the output columns, one per element of the rows
+         * @param[in] function   the callable, returning a range of rows or a generator of std::optional rows
+         * @param[in] parameters the names of the hidden columns holding the arguments, "arg1", "arg2", ... when empty
+         * @throws SQLiteXXException if the number of names does not match the callable
+         * @throws sqlite::exception if the function could not be registered
+         */
+        template <typename F>
+        void create_table_function(const std::string& name, std::vector<std::string> columns, F&& function, std::vector<std::string> parameters = {})
+        {
+            using FunctionType = typename std::decay<F>::type;
+            using TableType = table_function<FunctionType>;
+
+            if (columns.size() != TableType::column_count) {
+                throw SQLiteXXException(name + "() produces " + std::to_string(TableType::column_count) + " columns");
+            }
+            if (parameters.empty()) {
+                for (std::size_t i = 1; i <= TableType::parameter_count; ++i) {
+                    parameters.push_back("arg" + std::to_string(i));
+                }
+            } else if (parameters.size() != TableType::parameter_count) {
+                throw SQLiteXXException(name + "() takes " + std::to_string(TableType::parameter_count) + " arguments");
+            }
+
+            std::shared_ptr<FunctionType> userFunction = std::make_shared<FunctionType>(std::forward<F>(function));
+            create_module<TableType>(name, [name, userFunction, columns = std::move(columns), parameters = std::move(parameters)](const std::vector<std::string>&) {
+                return std::unique_ptr<TableType>(new TableType(name, userFunction, columns, parameters));
+            });
+        }
+#endif
+
+        /** Registers the read-only csv module over memory-mapped CSV files, see sqlite::csv_table.
+         * Tables are then created with CREATE VIRTUAL TABLE name USING csv('file.csv'), and loaded with INSERT INTO t SELECT ... FROM name.
+         * @param[in] name the name of the module
+         * @throws sqlite::exception if the module could not be registered
+         */
+        void create_csv_module(const std::string& name = "csv");
+
+        /** Registers a module reading a time series store, see sqlite::timeseries_table.
+         * Tables are then created with CREATE VIRTUAL TABLE name USING module, while rows are appended to the store from C++.
+         * @param[in] name  the name of the module
+         * @param[in] store the store the tables read
+         * @throws sqlite::exception if the module could not be registered
+         */
+        void create_timeseries_module(const std::string& name, std::shared_ptr<const timeseries_store> store);
+
+        /** Adds the regexp() function so that "X REGEXP Y" can be used in SQL queries.
+         * The pattern uses the ECMAScript grammar of std::regex and matches anywhere in the text.
+         * The pattern is compiled once per statement when it is a constant.
+         * @throws sqlite::exception if the function could not be created
+         */
+        void create_regexp_function();
+
+        /** Adds the vec_dot(), vec_l2(), vec_cosine() and vec_norm() functions over vectors stored as float32 blobs.
+         * The blobs are read in place with the best SIMD instruction set of the CPU, see sqlite::register_vector_functions.
+         * @throws sqlite::exception if the functions could not be created
+         */
+        void create_vector_functions();
+
+#if SQLITE_VERSION_NUMBER >= 3036000 || defined(SQLITE_ENABLE_DESERIALIZE)
+        /** Serializes a database into the bytes of a database file, without any I/O.
+         * A database SQLite keeps in one buffer, one loaded by deserialize() or opened with the memdb VFS,
+         * is returned as a view of that buffer. Any other database, including a ":memory:" one, is copied.
+         * @param[in] schema the name of the database, "main" or the name of an attached database
+         * @returns the image of the database, empty for a database without pages
+         * @throws sqlite::exception if there is no such database or the copy could not be allocated
+         */
+        serialized_database serialize(const std::string& schema = "main") const;
+
+        /** Replaces a database by an image of a database file, which is used from then on instead of a file.
+         * In read_only mode the database is read in place, so the image has to stay valid and unchanged until the connection
+         * is closed or the database is replaced again. A file mapped by sqlite::mapped_file is loaded this way without reading it.
+         * In resizable mode the image is copied and the database can be changed.
+         * @param[in] data   the first byte of the image
+         * @param[in] size   the size of the image in bytes
+         * @param[in] mode   whether the database is read in place or copied and writable
+         * @param[in] schema the name of the database, "main" or the name of an attached database
+         * @throws sqlite::exception if there is no such database, it is in use or the copy could not be allocated
+         */
+        void deserialize(const void* data, std::size_t size, deserialize_mode mode = deserialize_mode::resizable, const std::string& schema = "main");
+
+        /** Replaces a database by an image returned by serialize().
+         * A copy is handed over to SQLite without copying it again, a view is copied.
+         * @param[in] image  the image of the database, empty afterwards
+         * @param[in] mode   whether the database can be changed
+         * @param[in] schema the name of the database, "main" or the name of an attached database
+         * @throws sqlite::exception if there is no such database, it is in use or the copy could not be allocated
+         */
+        void deserialize(serialized_database&& image, deserialize_mode mode = deserialize_mode::resizable, const std::string& schema = "main");
+#endif
 
         template <typename F>
         void profile(F&& callback, void* const context = nullptr)
@@ -265,6 +661,26 @@ namespace sqlite
         }
 
         private:
+        template <typename C>
+        void register_collation(const std::string& name, C* userFunction, const textencoding encoding)
+        {
+            int flags = static_cast<int>(encoding);
+
+            int errorcode = sqlite3_create_collation_v2(
+                handle(),
+                name.c_str(),
+                flags,
+                (void*)userFunction,
+                &internal_collation_function<C>,
+                &internal_delete<C>);
+
+            // The destroy callback is not invoked when registering fails.
+            if (errorcode != SQLITE_OK) {
+                delete userFunction;
+            }
+            throw_error_code(errorcode, "");
+        }
+
         using connection_handle = std::shared_ptr<sqlite3>;
         connection_handle m_handle;
 
@@ -0,0 +1,163 @@
+#include "FaultVfs.h"
+
+#include <cstring>
+#include <thread>
+#include <utility>
+
+namespace sqlite
+{
+    class fault_vfs::file : public vfs_file
+    {
+        public:
+        file(sqlite3_file* base, const file_kind kind, fault_vfs& vfs) noexcept :
+            vfs_file(base, kind),
+            m_vfs(vfs)
+        {}
+
+        int read(void* buffer, const int amount, const int64_t offset) override
+        {
+            const fault injected = apply(io_operation::read, true);
+            if (injected.error != SQLITE_OK) {
+                return injected.error;
+            }
+            if (!injected.short_read) {
+                return vfs_file::read(buffer, amount, offset);
+            }
+            const int half = amount / 2;
+            const int errorcode = vfs_file::read(buffer, half, offset);
+            std::memset(static_cast<char*>(buffer) + half, 0, static_cast<std::size_t>(amount - half));
+            return errorcode == SQLITE_OK ? SQLITE_IOERR_SHORT_READ : errorcode;
+        }
+
+        int write(const void* buffer, const int amount, const int64_t offset) override
+        {
+            const fault injected = apply(io_operation::write, true);
+            return injected.error != SQLITE_OK ? injected.error : vfs_file::write(buffer, amount, offset);
+        }
+
+        int truncate(const int64_t size) override
+        {
+            const fault injected = apply(io_operation::truncate, true);
+            return injected.error != SQLITE_OK ? injected.error : vfs_file::truncate(size);
+        }
+
+        int sync(const int flags) override
+        {
+            const fault injected = apply(io_operation::sync, true);
+            return injected.error != SQLITE_OK ? injected.error : vfs_file::sync(flags);
+        }
+
+        int lock(const int level) override
+        {
+            const fault injected = apply(io_operation::lock, true);
+            return injected.error != SQLITE_OK ? injected.error : vfs_file::lock(level);
+        }
+
+        int unlock(const int level) override
+        {
+            apply(io_operation::lock, false);
+            return vfs_file::unlock(level);
+        }
+
+        int check_reserved_lock(int* result) override
+        {
+            apply(io_operation::lock, false);
+            return vfs_file::check_reserved_lock(result);
+        }
+
+        int shm_map(const int region, const int size, const int extend, void volatile** address) override
+        {
+            const fault injected = apply(io_operation::shm, true);
+            return injected.error != SQLITE_OK ? injected.error : vfs_file::shm_map(region, size, extend, address);
+        }
+
+        int shm_lock(const int offset, const int count, const int flags) override
+        {
+            const fault injected = apply(io_operation::shm, (flags & SQLITE_SHM_UNLOCK) == 0);
+            return injected.error != SQLITE_OK ? injected.error : vfs_file::shm_lock(offset, count, flags);
+        }
+
+        int shm_unmap(const int delete_flag) override
+        {
+            apply(io_operation::shm, false);
+            return vfs_file::shm_unmap(delete_flag);
+        }
+
+        private:
+        fault apply(const io_operation operation, const bool may_fail)
+        {
+            const fault injected = m_vfs.draw(operation, kind(), may_fail);
+            if (injected.delay.count() > 0) {
+                std::this_thread::sleep_for(injected.delay);
+            }
+            return injected;
+        }
+
+        fault_vfs& m_vfs;
+    };
+
+    fault_vfs::fault_vfs(std::string name, const uint64_t seed, const std::string& base) :
+        vfs_shim(std::move(name), base),
+        m_random(seed)
+    {}
+
+    fault_vfs::~fault_vfs() = default;
+
+    void fault_vfs::inject(const io_operation operation, const fault_config& config)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_configs[static_cast<std::size_t>(operation)] = config;
+    }
+
+    void fault_vfs::clear()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_configs.fill(fault_config());
+    }
+
+    fault_stats fault_vfs::stats() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_stats;
+    }
+
+    std::unique_ptr<vfs_file> fault_vfs::wrap(sqlite3_file* base, const char*, const int flags)
+    {
+        return std::unique_ptr<vfs_file>(new file(base, file_kind_of(flags), *this));
+    }
+
+    fault_vfs::fault fault_vfs::draw(const io_operation operation, const file_kind kind, const bool may_fail)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const fault_config& config = m_configs[static_cast<std::size_t>(operation)];
+        fault result;
+        if (config.only && *config.only != kind) {
+            return result;
+        }
+
+        std::uniform_real_distribution<double> chance(0.0, 1.0);
+        const latency_distribution& latency = config.latency;
+        result.delay = latency.fixed;
+        if (latency.exponential_mean.count() > 0) {
+            std::exponential_distribution<double> exponential(1.0 / static_cast<double>(latency.exponential_mean.count()));
+            result.delay += std::chrono::microseconds(static_cast<int64_t>(exponential(m_random)));
+        }
+        if (latency.stall_probability > 0.0 && chance(m_random) < latency.stall_probability) {
+            result.delay += latency.stall;
+            ++m_stats.stalls;
+        }
+        if (may_fail && config.error_probability > 0.0 && chance(m_random) < config.error_probability) {
+            result.error = config.error;
+            ++m_stats.errors;
+        } else if (operation == io_operation::read && config.short_read_probability > 0.0 && chance(m_random) < config.short_read_probability) {
+            result.short_read = true;
+            ++m_stats.short_reads;
+        }
+
+        if (result.delay.count() > 0) {
+            ++m_stats.delayed;
+            m_stats.delay += result.delay;
+        }
+        return result;
+    }
+}
@@ -0,0 +1,114 @@
+/** @file */
+
+#ifndef __SQLITEXX_SQLITE_FAULTVFS_H__
+#define __SQLITEXX_SQLITE_FAULTVFS_H__
+
+#include "InstrumentedVfs.h"
+#include "VfsShim.h"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+
+namespace sqlite
+{
+    /** The delay sqlite::fault_vfs adds to a call, the sum of three parts.
+     */
+    struct latency_distribution
+    {
+        std::chrono::microseconds fixed{0};            ///< added to every call
+        std::chrono::microseconds exponential_mean{0}; ///< mean of an exponentially distributed delay added to every call, 0 for none
+        double stall_probability = 0.0;                ///< probability of a call stalling
+        std::chrono::microseconds stall{0};            ///< the length of a stall
+    };
+
+    /** The faults sqlite::fault_vfs injects into one operation.
+     */
+    struct fault_config
+    {
+        latency_distribution latency;            ///< the delay added before the call
+        double error_probability = 0.0;          ///< probability of a call failing without reaching the underlying file
+        int error = SQLITE_IOERR;                ///< the result code of a failed call, for example SQLITE_FULL, SQLITE_IOERR_FSYNC or SQLITE_BUSY for locks
+        double short_read_probability = 0.0;     ///< for reads, probability of returning only the first half of the data with SQLITE_IOERR_SHORT_READ
+        std::optional<file_kind> only;           ///< if set, only files of this kind are affected
+    };
+
+    /** Counters of a sqlite::fault_vfs.
+     */
+    struct fault_stats
+    {
+        uint64_t delayed = 0;                ///< calls that were delayed
+        std::chrono::microseconds delay{0};  ///< the sum of all delays
+        uint64_t stalls = 0;                 ///< calls that stalled
+        uint64_t errors = 0;                 ///< calls that failed with an injected error
+        uint64_t short_reads = 0;            ///< reads that were cut short
+    };
+
+    /**
+     * A VFS layered over the default VFS for tests, which slows down and fails file operations to simulate slow disks,
+     * sync stalls, full disks, I/O errors and lock contention without special hardware.
+     * Every operation of sqlite::io_operation has its own sqlite::fault_config, empty by default so the VFS only forwards.
+     * Errors are injected into reads, writes, syncs, truncates, lock and WAL index lock and map calls,
+     * never into unlocks, which SQLite expects to succeed. Delays apply to every call of the operation.
+     * The faults are drawn from a random generator with a fixed seed, so a single threaded test sees the same
+     * faults on every run. The configuration can be changed while connections use the VFS.
+     * The VFS must outlive the connections using it.
+     */
+    class fault_vfs : public vfs_shim
+    {
+        public:
+
+        /** Registers the VFS.
+         * @param[in] name the name of the VFS
+         * @param[in] seed the seed of the random generator the faults are drawn from
+         * @param[in] base the name of the underlying VFS, the default VFS when empty
+         * @throws SQLiteXXException if the underlying VFS does not exist or the name is taken
+         * @throws sqlite::exception if the VFS could not be registered
+         */
+        explicit fault_vfs(std::string name = "sqlitexx-fault", uint64_t seed = 42, const std::string& base = std::string());
+
+        ~fault_vfs() override;
+
+        /** Sets the faults of an operation.
+         * @param[in] operation the operation
+         * @param[in] config    the faults to inject
+         */
+        void inject(io_operation operation, const fault_config& config);
+
+        /** Removes the faults of every operation.
+         */
+        void clear();
+
+        /** Returns the counters since construction.
+         */
+        fault_stats stats() const;
+
+        protected:
+        std::unique_ptr<vfs_file> wrap(sqlite3_file* file, const char* name, int flags) override;
+
+        private:
+        class file;
+
+        /** What happens to one call. */
+        struct fault
+        {
+            std::chrono::microseconds delay{0};
+            int error = SQLITE_OK;
+            bool short_read = false;
+        };
+
+        fault draw(io_operation operation, file_kind kind, bool may_fail);
+
+        mutable std::mutex m_mutex;
+        std::mt19937_64 m_random;
+        std::array<fault_config, io_stats::operation_count> m_configs;
+        fault_stats m_stats;
+    };
+}
+
+#endif
@@ -6,27 +6,22 @@
 
 #include <sqlite3.h>
 
+#include <atomic>
+#include <cstdint>
+#include <deque>
 #include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
-namespace sqlite {
-    template<std::size_t N>
-    struct placeholder_template {
-        static placeholder_template pt;
-    };
-
-    template<std::size_t N>
-    placeholder_template<N> placeholder_template<N>::pt;
-}
-
-namespace std {
-    template<std::size_t N>
-    struct is_placeholder<sqlite::placeholder_template<N> > : std::integral_constant<std::size_t, N> {
-    };
-}
-
 namespace sqlite
 {
     enum class textencoding: int {
@@ -55,6 +50,10 @@ namespace sqlite
         sqlite3_result_text(context, value.c_str(), value.size(), SQLITE_TRANSIENT);
     }
 
+    inline void return_result(sqlite3_context *context, std::string_view value) {
+        sqlite3_result_text64(context, value.data(), value.size(), SQLITE_TRANSIENT, SQLITE_UTF8);
+    }
+
     inline void return_result(sqlite3_context *context, const std::u16string &value) {
         sqlite3_result_text16(context, value.c_str(), value.size() * sizeof(char16_t), SQLITE_TRANSIENT);
     }
@@ -63,10 +62,24 @@ namespace sqlite
         sqlite3_result_value(context, value.handle());
     }
 
+    inline void return_result(sqlite3_context *context, value_ref value) {
+        sqlite3_result_value(context, value.handle());
+    }
+
     inline void return_result(sqlite3_context *context, const blob &value) {
         sqlite3_result_blob(context, value.data(), value.size(), SQLITE_TRANSIENT);
     }
 
+    /** Returns NULL for an empty optional. */
+    template <typename T>
+    void return_result(sqlite3_context *context, const std::optional<T> &value) {
+        if (value.has_value()) {
+            return_result(context, *value);
+        } else {
+            sqlite3_result_null(context);
+        }
+    }
+
     template <typename T>
     struct function_traits : public function_traits<decltype(&T::operator())>
     {};
@@ -127,82 +140,340 @@ namespace sqlite
         };
     };
 
-    template <typename T>
-    struct SQLiteFunctionTraits : public SQLiteFunctionTraits<decltype(&T::operator())>
-    {};
-
-    template <typename C, typename R>
-    struct SQLiteFunctionTraits<R(C::*)(const std::vector<value> &)> {
-        typedef std::function<R(const std::vector<value> &)> f_type;
+    /**
+     * Converts a "sqlite3_value" argument of a function into the parameter type of the callable.
+     * The specializations read the value directly with the matching sqlite3_value_* interface
+     * so no intermediate value object, and for numbers no allocation at all, is needed.
+     * Types without a specialization are converted through a sqlite::value.
+     */
+    template <typename T, typename Enable = void>
+    struct argument {
+        static T get(sqlite3_value *arg) {
+            return value(arg);
+        }
     };
 
-    template <typename C, typename R>
-    struct SQLiteFunctionTraits<R(C::*)(const std::vector<value> &) const> {
-        typedef std::function<R(const std::vector<value> &)> f_type;
+    template <>
+    struct argument<bool> {
+        static bool get(sqlite3_value *arg) noexcept {
+            return sqlite3_value_int(arg) != 0;
+        }
     };
 
-    template <typename R>
-    struct SQLiteFunctionTraits<R(*)(const std::vector<value> &)> {
-        typedef std::function<R(const std::vector<value> &)> f_type;
+    template <>
+    struct argument<int> {
+        static int get(sqlite3_value *arg) noexcept {
+            return sqlite3_value_int(arg);
+        }
     };
 
-    template <typename R>
-    struct SQLiteFunctionTraits<R(&)(const std::vector<value> &)> {
-        typedef std::function<R(const std::vector<value> &)> f_type;
+    template <typename T>
+    struct argument<T, typename std::enable_if<std::is_integral<T>::value>::type> {
+        static T get(sqlite3_value *arg) noexcept {
+            return static_cast<T>(sqlite3_value_int64(arg));
+        }
     };
 
     template <typename T>
-    struct collation_traits : public collation_traits<decltype(&T::operator())>
-    {};
+    struct argument<T, typename std::enable_if<std::is_floating_point<T>::value>::type> {
+        static T get(sqlite3_value *arg) noexcept {
+            return static_cast<T>(sqlite3_value_double(arg));
+        }
+    };
 
-    template <typename C>
-    struct collation_traits<int(C::*)(const std::string&, const std::string&)> {
-        typedef std::function<int(const std::string&, const std::string&)> f_type;
+    /** The view refers to memory owned by SQLite and is only valid during the function call. */
+    template <>
+    struct argument<std::string_view> {
+        static std::string_view get(sqlite3_value *arg) noexcept {
+            const char *text = reinterpret_cast<const char *>(sqlite3_value_text(arg));
+            // sqlite3_value_bytes must be called after sqlite3_value_text to get the size of the converted text.
+            return std::string_view(text != nullptr ? text : "", sqlite3_value_bytes(arg));
+        }
     };
 
-    template <typename C>
-    struct collation_traits<int(C::*)(const std::string&, const std::string&) const> {
-        typedef std::function<int(const std::string&, const std::string&)> f_type;
+    template <>
+    struct argument<std::string> {
+        static std::string get(sqlite3_value *arg) {
+            return std::string(argument<std::string_view>::get(arg));
+        }
     };
 
     template <>
-    struct collation_traits<int(*)(const std::string&, const std::string&)> {
-        typedef std::function<int(const std::string&, const std::string&)> f_type;
+    struct argument<std::u16string> {
+        static std::u16string get(sqlite3_value *arg) {
+            const char16_t *text = reinterpret_cast<const char16_t *>(sqlite3_value_text16(arg));
+            return std::u16string(text != nullptr ? text : u"", sqlite3_value_bytes16(arg) / sizeof(char16_t));
+        }
     };
 
     template <>
-    struct collation_traits<int(&)(const std::string&, const std::string&)> {
-        typedef std::function<int(const std::string&, const std::string&)> f_type;
+    struct argument<blob> {
+        static blob get(sqlite3_value *arg) {
+            const void *data = sqlite3_value_blob(arg);
+            return blob(data, data != nullptr ? sqlite3_value_bytes(arg) : 0);
+        }
+    };
+
+    /** Passes NULL as an empty optional, so a function can tell it from an empty string or zero. */
+    template <typename T>
+    struct argument<std::optional<T>> {
+        static std::optional<T> get(sqlite3_value *arg) {
+            if (sqlite3_value_type(arg) == SQLITE_NULL) {
+                return std::nullopt;
+            }
+            return argument<T>::get(arg);
+        }
     };
 
     template<typename T>
     typename std::remove_reference<T>::type get(sqlite3_value **values, const std::size_t index) {
-        return value(values[index]);
+        return argument<typename std::decay<T>::type>::get(values[index]);
     }
 
-    template<typename F, typename C, std::size_t... Is>
-    typename function_traits<F>::f_type
-    bind_class_method(F method, C* classObject, std::index_sequence<Is...>) {
-        return std::bind(method, classObject, placeholder_template<Is+1>::pt...);
-    }
+    /**
+     * Turns the text of a function argument into a T for use with sqlite::cached.
+     * By default T is constructed from the argument text as a std::string,
+     * specialize this for types that are built differently.
+     */
+    template <typename T>
+    struct argument_compiler {
+        static T compile(sqlite3_value *arg) {
+            return T(std::string(argument<std::string_view>::get(arg)));
+        }
+    };
+
+    /**
+     * A function parameter type for arguments that are expensive to preprocess, like a regular expression pattern.
+     * The argument is compiled into a T once and kept by SQLite as auxiliary data of the statement.
+     * As long as the argument is a constant of the statement following rows reuse the compiled T.
+     * A NULL argument is compiled from empty text, a std::optional<cached<T>> parameter receives it as std::nullopt.
+     */
+    template <typename T>
+    class cached {
+        public:
+        /** Returns the compiled argument.
+         * @returns the compiled argument, only valid during the function call
+         */
+        const T& get() const noexcept {
+            return *m_value;
+        }
 
-    template<typename F, typename C>
-    typename function_traits<F>::f_type
-    bind_class_method(F method, C* classObject) {
-        return bind_class_method(method, classObject, std::make_index_sequence<function_traits<F>::nargs>{});
+        const T& operator*() const noexcept {
+            return *m_value;
+        }
+
+        const T* operator->() const noexcept {
+            return m_value;
+        }
+
+        /** Loads the compiled argument from the auxiliary data of the function or compiles it when there is none.
+         * @param[in] context the context of the function call
+         * @param[in] arg     the argument to compile
+         * @param[in] index   the index of the argument
+         * @returns the compiled argument
+         */
+        static cached load(sqlite3_context *context, sqlite3_value *arg, const int index) {
+            const auto *stored = static_cast<const std::shared_ptr<const T>*>(sqlite3_get_auxdata(context, index));
+            if (stored != nullptr) {
+                return cached(stored->get(), nullptr);
+            }
+            std::shared_ptr<const T> compiled = std::make_shared<const T>(argument_compiler<T>::compile(arg));
+            // SQLite drops its copy right away when it cannot keep it, like outside a prepared statement,
+            // so this call uses its own.
+            sqlite3_set_auxdata(context, index, new std::shared_ptr<const T>(compiled), &destroy);
+            const T *value = compiled.get();
+            return cached(value, std::move(compiled));
+        }
+
+        private:
+        cached(const T *value, std::shared_ptr<const T> owned) noexcept :
+            m_value(value),
+            m_owned(std::move(owned))
+        {}
+
+        static void destroy(void *value) {
+            delete static_cast<std::shared_ptr<const T>*>(value);
+        }
+
+        const T *m_value;
+        std::shared_ptr<const T> m_owned;
+    };
+
+    template <typename T>
+    struct is_cached : std::false_type {};
+
+    template <typename T>
+    struct is_cached<cached<T>> : std::true_type {};
+
+    template <typename T>
+    struct is_optional_cached : std::false_type {};
+
+    template <typename T>
+    struct is_optional_cached<std::optional<cached<T>>> : std::true_type {};
+
+    template<typename T>
+    typename std::remove_reference<T>::type get(sqlite3_context *context, sqlite3_value **values, const std::size_t index) {
+        using ArgumentType = typename std::decay<T>::type;
+        if constexpr (is_cached<ArgumentType>::value) {
+            return ArgumentType::load(context, values[index], static_cast<int>(index));
+        } else if constexpr (is_optional_cached<ArgumentType>::value) {
+            if (sqlite3_value_type(values[index]) == SQLITE_NULL) {
+                return std::nullopt;
+            }
+            return ArgumentType::value_type::load(context, values[index], static_cast<int>(index));
+        } else {
+            (void)context;
+            return get<T>(values, index);
+        }
     }
 
-    template<typename R, typename... Args, std::size_t... Is>
-    R invoke(std::function<R(Args...)> func, sqlite3_value **values, std::index_sequence<Is...>) {
+    template<typename F, std::size_t... Is>
+    auto invoke_callable(F& func, sqlite3_context *context, sqlite3_value **values, std::index_sequence<Is...>) {
         // So there is no warnings when no arguments are given to function.
+        (void)context;
         (void)values;
 
-        return func(get<typename function_traits<decltype(func)>::template arg<Is>::type>(values, Is) ...);
+        return func(get<typename function_traits<F>::template arg<Is>::type>(context, values, Is) ...);
+    }
+
+    template<typename C, typename M, std::size_t... Is>
+    void invoke_method(C* object, M method, sqlite3_context *context, sqlite3_value **values, std::index_sequence<Is...>) {
+        // So there is no warnings when no arguments are given to the method.
+        (void)context;
+        (void)values;
+
+        (object->*method)(get<typename function_traits<M>::template arg<Is>::type>(context, values, Is) ...);
+    }
+
+    /** Calls a member function of object with the arguments of a function call, without wrapping it in a std::function.
+     */
+    template<typename C, typename M>
+    void invoke_method(C* object, M method, sqlite3_context *context, sqlite3_value **values) {
+        invoke_method(object, method, context, values, std::make_index_sequence<function_traits<M>::nargs>{});
     }
 
-    template<typename R, typename... Args>
-    R invoke(std::function<R(Args...)> func, sqlite3_value **values) {
-        return invoke(func, values, std::index_sequence_for<Args...>{});
+    /** Hit and miss counters of a memoized function, safe to read from any thread.
+     */
+    struct memoization_counters {
+        /** Calls answered from the cache. */
+        std::atomic<uint64_t> hits{0};
+        /** Calls that had to run the function. */
+        std::atomic<uint64_t> misses{0};
+        /** Results dropped from the cache to stay within its capacity. */
+        std::atomic<uint64_t> evictions{0};
+    };
+
+    /** Appends the type and content of an argument to a memoization key.
+     * Every part is prefixed by its type and text and blobs by their size, so different argument lists never share a key.
+     */
+    inline void append_memoization_key(std::string& key, sqlite3_value *arg) {
+        const int type = sqlite3_value_type(arg);
+        key += static_cast<char>(type);
+        switch (type) {
+            case SQLITE_INTEGER: {
+                const sqlite3_int64 number = sqlite3_value_int64(arg);
+                key.append(reinterpret_cast<const char*>(&number), sizeof(number));
+                break;
+            }
+            case SQLITE_FLOAT: {
+                const double number = sqlite3_value_double(arg);
+                key.append(reinterpret_cast<const char*>(&number), sizeof(number));
+                break;
+            }
+            case SQLITE_TEXT:
+            case SQLITE_BLOB: {
+                const char *data = static_cast<const char*>(
+                    type == SQLITE_TEXT ? static_cast<const void*>(sqlite3_value_text(arg)) : sqlite3_value_blob(arg));
+                const int size = sqlite3_value_bytes(arg);
+                key.append(reinterpret_cast<const char*>(&size), sizeof(size));
+                key.append(data != nullptr ? data : "", size);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    /**
+     * Wraps a deterministic function with a bounded least recently used cache of its results,
+     * keyed by the values of its arguments. The function itself is left unchanged and is not
+     * called while the cache is locked, so it may run SQL on the same connection.
+     */
+    template <typename F>
+    class memoized_function {
+        public:
+        using result_type = typename std::decay<typename function_traits<F>::result_type>::type;
+
+        static_assert(
+            !std::is_same<result_type, std::string_view>::value && !std::is_same<result_type, value_ref>::value,
+            "A memoized function has to return a value that owns its data");
+
+        memoized_function(F&& function, const std::size_t capacity) :
+            m_function(std::move(function)),
+            m_capacity(capacity < 1 ? 1 : capacity),
+            m_counters(std::make_shared<memoization_counters>())
+        {}
+
+        const std::shared_ptr<memoization_counters>& counters() const noexcept {
+            return m_counters;
+        }
+
+        result_type operator()(sqlite3_context *context, sqlite3_value **values) {
+            std::string key;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_key.clear();
+                for (std::size_t i = 0; i < function_traits<F>::nargs; ++i) {
+                    append_memoization_key(m_key, values[i]);
+                }
+
+                const auto found = m_index.find(m_key);
+                if (found != m_index.end()) {
+                    m_entries.splice(m_entries.begin(), m_entries, found->second);
+                    ++m_counters->hits;
+                    return found->second->second;
+                }
+                key = m_key;
+            }
+
+            ++m_counters->misses;
+            result_type result = invoke_callable(m_function, context, values, std::make_index_sequence<function_traits<F>::nargs>{});
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            // Another thread may have computed the same result in the meantime.
+            if (m_index.find(key) == m_index.end()) {
+                m_entries.emplace_front(std::move(key), result);
+                m_index.emplace(std::string_view(m_entries.front().first), m_entries.begin());
+                if (m_entries.size() > m_capacity) {
+                    m_index.erase(std::string_view(m_entries.back().first));
+                    m_entries.pop_back();
+                    ++m_counters->evictions;
+                }
+            }
+            return result;
+        }
+
+        private:
+        using entry_list = std::list<std::pair<std::string, result_type>>;
+
+        F m_function;
+        std::size_t m_capacity;
+        std::shared_ptr<memoization_counters> m_counters;
+        std::mutex m_mutex;
+        std::string m_key;
+        // List nodes never move so the keys in the index can refer to the strings in the list.
+        entry_list m_entries;
+        std::unordered_map<std::string_view, typename entry_list::iterator> m_index;
+    };
+
+    template <typename F>
+    auto invoke_scalar(F& func, sqlite3_context *context, sqlite3_value **values) {
+        return invoke_callable(func, context, values, std::make_index_sequence<function_traits<F>::nargs>{});
+    }
+
+    template <typename F>
+    auto invoke_scalar(memoized_function<F>& func, sqlite3_context *context, sqlite3_value **values) {
+        return func(context, values);
     }
 
     template <typename F>
@@ -214,7 +485,7 @@ namespace sqlite
         assert(userScalarFunction != 0);
 
         try {
-            auto result = invoke(*userScalarFunction, values);
+            auto result = invoke_scalar(*userScalarFunction, context, values);
             return_result(context, result);
         } catch (const std::bad_alloc&) {
             sqlite3_result_error_nomem(context);
@@ -227,18 +498,38 @@ namespace sqlite
         }
     }
 
+    /**
+     * Adapts a general function taking a std::vector of values to the value_span interface.
+     * Every call copies the arguments into a new vector, prefer taking a value_span directly.
+     */
+    template <typename F>
+    class vector_function_adapter {
+        public:
+        explicit vector_function_adapter(F&& function) :
+            m_function(std::move(function))
+        {}
+
+        auto operator()(value_span args) {
+            std::vector<value> argValues;
+            argValues.reserve(args.size());
+            for (value_ref arg : args) {
+                argValues.push_back(value(arg.handle()));
+            }
+
+            return m_function(argValues);
+        }
+
+        private:
+        F m_function;
+    };
+
     template <typename F>
     void internal_general_scalar_function(sqlite3_context* context, int argc, sqlite3_value **values) {
         F* userScalarFunction = static_cast<F*>(sqlite3_user_data(context));
         assert(userScalarFunction != 0);
 
         try {
-            std::vector<value> argValues;
-            for (int i = 0; i < argc; ++i) {
-                argValues.push_back(value(values[i]));
-            }
-
-            auto result = (*userScalarFunction)(argValues);
+            auto result = (*userScalarFunction)(value_span(values, argc));
             return_result(context, result);
         } catch (const std::bad_alloc&) {
             sqlite3_result_error_nomem(context);
@@ -251,13 +542,105 @@ namespace sqlite
         }
     }
 
+    /**
+     * Adapts a collation taking two const std::string& to the std::string_view interface.
+     * The text is copied into buffers that are reused between comparisons so after
+     * the first few comparisons no allocation takes place.
+     */
+    template <typename F>
+    class string_collation_adapter {
+        public:
+        explicit string_collation_adapter(F&& function) :
+            m_function(std::move(function))
+        {}
+
+        int operator()(std::string_view lhs, std::string_view rhs) {
+            m_lhs.assign(lhs.data(), lhs.size());
+            m_rhs.assign(rhs.data(), rhs.size());
+            return m_function(static_cast<const std::string&>(m_lhs), static_cast<const std::string&>(m_rhs));
+        }
+
+        private:
+        F m_function;
+        std::string m_lhs;
+        std::string m_rhs;
+    };
+
+    /**
+     * Selects how a collation callable is stored.
+     * Callables taking two std::string_view are stored as is, callables taking two
+     * const std::string& are wrapped in a string_collation_adapter.
+     */
+    template <typename F>
+    struct collation_callable {
+        static_assert(
+            std::is_invocable_r<int, F&, std::string_view, std::string_view>::value ||
+            std::is_invocable_r<int, F&, const std::string&, const std::string&>::value,
+            "A collation must be callable as int(std::string_view, std::string_view) or int(const std::string&, const std::string&)");
+
+        typedef typename std::conditional<
+            std::is_invocable_r<int, F&, std::string_view, std::string_view>::value,
+            F,
+            string_collation_adapter<F>>::type type;
+    };
+
+    /**
+     * A collation that orders text by a normalized sort key, for example case folded or
+     * natural sort order text. The key of a text is computed once and cached so repeated
+     * comparisons of the same text only cost a lookup and a memcmp.
+     */
+    template <typename F>
+    class sortkey_collation {
+        public:
+        sortkey_collation(F&& key_function, const std::size_t capacity) :
+            m_key_function(std::move(key_function)),
+            m_capacity(capacity < 2 ? 2 : capacity)
+        {}
+
+        int operator()(std::string_view lhs, std::string_view rhs) {
+            // Make room for both keys up front so the first one is not evicted by the second.
+            if (m_keys.size() + 2 > m_capacity) {
+                m_keys.clear();
+                m_entries.clear();
+            }
+
+            const std::string& lhsKey = key(lhs);
+            const std::string& rhsKey = key(rhs);
+            return lhsKey.compare(rhsKey);
+        }
+
+        private:
+        struct entry {
+            std::string text;
+            std::string key;
+        };
+
+        F m_key_function;
+        std::size_t m_capacity;
+        // A deque never moves its elements so the views used as map keys stay valid.
+        std::deque<entry> m_entries;
+        std::unordered_map<std::string_view, const entry*> m_keys;
+
+        const std::string& key(std::string_view text) {
+            const auto found = m_keys.find(text);
+            if (found != m_keys.end()) {
+                return found->second->key;
+            }
+
+            m_entries.push_back(entry{std::string(text), std::string(m_key_function(text))});
+            const entry& added = m_entries.back();
+            m_keys.emplace(std::string_view(added.text), &added);
+            return added.key;
+        }
+    };
+
     template <typename F>
     int internal_collation_function(void* context, int bytes1, const void* string_bytes1, int bytes2, const void* string_bytes2) {
         F* userCollationFunction = static_cast<F*>(context);
         assert(userCollationFunction != 0);
 
-        const std::string string1(static_cast<const char*>(string_bytes1), bytes1);
-        const std::string string2(static_cast<const char*>(string_bytes2), bytes2);
+        const std::string_view string1(static_cast<const char*>(string_bytes1), bytes1);
+        const std::string_view string2(static_cast<const char*>(string_bytes2), bytes2);
 
         int result = (*userCollationFunction)(string1, string2);
         return result;
@@ -272,29 +655,81 @@ namespace sqlite
         delete callback;
     }
 
+    template<typename T, typename Enable = void>
+    struct has_window_members : std::false_type {};
+
+    /** True when an aggregate class has both inverse() and value() members and can run as a sliding window function.
+     */
+    template<typename T>
+    struct has_window_members<T, std::void_t<decltype(&T::inverse), decltype(&T::value)>> : std::true_type {};
+
+    /** Runs an aggregate or window function with one instance of T per group or window, kept in SQLite's aggregate context.
+     * SQLite runs every group of a GROUP BY, and every use of the function in a query, through the same registration,
+     * so the state cannot live in the registration itself.
+     * Keeping it in the aggregate context also avoids a separate heap allocation per group.
+     */
     template<typename T>
     class aggregate_wrapper {
         public:
-        aggregate_wrapper() :
-            m_implementation()
-        {}
-
         void step(sqlite3_context* context, int argc, sqlite3_value **values) {
-            (void)context;
             (void)argc;
-            invoke(bind_class_method(&T::step, &m_implementation), values);
+            T* implementation = instance(context, true);
+            invoke_method(implementation, &T::step, context, values);
         }
 
-        void finalize(sqlite3_context* context) {
-            return_result(context, m_implementation.finalize());
+        void inverse(sqlite3_context* context, int argc, sqlite3_value **values) {
+            (void)argc;
+            T* implementation = instance(context, true);
+            invoke_method(implementation, &T::inverse, context, values);
+        }
+
+        void value(sqlite3_context* context) {
+            T* implementation = instance(context, true);
+            return_result(context, implementation->value());
         }
 
-        void reset() {
-            m_implementation = T();
+        void finalize(sqlite3_context* context) {
+            T* implementation = instance(context, false);
+            if (implementation == nullptr) {
+                // No rows were stepped so there is no state to finalize.
+                T empty;
+                return_result(context, empty.finalize());
+                return;
+            }
+
+            // Destroy the instance even when finalize throws since SQLite frees the memory afterwards.
+            struct destroy_on_exit {
+                T* implementation;
+                ~destroy_on_exit() { implementation->~T(); }
+            } guard{implementation};
+            return_result(context, implementation->finalize());
         }
 
         private:
-        T m_implementation;
+        struct slot {
+            bool constructed;
+            typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+        };
+
+        // SQLite only guarantees 8 byte alignment for the memory it hands out.
+        static_assert(alignof(slot) <= 8, "aggregate classes cannot need more than 8 byte alignment");
+
+        static T* instance(sqlite3_context* context, const bool create) {
+            slot* state = static_cast<slot*>(sqlite3_aggregate_context(context, create ? static_cast<int>(sizeof(slot)) : 0));
+            if (state == nullptr) {
+                if (create) {
+                    throw std::bad_alloc();
+                }
+                return nullptr;
+            }
+
+            // The memory is zeroed when first allocated, so constructed starts out false.
+            if (!state->constructed) {
+                new (&state->storage) T();
+                state->constructed = true;
+            }
+            return reinterpret_cast<T*>(&state->storage);
+        }
     };
 
     template <typename T>
@@ -315,6 +750,42 @@ namespace sqlite
         }
     }
 
+    template <typename T>
+    void internal_inverse(sqlite3_context* context, int argc, sqlite3_value **values) {
+        T* wrapper = static_cast<T*>(sqlite3_user_data(context));
+        assert(wrapper != 0);
+
+        try {
+            wrapper->inverse(context, argc, values);
+        } catch (const std::bad_alloc&) {
+            sqlite3_result_error_nomem(context);
+        } catch (const sqlite::exception& e) {
+            sqlite3_result_error(context, e.what(), e.errcode);
+        } catch (const std::exception& e) {
+            sqlite3_result_error(context, e.what(), SQLITE_ABORT);
+        } catch (...) {
+            sqlite3_result_error_code(context, SQLITE_ABORT);
+        }
+    }
+
+    template <typename T>
+    void internal_value(sqlite3_context* context) {
+        T* wrapper = static_cast<T*>(sqlite3_user_data(context));
+        assert(wrapper != 0);
+
+        try {
+            wrapper->value(context);
+        } catch (const std::bad_alloc&) {
+            sqlite3_result_error_nomem(context);
+        } catch (const sqlite::exception& e) {
+            sqlite3_result_error(context, e.what(), e.errcode);
+        } catch (const std::exception& e) {
+            sqlite3_result_error(context, e.what(), SQLITE_ABORT);
+        } catch (...) {
+            sqlite3_result_error_code(context, SQLITE_ABORT);
+        }
+    }
+
     template <typename T>
     void internal_final(sqlite3_context* context) {
         T* wrapper = static_cast<T*>(sqlite3_user_data(context));
@@ -322,7 +793,6 @@ namespace sqlite
 
         try {
             wrapper->finalize(context);
-            wrapper->reset();
         } catch (const std::bad_alloc&) {
             sqlite3_result_error_nomem(context);
         } catch (const sqlite::exception& e) {
@@ -0,0 +1,221 @@
+#include "InstrumentedVfs.h"
+
+#include <cmath>
+#include <utility>
+
+namespace sqlite
+{
+    std::chrono::microseconds io_counters::bucket_limit(const std::size_t bucket) noexcept
+    {
+        return std::chrono::microseconds(int64_t(1) << bucket);
+    }
+
+    std::chrono::nanoseconds io_counters::mean() const noexcept
+    {
+        if (calls == 0) {
+            return std::chrono::nanoseconds(0);
+        }
+        return std::chrono::nanoseconds(time.count() / static_cast<int64_t>(calls));
+    }
+
+    std::chrono::microseconds io_counters::percentile(const double fraction) const noexcept
+    {
+        if (calls == 0) {
+            return std::chrono::microseconds(0);
+        }
+        const double wanted = std::ceil(fraction * static_cast<double>(calls));
+        const uint64_t target = wanted < 1.0 ? 1 : static_cast<uint64_t>(wanted);
+        uint64_t seen = 0;
+        for (std::size_t bucket = 0; bucket < bucket_count; ++bucket) {
+            seen += latency[bucket];
+            if (seen >= target) {
+                return bucket_limit(bucket);
+            }
+        }
+        return bucket_limit(bucket_count - 1);
+    }
+
+    io_counters& io_counters::operator+=(const io_counters& other) noexcept
+    {
+        calls += other.calls;
+        bytes += other.bytes;
+        errors += other.errors;
+        time += other.time;
+        for (std::size_t bucket = 0; bucket < bucket_count; ++bucket) {
+            latency[bucket] += other.latency[bucket];
+        }
+        return *this;
+    }
+
+    const io_counters& io_stats::get(const file_kind kind, const io_operation operation) const noexcept
+    {
+        return m_counters[static_cast<std::size_t>(kind)][static_cast<std::size_t>(operation)];
+    }
+
+    io_counters io_stats::total(const io_operation operation) const noexcept
+    {
+        io_counters result;
+        for (const auto& kind : m_counters) {
+            result += kind[static_cast<std::size_t>(operation)];
+        }
+        return result;
+    }
+
+    io_counters io_stats::total(const file_kind kind) const noexcept
+    {
+        io_counters result;
+        for (const io_counters& operation : m_counters[static_cast<std::size_t>(kind)]) {
+            result += operation;
+        }
+        return result;
+    }
+
+    namespace
+    {
+        std::size_t latency_bucket(const uint64_t nanoseconds) noexcept
+        {
+            uint64_t microseconds = nanoseconds / 1000;
+            std::size_t bucket = 0;
+            while (microseconds != 0 && bucket < io_counters::bucket_count - 1) {
+                microseconds >>= 1;
+                ++bucket;
+            }
+            return bucket;
+        }
+    }
+
+    class instrumented_vfs::file : public vfs_file
+    {
+        public:
+        file(sqlite3_file* base, const file_kind kind, counters* kind_counters) noexcept :
+            vfs_file(base, kind),
+            m_counters(kind_counters)
+        {}
+
+        int read(void* buffer, const int amount, const int64_t offset) override
+        {
+            return measure(io_operation::read, amount, [&]() { return vfs_file::read(buffer, amount, offset); });
+        }
+
+        int write(const void* buffer, const int amount, const int64_t offset) override
+        {
+            return measure(io_operation::write, amount, [&]() { return vfs_file::write(buffer, amount, offset); });
+        }
+
+        int truncate(const int64_t size) override
+        {
+            return measure(io_operation::truncate, 0, [&]() { return vfs_file::truncate(size); });
+        }
+
+        int sync(const int flags) override
+        {
+            return measure(io_operation::sync, 0, [&]() { return vfs_file::sync(flags); });
+        }
+
+        int lock(const int level) override
+        {
+            return measure(io_operation::lock, 0, [&]() { return vfs_file::lock(level); });
+        }
+
+        int unlock(const int level) override
+        {
+            return measure(io_operation::lock, 0, [&]() { return vfs_file::unlock(level); });
+        }
+
+        int check_reserved_lock(int* result) override
+        {
+            return measure(io_operation::lock, 0, [&]() { return vfs_file::check_reserved_lock(result); });
+        }
+
+        int shm_map(const int region, const int size, const int extend, void volatile** address) override
+        {
+            return measure(io_operation::shm, 0, [&]() { return vfs_file::shm_map(region, size, extend, address); });
+        }
+
+        int shm_lock(const int offset, const int count, const int flags) override
+        {
+            return measure(io_operation::shm, 0, [&]() { return vfs_file::shm_lock(offset, count, flags); });
+        }
+
+        void shm_barrier() override
+        {
+            measure(io_operation::shm, 0, [&]() {
+                vfs_file::shm_barrier();
+                return SQLITE_OK;
+            });
+        }
+
+        int shm_unmap(const int delete_flag) override
+        {
+            return measure(io_operation::shm, 0, [&]() { return vfs_file::shm_unmap(delete_flag); });
+        }
+
+        private:
+        template <typename F>
+        int measure(const io_operation operation, const int bytes, F&& function)
+        {
+            const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            const int errorcode = function();
+            const uint64_t elapsed = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+
+            counters& target = m_counters[static_cast<std::size_t>(operation)];
+            target.calls.fetch_add(1, std::memory_order_relaxed);
+            target.bytes.fetch_add(static_cast<uint64_t>(bytes), std::memory_order_relaxed);
+            if (errorcode != SQLITE_OK && errorcode != SQLITE_IOERR_SHORT_READ) {
+                target.errors.fetch_add(1, std::memory_order_relaxed);
+            }
+            target.nanoseconds.fetch_add(elapsed, std::memory_order_relaxed);
+            target.latency[latency_bucket(elapsed)].fetch_add(1, std::memory_order_relaxed);
+            return errorcode;
+        }
+
+        counters* m_counters;
+    };
+
+    instrumented_vfs::instrumented_vfs(std::string name, const std::string& base) :
+        vfs_shim(std::move(name), base),
+        m_counters(new counters[io_stats::kind_count * io_stats::operation_count])
+    {}
+
+    instrumented_vfs::~instrumented_vfs() = default;
+
+    io_stats instrumented_vfs::stats() const noexcept
+    {
+        io_stats result;
+        for (std::size_t kind = 0; kind < io_stats::kind_count; ++kind) {
+            for (std::size_t operation = 0; operation < io_stats::operation_count; ++operation) {
+                const counters& source = m_counters[kind * io_stats::operation_count + operation];
+                io_counters& target = result.m_counters[kind][operation];
+                target.calls = source.calls.load(std::memory_order_relaxed);
+                target.bytes = source.bytes.load(std::memory_order_relaxed);
+                target.errors = source.errors.load(std::memory_order_relaxed);
+                target.time = std::chrono::nanoseconds(static_cast<int64_t>(source.nanoseconds.load(std::memory_order_relaxed)));
+                for (std::size_t bucket = 0; bucket < io_counters::bucket_count; ++bucket) {
+                    target.latency[bucket] = source.latency[bucket].load(std::memory_order_relaxed);
+                }
+            }
+        }
+        return result;
+    }
+
+    void instrumented_vfs::reset() noexcept
+    {
+        for (std::size_t i = 0; i < io_stats::kind_count * io_stats::operation_count; ++i) {
+            counters& target = m_counters[i];
+            target.calls.store(0, std::memory_order_relaxed);
+            target.bytes.store(0, std::memory_order_relaxed);
+            target.errors.store(0, std::memory_order_relaxed);
+            target.nanoseconds.store(0, std::memory_order_relaxed);
+            for (std::atomic<uint64_t>& bucket : target.latency) {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    std::unique_ptr<vfs_file> instrumented_vfs::wrap(sqlite3_file* base, const char*, const int flags)
+    {
+        const file_kind kind = file_kind_of(flags);
+        counters* kind_counters = &m_counters[static_cast<std::size_t>(kind) * io_stats::operation_count];
+        return std::unique_ptr<vfs_file>(new file(base, kind, kind_counters));
+    }
+}
@@ -0,0 +1,146 @@
+/** @file */
+
+#ifndef __SQLITEXX_SQLITE_INSTRUMENTEDVFS_H__
+#define __SQLITEXX_SQLITE_INSTRUMENTEDVFS_H__
+
+#include "VfsShim.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace sqlite
+{
+    /** The file operations sqlite::instrumented_vfs measures.
+     */
+    enum class io_operation: int {
+        read     = 0, ///< xRead
+        write    = 1, ///< xWrite
+        sync     = 2, ///< xSync
+        truncate = 3, ///< xTruncate
+        lock     = 4, ///< xLock, xUnlock and xCheckReservedLock
+        shm      = 5, ///< xShmMap, xShmLock, xShmBarrier and xShmUnmap on the WAL index
+    };
+
+    /** The calls of one operation on one kind of file, counted by sqlite::instrumented_vfs.
+     * Latencies are kept in a histogram with power of two buckets: bucket 0 counts calls that took less than
+     * a microsecond and bucket i counts calls that took from 2^(i-1) up to 2^i microseconds, the last bucket
+     * also counts everything slower.
+     */
+    struct io_counters
+    {
+        static constexpr std::size_t bucket_count = 32;
+
+        uint64_t calls = 0;                          ///< number of calls
+        uint64_t bytes = 0;                          ///< bytes read or written, 0 for other operations
+        uint64_t errors = 0;                         ///< calls that failed or returned SQLITE_BUSY, short reads do not count
+        std::chrono::nanoseconds time{0};            ///< time spent in all calls
+        std::array<uint64_t, bucket_count> latency{}; ///< the latency histogram
+
+        /** Returns the exclusive upper bound of a histogram bucket.
+         * @param[in] bucket the bucket, from 0 to bucket_count - 1
+         */
+        static std::chrono::microseconds bucket_limit(std::size_t bucket) noexcept;
+
+        /** Returns the mean latency of a call, 0 if there was none.
+         */
+        std::chrono::nanoseconds mean() const noexcept;
+
+        /** Returns an upper bound of a latency percentile, the limit of the bucket it falls into.
+         * @param[in] fraction the percentile as a fraction, for example 0.99 for the 99th percentile
+         * @returns the upper bound, 0 if there were no calls
+         */
+        std::chrono::microseconds percentile(double fraction) const noexcept;
+
+        /** Adds the counters of other to these.
+         * @param[in] other the counters to add
+         * @returns *this
+         */
+        io_counters& operator+=(const io_counters& other) noexcept;
+    };
+
+    /** A snapshot of the counters of sqlite::instrumented_vfs per kind of file and operation.
+     */
+    class io_stats
+    {
+        public:
+        static constexpr std::size_t kind_count = 4;
+        static constexpr std::size_t operation_count = 6;
+
+        /** Returns the counters of one operation on one kind of file.
+         */
+        const io_counters& get(file_kind kind, io_operation operation) const noexcept;
+
+        /** Returns the counters of one operation summed over all kinds of files.
+         */
+        io_counters total(io_operation operation) const noexcept;
+
+        /** Returns the counters of all operations on one kind of file.
+         */
+        io_counters total(file_kind kind) const noexcept;
+
+        private:
+        friend class instrumented_vfs;
+
+        std::array<std::array<io_counters, operation_count>, kind_count> m_counters;
+    };
+
+    /**
+     * A VFS that passes every call to the underlying VFS and counts the calls, bytes and latency of each operation
+     * per kind of file, to tell the time a query spends in the file system from the time SQLite spends computing.
+     * Connections use it by opening the database with the name of the VFS:
+     * @code
+     * sqlite::instrumented_vfs vfs("instrumented");
+     * sqlite::dbconnection connection("database.db", sqlite::openmode::read_write | sqlite::openmode::create,
+     *                                 std::chrono::seconds(5), vfs.name());
+     * @endcode
+     * Counting uses relaxed atomics, so the VFS can be shared by connections on several threads
+     * and read from another one. The VFS must outlive the connections using it.
+     */
+    class instrumented_vfs : public vfs_shim
+    {
+        public:
+
+        /** Registers the VFS.
+         * @param[in] name the name of the VFS
+         * @param[in] base the name of the underlying VFS, the default VFS when empty
+         * @throws SQLiteXXException if the underlying VFS does not exist or the name is taken
+         * @throws sqlite::exception if the VFS could not be registered
+         */
+        explicit instrumented_vfs(std::string name = "sqlitexx-instrumented", const std::string& base = std::string());
+
+        ~instrumented_vfs() override;
+
+        /** Returns the counters collected since construction or the last reset.
+         * Calls running at the same time may be partially counted.
+         */
+        io_stats stats() const noexcept;
+
+        /** Sets every counter to 0.
+         */
+        void reset() noexcept;
+
+        protected:
+        std::unique_ptr<vfs_file> wrap(sqlite3_file* file, const char* name, int flags) override;
+
+        private:
+        struct counters
+        {
+            std::atomic<uint64_t> calls{0};
+            std::atomic<uint64_t> bytes{0};
+            std::atomic<uint64_t> errors{0};
+            std::atomic<uint64_t> nanoseconds{0};
+            std::array<std::atomic<uint64_t>, io_counters::bucket_count> latency{};
+        };
+
+        class file;
+
+        std::unique_ptr<counters[]> m_counters;
+    };
+}
+
+#endif
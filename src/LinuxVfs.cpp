@@ -0,0 +1,333 @@
+#include "LinuxVfs.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+#ifdef __linux__
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace sqlite
+{
+#ifdef __linux__
+    namespace
+    {
+        // The start of the unixFile struct every VFS of the unix family opens, unchanged since SQLite 3.7.
+        struct unix_file_prefix
+        {
+            const sqlite3_io_methods* methods;
+            sqlite3_vfs* vfs;
+            void* inode;
+            int descriptor;
+        };
+
+        // Returns the descriptor the underlying VFS opened name with, or -1 if it is not a unix VFS
+        // or the descriptor does not refer to the file.
+        int descriptor_of(const sqlite3_vfs* vfs, sqlite3_file* file, const char* name) noexcept
+        {
+            if (std::strncmp(vfs->zName, "unix", 4) != 0) {
+                return -1;
+            }
+            const int descriptor = reinterpret_cast<const unix_file_prefix*>(file)->descriptor;
+            struct stat opened;
+            struct stat named;
+            if (descriptor < 0 || fstat(descriptor, &opened) != 0 || stat(name, &named) != 0) {
+                return -1;
+            }
+            return opened.st_dev == named.st_dev && opened.st_ino == named.st_ino ? descriptor : -1;
+        }
+
+        // O_DIRECT needs buffers, offsets and sizes aligned to the logical block size, which is at most a page.
+        constexpr int64_t direct_alignment = 4096;
+
+        int64_t align_down(const int64_t value) noexcept
+        {
+            return value & ~(direct_alignment - 1);
+        }
+
+        int64_t align_up(const int64_t value) noexcept
+        {
+            return align_down(value + direct_alignment - 1);
+        }
+
+        struct aligned_free
+        {
+            void operator()(char* pointer) const noexcept
+            {
+                std::free(pointer);
+            }
+        };
+
+        class aligned_buffer
+        {
+            public:
+            char* data() const noexcept
+            {
+                return m_data.get();
+            }
+
+            bool reserve(const std::size_t size) noexcept
+            {
+                if (size <= m_size) {
+                    return true;
+                }
+                void* memory = nullptr;
+                if (posix_memalign(&memory, direct_alignment, size) != 0) {
+                    return false;
+                }
+                m_data.reset(static_cast<char*>(memory));
+                m_size = size;
+                return true;
+            }
+
+            private:
+            std::unique_ptr<char, aligned_free> m_data;
+            std::size_t m_size = 0;
+        };
+    }
+
+    class linux_vfs::file : public vfs_file
+    {
+        public:
+        file(sqlite3_file* base, const linux_vfs_options& options, const int descriptor, const bool direct) noexcept :
+            vfs_file(base, file_kind::main_database),
+            m_options(options),
+            m_descriptor(descriptor),
+            m_direct(direct)
+        {}
+
+        int close() override
+        {
+            // The underlying VFS may hand the descriptor to a later connection, which expects buffered I/O.
+            if (m_direct) {
+                set_direct(false);
+            }
+            return vfs_file::close();
+        }
+
+        int read(void* buffer, const int amount, const int64_t offset) override
+        {
+            const bool sequential = track(offset, amount);
+            if (m_direct) {
+                return read_direct(buffer, amount, offset, sequential);
+            }
+            if (sequential) {
+                advise();
+            }
+            return vfs_file::read(buffer, amount, offset);
+        }
+
+        int write(const void* buffer, const int amount, const int64_t offset) override
+        {
+            if (!m_direct) {
+                return vfs_file::write(buffer, amount, offset);
+            }
+            invalidate();
+            if (offset % direct_alignment != 0 || amount % direct_alignment != 0) {
+                // Databases with pages smaller than the alignment, and the file header, are written buffered.
+                set_direct(false);
+                const int errorcode = vfs_file::write(buffer, amount, offset);
+                set_direct(true);
+                return errorcode;
+            }
+            if (!m_write_buffer.reserve(static_cast<std::size_t>(amount))) {
+                return SQLITE_IOERR_NOMEM;
+            }
+            std::memcpy(m_write_buffer.data(), buffer, static_cast<std::size_t>(amount));
+            std::size_t written = 0;
+            while (written < static_cast<std::size_t>(amount)) {
+                const ssize_t result = pwrite(m_descriptor, m_write_buffer.data() + written, static_cast<std::size_t>(amount) - written, offset + static_cast<int64_t>(written));
+                if (result < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    return errno == ENOSPC || errno == EDQUOT ? SQLITE_FULL : SQLITE_IOERR_WRITE;
+                }
+                written += static_cast<std::size_t>(result);
+            }
+            return SQLITE_OK;
+        }
+
+        int truncate(const int64_t size) override
+        {
+            invalidate();
+            return vfs_file::truncate(size);
+        }
+
+        // Another connection can change the file between transactions, every lock change starts over.
+        int lock(const int level) override
+        {
+            invalidate();
+            return vfs_file::lock(level);
+        }
+
+        int unlock(const int level) override
+        {
+            invalidate();
+            return vfs_file::unlock(level);
+        }
+
+        int shm_lock(const int offset, const int count, const int flags) override
+        {
+            invalidate();
+            return vfs_file::shm_lock(offset, count, flags);
+        }
+
+        int fetch(const int64_t offset, const int amount, void** pointer) override
+        {
+            if (m_direct) {
+                *pointer = nullptr;
+                return SQLITE_OK;
+            }
+            return vfs_file::fetch(offset, amount, pointer);
+        }
+
+        private:
+        // Reads continuing within this distance of the previous one count as sequential,
+        // so scans skipping a few pages or reading an interior page now and then still get read ahead.
+        static constexpr int64_t sequential_gap = 64 * 1024;
+        static constexpr int stray_reads = 4;
+
+        bool track(const int64_t offset, const int amount) noexcept
+        {
+            if (offset >= m_next && offset - m_next <= sequential_gap) {
+                ++m_run;
+                m_strays = 0;
+                m_next = offset + amount;
+            } else if (++m_strays > stray_reads || m_run == 0) {
+                if (m_run >= 2 && !m_direct) {
+                    posix_fadvise(m_descriptor, 0, 0, POSIX_FADV_NORMAL);
+                }
+                m_run = 0;
+                m_strays = 0;
+                m_next = offset + amount;
+                m_advised = 0;
+            }
+            return m_run >= 2;
+        }
+
+        // Keeps the kernel readahead at least half a window in front of the scan.
+        void advise() noexcept
+        {
+            if (m_options.readahead == 0) {
+                return;
+            }
+            const int64_t window = static_cast<int64_t>(m_options.readahead);
+            if (m_advised == 0) {
+                posix_fadvise(m_descriptor, 0, 0, POSIX_FADV_SEQUENTIAL);
+            }
+            if (m_next + window / 2 > m_advised) {
+                const int64_t start = std::max(m_next, m_advised);
+                posix_fadvise(m_descriptor, start, window, POSIX_FADV_WILLNEED);
+                m_advised = start + window;
+            }
+        }
+
+        int read_direct(void* buffer, const int amount, const int64_t offset, const bool sequential)
+        {
+            if (offset >= m_window_start && offset + amount <= m_window_start + m_window_size) {
+                std::memcpy(buffer, m_read_buffer.data() + (offset - m_window_start), static_cast<std::size_t>(amount));
+                return SQLITE_OK;
+            }
+
+            const int64_t start = align_down(offset);
+            int64_t end = align_up(offset + amount);
+            if (sequential) {
+                end = std::max(end, start + align_up(static_cast<int64_t>(m_options.direct_read_size)));
+            }
+            const std::size_t length = static_cast<std::size_t>(end - start);
+            if (!m_read_buffer.reserve(length)) {
+                return SQLITE_IOERR_NOMEM;
+            }
+
+            invalidate();
+            std::size_t total = 0;
+            while (total < length) {
+                const ssize_t result = pread(m_descriptor, m_read_buffer.data() + total, length - total, start + static_cast<int64_t>(total));
+                if (result < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    return SQLITE_IOERR_READ;
+                }
+                total += static_cast<std::size_t>(result);
+                // A read ending off the alignment reached the end of the file.
+                if (result == 0 || result % direct_alignment != 0) {
+                    break;
+                }
+            }
+            m_window_start = start;
+            m_window_size = static_cast<int64_t>(total);
+
+            const int64_t skipped = offset - start;
+            const std::size_t available = m_window_size > skipped ? static_cast<std::size_t>(std::min<int64_t>(amount, m_window_size - skipped)) : 0;
+            std::memcpy(buffer, m_read_buffer.data() + skipped, available);
+            if (available < static_cast<std::size_t>(amount)) {
+                std::memset(static_cast<char*>(buffer) + available, 0, static_cast<std::size_t>(amount) - available);
+                return SQLITE_IOERR_SHORT_READ;
+            }
+            return SQLITE_OK;
+        }
+
+        void invalidate() noexcept
+        {
+            m_window_size = 0;
+        }
+
+        void set_direct(const bool direct) noexcept
+        {
+            const int flags = fcntl(m_descriptor, F_GETFL);
+            if (flags >= 0) {
+                fcntl(m_descriptor, F_SETFL, direct ? (flags | O_DIRECT) : (flags & ~O_DIRECT));
+            }
+        }
+
+        const linux_vfs_options& m_options;
+        const int m_descriptor;
+        const bool m_direct;
+
+        int64_t m_next = 0;
+        int m_run = 0;
+        int m_strays = 0;
+        int64_t m_advised = 0;
+
+        aligned_buffer m_read_buffer;
+        aligned_buffer m_write_buffer;
+        int64_t m_window_start = 0;
+        int64_t m_window_size = 0;
+    };
+#endif
+
+    linux_vfs::linux_vfs(std::string name, const linux_vfs_options& options, const std::string& base) :
+        vfs_shim(std::move(name), base),
+        m_options(options)
+    {}
+
+    const linux_vfs_options& linux_vfs::options() const noexcept
+    {
+        return m_options;
+    }
+
+    std::unique_ptr<vfs_file> linux_vfs::wrap(sqlite3_file* file, const char* name, const int flags)
+    {
+#ifdef __linux__
+        const file_kind kind = file_kind_of(flags);
+        const int descriptor = kind == file_kind::main_database && name != nullptr ? descriptor_of(base(), file, name) : -1;
+        if (descriptor >= 0) {
+            bool direct = false;
+            if (m_options.direct_io) {
+                // File systems without O_DIRECT support, like tmpfs, refuse the flag.
+                const int descriptor_flags = fcntl(descriptor, F_GETFL);
+                direct = descriptor_flags >= 0 && fcntl(descriptor, F_SETFL, descriptor_flags | O_DIRECT) == 0;
+            }
+            return std::unique_ptr<vfs_file>(new linux_vfs::file(file, m_options, descriptor, direct));
+        }
+#endif
+        return vfs_shim::wrap(file, name, flags);
+    }
+}
@@ -0,0 +1,70 @@
+/** @file */
+
+#ifndef __SQLITEXX_SQLITE_LINUXVFS_H__
+#define __SQLITEXX_SQLITE_LINUXVFS_H__
+
+#include "VfsShim.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace sqlite
+{
+    /** How sqlite::linux_vfs reads the main database.
+     */
+    struct linux_vfs_options
+    {
+        /** Bytes the kernel is asked to read ahead once reads of the main database are sequential, 0 to never ask.
+         */
+        std::size_t readahead = 4 * 1024 * 1024;
+
+        /** Reads and page aligned writes of the main database bypass the page cache with O_DIRECT,
+         * so pages are only cached once, by SQLite.
+         * Falls back to buffered I/O on file systems that do not support O_DIRECT.
+         */
+        bool direct_io = false;
+
+        /** Bytes a sequential direct read fetches at once, later reads of the same range are served from this buffer.
+         */
+        std::size_t direct_read_size = 1024 * 1024;
+    };
+
+    /**
+     * A VFS layered over the default VFS that tunes reading the main database for large sequential scans on Linux.
+     * SQLite reads one page at a time, so once several reads continue where the previous one ended the VFS asks
+     * the kernel with posix_fadvise to read the following linux_vfs_options::readahead bytes in the background.
+     * With linux_vfs_options::direct_io the main database is also opened with O_DIRECT and read through an aligned
+     * buffer, large reads for sequential scans and exact ones otherwise, which keeps the database out of the page cache.
+     * Journals, WAL files and locking are left to the underlying VFS.
+     * On other systems the VFS only forwards to the underlying VFS.
+     * The VFS must outlive the connections using it.
+     */
+    class linux_vfs : public vfs_shim
+    {
+        public:
+
+        /** Registers the VFS.
+         * @param[in] name    the name of the VFS
+         * @param[in] options how the main database is read
+         * @param[in] base    the name of the underlying VFS, the default VFS when empty
+         * @throws SQLiteXXException if the underlying VFS does not exist or the name is taken
+         * @throws sqlite::exception if the VFS could not be registered
+         */
+        explicit linux_vfs(std::string name = "sqlitexx-linux", const linux_vfs_options& options = linux_vfs_options(), const std::string& base = std::string());
+
+        /** Returns how the main database is read.
+         */
+        const linux_vfs_options& options() const noexcept;
+
+        protected:
+        std::unique_ptr<vfs_file> wrap(sqlite3_file* file, const char* name, int flags) override;
+
+        private:
+        class file;
+
+        linux_vfs_options m_options;
+    };
+}
+
+#endif
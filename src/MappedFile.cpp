@@ -0,0 +1,242 @@
+#include "MappedFile.h"
+
+#include "Exception.h"
+
+#include <algorithm>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace sqlite
+{
+    mapped_file::mapped_file() noexcept :
+        m_data(nullptr),
+        m_size(0),
+        m_writable(false)
+#ifdef _WIN32
+        , m_mapping(nullptr)
+        , m_file(nullptr)
+#endif
+    {}
+
+#ifdef _WIN32
+    mapped_file::mapped_file(const std::string& path) :
+        mapped_file()
+    {
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            throw SQLiteXXException("Unable to open " + path);
+        }
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size)) {
+            CloseHandle(file);
+            throw SQLiteXXException("Unable to read the size of " + path);
+        }
+        m_size = static_cast<std::size_t>(size.QuadPart);
+
+        if (m_size > 0) {
+            m_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (m_mapping != nullptr) {
+                m_data = static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+            }
+        }
+        CloseHandle(file);
+
+        if (m_size > 0 && m_data == nullptr) {
+            unmap();
+            throw SQLiteXXException("Unable to map " + path);
+        }
+    }
+
+    mapped_file mapped_file::writable(const std::string& path, const std::size_t size)
+    {
+        mapped_file result;
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            throw SQLiteXXException("Unable to open " + path);
+        }
+        // Closed by unmap, also when mapping fails.
+        result.m_file = file;
+
+        LARGE_INTEGER current;
+        if (!GetFileSizeEx(file, &current)) {
+            throw SQLiteXXException("Unable to read the size of " + path);
+        }
+        result.m_size = std::max(size, static_cast<std::size_t>(current.QuadPart));
+
+        // Mapping more than the file holds grows the file.
+        const unsigned long long length = result.m_size;
+        result.m_mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, static_cast<DWORD>(length >> 32), static_cast<DWORD>(length), nullptr);
+        if (result.m_mapping != nullptr) {
+            result.m_data = static_cast<const char*>(MapViewOfFile(result.m_mapping, FILE_MAP_WRITE, 0, 0, 0));
+        }
+
+        if (result.m_data == nullptr) {
+            throw SQLiteXXException("Unable to map " + path);
+        }
+        result.m_writable = true;
+        return result;
+    }
+#else
+    mapped_file::mapped_file(const std::string& path) :
+        mapped_file()
+    {
+        const int file = ::open(path.c_str(), O_RDONLY);
+        if (file < 0) {
+            throw SQLiteXXException("Unable to open " + path);
+        }
+
+        struct stat status;
+        if (::fstat(file, &status) != 0) {
+            ::close(file);
+            throw SQLiteXXException("Unable to read the size of " + path);
+        }
+        m_size = static_cast<std::size_t>(status.st_size);
+
+        if (m_size > 0) {
+            void* address = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, file, 0);
+            if (address == MAP_FAILED) {
+                ::close(file);
+                m_size = 0;
+                throw SQLiteXXException("Unable to map " + path);
+            }
+            m_data = static_cast<const char*>(address);
+            // The file is mostly read front to back.
+            ::madvise(address, m_size, MADV_SEQUENTIAL);
+        }
+        ::close(file);
+    }
+
+    mapped_file mapped_file::writable(const std::string& path, const std::size_t size)
+    {
+        mapped_file result;
+        const int file = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (file < 0) {
+            throw SQLiteXXException("Unable to open " + path);
+        }
+
+        struct stat status;
+        if (::fstat(file, &status) != 0) {
+            ::close(file);
+            throw SQLiteXXException("Unable to read the size of " + path);
+        }
+        if (static_cast<std::size_t>(status.st_size) < size && ::ftruncate(file, static_cast<off_t>(size)) != 0) {
+            ::close(file);
+            throw SQLiteXXException("Unable to grow " + path);
+        }
+        const std::size_t length = std::max(size, static_cast<std::size_t>(status.st_size));
+
+        void* address = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+        ::close(file);
+        if (address == MAP_FAILED) {
+            throw SQLiteXXException("Unable to map " + path);
+        }
+        result.m_data = static_cast<const char*>(address);
+        result.m_size = length;
+        result.m_writable = true;
+        return result;
+    }
+#endif
+
+    mapped_file::mapped_file(mapped_file&& other) noexcept :
+        m_data(std::exchange(other.m_data, nullptr)),
+        m_size(std::exchange(other.m_size, 0)),
+        m_writable(std::exchange(other.m_writable, false))
+#ifdef _WIN32
+        , m_mapping(std::exchange(other.m_mapping, nullptr))
+        , m_file(std::exchange(other.m_file, nullptr))
+#endif
+    {}
+
+    mapped_file& mapped_file::operator=(mapped_file&& other) noexcept
+    {
+        if (this != &other) {
+            unmap();
+            m_data = std::exchange(other.m_data, nullptr);
+            m_size = std::exchange(other.m_size, 0);
+            m_writable = std::exchange(other.m_writable, false);
+#ifdef _WIN32
+            m_mapping = std::exchange(other.m_mapping, nullptr);
+            m_file = std::exchange(other.m_file, nullptr);
+#endif
+        }
+        return *this;
+    }
+
+    mapped_file::~mapped_file() noexcept
+    {
+        unmap();
+    }
+
+    const char* mapped_file::data() const noexcept
+    {
+        return m_data;
+    }
+
+    char* mapped_file::writable_data() const noexcept
+    {
+        return m_writable ? const_cast<char*>(m_data) : nullptr;
+    }
+
+    void mapped_file::flush() const
+    {
+        if (!m_writable) {
+            return;
+        }
+#ifdef _WIN32
+        // FlushViewOfFile only starts writing the pages, FlushFileBuffers waits for them and the metadata.
+        if (!FlushViewOfFile(m_data, 0) || !FlushFileBuffers(m_file)) {
+            throw SQLiteXXException("Unable to flush a mapped file");
+        }
+#else
+        if (::msync(const_cast<char*>(m_data), m_size, MS_SYNC) != 0) {
+            throw SQLiteXXException("Unable to flush a mapped file");
+        }
+#endif
+    }
+
+    std::size_t mapped_file::size() const noexcept
+    {
+        return m_size;
+    }
+
+    std::string_view mapped_file::view() const noexcept
+    {
+        return std::string_view(m_data, m_size);
+    }
+
+    void mapped_file::unmap() noexcept
+    {
+#ifdef _WIN32
+        if (m_data != nullptr) {
+            UnmapViewOfFile(m_data);
+        }
+        if (m_mapping != nullptr) {
+            CloseHandle(m_mapping);
+        }
+        if (m_file != nullptr) {
+            CloseHandle(m_file);
+        }
+        m_mapping = nullptr;
+        m_file = nullptr;
+#else
+        if (m_data != nullptr) {
+            ::munmap(const_cast<char*>(m_data), m_size);
+        }
+#endif
+        m_data = nullptr;
+        m_size = 0;
+        m_writable = false;
+    }
+}
@@ -0,0 +1,90 @@
+/** @file */
+
+#ifndef __SQLITEXX_SQLITE_MAPPEDFILE_H__
+#define __SQLITEXX_SQLITE_MAPPEDFILE_H__
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace sqlite
+{
+    /** A memory mapping of a whole file, read-only unless created with mapped_file::writable.
+     * The contents are read straight from the page cache, so views into data() stay valid as long as the object lives.
+     * The file must not be truncated by anyone while it is mapped.
+     */
+    class mapped_file
+    {
+        public:
+
+        /** Constructs an object that maps nothing.
+         */
+        mapped_file() noexcept;
+
+        /** Maps the file at path.
+         * @param[in] path the path of the file
+         * @throws SQLiteXXException if the file could not be opened or mapped
+         */
+        explicit mapped_file(const std::string& path);
+
+        /** Maps the file at path for reading and writing, creating it or growing it to size bytes first.
+         * Writes to the mapping reach the file when the operating system writes the pages back, or on flush().
+         * @param[in] path the path of the file
+         * @param[in] size the minimum size of the file in bytes, larger than 0
+         * @returns the mapping
+         * @throws SQLiteXXException if the file could not be opened, grown or mapped
+         */
+        static mapped_file writable(const std::string& path, std::size_t size);
+
+        mapped_file(const mapped_file&) = delete;
+        mapped_file& operator=(const mapped_file&) = delete;
+
+        /** Move constructor.
+         * @param[in] other another mapped_file object whose mapping is taken over.
+         */
+        mapped_file(mapped_file&& other) noexcept;
+
+        /** Move assignment operator.
+         * @param[in] other another mapped_file object whose mapping is taken over.
+         * @returns *this
+         */
+        mapped_file& operator=(mapped_file&& other) noexcept;
+
+        ~mapped_file() noexcept;
+
+        /** Returns the first byte of the mapping, nullptr for an empty file.
+         */
+        const char* data() const noexcept;
+
+        /** Returns the first byte of a writable mapping, nullptr for a read-only one.
+         */
+        char* writable_data() const noexcept;
+
+        /** Writes the modified pages of a writable mapping to the file and waits until they are on disk.
+         * @throws SQLiteXXException if the pages could not be written
+         */
+        void flush() const;
+
+        /** Returns the size of the file in bytes.
+         */
+        std::size_t size() const noexcept;
+
+        /** Returns the whole file as a view.
+         */
+        std::string_view view() const noexcept;
+
+        private:
+        void unmap() noexcept;
+
+        const char* m_data;
+        std::size_t m_size;
+        bool m_writable;
+#ifdef _WIN32
+        void* m_mapping;
+        // Only open for writable mappings, flush() needs it.
+        void* m_file;
+#endif
+    };
+}
+
+#endif
@@ -0,0 +1,537 @@
+#include "MemoryVfs.h"
+
+#include "Exception.h"
+
+#include <sqlite3.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <shared_mutex>
+#include <vector>
+
+namespace sqlite
+{
+    namespace
+    {
+        // A file shared by every handle that opened its name.
+        struct memory_file
+        {
+            std::string name;
+
+            // Guards the contents, reads run in parallel.
+            std::shared_mutex data_mutex;
+            std::vector<char> data;
+
+            // Guards the file locks and the WAL index.
+            std::mutex lock_mutex;
+            int shared_count = 0;
+            const void* reserved_owner = nullptr;
+            const void* pending_owner = nullptr;
+            const void* exclusive_owner = nullptr;
+
+            std::vector<std::unique_ptr<char[]>> shm_regions;
+            int shm_shared[SQLITE_SHM_NLOCK] = {};
+            const void* shm_exclusive[SQLITE_SHM_NLOCK] = {};
+            int shm_users = 0;
+
+            // Guarded by the registry mutex.
+            int open_count = 0;
+        };
+
+        struct registry
+        {
+            std::mutex mutex;
+            std::map<std::string, std::shared_ptr<memory_file>> files;
+        };
+
+        // Never destroyed, so connections closed during static destruction still find it.
+        registry& memory_files()
+        {
+            static registry* files = new registry();
+            return *files;
+        }
+
+        struct memory_handle : public sqlite3_file
+        {
+            std::shared_ptr<memory_file> file;
+            bool registered = false;
+            bool delete_on_close = false;
+            int lock = SQLITE_LOCK_NONE;
+            bool shm_mapped = false;
+            unsigned shm_shared_mask = 0;
+            unsigned shm_exclusive_mask = 0;
+        };
+
+        memory_handle& handle_of(sqlite3_file* file) noexcept
+        {
+            return *static_cast<memory_handle*>(file);
+        }
+
+        sqlite3_vfs* base_vfs(sqlite3_vfs* vfs) noexcept
+        {
+            return static_cast<sqlite3_vfs*>(vfs->pAppData);
+        }
+
+        int memory_read(sqlite3_file* file, void* buffer, int amount, sqlite3_int64 offset)
+        {
+            memory_file& target = *handle_of(file).file;
+            std::shared_lock<std::shared_mutex> lock(target.data_mutex);
+            const std::size_t size = target.data.size();
+            const std::size_t start = static_cast<std::size_t>(offset);
+            const std::size_t wanted = static_cast<std::size_t>(amount);
+            const std::size_t available = start < size ? std::min(wanted, size - start) : 0;
+            if (available > 0) {
+                std::memcpy(buffer, target.data.data() + start, available);
+            }
+            if (available < wanted) {
+                std::memset(static_cast<char*>(buffer) + available, 0, wanted - available);
+                return SQLITE_IOERR_SHORT_READ;
+            }
+            return SQLITE_OK;
+        }
+
+        int memory_write(sqlite3_file* file, const void* buffer, int amount, sqlite3_int64 offset)
+        {
+            memory_file& target = *handle_of(file).file;
+            try {
+                std::unique_lock<std::shared_mutex> lock(target.data_mutex);
+                const std::size_t end = static_cast<std::size_t>(offset) + static_cast<std::size_t>(amount);
+                if (target.data.size() < end) {
+                    target.data.resize(end);
+                }
+                std::memcpy(target.data.data() + offset, buffer, static_cast<std::size_t>(amount));
+                return SQLITE_OK;
+            } catch (const std::bad_alloc&) {
+                return SQLITE_FULL;
+            }
+        }
+
+        int memory_truncate(sqlite3_file* file, sqlite3_int64 size)
+        {
+            memory_file& target = *handle_of(file).file;
+            try {
+                std::unique_lock<std::shared_mutex> lock(target.data_mutex);
+                target.data.resize(static_cast<std::size_t>(size));
+                return SQLITE_OK;
+            } catch (const std::bad_alloc&) {
+                return SQLITE_FULL;
+            }
+        }
+
+        int memory_sync(sqlite3_file*, int)
+        {
+            return SQLITE_OK;
+        }
+
+        int memory_file_size(sqlite3_file* file, sqlite3_int64* size)
+        {
+            memory_file& target = *handle_of(file).file;
+            std::shared_lock<std::shared_mutex> lock(target.data_mutex);
+            *size = static_cast<sqlite3_int64>(target.data.size());
+            return SQLITE_OK;
+        }
+
+        // The usual SQLite lock levels: any number of SHARED locks, one RESERVED lock next to them,
+        // and a PENDING lock that keeps new SHARED locks out until the EXCLUSIVE lock can be taken.
+        int memory_lock(sqlite3_file* file, int level)
+        {
+            memory_handle& handle = handle_of(file);
+            memory_file& target = *handle.file;
+            if (handle.lock >= level) {
+                return SQLITE_OK;
+            }
+
+            std::lock_guard<std::mutex> lock(target.lock_mutex);
+            const bool other_pending = target.pending_owner != nullptr && target.pending_owner != &handle;
+            const bool other_exclusive = target.exclusive_owner != nullptr && target.exclusive_owner != &handle;
+            if (handle.lock == SQLITE_LOCK_NONE) {
+                if (other_pending || other_exclusive) {
+                    return SQLITE_BUSY;
+                }
+                ++target.shared_count;
+                handle.lock = SQLITE_LOCK_SHARED;
+            }
+            if (level == SQLITE_LOCK_SHARED) {
+                return SQLITE_OK;
+            }
+
+            if (level == SQLITE_LOCK_RESERVED) {
+                if (target.reserved_owner != nullptr || other_pending || other_exclusive) {
+                    return SQLITE_BUSY;
+                }
+                target.reserved_owner = &handle;
+                handle.lock = SQLITE_LOCK_RESERVED;
+                return SQLITE_OK;
+            }
+
+            if (other_pending || other_exclusive || (target.reserved_owner != nullptr && target.reserved_owner != &handle)) {
+                return SQLITE_BUSY;
+            }
+            target.pending_owner = &handle;
+            handle.lock = SQLITE_LOCK_PENDING;
+            if (target.shared_count > 1) {
+                return SQLITE_BUSY;
+            }
+            target.exclusive_owner = &handle;
+            handle.lock = SQLITE_LOCK_EXCLUSIVE;
+            return SQLITE_OK;
+        }
+
+        int memory_unlock(sqlite3_file* file, int level)
+        {
+            memory_handle& handle = handle_of(file);
+            memory_file& target = *handle.file;
+            if (handle.lock <= level) {
+                return SQLITE_OK;
+            }
+
+            std::lock_guard<std::mutex> lock(target.lock_mutex);
+            if (target.exclusive_owner == &handle) {
+                target.exclusive_owner = nullptr;
+            }
+            if (target.pending_owner == &handle) {
+                target.pending_owner = nullptr;
+            }
+            if (target.reserved_owner == &handle) {
+                target.reserved_owner = nullptr;
+            }
+            if (level == SQLITE_LOCK_NONE) {
+                --target.shared_count;
+            }
+            handle.lock = level;
+            return SQLITE_OK;
+        }
+
+        int memory_check_reserved_lock(sqlite3_file* file, int* result)
+        {
+            memory_file& target = *handle_of(file).file;
+            std::lock_guard<std::mutex> lock(target.lock_mutex);
+            *result = target.reserved_owner != nullptr || target.pending_owner != nullptr || target.exclusive_owner != nullptr;
+            return SQLITE_OK;
+        }
+
+        int memory_file_control(sqlite3_file*, int, void*)
+        {
+            return SQLITE_NOTFOUND;
+        }
+
+        int memory_sector_size(sqlite3_file*)
+        {
+            return 0;
+        }
+
+        int memory_device_characteristics(sqlite3_file*)
+        {
+            return SQLITE_IOCAP_SAFE_APPEND | SQLITE_IOCAP_SEQUENTIAL | SQLITE_IOCAP_POWERSAFE_OVERWRITE;
+        }
+
+        int memory_shm_map(sqlite3_file* file, int region, int size, int extend, void volatile** address)
+        {
+            memory_handle& handle = handle_of(file);
+            memory_file& target = *handle.file;
+            std::lock_guard<std::mutex> lock(target.lock_mutex);
+            if (!handle.shm_mapped) {
+                handle.shm_mapped = true;
+                ++target.shm_users;
+            }
+
+            try {
+                while (target.shm_regions.size() <= static_cast<std::size_t>(region)) {
+                    if (!extend) {
+                        *address = nullptr;
+                        return SQLITE_OK;
+                    }
+                    target.shm_regions.emplace_back(new char[static_cast<std::size_t>(size)]());
+                }
+            } catch (const std::bad_alloc&) {
+                return SQLITE_IOERR_NOMEM;
+            }
+            *address = target.shm_regions[static_cast<std::size_t>(region)].get();
+            return SQLITE_OK;
+        }
+
+        // The WAL index locks are either held shared by any number of handles or exclusively by one.
+        int memory_shm_lock(sqlite3_file* file, int offset, int count, int flags)
+        {
+            memory_handle& handle = handle_of(file);
+            memory_file& target = *handle.file;
+            const unsigned mask = ((1u << (offset + count)) - 1) & ~((1u << offset) - 1);
+            std::lock_guard<std::mutex> lock(target.lock_mutex);
+
+            if (flags & SQLITE_SHM_UNLOCK) {
+                for (int i = offset; i < offset + count; ++i) {
+                    if (handle.shm_shared_mask & (1u << i)) {
+                        --target.shm_shared[i];
+                    }
+                    if (handle.shm_exclusive_mask & (1u << i)) {
+                        target.shm_exclusive[i] = nullptr;
+                    }
+                }
+                handle.shm_shared_mask &= ~mask;
+                handle.shm_exclusive_mask &= ~mask;
+                return SQLITE_OK;
+            }
+
+            if (flags & SQLITE_SHM_SHARED) {
+                for (int i = offset; i < offset + count; ++i) {
+                    if (target.shm_exclusive[i] != nullptr && target.shm_exclusive[i] != &handle) {
+                        return SQLITE_BUSY;
+                    }
+                }
+                for (int i = offset; i < offset + count; ++i) {
+                    if (!(handle.shm_shared_mask & (1u << i))) {
+                        ++target.shm_shared[i];
+                    }
+                }
+                handle.shm_shared_mask |= mask;
+                return SQLITE_OK;
+            }
+
+            for (int i = offset; i < offset + count; ++i) {
+                const int own_shared = (handle.shm_shared_mask & (1u << i)) ? 1 : 0;
+                if ((target.shm_exclusive[i] != nullptr && target.shm_exclusive[i] != &handle) || target.shm_shared[i] > own_shared) {
+                    return SQLITE_BUSY;
+                }
+            }
+            for (int i = offset; i < offset + count; ++i) {
+                target.shm_exclusive[i] = &handle;
+            }
+            handle.shm_exclusive_mask |= mask;
+            return SQLITE_OK;
+        }
+
+        void memory_shm_barrier(sqlite3_file*)
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+
+        int memory_shm_unmap(sqlite3_file* file, int)
+        {
+            memory_handle& handle = handle_of(file);
+            if (!handle.shm_mapped) {
+                return SQLITE_OK;
+            }
+            memory_shm_lock(file, 0, SQLITE_SHM_NLOCK, SQLITE_SHM_UNLOCK | SQLITE_SHM_EXCLUSIVE);
+
+            memory_file& target = *handle.file;
+            std::lock_guard<std::mutex> lock(target.lock_mutex);
+            handle.shm_mapped = false;
+            if (--target.shm_users == 0) {
+                target.shm_regions.clear();
+            }
+            return SQLITE_OK;
+        }
+
+        int memory_close(sqlite3_file* file);
+
+        const sqlite3_io_methods memory_methods = {
+            2,
+            &memory_close,
+            &memory_read,
+            &memory_write,
+            &memory_truncate,
+            &memory_sync,
+            &memory_file_size,
+            &memory_lock,
+            &memory_unlock,
+            &memory_check_reserved_lock,
+            &memory_file_control,
+            &memory_sector_size,
+            &memory_device_characteristics,
+            &memory_shm_map,
+            &memory_shm_lock,
+            &memory_shm_barrier,
+            &memory_shm_unmap,
+            nullptr,
+            nullptr
+        };
+
+        int memory_close(sqlite3_file* file)
+        {
+            memory_handle& handle = handle_of(file);
+            memory_shm_unmap(file, 0);
+            memory_unlock(file, SQLITE_LOCK_NONE);
+
+            if (handle.registered) {
+                registry& files = memory_files();
+                std::lock_guard<std::mutex> lock(files.mutex);
+                if (--handle.file->open_count == 0 || handle.delete_on_close) {
+                    const auto found = files.files.find(handle.file->name);
+                    if (found != files.files.end() && found->second == handle.file) {
+                        files.files.erase(found);
+                    }
+                }
+            }
+
+            handle.~memory_handle();
+            return SQLITE_OK;
+        }
+
+        int memory_open(sqlite3_vfs*, const char* name, sqlite3_file* file, int flags, int* out_flags)
+        {
+            file->pMethods = nullptr;
+            try {
+                std::shared_ptr<memory_file> target;
+                if (name == nullptr) {
+                    target = std::make_shared<memory_file>();
+                } else {
+                    registry& files = memory_files();
+                    std::lock_guard<std::mutex> lock(files.mutex);
+                    std::shared_ptr<memory_file>& entry = files.files[name];
+                    if (!entry) {
+                        if (!(flags & SQLITE_OPEN_CREATE)) {
+                            files.files.erase(name);
+                            return SQLITE_CANTOPEN;
+                        }
+                        entry = std::make_shared<memory_file>();
+                        entry->name = name;
+                    }
+                    ++entry->open_count;
+                    target = entry;
+                }
+
+                memory_handle* handle = new (file) memory_handle();
+                handle->file = std::move(target);
+                handle->registered = name != nullptr;
+                handle->delete_on_close = (flags & SQLITE_OPEN_DELETEONCLOSE) != 0;
+                handle->pMethods = &memory_methods;
+            } catch (const std::bad_alloc&) {
+                return SQLITE_NOMEM;
+            }
+
+            if (out_flags != nullptr) {
+                *out_flags = flags;
+            }
+            return SQLITE_OK;
+        }
+
+        int memory_delete(sqlite3_vfs*, const char* name, int)
+        {
+            registry& files = memory_files();
+            std::lock_guard<std::mutex> lock(files.mutex);
+            files.files.erase(name);
+            return SQLITE_OK;
+        }
+
+        int memory_access(sqlite3_vfs*, const char* name, int flags, int* result)
+        {
+            registry& files = memory_files();
+            std::lock_guard<std::mutex> lock(files.mutex);
+            const auto found = files.files.find(name);
+            if (found == files.files.end()) {
+                *result = 0;
+            } else if (flags == SQLITE_ACCESS_EXISTS) {
+                // Like the unix VFS, an empty file does not count, so empty journals are not hot.
+                std::shared_lock<std::shared_mutex> data(found->second->data_mutex);
+                *result = !found->second->data.empty();
+            } else {
+                *result = 1;
+            }
+            return SQLITE_OK;
+        }
+
+        int memory_full_pathname(sqlite3_vfs*, const char* name, int size, char* output)
+        {
+            sqlite3_snprintf(size, output, "%s", name);
+            return SQLITE_OK;
+        }
+
+        void* memory_dl_open(sqlite3_vfs* vfs, const char* filename)
+        {
+            return base_vfs(vfs)->xDlOpen(base_vfs(vfs), filename);
+        }
+
+        void memory_dl_error(sqlite3_vfs* vfs, int size, char* message)
+        {
+            base_vfs(vfs)->xDlError(base_vfs(vfs), size, message);
+        }
+
+        void (*memory_dl_sym(sqlite3_vfs* vfs, void* library, const char* symbol))(void)
+        {
+            return base_vfs(vfs)->xDlSym(base_vfs(vfs), library, symbol);
+        }
+
+        void memory_dl_close(sqlite3_vfs* vfs, void* library)
+        {
+            base_vfs(vfs)->xDlClose(base_vfs(vfs), library);
+        }
+
+        int memory_randomness(sqlite3_vfs* vfs, int size, char* output)
+        {
+            return base_vfs(vfs)->xRandomness(base_vfs(vfs), size, output);
+        }
+
+        int memory_sleep(sqlite3_vfs* vfs, int microseconds)
+        {
+            return base_vfs(vfs)->xSleep(base_vfs(vfs), microseconds);
+        }
+
+        int memory_current_time(sqlite3_vfs* vfs, double* now)
+        {
+            return base_vfs(vfs)->xCurrentTime(base_vfs(vfs), now);
+        }
+
+        int memory_get_last_error(sqlite3_vfs*, int, char*)
+        {
+            return 0;
+        }
+
+        int memory_current_time_int64(sqlite3_vfs* vfs, sqlite3_int64* now)
+        {
+            sqlite3_vfs* base = base_vfs(vfs);
+            if (base->iVersion >= 2 && base->xCurrentTimeInt64 != nullptr) {
+                return base->xCurrentTimeInt64(base, now);
+            }
+            double days;
+            const int errorcode = base->xCurrentTime(base, &days);
+            *now = static_cast<sqlite3_int64>(days * 86400000.0);
+            return errorcode;
+        }
+    }
+
+    const std::string& memory_vfs()
+    {
+        static const std::string name = []() {
+            static sqlite3_vfs vfs = {};
+            sqlite3_vfs* base = sqlite3_vfs_find(nullptr);
+            if (base == nullptr) {
+                throw SQLiteXXException("There is no default VFS to build the memory VFS on");
+            }
+
+            vfs.iVersion = 2;
+            vfs.szOsFile = static_cast<int>(sizeof(memory_handle));
+            vfs.mxPathname = 512;
+            vfs.zName = "sqlitexx-memory";
+            vfs.pAppData = base;
+            vfs.xOpen = &memory_open;
+            vfs.xDelete = &memory_delete;
+            vfs.xAccess = &memory_access;
+            vfs.xFullPathname = &memory_full_pathname;
+            vfs.xDlOpen = &memory_dl_open;
+            vfs.xDlError = &memory_dl_error;
+            vfs.xDlSym = &memory_dl_sym;
+            vfs.xDlClose = &memory_dl_close;
+            vfs.xRandomness = &memory_randomness;
+            vfs.xSleep = &memory_sleep;
+            vfs.xCurrentTime = &memory_current_time;
+            vfs.xGetLastError = &memory_get_last_error;
+            vfs.xCurrentTimeInt64 = &memory_current_time_int64;
+
+            throw_error_code(sqlite3_vfs_register(&vfs, 0), "Unable to register the memory VFS");
+            return std::string(vfs.zName);
+        }();
+        return name;
+    }
+
+    bool memory_vfs_contains(const std::string& name)
+    {
+        registry& files = memory_files();
+        std::lock_guard<std::mutex> lock(files.mutex);
+        return files.files.count(name) != 0;
+    }
+}
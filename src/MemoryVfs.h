@@ -0,0 +1,27 @@
+/** @file */
+
+#ifndef __SQLITEXX_SQLITE_MEMORYVFS_H__
+#define __SQLITEXX_SQLITE_MEMORYVFS_H__
+
+#include <string>
+
+namespace sqlite
+{
+    /** Registers the memory VFS the first time it is called and returns its name.
+     * The memory VFS keeps named files in process memory, so every connection in the process that opens the same name
+     * shares one database, see dbconnection::shared_memory.
+     * It implements file locks and the WAL shared memory, so in WAL mode readers run concurrently with a writer.
+     * A file is freed when the last connection using it is closed.
+     * @returns the name of the VFS
+     * @throws sqlite::exception if the VFS could not be registered
+     */
+    const std::string& memory_vfs();
+
+    /** Tells if the memory VFS holds a file.
+     * @param[in] name the name the file was opened with
+     * @returns true if a connection has the file open
+     */
+    bool memory_vfs_contains(const std::string& name);
+}
+
+#endif
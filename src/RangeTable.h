@@ -0,0 +1,451 @@
+/** @file */
+
+#ifndef __SQLITEXX_SQLITE_RANGETABLE_H__
+#define __SQLITEXX_SQLITE_RANGETABLE_H__
+
+#include "Exception.h"
+#include "Utilities.h"
+#include "Value.h"
+#include "VirtualTable.h"
+
+#include <sqlite3.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace sqlite
+{
+    /**
+     * Describes how a C++ type is declared, returned to SQLite and compared with constraint values
+     * when it is exposed as a column of a range_table.
+     * compare() follows SQLite's ordering: NULL, then numbers, then text, then blobs.
+     * Numeric columns apply numeric affinity to text values and text columns compare numbers as text,
+     * like SQLite does for columns declared INTEGER, REAL and TEXT.
+     */
+    template <typename M, typename Enable = void>
+    struct range_value;
+
+    template <typename M>
+    struct range_value<M, typename std::enable_if<std::is_integral<M>::value>::type> {
+        static constexpr const char* declared_type = "INTEGER";
+
+        static void result(sqlite3_context* context, const M& value, bool) {
+            sqlite3_result_int64(context, static_cast<sqlite3_int64>(value));
+        }
+
+        static int compare(const M& key, sqlite3_value* value) {
+            switch (sqlite3_value_numeric_type(value)) {
+                case SQLITE_INTEGER: {
+                    const sqlite3_int64 other = sqlite3_value_int64(value);
+                    const sqlite3_int64 self = static_cast<sqlite3_int64>(key);
+                    return self < other ? -1 : (self > other ? 1 : 0);
+                }
+                case SQLITE_FLOAT: {
+                    const double other = sqlite3_value_double(value);
+                    const double self = static_cast<double>(key);
+                    return self < other ? -1 : (self > other ? 1 : 0);
+                }
+                default:
+                    return -1;
+            }
+        }
+    };
+
+    template <typename M>
+    struct range_value<M, typename std::enable_if<std::is_floating_point<M>::value>::type> {
+        static constexpr const char* declared_type = "REAL";
+
+        static void result(sqlite3_context* context, const M& value, bool) {
+            sqlite3_result_double(context, static_cast<double>(value));
+        }
+
+        static int compare(const M& key, sqlite3_value* value) {
+            const int type = sqlite3_value_numeric_type(value);
+            if (type != SQLITE_INTEGER && type != SQLITE_FLOAT) {
+                return -1;
+            }
+            const double other = sqlite3_value_double(value);
+            const double self = static_cast<double>(key);
+            return self < other ? -1 : (self > other ? 1 : 0);
+        }
+    };
+
+    template <typename M>
+    struct range_value<M, typename std::enable_if<std::is_same<M, std::string>::value || std::is_same<M, std::string_view>::value>::type> {
+        static constexpr const char* declared_type = "TEXT";
+
+        /** Text that lives in the range is handed to SQLite without a copy. */
+        static void result(sqlite3_context* context, const M& value, const bool in_range) {
+            sqlite3_result_text64(context, value.data(), value.size(), in_range ? SQLITE_STATIC : SQLITE_TRANSIENT, SQLITE_UTF8);
+        }
+
+        static int compare(const M& key, sqlite3_value* value) {
+            if (sqlite3_value_type(value) == SQLITE_BLOB) {
+                return -1;
+            }
+            const char* text = reinterpret_cast<const char*>(sqlite3_value_text(value));
+            const std::string_view other(text != nullptr ? text : "", sqlite3_value_bytes(value));
+            const int result = std::string_view(key).compare(other);
+            return result < 0 ? -1 : (result > 0 ? 1 : 0);
+        }
+    };
+
+    /** A column of a range_table, reading one field of the elements of the range.
+     * @tparam T the element type of the range
+     */
+    template <typename T>
+    class range_column
+    {
+        public:
+
+        /** Constructs a column.
+         * @param[in] name     the name of the column in SQL
+         * @param[in] accessor a pointer to a data member of T, or a callable taking a const T&, returning an integer, floating point,
+         *                     std::string or std::string_view value
+         * @param[in] sorted   true if the range is sorted in ascending order by this column,
+         *                     which lets constraints and ORDER BY on the column use binary search instead of a full scan
+         */
+        template <typename F>
+        range_column(std::string name, F accessor, const bool sorted = false) :
+            m_name(std::move(name)),
+            m_sorted(sorted)
+        {
+            using ResultType = typename std::invoke_result<const F&, const T&>::type;
+            using ValueType = typename std::decay<ResultType>::type;
+            // References and views point into the range itself, anything else is a temporary that SQLite has to copy.
+            constexpr bool inRange = std::is_reference<ResultType>::value || std::is_same<ValueType, std::string_view>::value;
+
+            m_declared_type = range_value<ValueType>::declared_type;
+            m_is_text = std::is_same<ValueType, std::string>::value || std::is_same<ValueType, std::string_view>::value;
+            m_result = [accessor](sqlite3_context* context, const T& element) {
+                range_value<ValueType>::result(context, std::invoke(accessor, element), inRange);
+            };
+            m_compare = [accessor](const T& element, sqlite3_value* value) {
+                return range_value<ValueType>::compare(std::invoke(accessor, element), value);
+            };
+        }
+
+        const std::string& name() const noexcept {
+            return m_name;
+        }
+
+        const char* declared_type() const noexcept {
+            return m_declared_type;
+        }
+
+        bool sorted() const noexcept {
+            return m_sorted;
+        }
+
+        bool is_text() const noexcept {
+            return m_is_text;
+        }
+
+        void result(sqlite3_context* context, const T& element) const {
+            m_result(context, element);
+        }
+
+        int compare(const T& element, sqlite3_value* value) const {
+            return m_compare(element, value);
+        }
+
+        private:
+        std::string m_name;
+        const char* m_declared_type;
+        bool m_sorted;
+        bool m_is_text;
+        std::function<void(sqlite3_context*, const T&)> m_result;
+        std::function<int(const T&, sqlite3_value*)> m_compare;
+    };
+
+    template <typename Range>
+    using range_element_t = typename std::decay<decltype(*std::begin(std::declval<const Range&>()))>::type;
+
+    /**
+     * A read-only virtual table over a random-access range of structs, like a std::vector or std::deque.
+     * The table refers to the range instead of copying it, so the range has to outlive every connection using the table
+     * and must not change while a statement reads from it.
+     * The rowid of a row is the position of its element in the range.
+     * Constraints on the rowid and on sorted columns are answered by binary search and ORDER BY on them needs no sorting,
+     * every other query scans the range.
+     */
+    template <typename Range>
+    class range_table
+    {
+        public:
+        using element_type = range_element_t<Range>;
+
+        range_table(const Range& range, std::vector<range_column<element_type>> columns) :
+            m_range(&range),
+            m_columns(std::move(columns))
+        {}
+
+        std::string schema() const {
+            std::string sql = "CREATE TABLE x(";
+            for (std::size_t i = 0; i < m_columns.size(); ++i) {
+                if (i != 0) {
+                    sql += ", ";
+                }
+                sql += quote_identifier(m_columns[i].name());
+                sql += ' ';
+                sql += m_columns[i].declared_type();
+            }
+            sql += ")";
+            return sql;
+        }
+
+        void best_index(index_info& info) const {
+            const double rows = static_cast<double>(size());
+            const double search = std::log2(rows + 1.0) + 1.0;
+
+            // Prefer an equality on the rowid, then an equality on a sorted column, then ranges on either.
+            int driving = no_column;
+            int bestScore = 4;
+            for (int i = 0; i < info.constraint_count(); ++i) {
+                const index_info::constraint term = info.get_constraint(i);
+                if (!can_search(info, i, term)) {
+                    continue;
+                }
+                const bool isEquality = term.op == constraint_op::eq;
+                const int score = term.column == rowid_column ? (isEquality ? 0 : 2) : (isEquality ? 1 : 3);
+                if (score < bestScore) {
+                    bestScore = score;
+                    driving = term.column;
+                }
+            }
+
+            int indexNumber = 0;
+            double estimatedRows = rows;
+            if (driving != no_column) {
+                std::string operations;
+                bool lowerBound = false;
+                bool upperBound = false;
+                for (int i = 0; i < info.constraint_count(); ++i) {
+                    const index_info::constraint term = info.get_constraint(i);
+                    if (term.column != driving || !can_search(info, i, term)) {
+                        continue;
+                    }
+                    // The rowid is searched exactly, other columns are checked again by SQLite
+                    // so corner cases of affinity and collations stay SQLite's business.
+                    info.use_constraint(i, static_cast<int>(operations.size()), driving == rowid_column);
+                    operations += operation_code(term.op);
+                    lowerBound |= term.op == constraint_op::eq || term.op == constraint_op::gt || term.op == constraint_op::ge;
+                    upperBound |= term.op == constraint_op::eq || term.op == constraint_op::lt || term.op == constraint_op::le;
+                }
+                info.set_index_string(operations);
+                indexNumber = driving + 2;
+
+                if (bestScore == 0) {
+                    estimatedRows = 1;
+                    info.set_unique(true);
+                } else if (bestScore == 1) {
+                    estimatedRows = std::min(rows, 10.0);
+                } else {
+                    estimatedRows = rows / ((lowerBound ? 3.0 : 1.0) * (upperBound ? 3.0 : 1.0));
+                }
+                info.set_estimated_cost(search + estimatedRows);
+            } else {
+                info.set_estimated_cost(rows);
+            }
+            info.set_estimated_rows(static_cast<int64_t>(estimatedRows));
+
+            if (in_range_order(info)) {
+                info.set_order_by_consumed(true);
+                if (info.get_order_by(0).descending) {
+                    indexNumber |= descending_flag;
+                }
+            }
+            info.set_index_number(indexNumber);
+        }
+
+        /** Iterates over the elements of a range_table that a plan selected. */
+        class cursor
+        {
+            public:
+            explicit cursor(const range_table& table) noexcept :
+                m_table(&table),
+                m_begin(0),
+                m_end(0),
+                m_position(0),
+                m_descending(false)
+            {}
+
+            void filter(const int index_number, const std::string_view index_string, value_span arguments) {
+                m_begin = 0;
+                m_end = m_table->size();
+                m_descending = (index_number & descending_flag) != 0;
+
+                const int code = index_number & ~descending_flag;
+                if (code != 0) {
+                    const int column = code - 2;
+                    for (std::size_t i = 0; i < index_string.size() && i < arguments.size(); ++i) {
+                        sqlite3_value* value = arguments[i].handle();
+                        if (sqlite3_value_type(value) == SQLITE_NULL) {
+                            // Comparisons with NULL are never true.
+                            m_end = m_begin;
+                            break;
+                        }
+                        const std::size_t lower = m_table->partition(column, value, false);
+                        const std::size_t upper = m_table->partition(column, value, true);
+                        switch (index_string[i]) {
+                            case 'e':
+                                m_begin = std::max(m_begin, lower);
+                                m_end = std::min(m_end, upper);
+                                break;
+                            case 'g':
+                                m_begin = std::max(m_begin, upper);
+                                break;
+                            case 'G':
+                                m_begin = std::max(m_begin, lower);
+                                break;
+                            case 'l':
+                                m_end = std::min(m_end, lower);
+                                break;
+                            case 'L':
+                                m_end = std::min(m_end, upper);
+                                break;
+                            default:
+                                throw SQLiteXXException("Unknown range_table plan.");
+                        }
+                    }
+                    if (m_end < m_begin) {
+                        m_end = m_begin;
+                    }
+                }
+                m_position = m_descending ? m_end : m_begin;
+            }
+
+            void next() noexcept {
+                if (m_descending) {
+                    --m_position;
+                } else {
+                    ++m_position;
+                }
+            }
+
+            bool eof() const noexcept {
+                return m_descending ? m_position == m_begin : m_position == m_end;
+            }
+
+            void column(sqlite3_context* context, const int column) const {
+                m_table->m_columns[column].result(context, m_table->at(current()));
+            }
+
+            int64_t rowid() const noexcept {
+                return static_cast<int64_t>(current());
+            }
+
+            private:
+            std::size_t current() const noexcept {
+                return m_descending ? m_position - 1 : m_position;
+            }
+
+            const range_table* m_table;
+            std::size_t m_begin;
+            std::size_t m_end;
+            std::size_t m_position;
+            bool m_descending;
+        };
+
+        cursor open() const {
+            return cursor(*this);
+        }
+
+        private:
+        static constexpr int rowid_column = -1;
+        static constexpr int no_column = -2;
+        static constexpr int descending_flag = 1 << 16;
+
+        static char operation_code(const constraint_op op) noexcept {
+            switch (op) {
+                case constraint_op::eq:
+                    return 'e';
+                case constraint_op::gt:
+                    return 'g';
+                case constraint_op::ge:
+                    return 'G';
+                case constraint_op::lt:
+                    return 'l';
+                default:
+                    return 'L';
+            }
+        }
+
+        bool can_search(const index_info& info, const int index, const index_info::constraint& term) const {
+            if (!term.usable) {
+                return false;
+            }
+            if (term.op != constraint_op::eq && term.op != constraint_op::gt && term.op != constraint_op::ge &&
+                term.op != constraint_op::lt && term.op != constraint_op::le) {
+                return false;
+            }
+            if (term.column == rowid_column) {
+                return true;
+            }
+            const range_column<element_type>& column = m_columns[term.column];
+            return column.sorted() && (!column.is_text() || sqlite3_stricmp(std::string(info.collation(index)).c_str(), "BINARY") == 0);
+        }
+
+        /** True if every ORDER BY term is on the rowid or a sorted column, all in the same direction. */
+        bool in_range_order(const index_info& info) const {
+            if (info.order_by_count() == 0) {
+                return false;
+            }
+            const bool descending = info.get_order_by(0).descending;
+            for (int i = 0; i < info.order_by_count(); ++i) {
+                const index_info::ordering term = info.get_order_by(i);
+                if (term.descending != descending) {
+                    return false;
+                }
+                if (term.column != rowid_column && !m_columns[term.column].sorted()) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        std::size_t size() const {
+            return static_cast<std::size_t>(std::distance(std::begin(*m_range), std::end(*m_range)));
+        }
+
+        const element_type& at(const std::size_t position) const {
+            return *(std::begin(*m_range) + position);
+        }
+
+        int compare(const int column, const std::size_t position, sqlite3_value* value) const {
+            if (column == rowid_column) {
+                return range_value<int64_t>::compare(static_cast<int64_t>(position), value);
+            }
+            return m_columns[column].compare(at(position), value);
+        }
+
+        /** Returns the first position whose key is not below the value, or above it when past_equal is set. */
+        std::size_t partition(const int column, sqlite3_value* value, const bool past_equal) const {
+            std::size_t low = 0;
+            std::size_t high = size();
+            while (low < high) {
+                const std::size_t middle = low + (high - low) / 2;
+                const int order = compare(column, middle, value);
+                if (order < 0 || (past_equal && order == 0)) {
+                    low = middle + 1;
+                } else {
+                    high = middle;
+                }
+            }
+            return low;
+        }
+
+        const Range* m_range;
+        std::vector<range_column<element_type>> m_columns;
+    };
+}
+
+#endif
@@ -3,12 +3,30 @@
 #define __SQLITEXX_SQLITE_SQLITEXX_H__
 
 #include "Backup.h"
+#include "BlobStream.h"
+#include "CompressedVfs.h"
+#include "Config.h"
+#include "CsvTable.h"
 #include "DBConnection.h"
 #include "Exception.h"
+#include "FaultVfs.h"
 #include "Functions.h"
+#include "InstrumentedVfs.h"
+#include "LinuxVfs.h"
+#include "MappedFile.h"
+#include "MemoryVfs.h"
 #include "Open.h"
+#include "RangeTable.h"
+#include "Serialize.h"
 #include "Statement.h"
+#include "Status.h"
+#include "TableFunction.h"
+#include "TimeSeries.h"
 #include "Transaction.h"
+#include "VectorFunctions.h"
+#include "VfsShim.h"
+#include "VirtualTable.h"
+#include "WriteBehindVfs.h"
 
 #include <sqlite3.h>
 
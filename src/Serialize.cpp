@@ -0,0 +1,69 @@
+#include "Serialize.h"
+
+#include <utility>
+
+namespace sqlite
+{
+    void serialized_database::sqlite_deleter::operator()(unsigned char* data) const noexcept
+    {
+        sqlite3_free(data);
+    }
+
+    serialized_database::serialized_database() noexcept :
+        m_owned(),
+        m_data(nullptr),
+        m_size(0)
+    {}
+
+    serialized_database::serialized_database(unsigned char* data, const std::size_t size, const bool owned) noexcept :
+        m_owned(owned ? data : nullptr),
+        m_data(data),
+        m_size(size)
+    {}
+
+    serialized_database::serialized_database(serialized_database&& other) noexcept :
+        m_owned(std::move(other.m_owned)),
+        m_data(std::exchange(other.m_data, nullptr)),
+        m_size(std::exchange(other.m_size, 0))
+    {}
+
+    serialized_database& serialized_database::operator=(serialized_database&& other) noexcept
+    {
+        if (this != &other) {
+            m_owned = std::move(other.m_owned);
+            m_data = std::exchange(other.m_data, nullptr);
+            m_size = std::exchange(other.m_size, 0);
+        }
+        return *this;
+    }
+
+    const unsigned char* serialized_database::data() const noexcept
+    {
+        return m_data;
+    }
+
+    std::size_t serialized_database::size() const noexcept
+    {
+        return m_size;
+    }
+
+    std::string_view serialized_database::view() const noexcept
+    {
+        return std::string_view(reinterpret_cast<const char*>(m_data), m_size);
+    }
+
+    bool serialized_database::is_view() const noexcept
+    {
+        return m_data != nullptr && m_owned == nullptr;
+    }
+
+    unsigned char* serialized_database::release() noexcept
+    {
+        unsigned char* owned = m_owned.release();
+        if (owned != nullptr) {
+            m_data = nullptr;
+            m_size = 0;
+        }
+        return owned;
+    }
+}
@@ -0,0 +1,85 @@
+/** @file */
+
+#ifndef __SQLITEXX_SQLITE_SERIALIZE_H__
+#define __SQLITEXX_SQLITE_SERIALIZE_H__
+
+#include <sqlite3.h>
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+
+namespace sqlite
+{
+    /** How dbconnection::deserialize hands a database image to SQLite.
+     */
+    enum class deserialize_mode: int {
+        read_only = 0, ///< the database is read in place and cannot be changed, the image has to outlive its use
+        resizable = 1, ///< the database can be changed and grow, SQLite works on its own copy of the image
+    };
+
+    /**
+     * A database serialized by dbconnection::serialize, holding the same bytes as a database file.
+     * The image is either a view of the memory of a database that SQLite keeps as one buffer already,
+     * valid until that database is changed or closed, or a copy the object owns.
+     * Objects can be moved but not copied.
+     */
+    class serialized_database
+    {
+        public:
+
+        /** Constructs an empty image.
+         */
+        serialized_database() noexcept;
+
+        serialized_database(const serialized_database&) = delete;
+        serialized_database& operator=(const serialized_database&) = delete;
+
+        /** Move constructor.
+         * @param[in] other another serialized_database object whose image is taken over.
+         */
+        serialized_database(serialized_database&& other) noexcept;
+
+        /** Move assignment operator.
+         * @param[in] other another serialized_database object whose image is taken over.
+         * @returns *this
+         */
+        serialized_database& operator=(serialized_database&& other) noexcept;
+
+        /** Returns the first byte of the image, nullptr if it is empty.
+         */
+        const unsigned char* data() const noexcept;
+
+        /** Returns the size of the image in bytes.
+         */
+        std::size_t size() const noexcept;
+
+        /** Returns the image as a view.
+         */
+        std::string_view view() const noexcept;
+
+        /** Returns true if the image is a view of the memory of a database instead of a copy.
+         */
+        bool is_view() const noexcept;
+
+        private:
+        friend class dbconnection;
+
+        struct sqlite_deleter
+        {
+            void operator()(unsigned char* data) const noexcept;
+        };
+
+        /** Takes over memory allocated by SQLite if owned, or refers to it otherwise. */
+        serialized_database(unsigned char* data, std::size_t size, bool owned) noexcept;
+
+        /** Gives up the memory allocated by SQLite, nullptr for a view. */
+        unsigned char* release() noexcept;
+
+        std::unique_ptr<unsigned char, sqlite_deleter> m_owned;
+        const unsigned char* m_data;
+        std::size_t m_size;
+    };
+}
+
+#endif
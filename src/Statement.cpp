@@ -71,6 +71,7 @@ namespace sqlite
         {
             throw_last_error();
         }
+        release_owned(index);
     }
 
     void statement::bind(const int index, const double value) const
@@ -79,6 +80,7 @@ namespace sqlite
         {
             throw_last_error();
         }
+        release_owned(index);
     }
 
     void statement::bind(const int index, const void * const value, const int size, bindtype type) const
@@ -87,6 +89,7 @@ namespace sqlite
         {
             throw_last_error();
         }
+        release_owned(index);
     }
 
     void statement::bind(const int index, const blob &value) const
@@ -95,6 +98,16 @@ namespace sqlite
         {
             throw_last_error();
         }
+        release_owned(index);
+    }
+
+    void statement::bind(const int index, const zeroblob &value) const
+    {
+        if (SQLITE_OK != sqlite3_bind_zeroblob64(handle(), index, value.size()))
+        {
+            throw_last_error();
+        }
+        release_owned(index);
     }
 
     void statement::bind(const int index, const char * const value, const int size, bindtype type) const
@@ -103,6 +116,7 @@ namespace sqlite
         {
             throw_last_error();
         }
+        release_owned(index);
     }
 
     void statement::bind(const int index, const char16_t * const value, const int size, bindtype type) const
@@ -111,6 +125,7 @@ namespace sqlite
         {
             throw_last_error();
         }
+        release_owned(index);
     }
 
     void statement::bind(const int index, const std::string &value) const
@@ -123,6 +138,84 @@ namespace sqlite
         bind(index, value.c_str(), value.size() * sizeof(char16_t));
     }
 
+    void statement::bind(const int index, std::string&& value) const
+    {
+        std::shared_ptr<std::string> owned = std::make_shared<std::string>(std::move(value));
+        if (SQLITE_OK != sqlite3_bind_text64(handle(), index, owned->data(), owned->size(), SQLITE_STATIC, SQLITE_UTF8))
+        {
+            throw_last_error();
+        }
+        keep_alive(index, std::move(owned));
+    }
+
+    void statement::bind(const int index, blob&& value) const
+    {
+        std::shared_ptr<blob> owned = std::make_shared<blob>(std::move(value));
+        if (SQLITE_OK != sqlite3_bind_blob64(handle(), index, owned->data(), owned->size(), SQLITE_STATIC))
+        {
+            throw_last_error();
+        }
+        keep_alive(index, std::move(owned));
+    }
+
+    void statement::bind(const int index, std::vector<uint8_t>&& value) const
+    {
+        std::shared_ptr<std::vector<uint8_t>> owned = std::make_shared<std::vector<uint8_t>>(std::move(value));
+        if (SQLITE_OK != sqlite3_bind_blob64(handle(), index, owned->data(), owned->size(), SQLITE_STATIC))
+        {
+            throw_last_error();
+        }
+        keep_alive(index, std::move(owned));
+    }
+
+    static void delete_buffer(void* buffer)
+    {
+        delete[] static_cast<char*>(buffer);
+    }
+
+    void statement::bind(const int index, std::unique_ptr<char[]> value, const size_t size, datatype type) const
+    {
+        int result;
+        switch (type)
+        {
+            case datatype::blob:
+                result = sqlite3_bind_blob64(handle(), index, value.release(), size, delete_buffer);
+                break;
+            case datatype::text:
+                result = sqlite3_bind_text64(handle(), index, value.release(), size, delete_buffer, SQLITE_UTF8);
+                break;
+            default:
+                throw SQLiteXXException("A buffer can only be bound as a blob or text");
+        }
+
+        // SQLite calls delete_buffer itself when binding fails.
+        if (SQLITE_OK != result)
+        {
+            throw_last_error();
+        }
+        release_owned(index);
+    }
+
+    void statement::keep_alive(const int index, std::shared_ptr<void>&& value) const
+    {
+        assert(index > 0);
+        const size_t slot = static_cast<size_t>(index);
+        if (m_owned_values.size() <= slot)
+        {
+            m_owned_values.resize(slot + 1);
+        }
+        m_owned_values[slot] = std::move(value);
+    }
+
+    void statement::release_owned(const int index) const
+    {
+        const size_t slot = static_cast<size_t>(index);
+        if (slot < m_owned_values.size())
+        {
+            m_owned_values[slot].reset();
+        }
+    }
+
     void statement::throw_last_error() const
     {
         throw_error_code(sqlite3_db_handle(handle()));
@@ -11,6 +11,7 @@
 #include <sqlite3.h>
 
 #include <cassert>
+#include <cstdint>
 #include <cstring>
 #include <functional>
 #include <iostream>
@@ -465,6 +466,13 @@ namespace sqlite
          **/
         void bind(const int index, const blob& value) const;
 
+        /** Binds a blob filled with zeros to a parameter in an SQL prepared statement.
+         * No memory is allocated for the contents, use a blob_stream to fill them in afterwards.
+         * @param[in] index specifies the index of the SQL parameter to be set
+         * @param[in] value the zeroblob to bind to the parameter.
+         **/
+        void bind(const int index, const zeroblob& value) const;
+
         /** Binds an string value to a parameter in an SQL prepared statement.
          * @param[in] index specifies the index of the SQL parameter to be set
          * @param[in] value the value to bind to the parameter.
@@ -493,6 +501,41 @@ namespace sqlite
          **/
         void bind(const int index, const std::u16string& value) const;
 
+        /** Binds a string value to a parameter in an SQL prepared statement without copying it.
+         * The statement takes ownership of the string and keeps it alive until the parameter
+         * is bound again, the bindings are cleared or the statement is destroyed.
+         * @param[in] index specifies the index of the SQL parameter to be set
+         * @param[in] value the value to bind to the parameter.
+         **/
+        void bind(const int index, std::string&& value) const;
+
+        /** Binds a blob value to a parameter in an SQL prepared statement without copying it.
+         * The statement takes ownership of the blob and keeps it alive until the parameter
+         * is bound again, the bindings are cleared or the statement is destroyed.
+         * @param[in] index specifies the index of the SQL parameter to be set
+         * @param[in] value the value to bind to the parameter.
+         **/
+        void bind(const int index, blob&& value) const;
+
+        /** Binds a blob value to a parameter in an SQL prepared statement without copying it.
+         * The statement takes ownership of the buffer and keeps it alive until the parameter
+         * is bound again, the bindings are cleared or the statement is destroyed.
+         * @param[in] index specifies the index of the SQL parameter to be set
+         * @param[in] value the value to bind to the parameter.
+         **/
+        void bind(const int index, std::vector<uint8_t>&& value) const;
+
+        /** Binds a buffer to a parameter in an SQL prepared statement without copying it.
+         * Ownership of the buffer is handed to SQLite which frees it once it is no longer needed,
+         * even if binding fails.
+         * @param[in] index specifies the index of the SQL parameter to be set
+         * @param[in] value the buffer to bind to the parameter.
+         * @param[in] size  the number of bytes of the buffer.
+         * @param[in] type  either sqlite::datatype::blob or sqlite::datatype::text (UTF-8).
+         * @throws SQLiteXXException if type is neither blob nor text.
+         **/
+        void bind(const int index, std::unique_ptr<char[]> value, const size_t size, datatype type = datatype::blob) const;
+
         /** Binds an value to a parameter in an SQL prepared statement.
          * @param[in] name  specifies the name of the SQL parameter to be set
          * @param[in] value the value to bind to the parameter.
@@ -523,6 +566,7 @@ namespace sqlite
             {
                 throw_last_error();
             }
+            m_owned_values.clear();
 
             bind_all(values ...);
         }
@@ -542,6 +586,10 @@ namespace sqlite
         }
 
         private:
+        // Values handed over with the rvalue bind overloads, indexed by parameter.
+        // Declared before m_handle so the statement is finalized before they are released.
+        mutable std::vector<std::shared_ptr<void>> m_owned_values;
+
         using statement_handle = std::unique_ptr<sqlite3_stmt, decltype(&sqlite3_finalize)>;
         statement_handle m_handle;
 
@@ -579,6 +627,10 @@ namespace sqlite
             internal_bind(index + 1, std::forward<Rest>(rest) ...);
         }
 
+        void keep_alive(const int index, std::shared_ptr<void>&& value) const;
+
+        void release_owned(const int index) const;
+
         void throw_last_error() const;
 
         statement(const statement& other) = delete;
@@ -0,0 +1,34 @@
+#include "Status.h"
+#include "Exception.h"
+
+namespace sqlite
+{
+    namespace
+    {
+        status_counter read_status(const int op, const bool reset)
+        {
+            sqlite3_int64 current = 0;
+            sqlite3_int64 highwater = 0;
+            const int errorcode = sqlite3_status64(op, &current, &highwater, reset ? 1 : 0);
+            throw_error_code(errorcode, "Unable to read SQLite library status");
+
+            status_counter counter;
+            counter.current = current;
+            counter.highwater = highwater;
+            return counter;
+        }
+    }
+
+    library_status global_status(bool reset)
+    {
+        library_status status;
+        status.memory_used = read_status(SQLITE_STATUS_MEMORY_USED, reset);
+        status.malloc_count = read_status(SQLITE_STATUS_MALLOC_COUNT, reset);
+        status.malloc_size = read_status(SQLITE_STATUS_MALLOC_SIZE, reset);
+        status.pagecache_used = read_status(SQLITE_STATUS_PAGECACHE_USED, reset);
+        status.pagecache_overflow = read_status(SQLITE_STATUS_PAGECACHE_OVERFLOW, reset);
+        status.pagecache_size = read_status(SQLITE_STATUS_PAGECACHE_SIZE, reset);
+        status.parser_stack = read_status(SQLITE_STATUS_PARSER_STACK, reset);
+        return status;
+    }
+}
@@ -0,0 +1,45 @@
+/** @file */
+
+#ifndef __SQLITEXX_SQLITE_STATUS_H__
+#define __SQLITEXX_SQLITE_STATUS_H__
+
+#include <sqlite3.h>
+
+#include <cstdint>
+
+namespace sqlite
+{
+    /** A single SQLite status value together with its highest recorded value.
+     */
+    struct status_counter
+    {
+        int64_t current;   ///< current value of the counter
+        int64_t highwater; ///< highest value of the counter since the last reset
+    };
+
+    /** Snapshot of the process wide runtime status of the SQLite library, aka "sqlite3_status64".
+     * Memory values are in bytes.
+     */
+    struct library_status
+    {
+        status_counter memory_used;        ///< memory currently checked out by the SQLite memory allocator
+        status_counter malloc_count;       ///< number of separate memory allocations currently checked out
+        status_counter malloc_size;        ///< only highwater is meaningful, the largest memory allocation request
+        status_counter pagecache_used;     ///< number of pages used out of the page cache memory pool
+        status_counter pagecache_overflow; ///< bytes of page cache allocations that did not fit in the page cache pool
+        status_counter pagecache_size;     ///< only highwater is meaningful, the largest page cache allocation request
+        status_counter parser_stack;       ///< only highwater is meaningful, the deepest parser stack
+    };
+
+    /** Returns a snapshot of the runtime status of the SQLite library.
+     * When reset is true the highwater marks are reset to the current values after being read,
+     * so successive calls report the peaks reached since the previous call. This makes the function
+     * suitable to poll periodically from a metrics thread.
+     * @param[in] reset if true the highwater marks are reset after being read
+     * @returns The current library status.
+     * @throws sqlite::exception if a status value could not be read
+     */
+    library_status global_status(bool reset = false);
+}
+
+#endif
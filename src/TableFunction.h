@@ -0,0 +1,332 @@
+/** @file */
+
+#ifndef __SQLITEXX_SQLITE_TABLEFUNCTION_H__
+#define __SQLITEXX_SQLITE_TABLEFUNCTION_H__
+
+#include "Blob.h"
+#include "Exception.h"
+#include "Functions.h"
+#include "Utilities.h"
+#include "Value.h"
+#include "VirtualTable.h"
+
+#include <sqlite3.h>
+
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace sqlite
+{
+    template <typename T>
+    struct is_optional : std::false_type {};
+
+    template <typename T>
+    struct is_optional<std::optional<T>> : std::true_type {};
+
+    /** True when R is a generator, a callable taking no arguments that returns the next row as a std::optional, or std::nullopt when done. */
+    template <typename R, typename Enable = void>
+    struct is_row_generator : std::false_type {};
+
+    template <typename R>
+    struct is_row_generator<R, std::void_t<decltype(std::declval<R&>()())>> :
+        is_optional<typename std::decay<decltype(std::declval<R&>()())>::type> {};
+
+    /** The row type produced by the result of a table-valued function. */
+    template <typename R, bool Generator = is_row_generator<R>::value>
+    struct produced_row {
+        using type = typename std::decay<decltype(*std::begin(std::declval<R&>()))>::type;
+    };
+
+    template <typename R>
+    struct produced_row<R, true> {
+        using type = typename std::decay<decltype(std::declval<R&>()())>::type::value_type;
+    };
+
+    /** Rows are std::tuple or std::pair objects with one element per column, anything else is a single column. */
+    template <typename Row, typename Enable = void>
+    struct row_columns {
+        static constexpr std::size_t count = 1;
+
+        template <std::size_t I>
+        static const Row& get(const Row& row) noexcept {
+            return row;
+        }
+    };
+
+    template <typename Row>
+    struct row_columns<Row, std::void_t<decltype(std::tuple_size<Row>::value)>> {
+        static constexpr std::size_t count = std::tuple_size<Row>::value;
+
+        template <std::size_t I>
+        static decltype(auto) get(const Row& row) noexcept {
+            return std::get<I>(row);
+        }
+    };
+
+    /** The type a column of a table-valued function is declared with. */
+    template <typename T>
+    const char* declared_column_type() noexcept {
+        if (std::is_integral<T>::value) {
+            return "INTEGER";
+        } else if (std::is_floating_point<T>::value) {
+            return "REAL";
+        } else if (std::is_same<T, std::string>::value || std::is_same<T, std::string_view>::value || std::is_same<T, std::u16string>::value) {
+            return "TEXT";
+        } else if (std::is_same<T, blob>::value) {
+            return "BLOB";
+        }
+        return "";
+    }
+
+    /** Walks the range returned by a table-valued function, one element per row. */
+    template <typename R, bool Generator = is_row_generator<R>::value>
+    class row_source
+    {
+        public:
+        explicit row_source(R&& rows) :
+            m_rows(std::move(rows)),
+            m_current(std::begin(m_rows)),
+            m_end(std::end(m_rows))
+        {}
+
+        row_source(const row_source&) = delete;
+        row_source& operator=(const row_source&) = delete;
+
+        bool done() const {
+            return !(m_current != m_end);
+        }
+
+        void advance() {
+            ++m_current;
+        }
+
+        decltype(auto) row() const {
+            return *m_current;
+        }
+
+        private:
+        R m_rows;
+        decltype(std::begin(std::declval<R&>())) m_current;
+        decltype(std::end(std::declval<R&>())) m_end;
+    };
+
+    /** Pulls the rows of a table-valued function from a generator, one call per row. */
+    template <typename R>
+    class row_source<R, true>
+    {
+        public:
+        explicit row_source(R&& generator) :
+            m_generator(std::move(generator)),
+            m_row(m_generator())
+        {}
+
+        row_source(const row_source&) = delete;
+        row_source& operator=(const row_source&) = delete;
+
+        bool done() const {
+            return !m_row.has_value();
+        }
+
+        void advance() {
+            m_row = m_generator();
+        }
+
+        const typename produced_row<R>::type& row() const {
+            return *m_row;
+        }
+
+        private:
+        R m_generator;
+        std::optional<typename produced_row<R>::type> m_row;
+    };
+
+    template <typename T>
+    void return_column(sqlite3_context* context, const T& value) {
+        if constexpr (std::is_integral<T>::value && !std::is_same<T, int>::value) {
+            return_result(context, static_cast<int64_t>(value));
+        } else if constexpr (std::is_floating_point<T>::value) {
+            return_result(context, static_cast<double>(value));
+        } else {
+            return_result(context, value);
+        }
+    }
+
+    /**
+     * An eponymous virtual table calling a C++ callable, so it can be used as a table-valued function,
+     * for example SELECT * FROM split('a,b', ',').
+     * The arguments of the callable are hidden columns after the output columns, converted like the arguments of scalar functions.
+     * The callable returns either a range, which is walked lazily, or a generator returning a std::optional row per call.
+     * Rows are std::tuple or std::pair objects with one element per column, or a single value for one column.
+     */
+    template <typename F>
+    class table_function
+    {
+        public:
+        static constexpr bool eponymous = true;
+
+        using result_type = typename std::decay<typename function_traits<F>::result_type>::type;
+        using row_type = typename produced_row<result_type>::type;
+        static constexpr std::size_t column_count = row_columns<row_type>::count;
+        static constexpr std::size_t parameter_count = function_traits<F>::nargs;
+
+        table_function(std::string name, std::shared_ptr<F> function, std::vector<std::string> columns, std::vector<std::string> parameters) :
+            m_name(std::move(name)),
+            m_function(std::move(function)),
+            m_columns(std::move(columns)),
+            m_parameters(std::move(parameters))
+        {}
+
+        std::string schema() const {
+            std::string sql = "CREATE TABLE x(";
+            append_columns(sql, std::make_index_sequence<column_count>{});
+            for (const std::string& parameter : m_parameters) {
+                sql += ", " + quote_identifier(parameter) + " HIDDEN";
+            }
+            sql += ")";
+            return sql;
+        }
+
+        void best_index(index_info& info) const {
+            int constraints[parameter_count + 1];
+            bool unusable = false;
+            for (std::size_t i = 0; i < parameter_count; ++i) {
+                constraints[i] = -1;
+            }
+
+            for (int i = 0; i < info.constraint_count(); ++i) {
+                const index_info::constraint term = info.get_constraint(i);
+                if (term.column < static_cast<int>(column_count) || term.op != constraint_op::eq) {
+                    continue;
+                }
+                if (!term.usable) {
+                    unusable = true;
+                    continue;
+                }
+                constraints[term.column - column_count] = i;
+            }
+
+            for (std::size_t i = 0; i < parameter_count; ++i) {
+                if (constraints[i] < 0) {
+#if SQLITE_VERSION_NUMBER >= 3026000
+                    // SQLITE_CONSTRAINT tells SQLite to try a plan where the arguments are available.
+                    if (unusable) {
+                        throw sqlite::exception(SQLITE_CONSTRAINT, m_name + "() arguments are not available");
+                    }
+#endif
+                    info.set_index_number(missing_arguments);
+                    info.set_estimated_cost(1e18);
+                    return;
+                }
+            }
+
+            for (std::size_t i = 0; i < parameter_count; ++i) {
+                info.use_constraint(constraints[i], static_cast<int>(i));
+            }
+            info.set_index_number(all_arguments);
+            info.set_estimated_cost(100);
+            info.set_estimated_rows(100);
+        }
+
+        /** Produces the rows of one call of the function. */
+        class cursor
+        {
+            public:
+            explicit cursor(const table_function& table) :
+                m_table(&table),
+                m_rowid(0)
+            {}
+
+            void filter(const int index_number, std::string_view, value_span arguments) {
+                if (index_number != all_arguments || arguments.size() != parameter_count) {
+                    throw SQLiteXXException(m_table->m_name + "() takes " + std::to_string(parameter_count) + " arguments");
+                }
+
+                // The rows may refer to the arguments, so both are replaced together and the arguments are copied
+                // since the values SQLite passes are only valid during this call.
+                m_rows.reset();
+                m_arguments.clear();
+                m_handles.clear();
+                for (value_ref argument : arguments) {
+                    m_arguments.emplace_back(argument.handle());
+                }
+                for (const value& argument : m_arguments) {
+                    m_handles.push_back(argument.handle());
+                }
+
+                m_rows.reset(new row_source<result_type>(call(std::make_index_sequence<parameter_count>{})));
+                m_rowid = 1;
+            }
+
+            void next() {
+                m_rows->advance();
+                ++m_rowid;
+            }
+
+            bool eof() const {
+                return m_rows == nullptr || m_rows->done();
+            }
+
+            void column(sqlite3_context* context, const int column) const {
+                if (column < static_cast<int>(column_count)) {
+                    decltype(auto) row = m_rows->row();
+                    return_row_column(context, row, column, std::make_index_sequence<column_count>{});
+                } else {
+                    sqlite3_result_value(context, m_handles[column - column_count]);
+                }
+            }
+
+            int64_t rowid() const noexcept {
+                return m_rowid;
+            }
+
+            private:
+            template <std::size_t... Is>
+            result_type call(std::index_sequence<Is...>) {
+                // So there is no warnings when the function takes no arguments.
+                sqlite3_value** values = m_handles.data();
+                (void)values;
+                return (*m_table->m_function)(get<typename function_traits<F>::template arg<Is>::type>(values, Is)...);
+            }
+
+            template <typename Row, std::size_t... Is>
+            static void return_row_column(sqlite3_context* context, const Row& row, const int column, std::index_sequence<Is...>) {
+                ((column == static_cast<int>(Is) ? return_column(context, row_columns<row_type>::template get<Is>(row)) : void()), ...);
+            }
+
+            const table_function* m_table;
+            std::vector<value> m_arguments;
+            std::vector<sqlite3_value*> m_handles;
+            std::unique_ptr<row_source<result_type>> m_rows;
+            int64_t m_rowid;
+        };
+
+        cursor open() const {
+            return cursor(*this);
+        }
+
+        private:
+        static constexpr int missing_arguments = 0;
+        static constexpr int all_arguments = 1;
+
+        template <std::size_t... Is>
+        void append_columns(std::string& sql, std::index_sequence<Is...>) const {
+            ((sql += (Is == 0 ? "" : ", ") + quote_identifier(m_columns[Is]) + " " +
+                declared_column_type<typename std::decay<decltype(row_columns<row_type>::template get<Is>(std::declval<const row_type&>()))>::type>()), ...);
+        }
+
+        std::string m_name;
+        std::shared_ptr<F> m_function;
+        std::vector<std::string> m_columns;
+        std::vector<std::string> m_parameters;
+    };
+}
+
+#endif
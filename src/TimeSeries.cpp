@@ -0,0 +1,447 @@
+#include "TimeSeries.h"
+
+#include "Utilities.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+namespace sqlite
+{
+    namespace
+    {
+        const char segment_magic[8] = {'S', 'Q', 'L', 'X', 'X', 'T', 'S', '1'};
+
+        // The first 64 bytes of every segment file, followed by the time column and the value columns,
+        // each an array of segment_rows 8-byte values.
+        struct segment_header {
+            char magic[8];
+            uint64_t columns;
+            uint64_t capacity;
+            uint64_t rows;
+            uint64_t floating_columns;
+            uint64_t reserved[3];
+        };
+
+        static_assert(sizeof(segment_header) == 64, "The segment header has to keep the columns 8-byte aligned");
+
+        const std::size_t cell_size = 8;
+
+        // Index numbers of the plans of timeseries_table, telling filter() which bounds it gets.
+        const int has_lower = 1;
+        const int lower_strict = 2;
+        const int has_upper = 4;
+        const int upper_strict = 8;
+        const int has_equal = 16;
+
+        std::string segment_path(const std::string& directory, const std::size_t number)
+        {
+            std::string digits = std::to_string(number);
+            digits.insert(0, digits.size() < 6 ? 6 - digits.size() : 0, '0');
+            return directory + "/segment-" + digits + ".ts";
+        }
+
+        bool file_exists(const std::string& path)
+        {
+            return std::ifstream(path).good();
+        }
+
+        int64_t clamp_to_int64(const double value) noexcept
+        {
+            if (value >= 9223372036854775807.0) {
+                return std::numeric_limits<int64_t>::max();
+            } else if (value <= -9223372036854775808.0) {
+                return std::numeric_limits<int64_t>::min();
+            }
+            return static_cast<int64_t>(value);
+        }
+
+        // Narrows [lower, upper] to the times matching "time op argument". Arguments that are not numbers
+        // leave the range as it is, SQLite checks every row again anyway.
+        // Returns false when no time can match.
+        bool apply_bound(sqlite3_value* argument, const bool lower, const bool strict, int64_t& first, int64_t& last) noexcept
+        {
+            const int type = sqlite3_value_numeric_type(argument);
+            if (type == SQLITE_NULL) {
+                return false;
+            } else if (type != SQLITE_INTEGER && type != SQLITE_FLOAT) {
+                return true;
+            }
+
+            int64_t bound;
+            if (type == SQLITE_INTEGER) {
+                bound = sqlite3_value_int64(argument);
+                if (strict) {
+                    if (bound == (lower ? std::numeric_limits<int64_t>::max() : std::numeric_limits<int64_t>::min())) {
+                        return false;
+                    }
+                    bound += lower ? 1 : -1;
+                }
+            } else {
+                const double value = sqlite3_value_double(argument);
+                if (std::isnan(value)) {
+                    return false;
+                }
+                // The smallest integer above, or at when not strict, the value for lower bounds and the largest below for upper bounds.
+                const double rounded = lower ? (strict ? std::floor(value) + 1 : std::ceil(value)) : (strict ? std::ceil(value) - 1 : std::floor(value));
+                bound = clamp_to_int64(rounded);
+            }
+
+            if (lower) {
+                first = std::max(first, bound);
+            } else {
+                last = std::min(last, bound);
+            }
+            return first <= last;
+        }
+    }
+
+    struct timeseries_store::segment {
+        mapped_file file;
+
+        segment_header& header() const noexcept
+        {
+            return *reinterpret_cast<segment_header*>(file.writable_data());
+        }
+
+        char* column(const std::size_t index) const noexcept
+        {
+            return file.writable_data() + sizeof(segment_header) + index * header().capacity * cell_size;
+        }
+
+        const int64_t* times() const noexcept
+        {
+            return reinterpret_cast<const int64_t*>(column(0));
+        }
+    };
+
+    timeseries_store::timeseries_store(const std::string& directory, std::vector<timeseries_column> columns, const std::size_t segment_rows) :
+        m_directory(directory),
+        m_columns(std::move(columns)),
+        m_segment_rows(segment_rows)
+    {
+        if (m_segment_rows == 0) {
+            throw SQLiteXXException("A time series segment needs room for at least one row");
+        }
+        if (m_columns.size() > 64) {
+            throw SQLiteXXException("A time series has at most 64 value columns");
+        }
+        for (const timeseries_column& column : m_columns) {
+            if (column.type != datatype::integer && column.type != datatype::floating) {
+                throw SQLiteXXException("The time series column " + column.name + " has to be integer or floating");
+            }
+        }
+
+        std::size_t number = 1;
+        do {
+            m_segments.push_back(open_segment(number++));
+        } while (file_exists(segment_path(m_directory, number)));
+    }
+
+    timeseries_store::~timeseries_store() = default;
+
+    std::unique_ptr<timeseries_store::segment> timeseries_store::open_segment(const std::size_t number) const
+    {
+        uint64_t floating_columns = 0;
+        for (std::size_t i = 0; i < m_columns.size(); ++i) {
+            if (m_columns[i].type == datatype::floating) {
+                floating_columns |= static_cast<uint64_t>(1) << i;
+            }
+        }
+
+        const std::string path = segment_path(m_directory, number);
+        const std::size_t size = sizeof(segment_header) + (m_columns.size() + 1) * m_segment_rows * cell_size;
+        std::unique_ptr<segment> added(new segment{mapped_file::writable(path, size)});
+
+        segment_header& header = added->header();
+        if (std::memcmp(header.magic, segment_magic, sizeof(segment_magic)) != 0) {
+            // A new file is all zeros.
+            std::memcpy(header.magic, segment_magic, sizeof(segment_magic));
+            header.columns = m_columns.size();
+            header.capacity = m_segment_rows;
+            header.rows = 0;
+            header.floating_columns = floating_columns;
+        } else if (header.columns != m_columns.size() || header.capacity != m_segment_rows || header.floating_columns != floating_columns) {
+            throw SQLiteXXException(path + " has other columns or another segment size");
+        } else if (header.rows > header.capacity || added->file.size() < size) {
+            throw SQLiteXXException(path + " is corrupt");
+        }
+        return added;
+    }
+
+    void timeseries_store::append(const std::size_t count, const int64_t* times, const std::vector<const void*>& values)
+    {
+        if (values.size() != m_columns.size()) {
+            throw SQLiteXXException("A time series append needs " + std::to_string(m_columns.size()) + " value columns");
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto current = m_segments.rbegin(); current != m_segments.rend(); ++current) {
+            const segment_header& header = (*current)->header();
+            if (header.rows > 0) {
+                if (count > 0 && times[0] < (*current)->times()[header.rows - 1]) {
+                    throw SQLiteXXException("Time series rows have to be appended in time order");
+                }
+                break;
+            }
+        }
+        for (std::size_t i = 1; i < count; ++i) {
+            if (times[i] < times[i - 1]) {
+                throw SQLiteXXException("Time series rows have to be appended in time order");
+            }
+        }
+
+        // Every segment the rows need is mapped before any row is written, so a failure appends nothing.
+        const std::size_t room = m_segment_rows - m_segments.back()->header().rows;
+        std::vector<std::unique_ptr<segment>> reserved;
+        if (count > room) {
+            const std::size_t needed = (count - room + m_segment_rows - 1) / m_segment_rows;
+            std::size_t attempted = 0;
+            try {
+                for (; attempted < needed; ++attempted) {
+                    reserved.push_back(open_segment(m_segments.size() + 1 + attempted));
+                }
+            } catch (...) {
+                // Also the segment that failed may have been created. The others are unmapped first,
+                // so the files can be removed on every platform.
+                reserved.clear();
+                for (std::size_t i = 0; i <= attempted; ++i) {
+                    std::remove(segment_path(m_directory, m_segments.size() + 1 + i).c_str());
+                }
+                throw;
+            }
+        }
+
+        m_segments.reserve(m_segments.size() + reserved.size());
+        std::size_t appended = 0;
+        auto next = reserved.begin();
+        while (appended < count) {
+            if (m_segments.back()->header().rows == m_segment_rows) {
+                m_segments.push_back(std::move(*next++));
+            }
+            segment& target = *m_segments.back();
+            segment_header& header = target.header();
+            const std::size_t rows = std::min<std::size_t>(count - appended, m_segment_rows - header.rows);
+
+            std::memcpy(target.column(0) + header.rows * cell_size, times + appended, rows * cell_size);
+            for (std::size_t i = 0; i < values.size(); ++i) {
+                std::memcpy(target.column(i + 1) + header.rows * cell_size, static_cast<const char*>(values[i]) + appended * cell_size, rows * cell_size);
+            }
+            // Readers only look at the rows before the count, which is raised once the values are in place.
+            header.rows += rows;
+            appended += rows;
+        }
+    }
+
+    void timeseries_store::flush() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const std::unique_ptr<segment>& current : m_segments) {
+            current->file.flush();
+        }
+    }
+
+    int64_t timeseries_store::row_count() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return static_cast<int64_t>((m_segments.size() - 1) * m_segment_rows + m_segments.back()->header().rows);
+    }
+
+    const std::vector<timeseries_column>& timeseries_store::columns() const noexcept
+    {
+        return m_columns;
+    }
+
+    std::size_t timeseries_store::segment_rows() const noexcept
+    {
+        return m_segment_rows;
+    }
+
+    std::vector<timeseries_store::segment_view> timeseries_store::snapshot() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::vector<segment_view> views;
+        views.reserve(m_segments.size());
+        for (const std::unique_ptr<segment>& current : m_segments) {
+            segment_view view;
+            view.times = current->times();
+            for (std::size_t i = 0; i < m_columns.size(); ++i) {
+                view.columns.push_back(current->column(i + 1));
+            }
+            view.row_count = current->header().rows;
+            views.push_back(std::move(view));
+        }
+        return views;
+    }
+
+    timeseries_table::timeseries_table(std::shared_ptr<const timeseries_store> store) :
+        m_store(std::move(store))
+    {}
+
+    std::string timeseries_table::schema() const
+    {
+        std::string sql = "CREATE TABLE x(time INTEGER";
+        for (const timeseries_column& column : m_store->columns()) {
+            sql += ", " + quote_identifier(column.name) + " " + (column.type == datatype::integer ? "INTEGER" : "REAL");
+        }
+        return sql + ")";
+    }
+
+    void timeseries_table::best_index(index_info& info) const
+    {
+        int lower = -1;
+        int upper = -1;
+        int equal = -1;
+        int plan = 0;
+        for (int i = 0; i < info.constraint_count(); ++i) {
+            const index_info::constraint term = info.get_constraint(i);
+            if (!term.usable || term.column != 0) {
+                continue;
+            }
+            if (term.op == constraint_op::eq && equal < 0) {
+                equal = i;
+            } else if ((term.op == constraint_op::gt || term.op == constraint_op::ge) && lower < 0) {
+                lower = i;
+                plan |= has_lower | (term.op == constraint_op::gt ? lower_strict : 0);
+            } else if ((term.op == constraint_op::lt || term.op == constraint_op::le) && upper < 0) {
+                upper = i;
+                plan |= has_upper | (term.op == constraint_op::lt ? upper_strict : 0);
+            }
+        }
+
+        // The bounds are widened to whole numbers, so SQLite checks the constraints again.
+        const double rows = static_cast<double>(m_store->row_count()) + 1;
+        if (equal >= 0) {
+            info.use_constraint(equal, 0, false);
+            info.set_index_number(has_equal);
+            info.set_estimated_cost(std::log2(rows) + 1);
+            info.set_estimated_rows(1);
+        } else {
+            int argument = 0;
+            if (lower >= 0) {
+                info.use_constraint(lower, argument++, false);
+            }
+            if (upper >= 0) {
+                info.use_constraint(upper, argument++, false);
+            }
+            info.set_index_number(plan);
+            const double fraction = argument == 2 ? 0.1 : (argument == 1 ? 0.5 : 1.0);
+            info.set_estimated_cost(std::log2(rows) + rows * fraction);
+            info.set_estimated_rows(static_cast<int64_t>(rows * fraction));
+        }
+
+        // The rows are stored in time order, which is also rowid order.
+        if (info.order_by_count() == 1) {
+            const index_info::ordering term = info.get_order_by(0);
+            if ((term.column == 0 || term.column == -1) && !term.descending) {
+                info.set_order_by_consumed(true);
+            }
+        }
+    }
+
+    timeseries_table::cursor timeseries_table::open() const
+    {
+        return cursor(*this);
+    }
+
+    timeseries_table::cursor::cursor(const timeseries_table& table) noexcept :
+        m_table(&table),
+        m_segment(0),
+        m_row(0),
+        m_end_segment(0),
+        m_end_row(0)
+    {}
+
+    void timeseries_table::cursor::filter(const int index_number, std::string_view, value_span arguments)
+    {
+        m_segments = m_table->m_store->snapshot();
+        m_segment = 0;
+        m_row = 0;
+        m_end_segment = 0;
+        m_end_row = 0;
+
+        int64_t first = std::numeric_limits<int64_t>::min();
+        int64_t last = std::numeric_limits<int64_t>::max();
+        std::size_t argument = 0;
+        bool matches = true;
+        if (index_number & has_equal) {
+            matches = apply_bound(arguments[0].handle(), true, false, first, last) &&
+                apply_bound(arguments[0].handle(), false, false, first, last);
+        } else {
+            if (index_number & has_lower) {
+                matches = apply_bound(arguments[argument++].handle(), true, (index_number & lower_strict) != 0, first, last);
+            }
+            if (matches && (index_number & has_upper)) {
+                matches = apply_bound(arguments[argument++].handle(), false, (index_number & upper_strict) != 0, first, last);
+            }
+        }
+        if (!matches) {
+            return;
+        }
+
+        // Only the last segment can be empty, so the last time of a segment tells if the range starts or ends in it.
+        auto last_time = [](const timeseries_store::segment_view& view) {
+            return view.row_count > 0 ? view.times[view.row_count - 1] : std::numeric_limits<int64_t>::max();
+        };
+        const auto begin = std::partition_point(m_segments.begin(), m_segments.end(), [&](const timeseries_store::segment_view& view) {
+            return last_time(view) < first;
+        });
+        const auto end = std::partition_point(begin, m_segments.end(), [&](const timeseries_store::segment_view& view) {
+            return last_time(view) <= last;
+        });
+
+        m_segment = static_cast<std::size_t>(begin - m_segments.begin());
+        if (begin != m_segments.end()) {
+            m_row = static_cast<std::size_t>(std::lower_bound(begin->times, begin->times + begin->row_count, first) - begin->times);
+        }
+        m_end_segment = static_cast<std::size_t>(end - m_segments.begin());
+        if (end != m_segments.end()) {
+            m_end_row = static_cast<std::size_t>(std::upper_bound(end->times, end->times + end->row_count, last) - end->times);
+        }
+    }
+
+    void timeseries_table::cursor::next() noexcept
+    {
+        if (++m_row >= m_segments[m_segment].row_count && m_segment < m_end_segment) {
+            ++m_segment;
+            m_row = 0;
+        }
+    }
+
+    bool timeseries_table::cursor::eof() const noexcept
+    {
+        if (m_segment != m_end_segment) {
+            return m_segment > m_end_segment || m_row >= m_segments[m_segment].row_count;
+        }
+        return m_row >= m_end_row;
+    }
+
+    void timeseries_table::cursor::column(sqlite3_context* context, const int column) const
+    {
+        const timeseries_store::segment_view& view = m_segments[m_segment];
+        if (column == 0) {
+            sqlite3_result_int64(context, view.times[m_row]);
+            return;
+        }
+
+        const std::size_t index = static_cast<std::size_t>(column - 1);
+        const char* cell = view.columns[index] + m_row * cell_size;
+        if (m_table->m_store->columns()[index].type == datatype::integer) {
+            int64_t value;
+            std::memcpy(&value, cell, sizeof(value));
+            sqlite3_result_int64(context, value);
+        } else {
+            double value;
+            std::memcpy(&value, cell, sizeof(value));
+            sqlite3_result_double(context, value);
+        }
+    }
+
+    int64_t timeseries_table::cursor::rowid() const noexcept
+    {
+        return static_cast<int64_t>(m_segment * m_table->m_store->segment_rows() + m_row) + 1;
+    }
+}
@@ -0,0 +1,201 @@
+/** @file */
+
+#ifndef __SQLITEXX_SQLITE_TIMESERIES_H__
+#define __SQLITEXX_SQLITE_TIMESERIES_H__
+
+#include "Exception.h"
+#include "MappedFile.h"
+#include "SQLiteEnums.h"
+#include "Value.h"
+#include "VirtualTable.h"
+
+#include <sqlite3.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace sqlite
+{
+    /** A value column of a time series, next to the time column every series has.
+     */
+    struct timeseries_column
+    {
+        std::string name; ///< the name of the column
+        datatype type;    ///< datatype::integer for 64-bit integers or datatype::floating for doubles
+    };
+
+    /**
+     * Append-only storage for rows ordered by a 64-bit integer time, kept in memory-mapped segment files.
+     * Every segment holds a fixed number of rows and stores each column as a contiguous array of 8-byte values,
+     * so appending a row writes to the end of each array and reading a time range starts with a binary search.
+     * The segments are the files segment-000001.ts, segment-000002.ts, ... in the directory, which has to exist,
+     * and opening a directory that already holds segments continues them.
+     * Rows are appended from C++ and read with SQL through sqlite::timeseries_table.
+     * Appending and reading from different threads is safe.
+     */
+    class timeseries_store
+    {
+        public:
+
+        /** Opens the segments in directory, creating the first one if there is none.
+         * @param[in] directory    the directory holding the segment files
+         * @param[in] columns      the value columns
+         * @param[in] segment_rows the number of rows in each segment
+         * @throws SQLiteXXException if a column type is not supported, the segments can not be mapped
+         *         or the existing segments have other columns
+         */
+        timeseries_store(const std::string& directory, std::vector<timeseries_column> columns, std::size_t segment_rows = 65536);
+
+        ~timeseries_store();
+
+        timeseries_store(const timeseries_store&) = delete;
+        timeseries_store& operator=(const timeseries_store&) = delete;
+
+        /** Appends rows given column by column, with one memcpy per column and segment.
+         * @param[in] count  the number of rows
+         * @param[in] times  the times of the rows, not smaller than the last time in the store and in ascending order
+         * @param[in] values one pointer per value column to count int64_t values for integer columns or count doubles for floating columns
+         * @throws SQLiteXXException if the times are out of order, the number of columns is wrong or a new segment can not be mapped,
+         *         in which case nothing is appended
+         */
+        void append(std::size_t count, const int64_t* times, const std::vector<const void*>& values);
+
+        /** Appends a single row.
+         * @param[in] time   the time of the row, not smaller than the last time in the store
+         * @param[in] values one arithmetic value per value column, converted to the type of the column
+         * @throws SQLiteXXException if the time is out of order or the number of values is wrong
+         */
+        template <typename... Values>
+        void append_row(const int64_t time, const Values... values)
+        {
+            static_assert(std::conjunction<std::is_arithmetic<Values>...>::value, "Time series values have to be numbers");
+            if (sizeof...(Values) != m_columns.size()) {
+                throw SQLiteXXException("A time series row needs " + std::to_string(m_columns.size()) + " values");
+            }
+
+            cell cells[sizeof...(Values) + 1];
+            std::size_t index = 0;
+            ((cells[index] = to_cell(m_columns[index].type, values), ++index), ...);
+
+            std::vector<const void*> pointers;
+            for (std::size_t i = 0; i < sizeof...(Values); ++i) {
+                pointers.push_back(&cells[i]);
+            }
+            append(1, &time, pointers);
+        }
+
+        /** Writes the appended rows to disk and waits until they are stored.
+         * @throws SQLiteXXException if the segments could not be written
+         */
+        void flush() const;
+
+        /** Returns the number of rows in the store.
+         */
+        int64_t row_count() const;
+
+        /** Returns the value columns.
+         */
+        const std::vector<timeseries_column>& columns() const noexcept;
+
+        /** Returns the number of rows in each segment.
+         */
+        std::size_t segment_rows() const noexcept;
+
+        /** A segment that a reader can use while rows are appended, since rows are only added after row_count.
+         */
+        struct segment_view
+        {
+            const int64_t* times;
+            std::vector<const char*> columns;
+            std::size_t row_count;
+        };
+
+        /** Returns the segments with their current number of rows.
+         */
+        std::vector<segment_view> snapshot() const;
+
+        private:
+        union cell {
+            int64_t integer;
+            double floating;
+        };
+
+        template <typename T>
+        static cell to_cell(const datatype type, const T value) noexcept
+        {
+            cell result;
+            if (type == datatype::integer) {
+                result.integer = static_cast<int64_t>(value);
+            } else {
+                result.floating = static_cast<double>(value);
+            }
+            return result;
+        }
+
+        struct segment;
+
+        std::unique_ptr<segment> open_segment(std::size_t number) const;
+
+        std::string m_directory;
+        std::vector<timeseries_column> m_columns;
+        std::size_t m_segment_rows;
+
+        mutable std::mutex m_mutex;
+        std::vector<std::unique_ptr<segment>> m_segments;
+    };
+
+    /**
+     * A read-only virtual table over a sqlite::timeseries_store with the columns (time INTEGER, value columns...).
+     * Constraints on time are turned into a range of segments and rows by binary search and are checked again by SQLite,
+     * and ORDER BY time needs no sorting. The rowid is the position of the row in the store.
+     * A scan reads the rows that were in the store when it started.
+     */
+    class timeseries_table
+    {
+        public:
+        explicit timeseries_table(std::shared_ptr<const timeseries_store> store);
+
+        std::string schema() const;
+
+        void best_index(index_info& info) const;
+
+        /** Walks the rows of a time range.
+         */
+        class cursor
+        {
+            public:
+            explicit cursor(const timeseries_table& table) noexcept;
+
+            void filter(int index_number, std::string_view index_string, value_span arguments);
+
+            void next() noexcept;
+
+            bool eof() const noexcept;
+
+            void column(sqlite3_context* context, int column) const;
+
+            int64_t rowid() const noexcept;
+
+            private:
+            const timeseries_table* m_table;
+            std::vector<timeseries_store::segment_view> m_segments;
+            std::size_t m_segment;
+            std::size_t m_row;
+            std::size_t m_end_segment;
+            std::size_t m_end_row;
+        };
+
+        cursor open() const;
+
+        private:
+        std::shared_ptr<const timeseries_store> m_store;
+    };
+}
+
+#endif
@@ -0,0 +1,16 @@
+#include "Utilities.h"
+
+namespace sqlite
+{
+    std::string quote_identifier(const std::string& name)
+    {
+        std::string quoted = "\"";
+        for (const char c : name) {
+            quoted += c;
+            if (c == '"') {
+                quoted += '"';
+            }
+        }
+        return quoted + "\"";
+    }
+}
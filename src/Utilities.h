@@ -0,0 +1,17 @@
+/** @file */
+
+#ifndef __SQLITEXX_SQLITE_UTILITIES_H__
+#define __SQLITEXX_SQLITE_UTILITIES_H__
+
+#include <string>
+
+namespace sqlite
+{
+    /** Quotes a name so it can be used as an identifier in SQL, doubling the double quotes inside it.
+     * @param[in] name the name of a table, column, schema or other object.
+     * @returns the name surrounded by double quotes.
+     */
+    std::string quote_identifier(const std::string& name);
+}
+
+#endif
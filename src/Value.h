@@ -9,8 +9,13 @@
 #include <sqlite3.h>
 
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <cstring>
+#include <iterator>
+#include <memory>
 #include <string>
+#include <string_view>
 
 namespace sqlite
 {
@@ -194,6 +199,205 @@ namespace sqlite
     {
         return as_u16string();
     }
+
+    /** A non-owning reference to a "sqlite3_value" argument of an SQL function.
+     * Unlike value no copy of the underlying sqlite3_value is made, so a value_ref is only
+     * valid for the duration of the function call that received it.
+     */
+    class value_ref
+    {
+        public:
+
+        /** Constructs a value_ref object referring to a sqlite3_value object.
+         * @param[in] value a pointer to the sqlite3_value object to refer to.
+         */
+        explicit value_ref(sqlite3_value* const value) noexcept :
+            m_handle(value)
+        {}
+
+        /** Returns pointer to the underlying "sqlite3_value" object.
+         */
+        sqlite3_value* handle() const noexcept
+        {
+            return m_handle;
+        }
+
+        /** Represents the value as an integer.
+         * @returns An integer representing the value of the object.
+         */
+        int as_int() const noexcept
+        {
+            return sqlite3_value_int(m_handle);
+        }
+
+        /** Represents the value as a 64-bit integer.
+         * @returns An 64-bit integer representing the value of the object.
+         */
+        int64_t as_int64() const noexcept
+        {
+            return sqlite3_value_int64(m_handle);
+        }
+
+        /** Represents the value as a double.
+         * @returns A double representing the value of the object.
+         */
+        double as_double() const noexcept
+        {
+            return sqlite3_value_double(m_handle);
+        }
+
+        /** Represents the value as UTF-8 text without copying it.
+         * The returned view is invalidated by a call to as_u16string() on the same value.
+         * @returns A view of the text representation of the value.
+         */
+        std::string_view as_string_view() const noexcept
+        {
+            const char* text = reinterpret_cast<const char*>(sqlite3_value_text(m_handle));
+            return std::string_view(text != nullptr ? text : "", sqlite3_value_bytes(m_handle));
+        }
+
+        /** Represents the value as a string.
+         * @returns A string representing the value of the object.
+         */
+        std::string as_string() const
+        {
+            return std::string(as_string_view());
+        }
+
+        /** Represents the value as a UTF-16 string.
+         * @returns A UTF-16 string representing the value of the object.
+         */
+        std::u16string as_u16string() const
+        {
+            const char16_t* text = reinterpret_cast<const char16_t*>(sqlite3_value_text16(m_handle));
+            return std::u16string(text != nullptr ? text : u"", sqlite3_value_bytes16(m_handle) / sizeof(char16_t));
+        }
+
+        /** Represents the value as a blob object.
+         * @returns A blob object representing the value of the object.
+         */
+        blob as_blob() const
+        {
+            const void* data = sqlite3_value_blob(m_handle);
+            return blob(data, data != nullptr ? sqlite3_value_bytes(m_handle) : 0);
+        }
+
+        /** Returns the size in bytes of the value.
+         * @returns The size in bytes of the value.
+         */
+        int bytes() const noexcept
+        {
+            return sqlite3_value_bytes(m_handle);
+        }
+
+        /** Returns the datatype for the initial datatype of the value.
+         * @returns The type of the value.
+         */
+        datatype type() const noexcept
+        {
+            return static_cast<datatype>(sqlite3_value_type(m_handle));
+        }
+
+        private:
+        sqlite3_value* m_handle;
+    };
+
+    /** A non-owning view over the arguments of an SQL function.
+     * Building a value_span does not allocate, which makes it the preferred argument of
+     * functions registered with dbconnection::create_general_function.
+     * A value_span is only valid for the duration of the function call that received it.
+     */
+    class value_span
+    {
+        public:
+
+        /** Iterates over the arguments of a value_span as value_ref objects.
+         */
+        class iterator
+        {
+            public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = value_ref;
+            using difference_type = std::ptrdiff_t;
+            using pointer = void;
+            using reference = value_ref;
+
+            explicit iterator(sqlite3_value** position) noexcept :
+                m_position(position)
+            {}
+
+            value_ref operator*() const noexcept
+            {
+                return value_ref(*m_position);
+            }
+
+            iterator& operator++() noexcept
+            {
+                ++m_position;
+                return *this;
+            }
+
+            bool operator==(const iterator& other) const noexcept
+            {
+                return m_position == other.m_position;
+            }
+
+            bool operator!=(const iterator& other) const noexcept
+            {
+                return m_position != other.m_position;
+            }
+
+            private:
+            sqlite3_value** m_position;
+        };
+
+        /** Constructs a value_span over an array of sqlite3_value pointers.
+         * @param[in] values the array of arguments
+         * @param[in] size   the number of arguments in the array
+         */
+        value_span(sqlite3_value** values, const std::size_t size) noexcept :
+            m_values(values),
+            m_size(size)
+        {}
+
+        /** Returns the number of arguments.
+         */
+        std::size_t size() const noexcept
+        {
+            return m_size;
+        }
+
+        /** Returns true if there are no arguments.
+         */
+        bool empty() const noexcept
+        {
+            return m_size == 0;
+        }
+
+        /** Access the specified argument without bounds checking.
+         * @param[in] index position of the argument
+         * @returns a value_ref to the requested argument
+         */
+        value_ref operator[](const std::size_t index) const noexcept
+        {
+            assert(index < m_size);
+            return value_ref(m_values[index]);
+        }
+
+        iterator begin() const noexcept
+        {
+            return iterator(m_values);
+        }
+
+        iterator end() const noexcept
+        {
+            return iterator(m_values + m_size);
+        }
+
+        private:
+        sqlite3_value** m_values;
+        std::size_t m_size;
+    };
 }
 
 #endif
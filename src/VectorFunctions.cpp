@@ -0,0 +1,491 @@
+#include "VectorFunctions.h"
+
+#include "Exception.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define SQLITEXX_VECTOR_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define SQLITEXX_TARGET(isa)
+#else
+#define SQLITEXX_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
+
+namespace sqlite
+{
+    namespace
+    {
+        // The blobs are read in place and SQLite does not align them, so every kernel uses unaligned loads.
+        struct kernels {
+            float (*dot)(const unsigned char* a, const unsigned char* b, std::size_t count);
+            float (*squared_distance)(const unsigned char* a, const unsigned char* b, std::size_t count);
+            void (*dot_and_norms)(const unsigned char* a, const unsigned char* b, std::size_t count, float& ab, float& aa, float& bb);
+        };
+
+        inline float load(const unsigned char* data, const std::size_t index)
+        {
+            float value;
+            std::memcpy(&value, data + index * sizeof(float), sizeof(float));
+            return value;
+        }
+
+        float scalar_dot(const unsigned char* a, const unsigned char* b, const std::size_t count)
+        {
+            float sum = 0.0f;
+            for (std::size_t i = 0; i < count; ++i) {
+                sum += load(a, i) * load(b, i);
+            }
+            return sum;
+        }
+
+        float scalar_squared_distance(const unsigned char* a, const unsigned char* b, const std::size_t count)
+        {
+            float sum = 0.0f;
+            for (std::size_t i = 0; i < count; ++i) {
+                const float difference = load(a, i) - load(b, i);
+                sum += difference * difference;
+            }
+            return sum;
+        }
+
+        void scalar_dot_and_norms(const unsigned char* a, const unsigned char* b, const std::size_t count, float& ab, float& aa, float& bb)
+        {
+            ab = aa = bb = 0.0f;
+            for (std::size_t i = 0; i < count; ++i) {
+                const float x = load(a, i);
+                const float y = load(b, i);
+                ab += x * y;
+                aa += x * x;
+                bb += y * y;
+            }
+        }
+
+        const kernels scalar_kernels = {&scalar_dot, &scalar_squared_distance, &scalar_dot_and_norms};
+
+#ifdef SQLITEXX_VECTOR_X86
+        inline const float* floats(const unsigned char* data, const std::size_t index)
+        {
+            return reinterpret_cast<const float*>(data) + index;
+        }
+
+        inline float sum_sse(const __m128 v)
+        {
+            __m128 shuffled = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+            __m128 sums = _mm_add_ps(v, shuffled);
+            shuffled = _mm_movehl_ps(shuffled, sums);
+            sums = _mm_add_ss(sums, shuffled);
+            return _mm_cvtss_f32(sums);
+        }
+
+        float sse2_dot(const unsigned char* a, const unsigned char* b, const std::size_t count)
+        {
+            __m128 sum = _mm_setzero_ps();
+            std::size_t i = 0;
+            for (; i + 4 <= count; i += 4) {
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(floats(a, i)), _mm_loadu_ps(floats(b, i))));
+            }
+            float result = sum_sse(sum);
+            for (; i < count; ++i) {
+                result += load(a, i) * load(b, i);
+            }
+            return result;
+        }
+
+        float sse2_squared_distance(const unsigned char* a, const unsigned char* b, const std::size_t count)
+        {
+            __m128 sum = _mm_setzero_ps();
+            std::size_t i = 0;
+            for (; i + 4 <= count; i += 4) {
+                const __m128 difference = _mm_sub_ps(_mm_loadu_ps(floats(a, i)), _mm_loadu_ps(floats(b, i)));
+                sum = _mm_add_ps(sum, _mm_mul_ps(difference, difference));
+            }
+            float result = sum_sse(sum);
+            for (; i < count; ++i) {
+                const float difference = load(a, i) - load(b, i);
+                result += difference * difference;
+            }
+            return result;
+        }
+
+        void sse2_dot_and_norms(const unsigned char* a, const unsigned char* b, const std::size_t count, float& ab, float& aa, float& bb)
+        {
+            __m128 sum_ab = _mm_setzero_ps();
+            __m128 sum_aa = _mm_setzero_ps();
+            __m128 sum_bb = _mm_setzero_ps();
+            std::size_t i = 0;
+            for (; i + 4 <= count; i += 4) {
+                const __m128 x = _mm_loadu_ps(floats(a, i));
+                const __m128 y = _mm_loadu_ps(floats(b, i));
+                sum_ab = _mm_add_ps(sum_ab, _mm_mul_ps(x, y));
+                sum_aa = _mm_add_ps(sum_aa, _mm_mul_ps(x, x));
+                sum_bb = _mm_add_ps(sum_bb, _mm_mul_ps(y, y));
+            }
+            ab = sum_sse(sum_ab);
+            aa = sum_sse(sum_aa);
+            bb = sum_sse(sum_bb);
+            for (; i < count; ++i) {
+                const float x = load(a, i);
+                const float y = load(b, i);
+                ab += x * y;
+                aa += x * x;
+                bb += y * y;
+            }
+        }
+
+        const kernels sse2_kernels = {&sse2_dot, &sse2_squared_distance, &sse2_dot_and_norms};
+
+        SQLITEXX_TARGET("avx2,fma")
+        inline float sum_avx(const __m256 v)
+        {
+            return sum_sse(_mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1)));
+        }
+
+        // Two accumulators hide the latency of the fused multiply-adds.
+        SQLITEXX_TARGET("avx2,fma")
+        float avx2_dot(const unsigned char* a, const unsigned char* b, const std::size_t count)
+        {
+            __m256 sum0 = _mm256_setzero_ps();
+            __m256 sum1 = _mm256_setzero_ps();
+            std::size_t i = 0;
+            for (; i + 16 <= count; i += 16) {
+                sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(floats(a, i)), _mm256_loadu_ps(floats(b, i)), sum0);
+                sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(floats(a, i + 8)), _mm256_loadu_ps(floats(b, i + 8)), sum1);
+            }
+            for (; i + 8 <= count; i += 8) {
+                sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(floats(a, i)), _mm256_loadu_ps(floats(b, i)), sum0);
+            }
+            float result = sum_avx(_mm256_add_ps(sum0, sum1));
+            for (; i < count; ++i) {
+                result += load(a, i) * load(b, i);
+            }
+            return result;
+        }
+
+        SQLITEXX_TARGET("avx2,fma")
+        float avx2_squared_distance(const unsigned char* a, const unsigned char* b, const std::size_t count)
+        {
+            __m256 sum0 = _mm256_setzero_ps();
+            __m256 sum1 = _mm256_setzero_ps();
+            std::size_t i = 0;
+            for (; i + 16 <= count; i += 16) {
+                const __m256 difference0 = _mm256_sub_ps(_mm256_loadu_ps(floats(a, i)), _mm256_loadu_ps(floats(b, i)));
+                const __m256 difference1 = _mm256_sub_ps(_mm256_loadu_ps(floats(a, i + 8)), _mm256_loadu_ps(floats(b, i + 8)));
+                sum0 = _mm256_fmadd_ps(difference0, difference0, sum0);
+                sum1 = _mm256_fmadd_ps(difference1, difference1, sum1);
+            }
+            for (; i + 8 <= count; i += 8) {
+                const __m256 difference = _mm256_sub_ps(_mm256_loadu_ps(floats(a, i)), _mm256_loadu_ps(floats(b, i)));
+                sum0 = _mm256_fmadd_ps(difference, difference, sum0);
+            }
+            float result = sum_avx(_mm256_add_ps(sum0, sum1));
+            for (; i < count; ++i) {
+                const float difference = load(a, i) - load(b, i);
+                result += difference * difference;
+            }
+            return result;
+        }
+
+        SQLITEXX_TARGET("avx2,fma")
+        void avx2_dot_and_norms(const unsigned char* a, const unsigned char* b, const std::size_t count, float& ab, float& aa, float& bb)
+        {
+            __m256 sum_ab = _mm256_setzero_ps();
+            __m256 sum_aa = _mm256_setzero_ps();
+            __m256 sum_bb = _mm256_setzero_ps();
+            std::size_t i = 0;
+            for (; i + 8 <= count; i += 8) {
+                const __m256 x = _mm256_loadu_ps(floats(a, i));
+                const __m256 y = _mm256_loadu_ps(floats(b, i));
+                sum_ab = _mm256_fmadd_ps(x, y, sum_ab);
+                sum_aa = _mm256_fmadd_ps(x, x, sum_aa);
+                sum_bb = _mm256_fmadd_ps(y, y, sum_bb);
+            }
+            ab = sum_avx(sum_ab);
+            aa = sum_avx(sum_aa);
+            bb = sum_avx(sum_bb);
+            for (; i < count; ++i) {
+                const float x = load(a, i);
+                const float y = load(b, i);
+                ab += x * y;
+                aa += x * x;
+                bb += y * y;
+            }
+        }
+
+        const kernels avx2_kernels = {&avx2_dot, &avx2_squared_distance, &avx2_dot_and_norms};
+
+        // The tail is handled with a masked load, so there is no scalar loop.
+        SQLITEXX_TARGET("avx512f")
+        inline __mmask16 tail_mask(const std::size_t remaining)
+        {
+            return static_cast<__mmask16>((1u << remaining) - 1u);
+        }
+
+        SQLITEXX_TARGET("avx512f")
+        float avx512_dot(const unsigned char* a, const unsigned char* b, const std::size_t count)
+        {
+            __m512 sum = _mm512_setzero_ps();
+            std::size_t i = 0;
+            for (; i + 16 <= count; i += 16) {
+                sum = _mm512_fmadd_ps(_mm512_loadu_ps(floats(a, i)), _mm512_loadu_ps(floats(b, i)), sum);
+            }
+            if (i < count) {
+                const __mmask16 mask = tail_mask(count - i);
+                sum = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, floats(a, i)), _mm512_maskz_loadu_ps(mask, floats(b, i)), sum);
+            }
+            return _mm512_reduce_add_ps(sum);
+        }
+
+        SQLITEXX_TARGET("avx512f")
+        float avx512_squared_distance(const unsigned char* a, const unsigned char* b, const std::size_t count)
+        {
+            __m512 sum = _mm512_setzero_ps();
+            std::size_t i = 0;
+            for (; i + 16 <= count; i += 16) {
+                const __m512 difference = _mm512_sub_ps(_mm512_loadu_ps(floats(a, i)), _mm512_loadu_ps(floats(b, i)));
+                sum = _mm512_fmadd_ps(difference, difference, sum);
+            }
+            if (i < count) {
+                const __mmask16 mask = tail_mask(count - i);
+                const __m512 difference = _mm512_sub_ps(_mm512_maskz_loadu_ps(mask, floats(a, i)), _mm512_maskz_loadu_ps(mask, floats(b, i)));
+                sum = _mm512_fmadd_ps(difference, difference, sum);
+            }
+            return _mm512_reduce_add_ps(sum);
+        }
+
+        SQLITEXX_TARGET("avx512f")
+        void avx512_dot_and_norms(const unsigned char* a, const unsigned char* b, const std::size_t count, float& ab, float& aa, float& bb)
+        {
+            __m512 sum_ab = _mm512_setzero_ps();
+            __m512 sum_aa = _mm512_setzero_ps();
+            __m512 sum_bb = _mm512_setzero_ps();
+            for (std::size_t i = 0; i < count; i += 16) {
+                const __mmask16 mask = count - i >= 16 ? static_cast<__mmask16>(0xFFFF) : tail_mask(count - i);
+                const __m512 x = _mm512_maskz_loadu_ps(mask, floats(a, i));
+                const __m512 y = _mm512_maskz_loadu_ps(mask, floats(b, i));
+                sum_ab = _mm512_fmadd_ps(x, y, sum_ab);
+                sum_aa = _mm512_fmadd_ps(x, x, sum_aa);
+                sum_bb = _mm512_fmadd_ps(y, y, sum_bb);
+            }
+            ab = _mm512_reduce_add_ps(sum_ab);
+            aa = _mm512_reduce_add_ps(sum_aa);
+            bb = _mm512_reduce_add_ps(sum_bb);
+        }
+
+        const kernels avx512_kernels = {&avx512_dot, &avx512_squared_distance, &avx512_dot_and_norms};
+
+        vector_isa detect_isa() noexcept
+        {
+#if defined(_MSC_VER) && !defined(__clang__)
+            int info[4];
+            __cpuid(info, 1);
+            const bool osxsave = (info[2] & (1 << 27)) != 0;
+            const bool fma = (info[2] & (1 << 12)) != 0;
+            if (!osxsave) {
+                return vector_isa::sse2;
+            }
+            const unsigned long long xcr0 = _xgetbv(0);
+            __cpuidex(info, 7, 0);
+            const bool avx2 = (info[1] & (1 << 5)) != 0;
+            const bool avx512f = (info[1] & (1 << 16)) != 0;
+            // The OS has to save the ymm registers, and for AVX-512 the opmask and zmm registers as well.
+            if (avx512f && (xcr0 & 0xE6) == 0xE6) {
+                return vector_isa::avx512;
+            }
+            if (avx2 && fma && (xcr0 & 0x6) == 0x6) {
+                return vector_isa::avx2;
+            }
+            return vector_isa::sse2;
+#else
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx512f")) {
+                return vector_isa::avx512;
+            }
+            if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+                return vector_isa::avx2;
+            }
+            return vector_isa::sse2;
+#endif
+        }
+#else
+        vector_isa detect_isa() noexcept
+        {
+            return vector_isa::scalar;
+        }
+#endif
+
+        const kernels* kernels_for(const vector_isa isa) noexcept
+        {
+            switch (isa) {
+#ifdef SQLITEXX_VECTOR_X86
+                case vector_isa::avx512:
+                    return &avx512_kernels;
+                case vector_isa::avx2:
+                    return &avx2_kernels;
+                case vector_isa::sse2:
+                    return &sse2_kernels;
+#endif
+                default:
+                    return &scalar_kernels;
+            }
+        }
+
+        vector_isa best_isa() noexcept
+        {
+            static const vector_isa isa = detect_isa();
+            return isa;
+        }
+
+        std::atomic<vector_isa>& selected_isa() noexcept
+        {
+            static std::atomic<vector_isa> isa(best_isa());
+            return isa;
+        }
+
+        bool read_vector(sqlite3_context* context, sqlite3_value* value, const unsigned char*& data, std::size_t& count)
+        {
+            data = static_cast<const unsigned char*>(sqlite3_value_blob(value));
+            // sqlite3_value_bytes must be called after sqlite3_value_blob to get the size of the converted value.
+            const int bytes = sqlite3_value_bytes(value);
+            if (bytes % sizeof(float) != 0) {
+                sqlite3_result_error(context, "vector blob size is not a multiple of 4 bytes", -1);
+                return false;
+            }
+            count = static_cast<std::size_t>(bytes) / sizeof(float);
+            return true;
+        }
+
+        bool has_null(const int argc, sqlite3_value** values)
+        {
+            for (int i = 0; i < argc; ++i) {
+                if (sqlite3_value_type(values[i]) == SQLITE_NULL) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool read_pair(
+            sqlite3_context* context,
+            sqlite3_value** values,
+            const unsigned char*& a,
+            const unsigned char*& b,
+            std::size_t& count)
+        {
+            std::size_t count_b;
+            if (!read_vector(context, values[0], a, count) || !read_vector(context, values[1], b, count_b)) {
+                return false;
+            }
+            if (count != count_b) {
+                sqlite3_result_error(context, "vectors have different dimensions", -1);
+                return false;
+            }
+            return true;
+        }
+
+        void vec_dot(sqlite3_context* context, int argc, sqlite3_value** values)
+        {
+            const unsigned char* a;
+            const unsigned char* b;
+            std::size_t count;
+            if (has_null(argc, values)) {
+                sqlite3_result_null(context);
+            } else if (read_pair(context, values, a, b, count)) {
+                sqlite3_result_double(context, kernels_for(selected_isa().load(std::memory_order_relaxed))->dot(a, b, count));
+            }
+        }
+
+        void vec_l2(sqlite3_context* context, int argc, sqlite3_value** values)
+        {
+            const unsigned char* a;
+            const unsigned char* b;
+            std::size_t count;
+            if (has_null(argc, values)) {
+                sqlite3_result_null(context);
+            } else if (read_pair(context, values, a, b, count)) {
+                const float sum = kernels_for(selected_isa().load(std::memory_order_relaxed))->squared_distance(a, b, count);
+                sqlite3_result_double(context, std::sqrt(static_cast<double>(sum)));
+            }
+        }
+
+        void vec_cosine(sqlite3_context* context, int argc, sqlite3_value** values)
+        {
+            const unsigned char* a;
+            const unsigned char* b;
+            std::size_t count;
+            if (has_null(argc, values)) {
+                sqlite3_result_null(context);
+            } else if (read_pair(context, values, a, b, count)) {
+                float ab;
+                float aa;
+                float bb;
+                kernels_for(selected_isa().load(std::memory_order_relaxed))->dot_and_norms(a, b, count, ab, aa, bb);
+                if (aa == 0.0f || bb == 0.0f) {
+                    sqlite3_result_null(context);
+                } else {
+                    sqlite3_result_double(context, ab / (std::sqrt(static_cast<double>(aa)) * std::sqrt(static_cast<double>(bb))));
+                }
+            }
+        }
+
+        void vec_norm(sqlite3_context* context, int argc, sqlite3_value** values)
+        {
+            const unsigned char* a;
+            std::size_t count;
+            if (has_null(argc, values)) {
+                sqlite3_result_null(context);
+            } else if (read_vector(context, values[0], a, count)) {
+                const float sum = kernels_for(selected_isa().load(std::memory_order_relaxed))->dot(a, a, count);
+                sqlite3_result_double(context, std::sqrt(static_cast<double>(sum)));
+            }
+        }
+
+        void register_function(sqlite3* connection, const char* name, const int nargs, void (*function)(sqlite3_context*, int, sqlite3_value**))
+        {
+            const int errorcode = sqlite3_create_function_v2(
+                connection,
+                name,
+                nargs,
+                SQLITE_UTF8 | SQLITE_DETERMINISTIC,
+                nullptr,
+                function,
+                nullptr,
+                nullptr,
+                nullptr);
+            throw_error_code(errorcode, std::string("Unable to register the vector function ") + name);
+        }
+    }
+
+    vector_isa supported_vector_isa() noexcept
+    {
+        return best_isa();
+    }
+
+    vector_isa active_vector_isa() noexcept
+    {
+        return selected_isa().load();
+    }
+
+    void use_vector_isa(const vector_isa isa)
+    {
+        if (static_cast<int>(isa) > static_cast<int>(best_isa())) {
+            throw SQLiteXXException("The requested vector instruction set is not supported on this CPU.");
+        }
+        selected_isa().store(isa);
+    }
+
+    void register_vector_functions(sqlite3* connection)
+    {
+        register_function(connection, "vec_dot", 2, &vec_dot);
+        register_function(connection, "vec_l2", 2, &vec_l2);
+        register_function(connection, "vec_cosine", 2, &vec_cosine);
+        register_function(connection, "vec_norm", 1, &vec_norm);
+    }
+}
@@ -0,0 +1,48 @@
+/** @file */
+
+#ifndef __SQLITEXX_SQLITE_VECTORFUNCTIONS_H__
+#define __SQLITEXX_SQLITE_VECTORFUNCTIONS_H__
+
+#include <sqlite3.h>
+
+namespace sqlite
+{
+    /** The instruction sets the vector functions have kernels for.
+     */
+    enum class vector_isa
+    {
+        scalar, ///< portable C++ loops
+        sse2,   ///< 4 floats at a time, always available on x86-64
+        avx2,   ///< 8 floats at a time with fused multiply-add
+        avx512  ///< 16 floats at a time with masked loads for the tail
+    };
+
+    /** Returns the best instruction set the vector functions can use on this CPU.
+     * @returns the best supported instruction set
+     */
+    vector_isa supported_vector_isa() noexcept;
+
+    /** Returns the instruction set the vector functions currently use.
+     * Unless changed with use_vector_isa() this is supported_vector_isa().
+     * @returns the instruction set in use
+     */
+    vector_isa active_vector_isa() noexcept;
+
+    /** Selects the instruction set the vector functions use, process wide.
+     * Mostly useful to compare kernels against each other.
+     * @param[in] isa the instruction set to use
+     * @throws SQLiteXXException if the CPU or the build does not support the instruction set
+     */
+    void use_vector_isa(const vector_isa isa);
+
+    /** Registers vec_dot(), vec_l2(), vec_cosine() and vec_norm() on a database connection.
+     * The functions take vectors stored as blobs of native float32 values and read them in place.
+     * A NULL argument gives NULL, as does vec_cosine() of a zero vector.
+     * Vectors of different lengths, or blobs that are not a whole number of floats, raise an error.
+     * @param[in] connection the connection to register the functions on
+     * @throws sqlite::exception if a function could not be registered
+     */
+    void register_vector_functions(sqlite3* connection);
+}
+
+#endif
@@ -0,0 +1,505 @@
+#include "VfsShim.h"
+
+#include "Exception.h"
+
+#include <algorithm>
+#include <new>
+#include <utility>
+
+namespace sqlite
+{
+    file_kind file_kind_of(const int flags) noexcept
+    {
+        if (flags & SQLITE_OPEN_MAIN_DB) {
+            return file_kind::main_database;
+        }
+        if (flags & SQLITE_OPEN_WAL) {
+            return file_kind::wal;
+        }
+        if (flags & (SQLITE_OPEN_MAIN_JOURNAL | SQLITE_OPEN_MASTER_JOURNAL)) {
+            return file_kind::journal;
+        }
+        return file_kind::temporary;
+    }
+
+    vfs_file::vfs_file(sqlite3_file* base, const file_kind kind) noexcept :
+        m_base(base),
+        m_kind(kind)
+    {}
+
+    vfs_file::~vfs_file() = default;
+
+    file_kind vfs_file::kind() const noexcept
+    {
+        return m_kind;
+    }
+
+    sqlite3_file* vfs_file::base() const noexcept
+    {
+        return m_base;
+    }
+
+    int vfs_file::close()
+    {
+        return m_base->pMethods->xClose(m_base);
+    }
+
+    int vfs_file::read(void* buffer, const int amount, const int64_t offset)
+    {
+        return m_base->pMethods->xRead(m_base, buffer, amount, offset);
+    }
+
+    int vfs_file::write(const void* buffer, const int amount, const int64_t offset)
+    {
+        return m_base->pMethods->xWrite(m_base, buffer, amount, offset);
+    }
+
+    int vfs_file::truncate(const int64_t size)
+    {
+        return m_base->pMethods->xTruncate(m_base, size);
+    }
+
+    int vfs_file::sync(const int flags)
+    {
+        return m_base->pMethods->xSync(m_base, flags);
+    }
+
+    int vfs_file::file_size(int64_t* size)
+    {
+        sqlite3_int64 result = 0;
+        const int errorcode = m_base->pMethods->xFileSize(m_base, &result);
+        *size = result;
+        return errorcode;
+    }
+
+    int vfs_file::lock(const int level)
+    {
+        return m_base->pMethods->xLock(m_base, level);
+    }
+
+    int vfs_file::unlock(const int level)
+    {
+        return m_base->pMethods->xUnlock(m_base, level);
+    }
+
+    int vfs_file::check_reserved_lock(int* result)
+    {
+        return m_base->pMethods->xCheckReservedLock(m_base, result);
+    }
+
+    int vfs_file::file_control(const int operation, void* argument)
+    {
+        return m_base->pMethods->xFileControl(m_base, operation, argument);
+    }
+
+    int vfs_file::sector_size()
+    {
+        return m_base->pMethods->xSectorSize(m_base);
+    }
+
+    int vfs_file::device_characteristics()
+    {
+        return m_base->pMethods->xDeviceCharacteristics(m_base);
+    }
+
+    int vfs_file::shm_map(const int region, const int size, const int extend, void volatile** address)
+    {
+        return m_base->pMethods->xShmMap(m_base, region, size, extend, address);
+    }
+
+    int vfs_file::shm_lock(const int offset, const int count, const int flags)
+    {
+        return m_base->pMethods->xShmLock(m_base, offset, count, flags);
+    }
+
+    void vfs_file::shm_barrier()
+    {
+        m_base->pMethods->xShmBarrier(m_base);
+    }
+
+    int vfs_file::shm_unmap(const int delete_flag)
+    {
+        return m_base->pMethods->xShmUnmap(m_base, delete_flag);
+    }
+
+    int vfs_file::fetch(const int64_t offset, const int amount, void** pointer)
+    {
+        return m_base->pMethods->xFetch(m_base, offset, amount, pointer);
+    }
+
+    int vfs_file::unfetch(const int64_t offset, void* pointer)
+    {
+        return m_base->pMethods->xUnfetch(m_base, offset, pointer);
+    }
+
+    namespace
+    {
+        // The file SQLite allocates szOsFile bytes for: the shim's handle followed by the underlying file.
+        struct shim_handle : public sqlite3_file
+        {
+            vfs_file* file;
+        };
+
+        constexpr std::size_t base_offset = (sizeof(shim_handle) + 7) & ~static_cast<std::size_t>(7);
+
+        vfs_file& file_of(sqlite3_file* file) noexcept
+        {
+            return *static_cast<shim_handle*>(file)->file;
+        }
+
+        sqlite3_file* base_file_of(sqlite3_file* file) noexcept
+        {
+            return reinterpret_cast<sqlite3_file*>(reinterpret_cast<char*>(file) + base_offset);
+        }
+
+        template <typename F>
+        int guard_vfs_call(F&& function) noexcept
+        {
+            try {
+                return function();
+            } catch (const sqlite::exception& e) {
+                return e.errcode;
+            } catch (const std::bad_alloc&) {
+                return SQLITE_IOERR_NOMEM;
+            } catch (...) {
+                return SQLITE_IOERR;
+            }
+        }
+
+        int shim_close(sqlite3_file* file)
+        {
+            shim_handle& handle = *static_cast<shim_handle*>(file);
+            const int errorcode = guard_vfs_call([&]() { return handle.file->close(); });
+            delete handle.file;
+            handle.file = nullptr;
+            return errorcode;
+        }
+
+        int shim_read(sqlite3_file* file, void* buffer, int amount, sqlite3_int64 offset)
+        {
+            return guard_vfs_call([&]() { return file_of(file).read(buffer, amount, offset); });
+        }
+
+        int shim_write(sqlite3_file* file, const void* buffer, int amount, sqlite3_int64 offset)
+        {
+            return guard_vfs_call([&]() { return file_of(file).write(buffer, amount, offset); });
+        }
+
+        int shim_truncate(sqlite3_file* file, sqlite3_int64 size)
+        {
+            return guard_vfs_call([&]() { return file_of(file).truncate(size); });
+        }
+
+        int shim_sync(sqlite3_file* file, int flags)
+        {
+            return guard_vfs_call([&]() { return file_of(file).sync(flags); });
+        }
+
+        int shim_file_size(sqlite3_file* file, sqlite3_int64* size)
+        {
+            return guard_vfs_call([&]() {
+                int64_t result = 0;
+                const int errorcode = file_of(file).file_size(&result);
+                *size = result;
+                return errorcode;
+            });
+        }
+
+        int shim_lock(sqlite3_file* file, int level)
+        {
+            return guard_vfs_call([&]() { return file_of(file).lock(level); });
+        }
+
+        int shim_unlock(sqlite3_file* file, int level)
+        {
+            return guard_vfs_call([&]() { return file_of(file).unlock(level); });
+        }
+
+        int shim_check_reserved_lock(sqlite3_file* file, int* result)
+        {
+            return guard_vfs_call([&]() { return file_of(file).check_reserved_lock(result); });
+        }
+
+        int shim_file_control(sqlite3_file* file, int operation, void* argument)
+        {
+            return guard_vfs_call([&]() { return file_of(file).file_control(operation, argument); });
+        }
+
+        int shim_sector_size(sqlite3_file* file)
+        {
+            try {
+                return file_of(file).sector_size();
+            } catch (...) {
+                return 0;
+            }
+        }
+
+        int shim_device_characteristics(sqlite3_file* file)
+        {
+            try {
+                return file_of(file).device_characteristics();
+            } catch (...) {
+                return 0;
+            }
+        }
+
+        int shim_shm_map(sqlite3_file* file, int region, int size, int extend, void volatile** address)
+        {
+            return guard_vfs_call([&]() { return file_of(file).shm_map(region, size, extend, address); });
+        }
+
+        int shim_shm_lock(sqlite3_file* file, int offset, int count, int flags)
+        {
+            return guard_vfs_call([&]() { return file_of(file).shm_lock(offset, count, flags); });
+        }
+
+        void shim_shm_barrier(sqlite3_file* file)
+        {
+            try {
+                file_of(file).shm_barrier();
+            } catch (...) {
+            }
+        }
+
+        int shim_shm_unmap(sqlite3_file* file, int delete_flag)
+        {
+            return guard_vfs_call([&]() { return file_of(file).shm_unmap(delete_flag); });
+        }
+
+        int shim_fetch(sqlite3_file* file, sqlite3_int64 offset, int amount, void** pointer)
+        {
+            return guard_vfs_call([&]() { return file_of(file).fetch(offset, amount, pointer); });
+        }
+
+        int shim_unfetch(sqlite3_file* file, sqlite3_int64 offset, void* pointer)
+        {
+            return guard_vfs_call([&]() { return file_of(file).unfetch(offset, pointer); });
+        }
+
+        // One table per io_methods version, so SQLite sees the same capabilities as the underlying file has.
+        constexpr sqlite3_io_methods shim_methods(const int version) noexcept
+        {
+            return {
+                version,
+                &shim_close,
+                &shim_read,
+                &shim_write,
+                &shim_truncate,
+                &shim_sync,
+                &shim_file_size,
+                &shim_lock,
+                &shim_unlock,
+                &shim_check_reserved_lock,
+                &shim_file_control,
+                &shim_sector_size,
+                &shim_device_characteristics,
+                version >= 2 ? &shim_shm_map : nullptr,
+                version >= 2 ? &shim_shm_lock : nullptr,
+                version >= 2 ? &shim_shm_barrier : nullptr,
+                version >= 2 ? &shim_shm_unmap : nullptr,
+                version >= 3 ? &shim_fetch : nullptr,
+                version >= 3 ? &shim_unfetch : nullptr
+            };
+        }
+
+        const sqlite3_io_methods shim_methods_v1 = shim_methods(1);
+        const sqlite3_io_methods shim_methods_v2 = shim_methods(2);
+        const sqlite3_io_methods shim_methods_v3 = shim_methods(3);
+
+        const sqlite3_io_methods* shim_methods_for(const sqlite3_io_methods* base) noexcept
+        {
+            if (base->iVersion >= 3) {
+                return &shim_methods_v3;
+            }
+            return base->iVersion == 2 ? &shim_methods_v2 : &shim_methods_v1;
+        }
+    }
+
+    struct vfs_shim_callbacks
+    {
+        static vfs_shim& shim_of(sqlite3_vfs* vfs) noexcept
+        {
+            return *static_cast<vfs_shim*>(vfs->pAppData);
+        }
+
+        static sqlite3_vfs* base_of(sqlite3_vfs* vfs) noexcept
+        {
+            return shim_of(vfs).m_base;
+        }
+
+        static int open(sqlite3_vfs* vfs, const char* name, sqlite3_file* file, int flags, int* out_flags)
+        {
+            shim_handle& handle = *static_cast<shim_handle*>(file);
+            handle.pMethods = nullptr;
+            handle.file = nullptr;
+
+            sqlite3_file* base_file = base_file_of(file);
+            base_file->pMethods = nullptr;
+            sqlite3_vfs* base = base_of(vfs);
+            const int errorcode = base->xOpen(base, name, base_file, flags, out_flags);
+            if (errorcode != SQLITE_OK) {
+                if (base_file->pMethods != nullptr) {
+                    base_file->pMethods->xClose(base_file);
+                }
+                return errorcode;
+            }
+
+            const int wrapped = guard_vfs_call([&]() {
+                handle.file = shim_of(vfs).wrap(base_file, name, flags).release();
+                return handle.file != nullptr ? SQLITE_OK : SQLITE_CANTOPEN;
+            });
+            if (wrapped != SQLITE_OK) {
+                base_file->pMethods->xClose(base_file);
+                return wrapped;
+            }
+            handle.pMethods = shim_methods_for(base_file->pMethods);
+            return SQLITE_OK;
+        }
+
+        static int remove(sqlite3_vfs* vfs, const char* name, int sync_directory)
+        {
+            return guard_vfs_call([&]() { return shim_of(vfs).remove(name, sync_directory); });
+        }
+
+        static int access(sqlite3_vfs* vfs, const char* name, int flags, int* result)
+        {
+            return guard_vfs_call([&]() { return shim_of(vfs).access(name, flags, result); });
+        }
+
+        static int full_pathname(sqlite3_vfs* vfs, const char* name, int size, char* output)
+        {
+            return base_of(vfs)->xFullPathname(base_of(vfs), name, size, output);
+        }
+
+        static void* dl_open(sqlite3_vfs* vfs, const char* filename)
+        {
+            return base_of(vfs)->xDlOpen(base_of(vfs), filename);
+        }
+
+        static void dl_error(sqlite3_vfs* vfs, int size, char* message)
+        {
+            base_of(vfs)->xDlError(base_of(vfs), size, message);
+        }
+
+        static void (*dl_sym(sqlite3_vfs* vfs, void* library, const char* symbol))(void)
+        {
+            return base_of(vfs)->xDlSym(base_of(vfs), library, symbol);
+        }
+
+        static void dl_close(sqlite3_vfs* vfs, void* library)
+        {
+            base_of(vfs)->xDlClose(base_of(vfs), library);
+        }
+
+        static int randomness(sqlite3_vfs* vfs, int size, char* output)
+        {
+            return base_of(vfs)->xRandomness(base_of(vfs), size, output);
+        }
+
+        static int sleep(sqlite3_vfs* vfs, int microseconds)
+        {
+            return base_of(vfs)->xSleep(base_of(vfs), microseconds);
+        }
+
+        static int current_time(sqlite3_vfs* vfs, double* now)
+        {
+            return base_of(vfs)->xCurrentTime(base_of(vfs), now);
+        }
+
+        static int get_last_error(sqlite3_vfs* vfs, int size, char* message)
+        {
+            return base_of(vfs)->xGetLastError(base_of(vfs), size, message);
+        }
+
+        static int current_time_int64(sqlite3_vfs* vfs, sqlite3_int64* now)
+        {
+            return base_of(vfs)->xCurrentTimeInt64(base_of(vfs), now);
+        }
+
+        static int set_system_call(sqlite3_vfs* vfs, const char* name, sqlite3_syscall_ptr call)
+        {
+            return base_of(vfs)->xSetSystemCall(base_of(vfs), name, call);
+        }
+
+        static sqlite3_syscall_ptr get_system_call(sqlite3_vfs* vfs, const char* name)
+        {
+            return base_of(vfs)->xGetSystemCall(base_of(vfs), name);
+        }
+
+        static const char* next_system_call(sqlite3_vfs* vfs, const char* name)
+        {
+            return base_of(vfs)->xNextSystemCall(base_of(vfs), name);
+        }
+    };
+
+    vfs_shim::vfs_shim(std::string name, const std::string& base) :
+        m_name(std::move(name)),
+        m_base(sqlite3_vfs_find(base.empty() ? nullptr : base.c_str())),
+        m_vfs()
+    {
+        if (m_base == nullptr) {
+            throw SQLiteXXException(base.empty() ? "There is no default VFS" : "There is no VFS named " + base);
+        }
+        if (sqlite3_vfs_find(m_name.c_str()) != nullptr) {
+            throw SQLiteXXException("A VFS named " + m_name + " is already registered");
+        }
+
+        m_vfs.iVersion = std::min(m_base->iVersion, 3);
+        m_vfs.szOsFile = static_cast<int>(base_offset) + m_base->szOsFile;
+        m_vfs.mxPathname = m_base->mxPathname;
+        m_vfs.zName = m_name.c_str();
+        m_vfs.pAppData = this;
+        m_vfs.xOpen = &vfs_shim_callbacks::open;
+        m_vfs.xDelete = &vfs_shim_callbacks::remove;
+        m_vfs.xAccess = &vfs_shim_callbacks::access;
+        m_vfs.xFullPathname = &vfs_shim_callbacks::full_pathname;
+        m_vfs.xDlOpen = &vfs_shim_callbacks::dl_open;
+        m_vfs.xDlError = &vfs_shim_callbacks::dl_error;
+        m_vfs.xDlSym = &vfs_shim_callbacks::dl_sym;
+        m_vfs.xDlClose = &vfs_shim_callbacks::dl_close;
+        m_vfs.xRandomness = &vfs_shim_callbacks::randomness;
+        m_vfs.xSleep = &vfs_shim_callbacks::sleep;
+        m_vfs.xCurrentTime = &vfs_shim_callbacks::current_time;
+        m_vfs.xGetLastError = &vfs_shim_callbacks::get_last_error;
+        if (m_vfs.iVersion >= 2) {
+            m_vfs.xCurrentTimeInt64 = &vfs_shim_callbacks::current_time_int64;
+        }
+        if (m_vfs.iVersion >= 3) {
+            m_vfs.xSetSystemCall = &vfs_shim_callbacks::set_system_call;
+            m_vfs.xGetSystemCall = &vfs_shim_callbacks::get_system_call;
+            m_vfs.xNextSystemCall = &vfs_shim_callbacks::next_system_call;
+        }
+
+        throw_error_code(sqlite3_vfs_register(&m_vfs, 0), "Unable to register the VFS " + m_name);
+    }
+
+    vfs_shim::~vfs_shim()
+    {
+        sqlite3_vfs_unregister(&m_vfs);
+    }
+
+    const std::string& vfs_shim::name() const noexcept
+    {
+        return m_name;
+    }
+
+    sqlite3_vfs* vfs_shim::base() const noexcept
+    {
+        return m_base;
+    }
+
+    std::unique_ptr<vfs_file> vfs_shim::wrap(sqlite3_file* file, const char*, const int flags)
+    {
+        return std::unique_ptr<vfs_file>(new vfs_file(file, file_kind_of(flags)));
+    }
+
+    int vfs_shim::remove(const char* name, const int sync_directory)
+    {
+        return m_base->xDelete(m_base, name, sync_directory);
+    }
+
+    int vfs_shim::access(const char* name, const int flags, int* result)
+    {
+        return m_base->xAccess(m_base, name, flags, result);
+    }
+}
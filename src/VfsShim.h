@@ -0,0 +1,158 @@
+/** @file */
+
+#ifndef __SQLITEXX_SQLITE_VFSSHIM_H__
+#define __SQLITEXX_SQLITE_VFSSHIM_H__
+
+#include <sqlite3.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace sqlite
+{
+    /** The kind of a file SQLite opens, taken from its open flags.
+     */
+    enum class file_kind: int {
+        main_database = 0, ///< a main or attached database
+        journal       = 1, ///< a rollback journal or super-journal
+        wal           = 2, ///< a write-ahead log
+        temporary     = 3, ///< a temporary database or journal, a statement journal or a transient database
+    };
+
+    /** Returns the kind of file SQLite opens with the flags given to xOpen.
+     * @param[in] flags the SQLITE_OPEN_* flags
+     */
+    file_kind file_kind_of(int flags) noexcept;
+
+    /**
+     * A file opened through a sqlite::vfs_shim, wrapping the file the underlying VFS opened.
+     * Every method forwards to the underlying file, a subclass overrides the ones it changes.
+     * The methods return SQLite result codes like the sqlite3_io_methods they implement.
+     * An exception escaping a method is turned into the error code of a sqlite::exception,
+     * SQLITE_IOERR_NOMEM for std::bad_alloc and SQLITE_IOERR for anything else.
+     */
+    class vfs_file
+    {
+        public:
+
+        /** Wraps a file of the underlying VFS.
+         * @param[in] base the open file of the underlying VFS, closed by close()
+         * @param[in] kind the kind of the file
+         */
+        vfs_file(sqlite3_file* base, file_kind kind) noexcept;
+
+        virtual ~vfs_file();
+
+        vfs_file(const vfs_file&) = delete;
+        vfs_file& operator=(const vfs_file&) = delete;
+
+        /** Returns the kind of the file.
+         */
+        file_kind kind() const noexcept;
+
+        /** Closes the underlying file, the object is destroyed afterwards. */
+        virtual int close();
+        virtual int read(void* buffer, int amount, int64_t offset);
+        virtual int write(const void* buffer, int amount, int64_t offset);
+        virtual int truncate(int64_t size);
+        virtual int sync(int flags);
+        virtual int file_size(int64_t* size);
+        virtual int lock(int level);
+        virtual int unlock(int level);
+        virtual int check_reserved_lock(int* result);
+        virtual int file_control(int operation, void* argument);
+        virtual int sector_size();
+        virtual int device_characteristics();
+
+        /** Only called if the underlying file supports the WAL shared memory. */
+        virtual int shm_map(int region, int size, int extend, void volatile** address);
+        virtual int shm_lock(int offset, int count, int flags);
+        virtual void shm_barrier();
+        virtual int shm_unmap(int delete_flag);
+
+        /** Only called if the underlying file supports memory-mapped I/O.
+         * A subclass that changes the bytes read has to override fetch to set *pointer to nullptr.
+         */
+        virtual int fetch(int64_t offset, int amount, void** pointer);
+        virtual int unfetch(int64_t offset, void* pointer);
+
+        protected:
+
+        /** Returns the file of the underlying VFS. */
+        sqlite3_file* base() const noexcept;
+
+        private:
+        sqlite3_file* m_base;
+        file_kind m_kind;
+    };
+
+    /**
+     * Base class for a VFS layered over another VFS, the default one unless a name is given.
+     * The shim registers itself under its name on construction and unregisters on destruction,
+     * and connections use it by passing the name to the dbconnection constructor or dbconnection::open.
+     * Every opened file is handed to wrap(), which returns the sqlite::vfs_file SQLite calls from then on.
+     * Everything else forwards to the underlying VFS.
+     * The shim must outlive every connection using it and can be neither copied nor moved.
+     */
+    class vfs_shim
+    {
+        public:
+
+        /** Registers the shim.
+         * @param[in] name the name of the shim
+         * @param[in] base the name of the underlying VFS, the default VFS when empty
+         * @throws SQLiteXXException if the underlying VFS does not exist or the name is taken
+         * @throws sqlite::exception if the VFS could not be registered
+         */
+        explicit vfs_shim(std::string name, const std::string& base = std::string());
+
+        virtual ~vfs_shim();
+
+        vfs_shim(const vfs_shim&) = delete;
+        vfs_shim& operator=(const vfs_shim&) = delete;
+
+        /** Returns the name the shim is registered under.
+         */
+        const std::string& name() const noexcept;
+
+        /** Returns the underlying VFS.
+         */
+        sqlite3_vfs* base() const noexcept;
+
+        protected:
+
+        /** Wraps a file the underlying VFS just opened. The default wraps it in a plain sqlite::vfs_file.
+         * If this throws, the underlying file is closed and the open fails.
+         * @param[in] file  the open file of the underlying VFS
+         * @param[in] name  the name of the file, nullptr for temporary files
+         * @param[in] flags the SQLITE_OPEN_* flags
+         * @returns the file SQLite uses
+         */
+        virtual std::unique_ptr<vfs_file> wrap(sqlite3_file* file, const char* name, int flags);
+
+        /** Deletes a file, forwarded to the underlying VFS by default.
+         * @param[in] name           the name of the file
+         * @param[in] sync_directory true if the directory has to be synced afterwards
+         * @returns a SQLite result code
+         */
+        virtual int remove(const char* name, int sync_directory);
+
+        /** Tells if a file exists or can be accessed, forwarded to the underlying VFS by default.
+         * @param[in]  name   the name of the file
+         * @param[in]  flags  one of the SQLITE_ACCESS_* values
+         * @param[out] result set to non-zero if the file is accessible
+         * @returns a SQLite result code
+         */
+        virtual int access(const char* name, int flags, int* result);
+
+        private:
+        friend struct vfs_shim_callbacks;
+
+        std::string m_name;
+        sqlite3_vfs* m_base;
+        sqlite3_vfs m_vfs;
+    };
+}
+
+#endif
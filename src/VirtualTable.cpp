@@ -0,0 +1,111 @@
+#include "VirtualTable.h"
+
+namespace sqlite
+{
+    index_info::index_info(sqlite3_index_info* info) noexcept :
+        m_info(info)
+    {}
+
+    int index_info::constraint_count() const noexcept
+    {
+        return m_info->nConstraint;
+    }
+
+    index_info::constraint index_info::get_constraint(const int index) const noexcept
+    {
+        const sqlite3_index_info::sqlite3_index_constraint& term = m_info->aConstraint[index];
+        return constraint{term.iColumn, static_cast<constraint_op>(term.op), term.usable != 0};
+    }
+
+    std::string_view index_info::collation(const int index) const noexcept
+    {
+#if SQLITE_VERSION_NUMBER >= 3022000
+        const char* name = sqlite3_vtab_collation(m_info, index);
+        return name != nullptr ? std::string_view(name) : std::string_view("BINARY");
+#else
+        (void)index;
+        return "BINARY";
+#endif
+    }
+
+    void index_info::use_constraint(const int index, const int argument, const bool omit) noexcept
+    {
+        m_info->aConstraintUsage[index].argvIndex = argument + 1;
+        m_info->aConstraintUsage[index].omit = omit ? 1 : 0;
+    }
+
+    int index_info::order_by_count() const noexcept
+    {
+        return m_info->nOrderBy;
+    }
+
+    index_info::ordering index_info::get_order_by(const int index) const noexcept
+    {
+        const sqlite3_index_info::sqlite3_index_orderby& term = m_info->aOrderBy[index];
+        return ordering{term.iColumn, term.desc != 0};
+    }
+
+    void index_info::set_order_by_consumed(const bool consumed) noexcept
+    {
+        m_info->orderByConsumed = consumed ? 1 : 0;
+    }
+
+    void index_info::set_estimated_cost(const double cost) noexcept
+    {
+        m_info->estimatedCost = cost;
+    }
+
+    void index_info::set_estimated_rows(const int64_t rows) noexcept
+    {
+#if SQLITE_VERSION_NUMBER >= 3008002
+        m_info->estimatedRows = rows;
+#else
+        (void)rows;
+#endif
+    }
+
+    void index_info::set_unique(const bool unique) noexcept
+    {
+#if SQLITE_VERSION_NUMBER >= 3009000
+        if (unique) {
+            m_info->idxFlags |= SQLITE_INDEX_SCAN_UNIQUE;
+        } else {
+            m_info->idxFlags &= ~SQLITE_INDEX_SCAN_UNIQUE;
+        }
+#else
+        (void)unique;
+#endif
+    }
+
+    void index_info::set_index_number(const int number) noexcept
+    {
+        m_info->idxNum = number;
+    }
+
+    void index_info::set_index_string(const std::string& text)
+    {
+        char* copy = sqlite3_mprintf("%s", text.c_str());
+        if (copy == nullptr) {
+            throw std::bad_alloc();
+        }
+        if (m_info->needToFreeIdxStr) {
+            sqlite3_free(m_info->idxStr);
+        }
+        m_info->idxStr = copy;
+        m_info->needToFreeIdxStr = 1;
+    }
+
+    uint64_t index_info::columns_used() const noexcept
+    {
+#if SQLITE_VERSION_NUMBER >= 3010000
+        return m_info->colUsed;
+#else
+        return ~static_cast<uint64_t>(0);
+#endif
+    }
+
+    sqlite3_index_info* index_info::handle() const noexcept
+    {
+        return m_info;
+    }
+}
@@ -0,0 +1,329 @@
+/** @file */
+
+#ifndef __SQLITEXX_SQLITE_VIRTUALTABLE_H__
+#define __SQLITEXX_SQLITE_VIRTUALTABLE_H__
+
+#include "Exception.h"
+#include "Value.h"
+
+#include <sqlite3.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace sqlite
+{
+    /** The comparison a WHERE clause constraint applies to a virtual table column. */
+    enum class constraint_op: int {
+        eq           = SQLITE_INDEX_CONSTRAINT_EQ,        ///< column = value
+        gt           = SQLITE_INDEX_CONSTRAINT_GT,        ///< column > value
+        le           = SQLITE_INDEX_CONSTRAINT_LE,        ///< column <= value
+        lt           = SQLITE_INDEX_CONSTRAINT_LT,        ///< column < value
+        ge           = SQLITE_INDEX_CONSTRAINT_GE,        ///< column >= value
+        match        = SQLITE_INDEX_CONSTRAINT_MATCH,     ///< column MATCH value
+#ifdef SQLITE_INDEX_CONSTRAINT_LIKE
+        like         = SQLITE_INDEX_CONSTRAINT_LIKE,      ///< column LIKE value
+        glob         = SQLITE_INDEX_CONSTRAINT_GLOB,      ///< column GLOB value
+        regexp       = SQLITE_INDEX_CONSTRAINT_REGEXP,    ///< column REGEXP value
+#endif
+#ifdef SQLITE_INDEX_CONSTRAINT_NE
+        ne           = SQLITE_INDEX_CONSTRAINT_NE,        ///< column != value
+        is_not       = SQLITE_INDEX_CONSTRAINT_ISNOT,     ///< column IS NOT value
+        is_not_null  = SQLITE_INDEX_CONSTRAINT_ISNOTNULL, ///< column IS NOT NULL
+        is_null      = SQLITE_INDEX_CONSTRAINT_ISNULL,    ///< column IS NULL
+        is           = SQLITE_INDEX_CONSTRAINT_IS,        ///< column IS value
+#endif
+    };
+
+    /** Wraps the sqlite3_index_info a virtual table receives when SQLite plans a query.
+     * The table reads the constraints and ORDER BY terms of the query, chooses which ones it handles,
+     * and describes its plan with an index number and string that are handed back to the cursor's filter().
+     */
+    class index_info
+    {
+        public:
+
+        /** A WHERE clause term on a column of the table. */
+        struct constraint {
+            /** The column, -1 for the rowid. */
+            int column;
+            /** The comparison. */
+            constraint_op op;
+            /** False if the value is not available for this plan, the table must not use the constraint then. */
+            bool usable;
+        };
+
+        /** An ORDER BY term on a column of the table. */
+        struct ordering {
+            /** The column, -1 for the rowid. */
+            int column;
+            /** True for DESC. */
+            bool descending;
+        };
+
+        explicit index_info(sqlite3_index_info* info) noexcept;
+
+        /** Returns the number of WHERE clause constraints. */
+        int constraint_count() const noexcept;
+
+        /** Returns a WHERE clause constraint.
+         * @param[in] index the index of the constraint, from 0 to constraint_count() - 1
+         */
+        constraint get_constraint(const int index) const noexcept;
+
+        /** Returns the name of the collation a constraint compares with, "BINARY" unless the query asks for another.
+         * @param[in] index the index of the constraint
+         */
+        std::string_view collation(const int index) const noexcept;
+
+        /** Passes the value of a constraint to the cursor's filter().
+         * @param[in] index    the index of the constraint
+         * @param[in] argument the position of the value in the arguments of filter(), starting from 0
+         * @param[in] omit     true if the table fully checks the constraint so SQLite does not have to check it again
+         */
+        void use_constraint(const int index, const int argument, const bool omit = true) noexcept;
+
+        /** Returns the number of ORDER BY terms. */
+        int order_by_count() const noexcept;
+
+        /** Returns an ORDER BY term.
+         * @param[in] index the index of the term, from 0 to order_by_count() - 1
+         */
+        ordering get_order_by(const int index) const noexcept;
+
+        /** Tells SQLite that the cursor returns the rows in the order of all ORDER BY terms so no sorting is needed.
+         * @param[in] consumed true if the rows come out sorted
+         */
+        void set_order_by_consumed(const bool consumed) noexcept;
+
+        /** Sets the estimated cost of the plan, roughly the number of disk accesses or row visits. */
+        void set_estimated_cost(const double cost) noexcept;
+
+        /** Sets the estimated number of rows the plan returns. */
+        void set_estimated_rows(const int64_t rows) noexcept;
+
+        /** Tells SQLite that the plan returns at most one row. */
+        void set_unique(const bool unique) noexcept;
+
+        /** Sets the index number handed to the cursor's filter(). */
+        void set_index_number(const int number) noexcept;
+
+        /** Sets the index string handed to the cursor's filter().
+         * @throws std::bad_alloc if the string could not be copied
+         */
+        void set_index_string(const std::string& text);
+
+        /** Returns a bit mask of the columns the query uses, the last bit stands for all columns from 63 on. */
+        uint64_t columns_used() const noexcept;
+
+        /** Returns the underlying sqlite3_index_info. */
+        sqlite3_index_info* handle() const noexcept;
+
+        private:
+        sqlite3_index_info* m_info;
+    };
+
+    /** Creates a table of a module from the arguments of CREATE VIRTUAL TABLE ... USING module(arguments). */
+    template <typename VTab>
+    using module_factory = std::function<std::unique_ptr<VTab>(const std::vector<std::string>&)>;
+
+    /** The sqlite3_vtab SQLite hands to every callback of a table, owning the C++ table. */
+    template <typename VTab>
+    struct virtual_table_handle : public sqlite3_vtab {
+        explicit virtual_table_handle(std::unique_ptr<VTab>&& implementation) :
+            sqlite3_vtab(),
+            table(std::move(implementation))
+        {}
+
+        std::unique_ptr<VTab> table;
+    };
+
+    /** The sqlite3_vtab_cursor SQLite hands to every callback of a cursor, owning the C++ cursor. */
+    template <typename VTab>
+    struct virtual_cursor_handle : public sqlite3_vtab_cursor {
+        explicit virtual_cursor_handle(typename VTab::cursor&& implementation) :
+            sqlite3_vtab_cursor(),
+            cursor(std::move(implementation))
+        {}
+
+        typename VTab::cursor cursor;
+    };
+
+    inline void set_virtual_table_error(sqlite3_vtab* table, const char* message) noexcept {
+        sqlite3_free(table->zErrMsg);
+        table->zErrMsg = sqlite3_mprintf("%s", message);
+    }
+
+    /** Runs a callback of a virtual table and turns exceptions into an error code and message. */
+    template <typename F>
+    int guard_virtual_table_call(sqlite3_vtab* table, F&& function) noexcept {
+        try {
+            function();
+            return SQLITE_OK;
+        } catch (const std::bad_alloc&) {
+            return SQLITE_NOMEM;
+        } catch (const sqlite::exception& e) {
+            set_virtual_table_error(table, e.what());
+            return e.errcode;
+        } catch (const std::exception& e) {
+            set_virtual_table_error(table, e.what());
+            return SQLITE_ERROR;
+        } catch (...) {
+            return SQLITE_ERROR;
+        }
+    }
+
+    template <typename VTab>
+    int internal_vtab_connect(sqlite3* connection, void* aux, int argc, const char* const* argv, sqlite3_vtab** table, char** error) {
+        try {
+            const module_factory<VTab>& factory = *static_cast<const module_factory<VTab>*>(aux);
+            // The first three arguments are the module, database and table names.
+            const std::vector<std::string> arguments(argv + 3, argv + argc);
+            std::unique_ptr<VTab> implementation = factory(arguments);
+
+            const std::string schema = implementation->schema();
+            const int errorcode = sqlite3_declare_vtab(connection, schema.c_str());
+            if (errorcode != SQLITE_OK) {
+                *error = sqlite3_mprintf("%s", sqlite3_errmsg(connection));
+                return errorcode;
+            }
+
+            *table = new virtual_table_handle<VTab>(std::move(implementation));
+            return SQLITE_OK;
+        } catch (const std::bad_alloc&) {
+            return SQLITE_NOMEM;
+        } catch (const sqlite::exception& e) {
+            *error = sqlite3_mprintf("%s", e.what());
+            return e.errcode;
+        } catch (const std::exception& e) {
+            *error = sqlite3_mprintf("%s", e.what());
+            return SQLITE_ERROR;
+        } catch (...) {
+            return SQLITE_ERROR;
+        }
+    }
+
+    template <typename VTab>
+    int internal_vtab_disconnect(sqlite3_vtab* table) {
+        delete static_cast<virtual_table_handle<VTab>*>(table);
+        return SQLITE_OK;
+    }
+
+    template <typename VTab>
+    int internal_vtab_best_index(sqlite3_vtab* table, sqlite3_index_info* info) {
+        const VTab& implementation = *static_cast<virtual_table_handle<VTab>*>(table)->table;
+        return guard_virtual_table_call(table, [&]() {
+            index_info plan(info);
+            implementation.best_index(plan);
+        });
+    }
+
+    template <typename VTab>
+    int internal_vtab_open(sqlite3_vtab* table, sqlite3_vtab_cursor** cursor) {
+        VTab& implementation = *static_cast<virtual_table_handle<VTab>*>(table)->table;
+        return guard_virtual_table_call(table, [&]() {
+            *cursor = new virtual_cursor_handle<VTab>(implementation.open());
+        });
+    }
+
+    template <typename VTab>
+    int internal_vtab_close(sqlite3_vtab_cursor* cursor) {
+        delete static_cast<virtual_cursor_handle<VTab>*>(cursor);
+        return SQLITE_OK;
+    }
+
+    template <typename VTab>
+    int internal_vtab_filter(sqlite3_vtab_cursor* cursor, int index_number, const char* index_string, int argc, sqlite3_value** argv) {
+        typename VTab::cursor& implementation = static_cast<virtual_cursor_handle<VTab>*>(cursor)->cursor;
+        return guard_virtual_table_call(cursor->pVtab, [&]() {
+            implementation.filter(
+                index_number,
+                std::string_view(index_string != nullptr ? index_string : ""),
+                value_span(argv, static_cast<std::size_t>(argc)));
+        });
+    }
+
+    template <typename VTab>
+    int internal_vtab_next(sqlite3_vtab_cursor* cursor) {
+        typename VTab::cursor& implementation = static_cast<virtual_cursor_handle<VTab>*>(cursor)->cursor;
+        return guard_virtual_table_call(cursor->pVtab, [&]() {
+            implementation.next();
+        });
+    }
+
+    template <typename VTab>
+    int internal_vtab_eof(sqlite3_vtab_cursor* cursor) {
+        return static_cast<virtual_cursor_handle<VTab>*>(cursor)->cursor.eof() ? 1 : 0;
+    }
+
+    template <typename VTab>
+    int internal_vtab_column(sqlite3_vtab_cursor* cursor, sqlite3_context* context, int column) {
+        const typename VTab::cursor& implementation = static_cast<virtual_cursor_handle<VTab>*>(cursor)->cursor;
+        return guard_virtual_table_call(cursor->pVtab, [&]() {
+            implementation.column(context, column);
+        });
+    }
+
+    template <typename VTab>
+    int internal_vtab_rowid(sqlite3_vtab_cursor* cursor, sqlite3_int64* rowid) {
+        const typename VTab::cursor& implementation = static_cast<virtual_cursor_handle<VTab>*>(cursor)->cursor;
+        return guard_virtual_table_call(cursor->pVtab, [&]() {
+            *rowid = implementation.rowid();
+        });
+    }
+
+    /** True when VTab declares a static constexpr bool eponymous member set to true.
+     * Eponymous-only tables exist in every schema under the name of their module and
+     * can not be created with CREATE VIRTUAL TABLE, which is how table-valued functions work.
+     */
+    template <typename VTab, typename Enable = void>
+    struct is_eponymous : std::false_type {};
+
+    template <typename VTab>
+    struct is_eponymous<VTab, std::void_t<decltype(VTab::eponymous)>> : std::integral_constant<bool, VTab::eponymous> {};
+
+    /** Returns the read-only sqlite3_module whose callbacks forward to VTab.
+     * VTab has to provide:
+     * - std::string schema() const, the CREATE TABLE statement declaring the columns
+     * - void best_index(index_info&) const, choosing a plan for a query
+     * - cursor open(), returning a movable cursor for a new scan
+     *
+     * and its cursor type:
+     * - void filter(int index_number, std::string_view index_string, value_span arguments), starting a scan
+     * - void next(), bool eof() const
+     * - void column(sqlite3_context*, int column) const, setting the result with sqlite::return_result or sqlite3_result_*
+     * - int64_t rowid() const
+     *
+     * A VTab with a static constexpr bool eponymous member set to true is registered as an eponymous-only table.
+     */
+    template <typename VTab>
+    const sqlite3_module* virtual_table_module() {
+        static const sqlite3_module module = []() {
+            sqlite3_module callbacks = {};
+            callbacks.iVersion = 1;
+            // Without xCreate SQLite only provides the eponymous table.
+            callbacks.xCreate = is_eponymous<VTab>::value ? nullptr : &internal_vtab_connect<VTab>;
+            callbacks.xConnect = &internal_vtab_connect<VTab>;
+            callbacks.xBestIndex = &internal_vtab_best_index<VTab>;
+            callbacks.xDisconnect = &internal_vtab_disconnect<VTab>;
+            callbacks.xDestroy = &internal_vtab_disconnect<VTab>;
+            callbacks.xOpen = &internal_vtab_open<VTab>;
+            callbacks.xClose = &internal_vtab_close<VTab>;
+            callbacks.xFilter = &internal_vtab_filter<VTab>;
+            callbacks.xNext = &internal_vtab_next<VTab>;
+            callbacks.xEof = &internal_vtab_eof<VTab>;
+            callbacks.xColumn = &internal_vtab_column<VTab>;
+            callbacks.xRowid = &internal_vtab_rowid<VTab>;
+            return callbacks;
+        }();
+        return &module;
+    }
+}
+
+#endif
@@ -0,0 +1,351 @@
+#include "WriteBehindVfs.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+namespace sqlite
+{
+    namespace
+    {
+        // A WAL file starts with a 32 byte header, every frame with a 24 byte header that SQLite writes on its own.
+        const int64_t wal_header_size = 32;
+        const int wal_frame_header_size = 24;
+    }
+
+    class write_behind_vfs::file : public vfs_file
+    {
+        public:
+        file(sqlite3_file* base, const file_kind kind, write_behind_vfs& vfs, std::string name, channel* target) noexcept :
+            vfs_file(base, kind),
+            m_vfs(vfs),
+            m_name(std::move(name)),
+            m_channel(target),
+            m_commit_page(-1)
+        {}
+
+        int close() override
+        {
+            if (m_channel == nullptr) {
+                return vfs_file::close();
+            }
+            m_vfs.drain();
+            const int errorcode = vfs_file::close();
+            m_vfs.detach(m_name);
+            return errorcode;
+        }
+
+        int read(void* buffer, const int amount, const int64_t offset) override
+        {
+            if (m_channel != nullptr) {
+                m_vfs.drain();
+                const int errorcode = m_vfs.take_error(*m_channel);
+                if (errorcode != SQLITE_OK) {
+                    return errorcode;
+                }
+            }
+            return vfs_file::read(buffer, amount, offset);
+        }
+
+        int write(const void* buffer, const int amount, const int64_t offset) override
+        {
+            if (m_channel == nullptr) {
+                // The journal has to be on its way to the disk before the database it protects is overwritten.
+                if (kind() == file_kind::main_database) {
+                    m_vfs.drain();
+                    const int errorcode = m_vfs.take_error(m_name);
+                    if (errorcode != SQLITE_OK) {
+                        return errorcode;
+                    }
+                }
+                return vfs_file::write(buffer, amount, offset);
+            }
+
+            bool commit = false;
+            if (kind() == file_kind::wal) {
+                if (amount == wal_frame_header_size && offset >= wal_header_size) {
+                    // Bytes 4 to 7 of a frame header hold the size of the database after a commit, 0 for other frames.
+                    const unsigned char* header = static_cast<const unsigned char*>(buffer);
+                    if ((header[4] | header[5] | header[6] | header[7]) != 0) {
+                        m_commit_page = offset + amount;
+                    }
+                } else if (offset == m_commit_page) {
+                    m_commit_page = -1;
+                    commit = true;
+                }
+            }
+
+            std::unique_ptr<char[]> data(new char[static_cast<std::size_t>(amount)]);
+            std::memcpy(data.get(), buffer, static_cast<std::size_t>(amount));
+            m_vfs.enqueue(operation{m_channel, base(), std::move(data), amount, offset, 0, nullptr});
+            if (commit) {
+                // Readers see the transaction once SQLite publishes the WAL index header after this write,
+                // which might not be followed by a sync that would report a failed write.
+                m_vfs.drain();
+                return m_vfs.take_error(*m_channel);
+            }
+            return SQLITE_OK;
+        }
+
+        int truncate(const int64_t size) override
+        {
+            if (m_channel != nullptr) {
+                m_vfs.drain();
+                const int errorcode = m_vfs.take_error(*m_channel);
+                if (errorcode != SQLITE_OK) {
+                    return errorcode;
+                }
+            }
+            return vfs_file::truncate(size);
+        }
+
+        int sync(const int flags) override
+        {
+            if (m_channel == nullptr) {
+                return vfs_file::sync(flags);
+            }
+            int result = SQLITE_OK;
+            m_vfs.wait_for(m_vfs.enqueue(operation{m_channel, base(), nullptr, 0, 0, flags, &result}));
+            return result;
+        }
+
+        int file_size(int64_t* size) override
+        {
+            if (m_channel != nullptr) {
+                m_vfs.drain();
+            }
+            return vfs_file::file_size(size);
+        }
+
+        int unlock(const int level) override
+        {
+            m_vfs.drain();
+            return vfs_file::unlock(level);
+        }
+
+        // A WAL writer publishes new frames with a barrier between the two copies of the WAL index header,
+        // and ends the transaction by releasing the WAL write lock.
+        void shm_barrier() override
+        {
+            m_vfs.drain();
+            vfs_file::shm_barrier();
+        }
+
+        int shm_lock(const int offset, const int count, const int flags) override
+        {
+            if (flags & SQLITE_SHM_UNLOCK) {
+                m_vfs.drain();
+            }
+            return vfs_file::shm_lock(offset, count, flags);
+        }
+
+        private:
+        write_behind_vfs& m_vfs;
+        // The name of the channel of a journal or WAL, or of the rollback journal of a main database.
+        const std::string m_name;
+        channel* m_channel;
+        // The offset of the page of the last commit frame written to a WAL, -1 if there is none.
+        int64_t m_commit_page;
+    };
+
+    write_behind_vfs::write_behind_vfs(std::string name, const std::string& base) :
+        vfs_shim(std::move(name), base)
+    {
+        m_thread = std::thread(&write_behind_vfs::run, this);
+    }
+
+    write_behind_vfs::~write_behind_vfs()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_work.notify_one();
+        m_thread.join();
+    }
+
+    write_behind_stats write_behind_vfs::stats() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_stats;
+    }
+
+    std::unique_ptr<vfs_file> write_behind_vfs::wrap(sqlite3_file* base, const char* name, const int flags)
+    {
+        const file_kind kind = file_kind_of(flags);
+        if ((kind == file_kind::journal || kind == file_kind::wal) && name != nullptr) {
+            channel* target = attach(name);
+            try {
+                return std::unique_ptr<vfs_file>(new file(base, kind, *this, name, target));
+            } catch (...) {
+                detach(name);
+                throw;
+            }
+        }
+        const std::string journal = kind == file_kind::main_database && name != nullptr ? std::string(name) + "-journal" : std::string();
+        return std::unique_ptr<vfs_file>(new file(base, kind, *this, journal, nullptr));
+    }
+
+    int write_behind_vfs::remove(const char* name, const int sync_directory)
+    {
+        drain();
+        return vfs_shim::remove(name, sync_directory);
+    }
+
+    uint64_t write_behind_vfs::enqueue(operation&& queued)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queued_bytes += static_cast<std::size_t>(queued.amount);
+        // Writes pile up until a sync, a drain or a full batch wakes the I/O thread, saving a wake-up per page.
+        if (queued.sync_result != nullptr || m_queued_bytes >= write_batch_bytes) {
+            m_wake = true;
+            m_work.notify_one();
+        }
+        if (queued.sync_result != nullptr) {
+            ++m_stats.sync_requests;
+        }
+        m_queue.push_back(std::move(queued));
+        return ++m_submitted;
+    }
+
+    void write_behind_vfs::wait_for(const uint64_t ticket)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_completed < ticket) {
+            m_wake = true;
+            m_work.notify_one();
+            m_done.wait(lock, [&]() { return m_completed >= ticket; });
+        }
+    }
+
+    void write_behind_vfs::drain()
+    {
+        uint64_t ticket = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ticket = m_submitted;
+        }
+        wait_for(ticket);
+    }
+
+    int write_behind_vfs::take_error(channel& target)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return std::exchange(target.error, SQLITE_OK);
+    }
+
+    int write_behind_vfs::take_error(const std::string& name)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const auto found = m_channels.find(name);
+        return found != m_channels.end() ? std::exchange(found->second.error, SQLITE_OK) : SQLITE_OK;
+    }
+
+    write_behind_vfs::channel* write_behind_vfs::attach(const std::string& name)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        channel& target = m_channels[name];
+        ++target.handles;
+        return &target;
+    }
+
+    void write_behind_vfs::detach(const std::string& name)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const auto found = m_channels.find(name);
+        if (found != m_channels.end() && --found->second.handles == 0) {
+            m_channels.erase(found);
+        }
+    }
+
+    namespace
+    {
+        // The strongest of two SQLITE_SYNC_* flag sets, DATAONLY only if both allow it.
+        int stronger_sync(const int current, const int requested) noexcept
+        {
+            if (current < 0) {
+                return requested;
+            }
+            const int level = std::max(current & 0x0F, requested & 0x0F);
+            return level | (current & requested & SQLITE_SYNC_DATAONLY);
+        }
+    }
+
+    void write_behind_vfs::run()
+    {
+        struct pending_sync
+        {
+            sqlite3_file* file = nullptr;
+            int flags = -1;
+            int error = SQLITE_OK;
+            std::vector<int*> results;
+        };
+
+        std::deque<operation> batch;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_work.wait(lock, [&]() { return m_stopping || (m_wake && !m_queue.empty()); });
+                if (m_queue.empty()) {
+                    return;
+                }
+                batch.swap(m_queue);
+                m_queued_bytes = 0;
+                m_wake = false;
+            }
+
+            // Writes keep their order, every sync requested in the batch follows all of them.
+            std::map<channel*, int> errors;
+            std::map<channel*, pending_sync> syncs;
+            uint64_t writes = 0;
+            for (operation& queued : batch) {
+                if (queued.sync_result == nullptr) {
+                    const int errorcode = queued.file->pMethods->xWrite(queued.file, queued.data.get(), queued.amount, queued.offset);
+                    ++writes;
+                    if (errorcode != SQLITE_OK) {
+                        errors.emplace(queued.target, errorcode);
+                    }
+                } else {
+                    pending_sync& pending = syncs[queued.target];
+                    pending.file = queued.file;
+                    pending.flags = stronger_sync(pending.flags, queued.sync_flags);
+                    pending.results.push_back(queued.sync_result);
+                }
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                for (const auto& error : errors) {
+                    if (error.first->error == SQLITE_OK) {
+                        error.first->error = error.second;
+                    }
+                }
+                for (auto& pending : syncs) {
+                    pending.second.error = std::exchange(pending.first->error, SQLITE_OK);
+                }
+            }
+
+            uint64_t issued = 0;
+            for (auto& pending : syncs) {
+                int errorcode = pending.second.error;
+                if (errorcode == SQLITE_OK) {
+                    errorcode = pending.second.file->pMethods->xSync(pending.second.file, pending.second.flags);
+                    ++issued;
+                }
+                for (int* result : pending.second.results) {
+                    *result = errorcode;
+                }
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_completed += batch.size();
+                m_stats.writes += writes;
+                m_stats.syncs += issued;
+            }
+            m_done.notify_all();
+            batch.clear();
+        }
+    }
+}
@@ -0,0 +1,115 @@
+/** @file */
+
+#ifndef __SQLITEXX_SQLITE_WRITEBEHINDVFS_H__
+#define __SQLITEXX_SQLITE_WRITEBEHINDVFS_H__
+
+#include "VfsShim.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace sqlite
+{
+    /** Counters of a sqlite::write_behind_vfs.
+     */
+    struct write_behind_stats
+    {
+        uint64_t writes = 0;        ///< journal and WAL writes done by the I/O thread
+        uint64_t sync_requests = 0; ///< xSync calls on journals and WAL files
+        uint64_t syncs = 0;         ///< syncs the I/O thread issued for them, fewer when requests were coalesced
+    };
+
+    /**
+     * A VFS layered over the default VFS that moves rollback journal and WAL writes to a dedicated I/O thread.
+     * A write is copied and queued, so the connection goes on building the transaction while the write runs.
+     * An xSync waits for the writes queued before it and for a sync of the file, and sync requests of handles of the
+     * same file that queue up while the I/O thread is busy are served by one sync. Commits to one file rarely share
+     * a sync, since SQLite's locks order them and each commit waits for its writes first. A commit still returns
+     * only after its sync, so the durability guarantees of the synchronous setting are unchanged.
+     * The queue is drained before a main database is written, before any file is read, truncated, measured,
+     * deleted or closed, and before a lock is released, so other connections and crashes of the process see
+     * the same files they would see without the VFS.
+     * A failed queued write is reported by the next sync, read or truncate of the file, by the next write of
+     * the database a rollback journal belongs to and by the last write of a WAL commit, so a commit that is not
+     * followed by a sync, as with synchronous=NORMAL in WAL mode, fails as well.
+     * The VFS must outlive the connections using it.
+     */
+    class write_behind_vfs : public vfs_shim
+    {
+        public:
+
+        /** Registers the VFS and starts its I/O thread.
+         * @param[in] name the name of the VFS
+         * @param[in] base the name of the underlying VFS, the default VFS when empty
+         * @throws SQLiteXXException if the underlying VFS does not exist or the name is taken
+         * @throws sqlite::exception if the VFS could not be registered
+         */
+        explicit write_behind_vfs(std::string name = "sqlitexx-write-behind", const std::string& base = std::string());
+
+        /** Stops the I/O thread after it finished the queued writes. */
+        ~write_behind_vfs() override;
+
+        /** Returns the counters since construction.
+         */
+        write_behind_stats stats() const;
+
+        protected:
+        std::unique_ptr<vfs_file> wrap(sqlite3_file* file, const char* name, int flags) override;
+
+        int remove(const char* name, int sync_directory) override;
+
+        private:
+        class file;
+
+        static constexpr std::size_t write_batch_bytes = 256 * 1024;
+
+        /** The journal or WAL file all handles opened under one name write to. */
+        struct channel
+        {
+            int handles = 0;
+            int error = SQLITE_OK;
+        };
+
+        struct operation
+        {
+            channel* target;
+            sqlite3_file* file;
+            std::unique_ptr<char[]> data;
+            int amount;
+            int64_t offset;
+            int sync_flags;
+            int* sync_result;
+        };
+
+        uint64_t enqueue(operation&& queued);
+        void wait_for(uint64_t ticket);
+        void drain();
+        int take_error(channel& target);
+        int take_error(const std::string& name);
+        channel* attach(const std::string& name);
+        void detach(const std::string& name);
+        void run();
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_work;
+        std::condition_variable m_done;
+        std::deque<operation> m_queue;
+        uint64_t m_submitted = 0;
+        uint64_t m_completed = 0;
+        std::size_t m_queued_bytes = 0;
+        bool m_wake = false;
+        bool m_stopping = false;
+        std::map<std::string, channel> m_channels;
+        write_behind_stats m_stats;
+        std::thread m_thread;
+    };
+}
+
+#endif
@@ -1,5 +1,10 @@
 #include "catch.hpp"
 #include <SQLiteXX.h>
+#include "TestHelpers.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
 
 TEST_CASE("Initialization with non empty database", "[Backup]") {
     sqlite::dbconnection src = sqlite::dbconnection::memory();
@@ -88,3 +93,104 @@ TEST_CASE("Backup process", "[Backup]") {
         REQUIRE(query.step() == false);
     }
 }
+
+TEST_CASE("Background backup", "[Backup]") {
+    sqlite::dbconnection src = sqlite::dbconnection::memory();
+    sqlite::execute(src, "CREATE TABLE test (id INTEGER PRIMARY KEY, value TEXT)");
+    sqlite::execute(src, "WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < 10000) "
+                         "INSERT INTO test (value) SELECT printf('%0100d', i) FROM n");
+    sqlite::dbconnection dest = sqlite::dbconnection::memory();
+
+    SECTION("Copies every page in steps and reports the progress") {
+        sqlite::backup_pacing pacing;
+        pacing.pages_per_step = 16;
+        pacing.pause = std::chrono::milliseconds(0);
+        int steps = 0;
+        int last_remaining = -1;
+        bool decreasing = true;
+        sqlite::background_backup backup(src, dest, pacing, [&](const int remaining, const int total) {
+            decreasing = decreasing && remaining < total && (last_remaining < 0 || remaining < last_remaining);
+            last_remaining = remaining;
+            ++steps;
+        });
+
+        REQUIRE(backup.wait());
+        REQUIRE(backup.finished());
+        REQUIRE(decreasing);
+        REQUIRE(last_remaining == 0);
+        REQUIRE(steps == (backup.total_page_count() + 15) / 16);
+        REQUIRE(backup.remaining_page_count() == 0);
+        REQUIRE(count_rows(dest) == 10000);
+    }
+
+    SECTION("Keeps to the rate limit") {
+        sqlite::backup_pacing pacing;
+        pacing.pages_per_step = 8;
+        pacing.pause = std::chrono::milliseconds(0);
+        pacing.max_megabytes_per_second = 5.0;
+
+        sqlite::statement page_size(src, "PRAGMA page_size");
+        page_size.step();
+
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        sqlite::background_backup backup(src, dest, pacing);
+        REQUIRE(backup.wait());
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        // The last step is not followed by a pause, and only a lower bound is checked with some slack for the clock.
+        const double megabytes = static_cast<double>(backup.total_page_count() - pacing.pages_per_step) * page_size.get_int(0) / 1e6;
+        REQUIRE(elapsed.count() >= 0.9 * megabytes / pacing.max_megabytes_per_second);
+        REQUIRE(count_rows(dest) == 10000);
+    }
+
+    SECTION("Lets the source be written between steps") {
+        // Changes to an in-memory source restart the backup, a file is updated in place.
+        remove("TestBackgroundBackupSource.db");
+        sqlite::dbconnection file("TestBackgroundBackupSource.db");
+        sqlite::save(src, "TestBackgroundBackupSource.db");
+
+        sqlite::backup_pacing pacing;
+        pacing.pages_per_step = 4;
+        pacing.pause = std::chrono::milliseconds(1);
+
+        // Written from the progress callback, so every write lands between two steps and none after the last one.
+        int written = 0;
+        sqlite::background_backup backup(file, dest, pacing, [&](const int remaining, int) {
+            if (remaining > 0) {
+                sqlite::execute(file, "INSERT INTO test (value) VALUES ('written during the backup')");
+                ++written;
+            }
+        });
+        REQUIRE(backup.wait());
+        REQUIRE(written > 0);
+        REQUIRE(count_rows(file) == 10000 + written);
+        REQUIRE(count_rows(dest) == count_rows(file));
+    }
+
+    SECTION("Cancel") {
+        sqlite::backup_pacing pacing;
+        pacing.pages_per_step = 1;
+        pacing.pause = std::chrono::seconds(10);
+        std::atomic<int> steps(0);
+        sqlite::background_backup backup(src, dest, pacing, [&](int, int) { ++steps; });
+
+        while (steps == 0) {
+            std::this_thread::yield();
+        }
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        backup.cancel();
+        REQUIRE_FALSE(backup.wait());
+        REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+        REQUIRE(backup.remaining_page_count() > 0);
+    }
+
+    SECTION("Failures are rethrown by wait") {
+        remove("TestBackgroundBackup.db");
+        sqlite::dbconnection create_database("TestBackgroundBackup.db");
+        sqlite::dbconnection read_only("TestBackgroundBackup.db", sqlite::openmode::read_only);
+
+        sqlite::background_backup backup(src, read_only);
+        REQUIRE_THROWS_AS(backup.wait(), sqlite::exception);
+        REQUIRE(backup.finished());
+    }
+}
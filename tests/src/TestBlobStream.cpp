@@ -0,0 +1,167 @@
+#include "catch.hpp"
+#include "SQLiteXX.h"
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+TEST_CASE("Blob stream chunked read and write", "[BlobStream]") {
+    sqlite::dbconnection connection = sqlite::dbconnection::memory();
+    REQUIRE(sqlite::execute(connection, "CREATE TABLE test (id INTEGER PRIMARY KEY, data BLOB)") == 0);
+    REQUIRE(sqlite::execute(connection, "INSERT INTO test VALUES (NULL, ?)", sqlite::zeroblob(10)) == 1);
+    const long long row = connection.row_id();
+
+    SECTION("Zeroblob preallocation") {
+        sqlite::blob_stream stream(connection, "test", "data", row);
+        REQUIRE(stream.size() == 10);
+
+        char buffer[10] = {1, 1, 1, 1, 1, 1, 1, 1, 1, 1};
+        stream.read(buffer, 10, 0);
+        for (int i = 0; i < 10; ++i) {
+            REQUIRE(buffer[i] == 0);
+        }
+    }
+
+    SECTION("Write then read back") {
+        sqlite::blob_stream stream(connection, "test", "data", row, true);
+        stream.write("hello", 5, 0);
+        stream.write("world", 5, 5);
+
+        char buffer[5];
+        stream.read(buffer, 5, 3);
+        REQUIRE(std::string(buffer, 5) == "lowor");
+
+        sqlite::statement query(connection, "SELECT data FROM test WHERE id = ?", static_cast<int>(row));
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_string(0) == "helloworld");
+    }
+
+    SECTION("Out of range access") {
+        sqlite::blob_stream stream(connection, "test", "data", row, true);
+        char buffer[11];
+        REQUIRE_THROWS_AS(stream.read(buffer, 11, 0), sqlite::exception);
+        REQUIRE_THROWS_AS(stream.write(buffer, 2, 9), sqlite::exception);
+    }
+
+    SECTION("Writing to a read-only blob") {
+        sqlite::blob_stream stream(connection, "test", "data", row);
+        REQUIRE_THROWS_AS(stream.write("a", 1, 0), sqlite::exception);
+    }
+
+    SECTION("Opening a row that does not exist") {
+        REQUIRE_THROWS_AS(sqlite::blob_stream(connection, "test", "data", row + 1), sqlite::exception);
+    }
+
+    SECTION("Expired blob") {
+        sqlite::blob_stream stream(connection, "test", "data", row, true);
+        REQUIRE(sqlite::execute(connection, "UPDATE test SET data = zeroblob(20) WHERE id = ?", static_cast<int>(row)) == 1);
+
+        char buffer[1];
+        REQUIRE_THROWS_AS(stream.read(buffer, 1, 0), sqlite::exception);
+    }
+}
+
+TEST_CASE("Blob stream reopen", "[BlobStream]") {
+    sqlite::dbconnection connection = sqlite::dbconnection::memory();
+    REQUIRE(sqlite::execute(connection, "CREATE TABLE test (id INTEGER PRIMARY KEY, data BLOB)") == 0);
+    REQUIRE(sqlite::execute(connection, "INSERT INTO test VALUES (1, ?)", std::string("one")) == 1);
+    REQUIRE(sqlite::execute(connection, "INSERT INTO test VALUES (2, ?)", std::string("second")) == 1);
+    REQUIRE(sqlite::execute(connection, "INSERT INTO test VALUES (3, ?)", std::string("third")) == 1);
+
+    sqlite::blob_stream stream(connection, "test", "data", 1);
+    std::vector<std::string> contents;
+    for (int row = 1; row <= 3; ++row) {
+        stream.reopen(row);
+        std::string value(stream.size(), '\0');
+        stream.read(&value[0], stream.size(), 0);
+        contents.push_back(value);
+    }
+
+    REQUIRE(contents == std::vector<std::string>({"one", "second", "third"}));
+    REQUIRE_THROWS_AS(stream.reopen(4), sqlite::exception);
+}
+
+TEST_CASE("Blob stream buffer", "[BlobStream]") {
+    sqlite::dbconnection connection = sqlite::dbconnection::memory();
+    REQUIRE(sqlite::execute(connection, "CREATE TABLE test (id INTEGER PRIMARY KEY, data BLOB)") == 0);
+
+    const int size = 100000;
+    REQUIRE(sqlite::execute(connection, "INSERT INTO test VALUES (1, ?)", sqlite::zeroblob(size)) == 1);
+    sqlite::blob_stream stream(connection, "test", "data", 1, true);
+
+    SECTION("Formatted output and input through small chunks") {
+        {
+            sqlite::blob_streambuf buffer(stream, 16);
+            std::ostream output(&buffer);
+            for (int i = 0; i < 1000; ++i) {
+                output << i << ' ';
+            }
+            REQUIRE(output.good());
+        }
+
+        sqlite::blob_streambuf buffer(stream, 16);
+        std::istream input(&buffer);
+        for (int i = 0; i < 1000; ++i) {
+            int value = -1;
+            input >> value;
+            REQUIRE(value == i);
+        }
+    }
+
+    SECTION("Large transfers bypass the buffer") {
+        std::string data(size, '\0');
+        for (int i = 0; i < size; ++i) {
+            data[i] = static_cast<char>('a' + i % 26);
+        }
+
+        sqlite::blob_streambuf buffer(stream, 1024);
+        std::iostream io(&buffer);
+        io.write(data.data(), size);
+        REQUIRE(io.good());
+
+        io.seekg(0);
+        std::string result(size, '\0');
+        io.read(&result[0], size);
+        REQUIRE(io.gcount() == size);
+        REQUIRE(result == data);
+    }
+
+    SECTION("Seeking and mixing reads and writes") {
+        sqlite::blob_streambuf buffer(stream, 8);
+        std::iostream io(&buffer);
+
+        io.seekp(50);
+        io << "marker";
+        io.seekg(-6, std::ios_base::cur);
+
+        char read[6];
+        io.read(read, 6);
+        REQUIRE(std::string(read, 6) == "marker");
+
+        io.seekg(0, std::ios_base::end);
+        REQUIRE(io.tellg() == size);
+        REQUIRE(io.get() == std::char_traits<char>::eof());
+    }
+
+    SECTION("Writing past the end fails") {
+        sqlite::blob_streambuf buffer(stream, 8);
+        std::ostream output(&buffer);
+        output.seekp(size - 2);
+        output << "abc";
+        output.flush();
+        REQUIRE(output.bad());
+    }
+
+    SECTION("Reopen through the stream buffer") {
+        REQUIRE(sqlite::execute(connection, "INSERT INTO test VALUES (2, ?)", std::string("row two")) == 1);
+
+        sqlite::blob_streambuf buffer(stream);
+        std::istream input(&buffer);
+        buffer.reopen(2);
+
+        std::string word;
+        input >> word;
+        REQUIRE(word == "row");
+    }
+}
@@ -0,0 +1,322 @@
+#include "catch.hpp"
+#include "SQLiteXX.h"
+#include "TestHelpers.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+static sqlite::dbconnection open_with(const std::string& filename, const sqlite::compressed_vfs& vfs) {
+    return sqlite::dbconnection(filename, sqlite::openmode::read_write | sqlite::openmode::create, std::chrono::seconds(5), vfs.name());
+}
+
+static void fill(sqlite::dbconnection& connection, const int rows) {
+    sqlite::execute(connection, "CREATE TABLE IF NOT EXISTS test (id INTEGER PRIMARY KEY, value TEXT)");
+    sqlite::deferred_transaction transaction(connection);
+    sqlite::execute(connection, "WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < ?) "
+                                "INSERT INTO test (value) SELECT printf('customer %d ordered %d items of product %d', i, i % 7, i % 13) FROM n", rows);
+    transaction.commit();
+}
+
+static std::string value_of(const sqlite::dbconnection& connection, const int id) {
+    sqlite::statement query(connection, "SELECT value FROM test WHERE id = ?", id);
+    query.step();
+    return query.get_string(0);
+}
+
+static std::vector<char> round_trip(const sqlite::page_codec& codec, const std::vector<char>& page) {
+    std::vector<char> packed(page.size());
+    const std::size_t size = codec.compress(page.data(), page.size(), packed.data(), page.size() - 1);
+    if (size == 0) {
+        return page;
+    }
+    std::vector<char> unpacked(page.size());
+    REQUIRE(codec.decompress(packed.data(), size, unpacked.data(), unpacked.size()));
+    return unpacked;
+}
+
+/** A codec storing pages as they are, which compresses nothing. */
+class copy_codec : public sqlite::page_codec {
+    public:
+    uint32_t id() const noexcept override {
+        return 42;
+    }
+
+    std::size_t compress(const char*, std::size_t, char*, std::size_t) const override {
+        return 0;
+    }
+
+    bool decompress(const char*, std::size_t, char*, std::size_t) const override {
+        return false;
+    }
+};
+
+TEST_CASE("The LZ codec", "[CompressedVfs]") {
+    sqlite::lz_codec codec;
+
+    SECTION("Restores pages of any content") {
+        std::mt19937 random(7);
+        std::vector<char> noise(4096);
+        for (char& byte : noise) {
+            byte = static_cast<char>(random());
+        }
+        std::vector<char> text(4096);
+        const std::string sentence = "the quick brown fox jumps over the lazy dog ";
+        for (std::size_t i = 0; i < text.size(); ++i) {
+            text[i] = sentence[i % sentence.size()];
+        }
+        std::vector<char> mixed = text;
+        for (std::size_t i = 0; i < mixed.size(); i += 97) {
+            mixed[i] = static_cast<char>(random());
+        }
+
+        REQUIRE(round_trip(codec, std::vector<char>(4096, 0)) == std::vector<char>(4096, 0));
+        REQUIRE(round_trip(codec, std::vector<char>(65536, 'x')) == std::vector<char>(65536, 'x'));
+        REQUIRE(round_trip(codec, text) == text);
+        REQUIRE(round_trip(codec, mixed) == mixed);
+        REQUIRE(round_trip(codec, std::vector<char>(7, 'a')) == std::vector<char>(7, 'a'));
+    }
+
+    SECTION("Compresses repetitive pages and gives up on noise") {
+        std::vector<char> packed(4096);
+        REQUIRE(codec.compress(std::vector<char>(4096, 0).data(), 4096, packed.data(), 4095) < 64);
+
+        std::mt19937 random(7);
+        std::vector<char> noise(4096);
+        for (char& byte : noise) {
+            byte = static_cast<char>(random());
+        }
+        REQUIRE(codec.compress(noise.data(), noise.size(), packed.data(), 4095) == 0);
+    }
+
+    SECTION("Rejects damaged input") {
+        std::vector<char> page(4096, 'a');
+        std::vector<char> packed(4096);
+        const std::size_t size = codec.compress(page.data(), page.size(), packed.data(), 4095);
+        std::vector<char> unpacked(4096);
+        REQUIRE_FALSE(codec.decompress(packed.data(), size - 1, unpacked.data(), unpacked.size()));
+        REQUIRE_FALSE(codec.decompress(packed.data(), size, unpacked.data(), unpacked.size() - 1));
+        packed[2] = 0x7F;
+        packed[3] = 0x7F;
+        REQUIRE_FALSE(codec.decompress(packed.data(), size, unpacked.data(), unpacked.size()));
+    }
+}
+
+TEST_CASE("Databases stored compressed", "[CompressedVfs]") {
+    const std::string filename = fresh_database("SQLiteXXCompressedVfs");
+    sqlite::compressed_vfs vfs("test-compressed", nullptr, 16);
+
+    {
+        sqlite::dbconnection connection = open_with(filename, vfs);
+        fill(connection, 5000);
+        REQUIRE(count_rows(connection) == 5000);
+    }
+
+    SECTION("Take less space than their pages") {
+        REQUIRE(std::filesystem::exists(filename + "-pagemap"));
+        sqlite::dbconnection connection = open_with(filename, vfs);
+        sqlite::statement pages(connection, "PRAGMA page_count");
+        pages.step();
+        sqlite::statement size(connection, "PRAGMA page_size");
+        size.step();
+        const auto logical = static_cast<std::uintmax_t>(pages.get_int(0)) * static_cast<std::uintmax_t>(size.get_int(0));
+        REQUIRE(std::filesystem::file_size(filename) < logical / 2);
+    }
+
+    SECTION("Are not readable without the VFS") {
+        sqlite::dbconnection plain(filename);
+        REQUIRE_THROWS_AS(count_rows(plain), sqlite::exception);
+    }
+
+    SECTION("Survive reopening with a new VFS") {
+        sqlite::compressed_vfs other("test-compressed-other");
+        sqlite::dbconnection connection = open_with(filename, other);
+        REQUIRE(count_rows(connection) == 5000);
+        REQUIRE(value_of(connection, 4321) == "customer 4321 ordered 2 items of product 5");
+        REQUIRE(integrity(connection) == "ok");
+    }
+
+    SECTION("Grow and shrink pages in place and at the end") {
+        sqlite::dbconnection connection = open_with(filename, vfs);
+        sqlite::execute(connection, "UPDATE test SET value = hex(randomblob(20)) WHERE id % 3 = 0");
+        sqlite::execute(connection, "DELETE FROM test WHERE id > 4000");
+        sqlite::execute(connection, "UPDATE test SET value = 'short' WHERE id % 5 = 0");
+        REQUIRE(integrity(connection) == "ok");
+        REQUIRE(count_rows(connection) == 4000);
+
+        sqlite::execute(connection, "VACUUM");
+        REQUIRE(integrity(connection) == "ok");
+        REQUIRE(value_of(connection, 10) == "short");
+    }
+
+    SECTION("Roll back") {
+        sqlite::dbconnection connection = open_with(filename, vfs);
+        sqlite::execute(connection, "PRAGMA cache_size = 2");
+        {
+            sqlite::deferred_transaction transaction(connection);
+            sqlite::execute(connection, "UPDATE test SET value = 'changed'");
+            sqlite::execute(connection, "DELETE FROM test WHERE id > 100");
+        }
+        REQUIRE(count_rows(connection) == 5000);
+        REQUIRE(value_of(connection, 7) == "customer 7 ordered 0 items of product 7");
+        REQUIRE(integrity(connection) == "ok");
+    }
+
+    SECTION("Are shared by the connections of a process") {
+        sqlite::dbconnection writer = open_with(filename, vfs);
+        sqlite::dbconnection reader = open_with(filename, vfs);
+        REQUIRE(count_rows(reader) == 5000);
+        fill(writer, 1000);
+        REQUIRE(count_rows(reader) == 6000);
+        REQUIRE(integrity(reader) == "ok");
+    }
+
+    SECTION("Are shared with other processes") {
+        // A second VFS keeps its own page map, like another process would.
+        sqlite::compressed_vfs other("test-compressed-process");
+        sqlite::dbconnection writer = open_with(filename, vfs);
+        sqlite::dbconnection reader = open_with(filename, other);
+        REQUIRE(count_rows(reader) == 5000);
+        fill(writer, 1000);
+        sqlite::execute(writer, "UPDATE test SET value = 'changed' WHERE id = 1");
+        REQUIRE(count_rows(reader) == 6000);
+        REQUIRE(value_of(reader, 1) == "changed");
+        REQUIRE(integrity(reader) == "ok");
+
+        fill(reader, 1000);
+        REQUIRE(count_rows(writer) == 7000);
+        REQUIRE(integrity(writer) == "ok");
+    }
+
+    SECTION("Work in WAL mode") {
+        sqlite::dbconnection connection = open_with(filename, vfs);
+        sqlite::statement(connection, "PRAGMA journal_mode = WAL").step();
+        fill(connection, 1000);
+        sqlite::statement(connection, "PRAGMA wal_checkpoint(TRUNCATE)").step();
+        fill(connection, 1000);
+
+        sqlite::dbconnection reader = open_with(filename, vfs);
+        REQUIRE(count_rows(reader) == 7000);
+        REQUIRE(integrity(reader) == "ok");
+    }
+
+    SECTION("Are written after a read-only connection opened them") {
+        sqlite::compressed_vfs other("test-compressed-read-only");
+        sqlite::dbconnection reader(filename, sqlite::openmode::read_only, std::chrono::seconds(5), other.name());
+        REQUIRE(count_rows(reader) == 5000);
+        sqlite::dbconnection writer = open_with(filename, other);
+        fill(writer, 1000);
+        REQUIRE(count_rows(reader) == 6000);
+        REQUIRE(integrity(writer) == "ok");
+    }
+
+    SECTION("Have their page map written before a commit ends, even without syncs") {
+        sqlite::dbconnection connection = open_with(filename, vfs);
+        sqlite::statement(connection, "PRAGMA locking_mode = EXCLUSIVE").step();
+        sqlite::execute(connection, "PRAGMA synchronous = OFF");
+        fill(connection, 1000);
+
+        // The connection keeps its lock, so the copies show what a crash would leave behind.
+        const std::string copy = fresh_database("SQLiteXXCompressedVfsCopy");
+        std::filesystem::copy_file(filename, copy);
+        std::filesystem::copy_file(filename + "-pagemap", copy + "-pagemap");
+        sqlite::compressed_vfs other("test-compressed-copied");
+        sqlite::dbconnection copied = open_with(copy, other);
+        REQUIRE(count_rows(copied) == 6000);
+        REQUIRE(integrity(copied) == "ok");
+    }
+
+    SECTION("Are recreated over a page map left behind") {
+        std::filesystem::remove(filename);
+        REQUIRE(std::filesystem::exists(filename + "-pagemap"));
+        sqlite::compressed_vfs other("test-compressed-recreated");
+        sqlite::dbconnection connection = open_with(filename, other);
+        fill(connection, 10);
+        REQUIRE(count_rows(connection) == 10);
+        REQUIRE(integrity(connection) == "ok");
+    }
+
+    SECTION("Are corrupt if cut short") {
+        std::filesystem::resize_file(filename, std::filesystem::file_size(filename) / 2);
+        sqlite::compressed_vfs other("test-compressed-truncated");
+        try {
+            open_with(filename, other);
+            FAIL("Opening a truncated database should fail");
+        } catch (const sqlite::exception& e) {
+            REQUIRE((e.errcode & 0xff) == SQLITE_CORRUPT);
+        }
+    }
+
+    SECTION("Are not read with another codec") {
+        sqlite::compressed_vfs other("test-compressed-copy", std::make_shared<copy_codec>());
+        REQUIRE_THROWS_AS(open_with(filename, other), sqlite::exception);
+    }
+}
+
+TEST_CASE("Empty databases opened read-only first", "[CompressedVfs]") {
+    const std::string filename = fresh_database("SQLiteXXCompressedVfsEmpty");
+    std::ofstream(filename).close();
+    {
+        sqlite::compressed_vfs vfs("test-compressed-empty");
+        sqlite::dbconnection reader(filename, sqlite::openmode::read_only, std::chrono::seconds(5), vfs.name());
+        sqlite::dbconnection writer = open_with(filename, vfs);
+        fill(writer, 1000);
+        REQUIRE(count_rows(reader) == 1000);
+    }
+
+    REQUIRE(std::filesystem::exists(filename + "-pagemap"));
+    sqlite::compressed_vfs other("test-compressed-empty-other");
+    sqlite::dbconnection connection = open_with(filename, other);
+    REQUIRE(count_rows(connection) == 1000);
+    REQUIRE(integrity(connection) == "ok");
+}
+
+TEST_CASE("Databases stored uncompressed", "[CompressedVfs]") {
+    sqlite::compressed_vfs vfs("test-compressed-plain", std::make_shared<copy_codec>(), 0);
+
+    SECTION("An existing database without a page map") {
+        const std::string filename = fresh_database("SQLiteXXCompressedVfsExisting");
+        {
+            sqlite::dbconnection plain(filename);
+            fill(plain, 100);
+        }
+        sqlite::dbconnection connection = open_with(filename, vfs);
+        fill(connection, 100);
+        REQUIRE_FALSE(std::filesystem::exists(filename + "-pagemap"));
+
+        sqlite::dbconnection plain(filename);
+        REQUIRE(count_rows(plain) == 200);
+    }
+
+    SECTION("A codec that compresses nothing") {
+        const std::string filename = fresh_database("SQLiteXXCompressedVfsCopy");
+        {
+            sqlite::dbconnection connection = open_with(filename, vfs);
+            fill(connection, 2000);
+        }
+        sqlite::dbconnection connection = open_with(filename, vfs);
+        REQUIRE(count_rows(connection) == 2000);
+        REQUIRE(integrity(connection) == "ok");
+    }
+}
+
+TEST_CASE("Page maps larger than one write", "[CompressedVfs]") {
+    const std::string filename = fresh_database("SQLiteXXCompressedVfsLarge");
+    sqlite::compressed_vfs vfs("test-compressed-large");
+    {
+        sqlite::dbconnection connection = open_with(filename, vfs);
+        sqlite::execute(connection, "PRAGMA page_size = 512");
+        fill(connection, 50000);
+    }
+
+    sqlite::compressed_vfs other("test-compressed-large-other");
+    sqlite::dbconnection connection = open_with(filename, other);
+    sqlite::statement pages(connection, "PRAGMA page_count");
+    pages.step();
+    REQUIRE(pages.get_int(0) > 4096);
+    REQUIRE(count_rows(connection) == 50000);
+    REQUIRE(integrity(connection) == "ok");
+}
@@ -0,0 +1,134 @@
+#include "catch.hpp"
+#include "SQLiteXX.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+static void write_file(const std::string& path, const std::string& contents) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << contents;
+}
+
+TEST_CASE("Reading CSV files with the csv module", "[CsvTable]") {
+    const std::string path = "TestCsvTable.csv";
+    sqlite::dbconnection connection = sqlite::dbconnection::memory();
+    REQUIRE_NOTHROW(connection.create_csv_module());
+
+    SECTION("Columns come from the header") {
+        write_file(path, "\xEF\xBB\xBFid,name,\"city, state\"\r\n1,Ann,\"Austin, TX\"\r\n2,Bob,Boston\r\n");
+        sqlite::execute(connection, "CREATE VIRTUAL TABLE temp.people USING csv('" + path + "')");
+
+        sqlite::statement query(connection, "SELECT rowid, id, name, \"city, state\" FROM people");
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_int(0) == 1);
+        REQUIRE(query.get_string(1) == "1");
+        REQUIRE(query.get_string(2) == "Ann");
+        REQUIRE(query.get_string(3) == "Austin, TX");
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_int(0) == 2);
+        REQUIRE(query.get_string(3) == "Boston");
+        REQUIRE(query.step() == false);
+    }
+
+    SECTION("Quoted fields") {
+        write_file(path, "a,b\n\"line\nbreak\",\"say \"\"hi\"\"\"\n,\"\"\nshort\n");
+        sqlite::execute(connection, "CREATE VIRTUAL TABLE temp.quoted USING csv(filename='" + path + "', header=yes)");
+
+        sqlite::statement query(connection, "SELECT a, b, typeof(b) FROM quoted");
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_string(0) == "line\nbreak");
+        REQUIRE(query.get_string(1) == "say \"hi\"");
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_string(0) == "");
+        REQUIRE(query.get_string(1) == "");
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_string(0) == "short");
+        REQUIRE(query.get_string(2) == "null");
+        REQUIRE(query.step() == false);
+    }
+
+    SECTION("Files without a header") {
+        write_file(path, "1,2,3\n4,5,6");
+        sqlite::execute(connection, "CREATE VIRTUAL TABLE temp.numbers USING csv('" + path + "', header=no)");
+
+        sqlite::statement query(connection, "SELECT sum(c1), sum(c2), sum(c3), count(*) FROM numbers");
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_int(0) == 5);
+        REQUIRE(query.get_int(1) == 7);
+        REQUIRE(query.get_int(2) == 9);
+        REQUIRE(query.get_int(3) == 2);
+    }
+
+    SECTION("Loading a table with INSERT INTO SELECT") {
+        std::string contents = "key,value\n";
+        for (int i = 1; i <= 1000; ++i) {
+            contents += std::to_string(i) + ",\"v" + std::to_string(i) + "\"\n";
+        }
+        write_file(path, contents);
+        sqlite::execute(connection, "CREATE VIRTUAL TABLE temp.source USING csv('" + path + "')");
+        sqlite::execute(connection, "CREATE TABLE target(key INTEGER PRIMARY KEY, value TEXT)");
+        sqlite::execute(connection, "INSERT INTO target SELECT CAST(key AS INTEGER), value FROM source");
+
+        sqlite::statement query(connection, "SELECT count(*), sum(key), max(value) FROM target");
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_int(0) == 1000);
+        REQUIRE(query.get_int(1) == 500500);
+        REQUIRE(query.get_string(2) == "v999");
+    }
+
+    SECTION("Rowid lookups use the record index") {
+        write_file(path, "n\n\"a\nb\"\nc\nd\n");
+        sqlite::execute(connection, "CREATE VIRTUAL TABLE temp.letters USING csv('" + path + "')");
+
+        sqlite::statement query(connection, "SELECT n FROM letters WHERE rowid = ?", 2);
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_string(0) == "c");
+        REQUIRE(query.step() == false);
+
+        sqlite::statement missing(connection, "SELECT n FROM letters WHERE rowid = 4");
+        REQUIRE(missing.step() == false);
+    }
+
+    SECTION("Invalid arguments are errors") {
+        write_file(path, "a\n1\n");
+        REQUIRE_THROWS_AS(sqlite::execute(connection, "CREATE VIRTUAL TABLE temp.none USING csv()"), sqlite::exception);
+        REQUIRE_THROWS_AS(sqlite::execute(connection, "CREATE VIRTUAL TABLE temp.missing USING csv('TestCsvTableMissing.csv')"), sqlite::exception);
+        REQUIRE_THROWS_AS(sqlite::execute(connection, "CREATE VIRTUAL TABLE temp.unknown USING csv('" + path + "', separator=';')"), sqlite::exception);
+    }
+
+    remove(path.c_str());
+}
+
+TEST_CASE("Indexing CSV records in parallel", "[CsvTable]") {
+    const std::string path = "TestCsvTableIndex.csv";
+    std::string contents = "id,text\n";
+    std::vector<std::size_t> expected;
+    for (int i = 0; i < 50000; ++i) {
+        expected.push_back(contents.size());
+        // Every third record has a newline and escaped quotes inside a quoted field.
+        if (i % 3 == 0) {
+            contents += std::to_string(i) + ",\"multi\nline \"\"" + std::to_string(i) + "\"\"\"\n";
+        } else {
+            contents += std::to_string(i) + ",plain text " + std::to_string(i) + "\n";
+        }
+    }
+    write_file(path, contents);
+
+    for (const std::string threads : {"1", "3", "8"}) {
+        sqlite::csv_table table({"'" + path + "'", "threads=" + threads});
+        REQUIRE(table.columns() == std::vector<std::string>({"id", "text"}));
+        REQUIRE(table.record_offsets() == expected);
+    }
+
+    sqlite::dbconnection connection = sqlite::dbconnection::memory();
+    connection.create_csv_module();
+    sqlite::execute(connection, "CREATE VIRTUAL TABLE temp.records USING csv('" + path + "', threads=4)");
+    sqlite::statement query(connection, "SELECT id, text FROM records WHERE rowid = 30001");
+    REQUIRE(query.step() == true);
+    REQUIRE(query.get_string(0) == "30000");
+    REQUIRE(query.get_string(1) == "multi\nline \"30000\"");
+
+    remove(path.c_str());
+}
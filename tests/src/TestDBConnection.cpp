@@ -1,6 +1,8 @@
 #include "catch.hpp"
 #include "SQLiteXX.h"
+#include "TestHelpers.h"
 
+#include <algorithm>
 #include <string>
 #include <utility>
 #include <vector>
@@ -148,3 +150,193 @@ TEST_CASE("DBConnectionTest Assignment Operators", "[DBConnection]") {
         REQUIRE(query.column_count() == 2);
     }
 }
+
+TEST_CASE("DBConnection memory configuration", "[DBConnection]") {
+    remove("testDBConnection.db");
+
+    SECTION("Configuration applied at open time") {
+        sqlite::dbconnection::memory_config config;
+        config.lookaside_slot_size = 256;
+        config.lookaside_slot_count = 64;
+        config.cache_size = 100;
+        config.cache_spill = 512;
+        config.mmap_size = 0;
+
+        sqlite::dbconnection connection("testDBConnection.db", config);
+
+        sqlite::statement cacheSize(connection, "PRAGMA cache_size");
+        REQUIRE(cacheSize.step() == true);
+        REQUIRE(cacheSize.get_int(0) == 100);
+
+        sqlite::statement cacheSpill(connection, "PRAGMA cache_spill");
+        REQUIRE(cacheSpill.step() == true);
+        REQUIRE(cacheSpill.get_int(0) == 512);
+
+        sqlite::statement mmapSize(connection, "PRAGMA mmap_size");
+        REQUIRE(mmapSize.step() == true);
+        REQUIRE(mmapSize.get_int(0) == 0);
+    }
+
+    SECTION("Lookaside counters are reported") {
+        sqlite::dbconnection::memory_config config;
+        config.lookaside_slot_size = 128;
+        config.lookaside_slot_count = 32;
+
+        sqlite::dbconnection connection("testDBConnection.db", config);
+        REQUIRE(sqlite::execute(connection, "CREATE TABLE test (id INTEGER PRIMARY KEY, value TEXT)") == 0);
+        for (int i = 0; i < 10; ++i) {
+            REQUIRE(sqlite::execute(connection, "INSERT INTO test VALUES (NULL, ?)", "value") == 1);
+        }
+
+        sqlite::dbconnection::lookaside_counters counters = connection.lookaside(true);
+        REQUIRE(counters.used_highwater <= 32);
+        if (!sqlite3_compileoption_used("OMIT_LOOKASIDE")) {
+            REQUIRE(counters.hit > 0);
+        }
+
+        counters = connection.lookaside();
+        REQUIRE(counters.hit == 0);
+        REQUIRE(counters.miss_size == 0);
+        REQUIRE(counters.miss_full == 0);
+    }
+
+    SECTION("Disabling lookaside") {
+        sqlite::dbconnection::memory_config config;
+        config.lookaside_slot_size = 0;
+        config.lookaside_slot_count = 0;
+
+        sqlite::dbconnection connection("testDBConnection.db", config);
+        REQUIRE(sqlite::execute(connection, "CREATE TABLE test (id INTEGER PRIMARY KEY, value TEXT)") == 0);
+        REQUIRE(connection.lookaside().hit == 0);
+    }
+
+    SECTION("Lookaside slot size without a count") {
+        sqlite::dbconnection::memory_config config;
+        config.lookaside_slot_size = 128;
+
+        REQUIRE_THROWS_AS(sqlite::dbconnection("testDBConnection.db", config), sqlite::SQLiteXXException);
+    }
+}
+
+TEST_CASE("DBConnection memory-mapped I/O", "[DBConnection]") {
+    remove("testDBConnection.db");
+    sqlite::dbconnection connection("testDBConnection.db");
+
+    SECTION("Enable and disable") {
+        const int64_t limit = sqlite::max_mmap_size();
+        const int64_t requested = 1024 * 1024;
+
+        REQUIRE(connection.set_mmap_size(requested) == std::min(requested, limit));
+        REQUIRE(connection.mmap_size() == std::min(requested, limit));
+        REQUIRE(connection.mmap_size("main") == std::min(requested, limit));
+
+        REQUIRE(connection.set_mmap_size(0) == 0);
+        REQUIRE(connection.mmap_size() == 0);
+    }
+
+    SECTION("Requests are limited by the library maximum") {
+        const int64_t limit = sqlite::max_mmap_size();
+        REQUIRE(connection.set_mmap_size(limit + 1) <= limit);
+    }
+
+    SECTION("Unknown database") {
+        REQUIRE_THROWS_AS(connection.set_mmap_size(4096, "unknown"), sqlite::exception);
+    }
+
+    SECTION("Database names are quoted") {
+        remove("testDBConnectionAttached.db");
+        sqlite::execute(connection, "ATTACH 'testDBConnectionAttached.db' AS \"odd\"\"name\"");
+        const int64_t limit = sqlite::max_mmap_size();
+        REQUIRE(connection.set_mmap_size(4096, "odd\"name") == std::min<int64_t>(4096, limit));
+        REQUIRE(connection.mmap_size("odd\"name") == std::min<int64_t>(4096, limit));
+        REQUIRE(connection.mmap_size() == 0);
+    }
+
+    SECTION("Library defaults can not be changed after initialization") {
+        REQUIRE_THROWS_AS(sqlite::configure_mmap_size(0, 0), sqlite::exception);
+    }
+}
+
+#if SQLITE_VERSION_NUMBER >= 3036000 || defined(SQLITE_ENABLE_DESERIALIZE)
+TEST_CASE("DBConnection serialize and deserialize", "[DBConnection]") {
+    sqlite::dbconnection source = sqlite::dbconnection::memory();
+    sqlite::execute(source, "CREATE TABLE test (id INTEGER PRIMARY KEY, value TEXT)");
+    sqlite::execute(source, "WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < 1000) "
+                            "INSERT INTO test (value) SELECT printf('value %d', i) FROM n");
+
+    SECTION("A memory database is copied") {
+        const sqlite::serialized_database image = source.serialize();
+        REQUIRE_FALSE(image.is_view());
+        REQUIRE(image.size() % 4096 == 0);
+        REQUIRE(image.view().substr(0, 15) == "SQLite format 3");
+    }
+
+    SECTION("Clone a database and change the clone") {
+        sqlite::dbconnection clone = sqlite::dbconnection::memory();
+        clone.deserialize(source.serialize());
+        sqlite::execute(clone, "DELETE FROM test WHERE id > 10");
+        sqlite::execute(clone, "INSERT INTO test (value) SELECT value FROM test");
+
+        REQUIRE(count_rows(clone) == 20);
+        REQUIRE(count_rows(source) == 1000);
+    }
+
+    SECTION("A deserialized database is returned as a view") {
+        sqlite::dbconnection clone = sqlite::dbconnection::memory();
+        const sqlite::serialized_database copy = source.serialize();
+        clone.deserialize(copy.data(), copy.size());
+
+        sqlite::serialized_database view = clone.serialize();
+        REQUIRE(view.is_view());
+        REQUIRE(view.view() == copy.view());
+
+        sqlite::dbconnection second = sqlite::dbconnection::memory();
+        second.deserialize(std::move(view));
+        REQUIRE(view.size() == 0);
+        sqlite::execute(clone, "DELETE FROM test");
+        REQUIRE(count_rows(second) == 1000);
+    }
+
+    SECTION("A read-only database is read in place") {
+        const sqlite::serialized_database copy = source.serialize();
+        const std::vector<unsigned char> bytes(copy.data(), copy.data() + copy.size());
+
+        sqlite::dbconnection reader = sqlite::dbconnection::memory();
+        reader.deserialize(bytes.data(), bytes.size(), sqlite::deserialize_mode::read_only);
+        REQUIRE(count_rows(reader) == 1000);
+        REQUIRE_THROWS_AS(sqlite::execute(reader, "DELETE FROM test"), sqlite::exception);
+        REQUIRE(reader.serialize().data() == bytes.data());
+    }
+
+    SECTION("Load a memory-mapped database file") {
+        remove("testDBConnectionSerialize.db");
+        sqlite::save(source, "testDBConnectionSerialize.db");
+        const sqlite::mapped_file file("testDBConnectionSerialize.db");
+
+        sqlite::dbconnection reader = sqlite::dbconnection::memory();
+        reader.deserialize(file.data(), file.size(), sqlite::deserialize_mode::read_only);
+        REQUIRE(count_rows(reader) == 1000);
+    }
+
+    SECTION("Attached databases") {
+        sqlite::execute(source, "ATTACH ':memory:' AS aux");
+        sqlite::execute(source, "CREATE TABLE aux.other (x)");
+        sqlite::execute(source, "INSERT INTO aux.other VALUES (1), (2)");
+        sqlite::serialized_database aux = source.serialize("aux");
+
+        sqlite::dbconnection target = sqlite::dbconnection::memory();
+        sqlite::execute(target, "ATTACH ':memory:' AS copy");
+        target.deserialize(std::move(aux), sqlite::deserialize_mode::read_only, "copy");
+        REQUIRE(count_rows(target, "copy.other") == 2);
+        REQUIRE_THROWS_AS(sqlite::execute(target, "INSERT INTO copy.other VALUES (3)"), sqlite::exception);
+    }
+
+    SECTION("Empty and unknown databases") {
+        REQUIRE(sqlite::dbconnection::memory().serialize().size() == 0);
+        REQUIRE_THROWS_AS(source.serialize("unknown"), sqlite::exception);
+
+        const sqlite::serialized_database image = source.serialize();
+        REQUIRE_THROWS_AS(source.deserialize(image.data(), image.size(), sqlite::deserialize_mode::resizable, "unknown"), sqlite::exception);
+    }
+}
+#endif
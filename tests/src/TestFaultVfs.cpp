@@ -0,0 +1,212 @@
+#include "catch.hpp"
+#include "SQLiteXX.h"
+#include "TestHelpers.h"
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+static sqlite::dbconnection open_with(const std::string& filename, const sqlite::fault_vfs& vfs, const std::chrono::milliseconds timeout = std::chrono::seconds(1)) {
+    return sqlite::dbconnection(filename, sqlite::openmode::read_write | sqlite::openmode::create, timeout, vfs.name());
+}
+
+static void create_table(const std::string& filename, const int rows) {
+    sqlite::dbconnection connection(filename);
+    sqlite::execute(connection, "CREATE TABLE test (id INTEGER PRIMARY KEY, value TEXT)");
+    sqlite::execute(connection, "WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < ?) "
+                                "INSERT INTO test (value) SELECT printf('%0200d', i) FROM n", rows);
+}
+
+template <typename F>
+static std::chrono::microseconds time_of(F&& function) {
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    function();
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+}
+
+TEST_CASE("Transactions under slow syncs", "[FaultVfs]") {
+    const std::string filename = fresh_database("SQLiteXXFaultVfsLatency");
+    create_table(filename, 10);
+    sqlite::fault_vfs vfs("test-fault-latency");
+    sqlite::dbconnection connection = open_with(filename, vfs);
+
+    SECTION("Every commit waits for its syncs") {
+        sqlite::fault_config config;
+        config.latency.fixed = std::chrono::milliseconds(2);
+        vfs.inject(sqlite::io_operation::sync, config);
+
+        sqlite::deferred_transaction transaction(connection);
+        sqlite::execute(connection, "INSERT INTO test (value) VALUES ('a')");
+        REQUIRE(time_of([&]() { transaction.commit(); }) >= std::chrono::milliseconds(2));
+        REQUIRE(vfs.stats().delayed > 0);
+    }
+
+    SECTION("Occasional sync stalls show up in the tail latency of commits") {
+        sqlite::fault_config config;
+        config.latency.exponential_mean = std::chrono::microseconds(50);
+        config.latency.stall_probability = 0.02;
+        config.latency.stall = std::chrono::milliseconds(20);
+        vfs.inject(sqlite::io_operation::sync, config);
+
+        std::vector<std::chrono::microseconds> commits;
+        for (int i = 0; i < 100; ++i) {
+            commits.push_back(time_of([&]() { sqlite::execute(connection, "INSERT INTO test (value) VALUES ('a')"); }));
+        }
+        std::sort(commits.begin(), commits.end());
+
+        // Only lower bounds are checked against the clock, how fast the other commits are depends on the machine.
+        const sqlite::fault_stats stats = vfs.stats();
+        REQUIRE(stats.stalls > 0);
+        REQUIRE(stats.stalls < commits.size() / 2);
+        REQUIRE(stats.delay >= stats.stalls * std::chrono::milliseconds(20));
+        REQUIRE(commits.back() >= std::chrono::milliseconds(20));
+        REQUIRE(count_rows(connection) == 110);
+    }
+}
+
+TEST_CASE("Transactions under I/O errors", "[FaultVfs]") {
+    const std::string filename = fresh_database("SQLiteXXFaultVfsErrors");
+    create_table(filename, 100);
+    sqlite::fault_vfs vfs("test-fault-errors");
+    sqlite::dbconnection connection = open_with(filename, vfs);
+
+    SECTION("A full disk while writing the journal") {
+        sqlite::fault_config config;
+        config.error_probability = 1.0;
+        config.error = SQLITE_FULL;
+        config.only = sqlite::file_kind::journal;
+        vfs.inject(sqlite::io_operation::write, config);
+
+        try {
+            sqlite::execute(connection, "UPDATE test SET value = 'b'");
+            FAIL("The update should fail");
+        } catch (const sqlite::exception& e) {
+            REQUIRE(e.errcode == SQLITE_FULL);
+        }
+        REQUIRE(vfs.stats().errors > 0);
+
+        vfs.clear();
+        sqlite::dbconnection plain(filename);
+        REQUIRE(count_rows(plain) == 100);
+        REQUIRE(integrity(plain) == "ok");
+    }
+
+    SECTION("A failing sync rolls the transaction back") {
+        sqlite::fault_config config;
+        config.error_probability = 1.0;
+        config.error = SQLITE_IOERR_FSYNC;
+        vfs.inject(sqlite::io_operation::sync, config);
+
+        {
+            sqlite::deferred_transaction transaction(connection);
+            sqlite::execute(connection, "DELETE FROM test WHERE id > 50");
+            try {
+                transaction.commit();
+                FAIL("The commit should fail");
+            } catch (const sqlite::exception& e) {
+                REQUIRE((e.errcode & 0xff) == SQLITE_IOERR);
+            }
+        }
+
+        vfs.clear();
+        REQUIRE(count_rows(connection) == 100);
+        REQUIRE(integrity(connection) == "ok");
+    }
+
+    SECTION("Short reads") {
+        sqlite::fault_config config;
+        config.short_read_probability = 1.0;
+        config.only = sqlite::file_kind::main_database;
+        vfs.inject(sqlite::io_operation::read, config);
+
+        sqlite::dbconnection reader = open_with(filename, vfs);
+        REQUIRE_THROWS_AS(count_rows(reader), sqlite::exception);
+        REQUIRE(vfs.stats().short_reads > 0);
+    }
+}
+
+TEST_CASE("Busy handling under lock contention", "[FaultVfs]") {
+    const std::string filename = fresh_database("SQLiteXXFaultVfsBusy");
+    create_table(filename, 10);
+    sqlite::fault_vfs vfs("test-fault-busy");
+
+    sqlite::fault_config config;
+    config.error = SQLITE_BUSY;
+    config.only = sqlite::file_kind::main_database;
+
+    SECTION("Without a busy timeout the first refused lock fails the statement") {
+        config.error_probability = 1.0;
+        vfs.inject(sqlite::io_operation::lock, config);
+
+        sqlite::dbconnection connection = open_with(filename, vfs, std::chrono::milliseconds(0));
+        REQUIRE_THROWS_AS(sqlite::execute(connection, "INSERT INTO test (value) VALUES ('a')"), sqlite::busy_exception);
+    }
+
+    SECTION("The busy handler retries refused locks") {
+        config.error_probability = 0.5;
+        config.latency.fixed = std::chrono::microseconds(100);
+        vfs.inject(sqlite::io_operation::lock, config);
+
+        sqlite::dbconnection connection = open_with(filename, vfs, std::chrono::seconds(10));
+        for (int i = 0; i < 20; ++i) {
+            REQUIRE_NOTHROW(sqlite::execute(connection, "INSERT INTO test (value) VALUES ('a')"));
+        }
+        REQUIRE(vfs.stats().errors > 0);
+
+        vfs.clear();
+        REQUIRE(count_rows(connection) == 30);
+    }
+
+    SECTION("A busy timeout shorter than the contention gives up") {
+        config.error_probability = 1.0;
+        vfs.inject(sqlite::io_operation::lock, config);
+
+        sqlite::dbconnection connection = open_with(filename, vfs, std::chrono::milliseconds(50));
+        const std::chrono::microseconds waited = time_of([&]() {
+            REQUIRE_THROWS_AS(sqlite::execute(connection, "INSERT INTO test (value) VALUES ('a')"), sqlite::busy_exception);
+        });
+        REQUIRE(waited >= std::chrono::milliseconds(50));
+    }
+}
+
+TEST_CASE("Backup under slow reads", "[FaultVfs]") {
+    const std::string filename = fresh_database("SQLiteXXFaultVfsBackup");
+    create_table(filename, 1000);
+    sqlite::fault_vfs vfs("test-fault-backup");
+
+    sqlite::fault_config config;
+    config.only = sqlite::file_kind::main_database;
+
+    SECTION("Stepping through a slow source") {
+        config.latency.fixed = std::chrono::microseconds(500);
+        vfs.inject(sqlite::io_operation::read, config);
+
+        sqlite::dbconnection source = open_with(filename, vfs);
+        sqlite::dbconnection destination = sqlite::dbconnection::memory();
+        sqlite::backup backup(source, destination);
+
+        int steps = 0;
+        const std::chrono::microseconds elapsed = time_of([&]() {
+            while (backup.step(10)) {
+                ++steps;
+                REQUIRE(backup.remaining_page_count() < backup.total_page_count());
+            }
+        });
+        REQUIRE(steps >= backup.total_page_count() / 10 - 1);
+        REQUIRE(elapsed >= std::chrono::microseconds(500) * backup.total_page_count());
+        REQUIRE(count_rows(destination) == 1000);
+    }
+
+    SECTION("A read error aborts the backup") {
+        config.error_probability = 1.0;
+        config.error = SQLITE_IOERR_READ;
+        sqlite::dbconnection source = open_with(filename, vfs);
+        sqlite::dbconnection destination = sqlite::dbconnection::memory();
+        sqlite::backup backup(source, destination);
+        REQUIRE(backup.step(10));
+
+        vfs.inject(sqlite::io_operation::read, config);
+        REQUIRE_THROWS_AS(backup.step(10), sqlite::exception);
+    }
+}
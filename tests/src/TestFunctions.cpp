@@ -92,6 +92,74 @@ TEST_CASE("Create General Scalar Functions", "[Functions]") {
     }
 }
 
+TEST_CASE("Create General Scalar Functions over a value span", "[Functions]") {
+    sqlite::dbconnection connection = sqlite::dbconnection::memory();
+
+    SECTION("Iterating over the arguments") {
+        REQUIRE_NOTHROW(
+            connection.create_general_function(
+                "total",
+                [](sqlite::value_span values) -> int64_t {
+                    int64_t sum = 0;
+                    for (sqlite::value_ref value : values) {
+                        sum += value.as_int64();
+                    }
+                    return sum;
+                },
+                true));
+
+        sqlite::statement query(connection, "SELECT total(), total(1), total(1, 2, 3, 4)");
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_int(0) == 0);
+        REQUIRE(query.get_int(1) == 1);
+        REQUIRE(query.get_int(2) == 10);
+    }
+
+    SECTION("Indexing and inspecting arguments") {
+        REQUIRE_NOTHROW(
+            connection.create_general_function(
+                "describe",
+                [](sqlite::value_span values) -> std::string {
+                    std::string description = std::to_string(values.size());
+                    for (std::size_t i = 0; i < values.size(); ++i) {
+                        description += ":";
+                        if (values[i].type() == sqlite::datatype::text) {
+                            description += values[i].as_string_view();
+                        } else if (values[i].type() == sqlite::datatype::floating) {
+                            description += std::to_string(values[i].as_double());
+                        } else if (values[i].type() == sqlite::datatype::blob) {
+                            description += std::to_string(values[i].as_blob().size());
+                        } else {
+                            description += std::to_string(values[i].as_int());
+                        }
+                    }
+                    return description;
+                }));
+
+        sqlite::statement query(connection, "SELECT describe(), describe('a', 2, 0.5, x'0102')");
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_string(0) == "0");
+        REQUIRE(query.get_string(1) == "4:a:2:0.500000:2");
+    }
+
+    SECTION("Returning an argument") {
+        REQUIRE_NOTHROW(
+            connection.create_general_function(
+                "last",
+                [](sqlite::value_span values) -> sqlite::value_ref {
+                    return values[values.size() - 1];
+                },
+                true,
+                sqlite::textencoding::utf8,
+                3));
+
+        sqlite::statement query(connection, "SELECT last(1, 'two', 3.5), typeof(last(1, 2, 'three'))");
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_double(0) == 3.5);
+        REQUIRE(query.get_string(1) == "text");
+    }
+}
+
 int testMultiply(int x, int y) {
     return x * y;
 }
@@ -169,6 +237,65 @@ TEST_CASE("Create Scalar Function", "[Functions]") {
     }
 }
 
+TEST_CASE("Scalar Function Argument Types", "[Functions]") {
+    sqlite::dbconnection connection = sqlite::dbconnection::memory();
+
+    REQUIRE(sqlite::execute(connection, "CREATE TABLE test (num INT, real REAL, txt TEXT, data BLOB)") == 0);
+    REQUIRE(sqlite::execute(connection, "INSERT INTO test VALUES (5000000000, 2.5, 'hello', x'00010203')") == 1);
+
+    SECTION("64-bit integer and floating point arguments") {
+        connection.create_function("scale", [](int64_t x, double y) -> double { return x * y; });
+        connection.create_function("narrow", [](float x) -> double { return x; });
+        connection.create_function("truthy", [](bool x) -> int { return x ? 1 : 0; });
+
+        sqlite::statement query(connection, "SELECT scale(num, real), narrow(real), truthy(num), truthy(0) FROM test");
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_double(0) == 12500000000.0);
+        REQUIRE(query.get_double(1) == 2.5);
+        REQUIRE(query.get_int(2) == 1);
+        REQUIRE(query.get_int(3) == 0);
+    }
+
+    SECTION("Text arguments") {
+        connection.create_function("view_length", [](std::string_view text) -> int { return static_cast<int>(text.size()); });
+        connection.create_function("first_half", [](std::string_view text) -> std::string_view { return text.substr(0, text.size() / 2); });
+        connection.create_function("shout", [](const std::string& text) -> std::string { return text + "!"; });
+        connection.create_function("wide_length", [](const std::u16string& text) -> int { return static_cast<int>(text.size()); });
+
+        sqlite::statement query(connection, "SELECT view_length(txt), first_half(txt), shout(txt), wide_length(txt), view_length(NULL) FROM test");
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_int(0) == 5);
+        REQUIRE(query.get_string(1) == "he");
+        REQUIRE(query.get_string(2) == "hello!");
+        REQUIRE(query.get_int(3) == 5);
+        REQUIRE(query.get_int(4) == 0);
+    }
+
+    SECTION("Blob and value arguments") {
+        connection.create_function("blob_size", [](const sqlite::blob& data) -> int { return static_cast<int>(data.size()); });
+        connection.create_function("type_of", [](const sqlite::value& arg) -> int { return static_cast<int>(arg.type()); });
+
+        sqlite::statement query(connection, "SELECT blob_size(data), type_of(data), type_of(real) FROM test");
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_int(0) == 4);
+        REQUIRE(query.get_int(1) == SQLITE_BLOB);
+        REQUIRE(query.get_int(2) == SQLITE_FLOAT);
+    }
+
+    SECTION("Stateful function object") {
+        struct counter {
+            int calls = 0;
+            int operator()(int x) { return x + ++calls; }
+        };
+
+        connection.create_function("counted", counter());
+
+        sqlite::statement query(connection, "SELECT counted(1), counted(1)");
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_int(0) + query.get_int(1) == 5);
+    }
+}
+
 class MySum {
     public:
     MySum() :
@@ -217,6 +344,204 @@ TEST_CASE("Create Aggregate Function", "[Functions]") {
     }
 }
 
+#if SQLITE_VERSION_NUMBER >= 3025000
+class SlidingSum {
+    public:
+    static int inverse_calls;
+
+    SlidingSum() :
+        m_sum(0)
+    {}
+
+    void step(int64_t val) {
+        m_sum += val;
+    }
+
+    void inverse(int64_t val) {
+        m_sum -= val;
+        ++inverse_calls;
+    }
+
+    int64_t value() {
+        return m_sum;
+    }
+
+    int64_t finalize() {
+        return m_sum;
+    }
+
+    private:
+    int64_t m_sum;
+};
+
+int SlidingSum::inverse_calls = 0;
+
+class SlidingAvg {
+    public:
+    SlidingAvg() :
+        m_sum(0),
+        m_count(0)
+    {}
+
+    void step(double val) {
+        m_sum += val;
+        ++m_count;
+    }
+
+    void inverse(double val) {
+        m_sum -= val;
+        --m_count;
+    }
+
+    double value() {
+        return m_count == 0 ? 0.0 : m_sum / m_count;
+    }
+
+    double finalize() {
+        return value();
+    }
+
+    private:
+    double m_sum;
+    int64_t m_count;
+};
+
+TEST_CASE("Create Window Function", "[Functions]") {
+    sqlite::dbconnection connection = sqlite::dbconnection::memory();
+
+    REQUIRE(sqlite::execute(connection, "CREATE TABLE test (id INTEGER PRIMARY KEY, num INT)") == 0);
+    REQUIRE(sqlite::execute(
+        connection,
+        "WITH RECURSIVE series(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM series WHERE x < 5000) "
+        "INSERT INTO test (num) SELECT (x * 7919) % 1000 FROM series") == 5000);
+
+    SECTION("Sliding sum and average") {
+        REQUIRE_NOTHROW(connection.create_window_function<SlidingSum>("SlidingSum", true));
+        REQUIRE_NOTHROW(connection.create_window_function<SlidingAvg>("SlidingAvg", true));
+
+        SlidingSum::inverse_calls = 0;
+        int rows = 0;
+        for (auto row : sqlite::statement(
+                connection,
+                "SELECT SlidingSum(num) OVER w, sum(num) OVER w, SlidingAvg(num) OVER w, avg(num) OVER w FROM test "
+                "WINDOW w AS (ORDER BY id ROWS BETWEEN 2 PRECEDING AND CURRENT ROW)")) {
+            REQUIRE(row.get_int64(0) == row.get_int64(1));
+            REQUIRE(row.get_double(2) == Approx(row.get_double(3)));
+            ++rows;
+        }
+        REQUIRE(rows == 5000);
+        // Every row past the first frame leaves it exactly once.
+        REQUIRE(SlidingSum::inverse_calls == 5000 - 3);
+    }
+
+    SECTION("Large frame") {
+        REQUIRE_NOTHROW(connection.create_window_function<SlidingSum>("SlidingSum", true));
+
+        int rows = 0;
+        for (auto row : sqlite::statement(
+                connection,
+                "SELECT SlidingSum(num) OVER w, sum(num) OVER w, SlidingSum(num) OVER s, sum(num) OVER s FROM test "
+                "WINDOW w AS (ORDER BY id ROWS BETWEEN 1000 PRECEDING AND 1000 FOLLOWING), "
+                "s AS (ORDER BY id ROWS BETWEEN 1 PRECEDING AND CURRENT ROW)")) {
+            REQUIRE(row.get_int64(0) == row.get_int64(1));
+            REQUIRE(row.get_int64(2) == row.get_int64(3));
+            ++rows;
+        }
+        REQUIRE(rows == 5000);
+    }
+
+    SECTION("Partitions") {
+        REQUIRE_NOTHROW(connection.create_window_function<SlidingSum>("SlidingSum", true));
+
+        int rows = 0;
+        for (auto row : sqlite::statement(
+                connection,
+                "SELECT SlidingSum(num) OVER w, sum(num) OVER w FROM test "
+                "WINDOW w AS (PARTITION BY num % 10 ORDER BY id ROWS BETWEEN 5 PRECEDING AND CURRENT ROW)")) {
+            REQUIRE(row.get_int64(0) == row.get_int64(1));
+            ++rows;
+        }
+        REQUIRE(rows == 5000);
+    }
+}
+#endif
+
+class CountingAggregate {
+    public:
+    static int alive;
+
+    CountingAggregate() :
+        m_sum(0)
+    {
+        ++alive;
+    }
+
+    ~CountingAggregate() {
+        --alive;
+    }
+
+    void step(int64_t val) {
+        m_sum += val;
+    }
+
+    int64_t finalize() {
+        return m_sum;
+    }
+
+    private:
+    int64_t m_sum;
+};
+
+int CountingAggregate::alive = 0;
+
+TEST_CASE("Aggregate Function with GROUP BY", "[Functions]") {
+    sqlite::dbconnection connection = sqlite::dbconnection::memory();
+
+    REQUIRE(sqlite::execute(connection, "CREATE TABLE test (grp INT, num INT)") == 0);
+    REQUIRE(sqlite::execute(
+        connection,
+        "WITH RECURSIVE series(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM series WHERE x < 1000) "
+        "INSERT INTO test SELECT x % 37, x FROM series") == 1000);
+
+    SECTION("Every group has its own state") {
+        REQUIRE_NOTHROW(connection.create_aggregate<MySum>("MySum", true));
+
+        int groups = 0;
+        for (auto row : sqlite::statement(connection, "SELECT MySum(num), sum(num) FROM test GROUP BY grp")) {
+            REQUIRE(row.get_int(0) == row.get_int(1));
+            ++groups;
+        }
+        REQUIRE(groups == 37);
+    }
+
+    SECTION("Same aggregate used twice in one query") {
+        REQUIRE_NOTHROW(connection.create_aggregate<MySum>("MySum", true));
+
+        sqlite::statement query(connection, "SELECT MySum(num), MySum(grp), sum(num), sum(grp) FROM test");
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_int(0) == query.get_int(2));
+        REQUIRE(query.get_int(1) == query.get_int(3));
+    }
+
+    SECTION("State is destroyed after every group") {
+        REQUIRE_NOTHROW(connection.create_aggregate<CountingAggregate>("CountingSum", true));
+
+        CountingAggregate::alive = 0;
+        int groups = 0;
+        for (auto row : sqlite::statement(connection, "SELECT CountingSum(num), sum(num) FROM test GROUP BY grp")) {
+            REQUIRE(row.get_int64(0) == row.get_int64(1));
+            ++groups;
+        }
+        REQUIRE(groups == 37);
+        REQUIRE(CountingAggregate::alive == 0);
+
+        sqlite::statement query(connection, "SELECT CountingSum(num) FROM test WHERE grp < 0");
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_int64(0) == 0);
+        REQUIRE(CountingAggregate::alive == 0);
+    }
+}
+
 class BadAllocAggregate {
     public:
     BadAllocAggregate() :
@@ -506,3 +831,276 @@ TEST_CASE("Create Collation Function", "[Functions]") {
         }
     }
 }
+
+static int view_collation(std::string_view s1, std::string_view s2) {
+    return -1 * s1.compare(s2);
+}
+
+TEST_CASE("Create Collation Function with string views", "[Functions]") {
+    sqlite::dbconnection connection = sqlite::dbconnection::memory();
+
+    REQUIRE(sqlite::execute(connection, "CREATE TABLE test (string TEXT)") == 0);
+    REQUIRE(sqlite::execute(connection, "INSERT INTO test VALUES ('a'), ('b'), ('c'), ('d')") == 4);
+
+    std::vector<std::string> expectedValues = {"d", "c", "b", "a"};
+
+    SECTION("Create collation with function reference") {
+        REQUIRE_NOTHROW(connection.create_collation("reverse", view_collation));
+
+        int i = 0;
+        for (auto row : sqlite::statement(connection, "SELECT string FROM test ORDER BY string COLLATE reverse")) {
+            REQUIRE(expectedValues[i] == row.get_string(0));
+            ++i;
+        }
+        REQUIRE(i == 4);
+    }
+
+    SECTION("Create collation with lambda") {
+        REQUIRE_NOTHROW(
+            connection.create_collation(
+                "reverse",
+                [](std::string_view s1, std::string_view s2) -> int {
+                    return -1 * s1.compare(s2);
+                }));
+
+        int i = 0;
+        for (auto row : sqlite::statement(connection, "SELECT string FROM test ORDER BY string COLLATE reverse")) {
+            REQUIRE(expectedValues[i] == row.get_string(0));
+            ++i;
+        }
+        REQUIRE(i == 4);
+    }
+}
+
+static std::string case_fold_key(std::string_view text) {
+    std::string key(text);
+    for (char& c : key) {
+        c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+    }
+    return key;
+}
+
+// Prefixes every run of digits with its length so "item10" sorts after "item9".
+static std::string natural_sort_key(std::string_view text) {
+    std::string key;
+    std::size_t i = 0;
+    while (i < text.size()) {
+        if (isdigit(static_cast<unsigned char>(text[i]))) {
+            std::size_t end = i;
+            while (end < text.size() && isdigit(static_cast<unsigned char>(text[end]))) {
+                ++end;
+            }
+            key += static_cast<char>('0' + (end - i));
+            key.append(text.substr(i, end - i));
+            i = end;
+        } else {
+            key += text[i++];
+        }
+    }
+    return key;
+}
+
+TEST_CASE("Create Sort Key Collation", "[Functions]") {
+    sqlite::dbconnection connection = sqlite::dbconnection::memory();
+
+    SECTION("Case folding") {
+        REQUIRE(sqlite::execute(connection, "CREATE TABLE test (string TEXT)") == 0);
+        REQUIRE(sqlite::execute(connection, "INSERT INTO test VALUES ('banana'), ('Apple'), ('cherry'), ('apricot'), ('Blueberry')") == 5);
+        REQUIRE_NOTHROW(connection.create_sortkey_collation("fold", case_fold_key));
+
+        std::vector<std::string> expectedValues = {"Apple", "apricot", "banana", "Blueberry", "cherry"};
+        std::vector<std::string> values;
+        for (auto row : sqlite::statement(connection, "SELECT string FROM test ORDER BY string COLLATE fold")) {
+            values.push_back(row.get_string(0));
+        }
+        REQUIRE(values == expectedValues);
+
+        sqlite::statement query(connection, "SELECT count(*) FROM test WHERE string = 'APPLE' COLLATE fold");
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_int(0) == 1);
+    }
+
+    SECTION("Natural sort with a small cache") {
+        REQUIRE(sqlite::execute(connection, "CREATE TABLE test (string TEXT)") == 0);
+        for (int i = 20; i > 0; --i) {
+            REQUIRE(sqlite::execute(connection, "INSERT INTO test VALUES (?)", "item" + std::to_string(i)) == 1);
+        }
+
+        // A capacity of 2 forces the cache to be dropped between almost every comparison.
+        REQUIRE_NOTHROW(connection.create_sortkey_collation("natsort", natural_sort_key, 2));
+        REQUIRE_NOTHROW(sqlite::execute(connection, "CREATE INDEX natsort_index ON test (string COLLATE natsort)"));
+
+        int i = 1;
+        for (auto row : sqlite::statement(connection, "SELECT string FROM test ORDER BY string COLLATE natsort")) {
+            REQUIRE(row.get_string(0) == "item" + std::to_string(i));
+            ++i;
+        }
+        REQUIRE(i == 21);
+    }
+}
+
+struct CountedPattern {
+    static int compiled;
+
+    std::string text;
+};
+
+int CountedPattern::compiled = 0;
+
+namespace sqlite {
+    template <>
+    struct argument_compiler<CountedPattern> {
+        static CountedPattern compile(sqlite3_value *arg) {
+            ++CountedPattern::compiled;
+            return CountedPattern{std::string(argument<std::string_view>::get(arg))};
+        }
+    };
+}
+
+TEST_CASE("Cached Function Arguments", "[Functions]") {
+    sqlite::dbconnection connection = sqlite::dbconnection::memory();
+
+    REQUIRE(sqlite::execute(connection, "CREATE TABLE test (string TEXT)") == 0);
+    REQUIRE(sqlite::execute(
+        connection,
+        "WITH RECURSIVE series(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM series WHERE x < 100) "
+        "INSERT INTO test SELECT 'row' || x FROM series") == 100);
+
+    REQUIRE_NOTHROW(connection.create_function(
+        "starts_with",
+        [](const sqlite::cached<CountedPattern>& prefix, std::string_view text) -> bool {
+            return text.substr(0, prefix->text.size()) == prefix->text;
+        }));
+
+    SECTION("Constant argument is compiled once") {
+        CountedPattern::compiled = 0;
+        sqlite::statement query(connection, "SELECT count(*) FROM test WHERE starts_with('row1', string)");
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_int(0) == 12);
+        REQUIRE(CountedPattern::compiled == 1);
+    }
+
+    SECTION("Changing argument is compiled on every call") {
+        CountedPattern::compiled = 0;
+        sqlite::statement query(connection, "SELECT count(*) FROM test WHERE starts_with(string, string)");
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_int(0) == 100);
+        REQUIRE(CountedPattern::compiled == 100);
+    }
+}
+
+TEST_CASE("Regexp Function", "[Functions]") {
+    sqlite::dbconnection connection = sqlite::dbconnection::memory();
+
+    REQUIRE(sqlite::execute(connection, "CREATE TABLE test (string TEXT)") == 0);
+    REQUIRE(sqlite::execute(connection, "INSERT INTO test VALUES ('apple'), ('banana'), ('avocado'), ('cherry')") == 4);
+    REQUIRE_NOTHROW(connection.create_regexp_function());
+
+    SECTION("Matching rows") {
+        std::vector<std::string> expectedValues = {"apple", "avocado"};
+        std::vector<std::string> values;
+        for (auto row : sqlite::statement(connection, "SELECT string FROM test WHERE string REGEXP '^a' ORDER BY string")) {
+            values.push_back(row.get_string(0));
+        }
+        REQUIRE(values == expectedValues);
+    }
+
+    SECTION("Matches anywhere in the text") {
+        sqlite::statement query(connection, "SELECT count(*) FROM test WHERE string REGEXP 'an+a'");
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_int(0) == 1);
+    }
+
+    SECTION("NULL on either side gives NULL") {
+        sqlite::statement query(connection, "SELECT NULL REGEXP 'a*', 'abc' REGEXP NULL, NULL REGEXP NULL");
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_type(0) == sqlite::datatype::null);
+        REQUIRE(query.get_type(1) == sqlite::datatype::null);
+        REQUIRE(query.get_type(2) == sqlite::datatype::null);
+    }
+
+    SECTION("NULL rows never match") {
+        REQUIRE(sqlite::execute(connection, "INSERT INTO test VALUES (NULL)") == 1);
+        sqlite::statement query(connection, "SELECT count(*) FROM test WHERE string REGEXP '.*'");
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_int(0) == 4);
+    }
+
+    SECTION("Invalid pattern") {
+        REQUIRE_THROWS_AS(
+            sqlite::execute(connection, "SELECT count(*) FROM test WHERE string REGEXP '(unclosed'"),
+            sqlite::exception);
+    }
+}
+
+TEST_CASE("Memoized Function", "[Functions]") {
+    sqlite::dbconnection connection = sqlite::dbconnection::memory();
+
+    REQUIRE(sqlite::execute(connection, "CREATE TABLE test (num INT)") == 0);
+    REQUIRE(sqlite::execute(
+        connection,
+        "WITH RECURSIVE series(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM series WHERE x < 1000) "
+        "INSERT INTO test SELECT x % 10 FROM series") == 1000);
+
+    int calls = 0;
+
+    SECTION("Results are reused for repeated arguments") {
+        std::shared_ptr<const sqlite::memoization_counters> counters;
+        REQUIRE_NOTHROW(counters = connection.create_memoized_function(
+            "slow_square",
+            [&calls](int64_t x) -> int64_t {
+                ++calls;
+                return x * x;
+            }));
+
+        sqlite::statement query(connection, "SELECT sum(slow_square(num)), sum(num * num) FROM test");
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_int64(0) == query.get_int64(1));
+        REQUIRE(calls == 10);
+        REQUIRE(counters->misses == 10);
+        REQUIRE(counters->hits == 990);
+        REQUIRE(counters->evictions == 0);
+
+        // The cache belongs to the connection, not to the statement.
+        sqlite::statement again(connection, "SELECT slow_square(7)");
+        REQUIRE(again.step() == true);
+        REQUIRE(again.get_int64(0) == 49);
+        REQUIRE(calls == 10);
+    }
+
+    SECTION("Least recently used results are evicted") {
+        std::shared_ptr<const sqlite::memoization_counters> counters;
+        REQUIRE_NOTHROW(counters = connection.create_memoized_function(
+            "label",
+            [&calls](int64_t x) -> std::string {
+                ++calls;
+                return "label" + std::to_string(x);
+            },
+            2));
+
+        for (auto row : sqlite::statement(connection, "SELECT label(num), num FROM test")) {
+            REQUIRE(row.get_string(0) == "label" + std::to_string(row.get_int(1)));
+        }
+        REQUIRE(calls == 1000);
+        REQUIRE(counters->misses == 1000);
+        REQUIRE(counters->evictions == 998);
+    }
+
+    SECTION("Argument types are part of the key") {
+        REQUIRE_NOTHROW(connection.create_memoized_function(
+            "type_of",
+            [&calls](const sqlite::value& x) -> int {
+                ++calls;
+                return static_cast<int>(x.type());
+            }));
+
+        sqlite::statement query(connection, "SELECT type_of(1), type_of('1'), type_of(1.0), type_of(NULL), type_of(1)");
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_int(0) == SQLITE_INTEGER);
+        REQUIRE(query.get_int(1) == SQLITE_TEXT);
+        REQUIRE(query.get_int(2) == SQLITE_FLOAT);
+        REQUIRE(query.get_int(3) == SQLITE_NULL);
+        REQUIRE(query.get_int(4) == SQLITE_INTEGER);
+        REQUIRE(calls == 4);
+    }
+}
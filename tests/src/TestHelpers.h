@@ -0,0 +1,35 @@
+#ifndef __SQLITEXX_TESTHELPERS_H__
+#define __SQLITEXX_TESTHELPERS_H__
+
+#include "SQLiteXX.h"
+
+#include <filesystem>
+#include <string>
+
+// Returns an empty directory in the temporary directory, removing what an earlier run left in it.
+inline std::string fresh_directory(const std::string& name) {
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / name;
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    return directory.string();
+}
+
+// Returns the path of a database file that does not exist yet, in a directory of its own so no journal is left over.
+inline std::string fresh_database(const std::string& name) {
+    return (std::filesystem::path(fresh_directory(name)) / "test.db").string();
+}
+
+// Counts the rows of a table, which may be followed by a WHERE clause.
+inline int count_rows(const sqlite::dbconnection& connection, const std::string& from = "test") {
+    sqlite::statement query(connection, "SELECT count(*) FROM " + from);
+    query.step();
+    return query.get_int(0);
+}
+
+inline std::string integrity(const sqlite::dbconnection& connection) {
+    sqlite::statement query(connection, "PRAGMA integrity_check");
+    query.step();
+    return query.get_string(0);
+}
+
+#endif
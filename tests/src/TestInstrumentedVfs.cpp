@@ -0,0 +1,115 @@
+#include "catch.hpp"
+#include "SQLiteXX.h"
+#include "TestHelpers.h"
+
+#include <chrono>
+#include <string>
+
+static void fill(sqlite::dbconnection& connection) {
+    sqlite::execute(connection, "CREATE TABLE test (id INTEGER PRIMARY KEY, value TEXT)");
+    sqlite::deferred_transaction transaction(connection);
+    for (int i = 0; i < 1000; ++i) {
+        sqlite::execute(connection, "INSERT INTO test (value) VALUES (?)", std::string(100, 'a' + i % 26));
+    }
+    transaction.commit();
+}
+
+TEST_CASE("Counting file operations", "[InstrumentedVfs]") {
+    const std::string filename = fresh_database("SQLiteXXInstrumentedVfs");
+    sqlite::instrumented_vfs vfs("test-instrumented");
+
+    SECTION("Rollback journal") {
+        {
+            sqlite::dbconnection connection(filename, sqlite::openmode::read_write | sqlite::openmode::create, std::chrono::seconds(1), vfs.name());
+            fill(connection);
+        }
+
+        const sqlite::io_stats stats = vfs.stats();
+        const sqlite::io_counters& database_writes = stats.get(sqlite::file_kind::main_database, sqlite::io_operation::write);
+        REQUIRE(database_writes.calls > 0);
+        REQUIRE(database_writes.bytes >= 100000);
+        REQUIRE(database_writes.errors == 0);
+        REQUIRE(stats.get(sqlite::file_kind::journal, sqlite::io_operation::write).calls > 0);
+        REQUIRE(stats.get(sqlite::file_kind::main_database, sqlite::io_operation::sync).calls > 0);
+        REQUIRE(stats.get(sqlite::file_kind::main_database, sqlite::io_operation::lock).calls > 0);
+        REQUIRE(stats.get(sqlite::file_kind::wal, sqlite::io_operation::write).calls == 0);
+        REQUIRE(stats.total(sqlite::io_operation::shm).calls == 0);
+
+        vfs.reset();
+        REQUIRE(vfs.stats().total(sqlite::file_kind::main_database).calls == 0);
+
+        sqlite::dbconnection connection(filename, sqlite::openmode::read_only, std::chrono::seconds(1), vfs.name());
+        sqlite::statement query(connection, "SELECT count(*), sum(length(value)) FROM test");
+        REQUIRE(query.step());
+        REQUIRE(query.get_int(0) == 1000);
+
+        const sqlite::io_counters reads = vfs.stats().get(sqlite::file_kind::main_database, sqlite::io_operation::read);
+        REQUIRE(reads.calls > 0);
+        REQUIRE(reads.bytes >= 100000);
+        REQUIRE(vfs.stats().total(sqlite::io_operation::write).calls == 0);
+    }
+
+    SECTION("Write-ahead log") {
+        {
+            sqlite::dbconnection connection(filename, sqlite::openmode::read_write | sqlite::openmode::create, std::chrono::seconds(1), vfs.name());
+            sqlite::statement(connection, "PRAGMA journal_mode=WAL").step();
+            fill(connection);
+        }
+
+        const sqlite::io_stats stats = vfs.stats();
+        REQUIRE(stats.get(sqlite::file_kind::wal, sqlite::io_operation::write).calls > 0);
+        REQUIRE(stats.get(sqlite::file_kind::wal, sqlite::io_operation::write).bytes >= 100000);
+        REQUIRE(stats.get(sqlite::file_kind::main_database, sqlite::io_operation::shm).calls > 0);
+        REQUIRE(stats.total(sqlite::io_operation::shm).calls == stats.get(sqlite::file_kind::main_database, sqlite::io_operation::shm).calls);
+    }
+
+    SECTION("Temporary files") {
+        sqlite::dbconnection connection(filename, sqlite::openmode::read_write | sqlite::openmode::create, std::chrono::seconds(1), vfs.name());
+        sqlite::execute(connection, "PRAGMA temp_store=FILE");
+        sqlite::execute(connection, "CREATE TEMP TABLE scratch (value TEXT)");
+        // A tiny cache makes the temporary database spill to its file.
+        sqlite::execute(connection, "PRAGMA temp.cache_size=2");
+        sqlite::execute(connection, "WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < 5000) "
+                                    "INSERT INTO scratch SELECT printf('%0100d', i) FROM n");
+        REQUIRE(vfs.stats().total(sqlite::file_kind::temporary).calls > 0);
+    }
+
+    SECTION("Layered over another VFS") {
+        sqlite::instrumented_vfs memory("test-instrumented-memory", sqlite::memory_vfs());
+        {
+            sqlite::dbconnection connection("instrumented", sqlite::openmode::read_write | sqlite::openmode::create, std::chrono::seconds(1), memory.name());
+            fill(connection);
+            REQUIRE(sqlite::memory_vfs_contains("instrumented"));
+        }
+        REQUIRE(memory.stats().get(sqlite::file_kind::main_database, sqlite::io_operation::write).calls > 0);
+        REQUIRE(vfs.stats().total(sqlite::io_operation::write).calls == 0);
+    }
+
+    SECTION("Registration errors") {
+        REQUIRE_THROWS_AS(sqlite::instrumented_vfs("test-instrumented"), sqlite::SQLiteXXException);
+        REQUIRE_THROWS_AS(sqlite::instrumented_vfs("test-instrumented-other", "no-such-vfs"), sqlite::SQLiteXXException);
+    }
+}
+
+TEST_CASE("Latency histograms", "[InstrumentedVfs]") {
+    sqlite::io_counters counters;
+    REQUIRE(counters.mean() == std::chrono::nanoseconds(0));
+    REQUIRE(counters.percentile(0.99) == std::chrono::microseconds(0));
+
+    // 90 calls below a microsecond and 10 calls between 512 and 1024 microseconds.
+    counters.calls = 100;
+    counters.time = std::chrono::nanoseconds(100000);
+    counters.latency[0] = 90;
+    counters.latency[10] = 10;
+    REQUIRE(counters.mean() == std::chrono::nanoseconds(1000));
+    REQUIRE(counters.percentile(0.5) == std::chrono::microseconds(1));
+    REQUIRE(counters.percentile(0.9) == std::chrono::microseconds(1));
+    REQUIRE(counters.percentile(0.91) == std::chrono::microseconds(1024));
+    REQUIRE(sqlite::io_counters::bucket_limit(10) == std::chrono::microseconds(1024));
+
+    sqlite::io_counters sum;
+    sum += counters;
+    sum += counters;
+    REQUIRE(sum.calls == 200);
+    REQUIRE(sum.latency[10] == 20);
+}
@@ -0,0 +1,78 @@
+#include "catch.hpp"
+#include "SQLiteXX.h"
+#include "TestHelpers.h"
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+
+static sqlite::dbconnection open_with(const std::string& filename, const std::string& vfs) {
+    return sqlite::dbconnection(filename, sqlite::openmode::read_write | sqlite::openmode::create, std::chrono::seconds(1), vfs);
+}
+
+static void fill(sqlite::dbconnection& connection, const int rows) {
+    sqlite::execute(connection, "CREATE TABLE IF NOT EXISTS test (id INTEGER PRIMARY KEY, value TEXT)");
+    sqlite::immediate_transaction transaction(connection);
+    sqlite::execute(connection, "WITH RECURSIVE n(i) AS (SELECT 1 UNION ALL SELECT i + 1 FROM n WHERE i < ?) "
+                                "INSERT INTO test (value) SELECT printf('%0300d', i) FROM n", rows);
+    transaction.commit();
+}
+
+static int64_t scan(const sqlite::dbconnection& connection) {
+    sqlite::statement query(connection, "SELECT sum(length(value)) FROM test");
+    query.step();
+    return query.get_int64(0);
+}
+
+TEST_CASE("Reading with the Linux VFS", "[LinuxVfs]") {
+    const std::string filename = fresh_database("SQLiteXXLinuxVfs");
+
+    SECTION("Readahead") {
+        sqlite::linux_vfs vfs("test-linux");
+        sqlite::dbconnection connection = open_with(filename, vfs.name());
+        fill(connection, 5000);
+        REQUIRE(scan(connection) == 5000 * 300);
+        REQUIRE(integrity(connection) == "ok");
+    }
+
+    for (const int page_size : {1024, 4096, 65536}) {
+        SECTION("Direct I/O with " + std::to_string(page_size) + " byte pages") {
+            sqlite::linux_vfs_options options;
+            options.direct_io = true;
+            options.direct_read_size = 64 * 1024;
+            sqlite::linux_vfs vfs("test-linux-direct", options);
+
+            sqlite::dbconnection connection = open_with(filename, vfs.name());
+            sqlite::execute(connection, "PRAGMA page_size=" + std::to_string(page_size));
+            fill(connection, 5000);
+            sqlite::execute(connection, "DELETE FROM test WHERE id % 3 = 0");
+            REQUIRE(scan(connection) == (5000 - 1666) * 300);
+            REQUIRE(integrity(connection) == "ok");
+
+            // Reopening reads everything from the file again.
+            sqlite::dbconnection reopened = open_with(filename, vfs.name());
+            REQUIRE(scan(reopened) == (5000 - 1666) * 300);
+        }
+    }
+
+    SECTION("Direct reads see writes of other connections") {
+        sqlite::linux_vfs_options options;
+        options.direct_io = true;
+        sqlite::linux_vfs vfs("test-linux-direct", options);
+
+        for (const std::string mode : {"DELETE", "WAL"}) {
+            std::filesystem::remove(filename);
+            sqlite::dbconnection writer(filename);
+            sqlite::statement(writer, "PRAGMA journal_mode=" + mode).step();
+            fill(writer, 1000);
+
+            sqlite::dbconnection reader = open_with(filename, vfs.name());
+            REQUIRE(scan(reader) == 1000 * 300);
+            fill(writer, 1000);
+            sqlite::execute(writer, "UPDATE test SET value = 'x' WHERE id <= 10");
+            REQUIRE(scan(reader) == 1990 * 300 + 10);
+            sqlite::statement(writer, "PRAGMA wal_checkpoint(TRUNCATE)").step();
+            REQUIRE(scan(reader) == 1990 * 300 + 10);
+        }
+    }
+}
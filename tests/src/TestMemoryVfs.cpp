@@ -0,0 +1,113 @@
+#include "catch.hpp"
+#include "SQLiteXX.h"
+#include "TestHelpers.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Sharing an in memory database between connections", "[MemoryVfs]") {
+    SECTION("Connections with the same name share the database") {
+        sqlite::dbconnection writer = sqlite::dbconnection::shared_memory("shared");
+        sqlite::dbconnection reader = sqlite::dbconnection::shared_memory("shared");
+        sqlite::dbconnection other = sqlite::dbconnection::shared_memory("other");
+
+        sqlite::execute(writer, "CREATE TABLE test (id INTEGER PRIMARY KEY, value TEXT)");
+        sqlite::execute(writer, "INSERT INTO test (value) VALUES ('a'), ('b')");
+        REQUIRE(count_rows(reader) == 2);
+        REQUIRE_THROWS_AS(count_rows(other), sqlite::exception);
+    }
+
+    SECTION("The database is freed with the last connection") {
+        {
+            sqlite::dbconnection first = sqlite::dbconnection::shared_memory("freed");
+            sqlite::execute(first, "CREATE TABLE test (id INTEGER PRIMARY KEY)");
+            {
+                sqlite::dbconnection second = sqlite::dbconnection::shared_memory("freed");
+                REQUIRE(count_rows(second) == 0);
+            }
+            REQUIRE(sqlite::memory_vfs_contains("freed"));
+        }
+        REQUIRE_FALSE(sqlite::memory_vfs_contains("freed"));
+
+        REQUIRE_THROWS_AS(sqlite::dbconnection::shared_memory("freed", sqlite::openmode::read_write), sqlite::exception);
+    }
+
+    SECTION("Rollback journal locking") {
+        sqlite::dbconnection writer = sqlite::dbconnection::shared_memory("journal", sqlite::openmode::read_write | sqlite::openmode::create, std::chrono::milliseconds(0));
+        sqlite::dbconnection reader = sqlite::dbconnection::shared_memory("journal", sqlite::openmode::read_write | sqlite::openmode::create, std::chrono::milliseconds(0));
+        sqlite::execute(writer, "CREATE TABLE test (id INTEGER PRIMARY KEY, value TEXT)");
+        sqlite::execute(writer, "INSERT INTO test (value) VALUES ('a')");
+
+        sqlite::execute(reader, "BEGIN");
+        REQUIRE(count_rows(reader) == 1);
+        // The reader holds a SHARED lock, so the writer can not commit.
+        sqlite::execute(writer, "BEGIN");
+        sqlite::execute(writer, "INSERT INTO test (value) VALUES ('b')");
+        REQUIRE_THROWS_AS(sqlite::execute(writer, "COMMIT"), sqlite::exception);
+        sqlite::execute(reader, "COMMIT");
+        REQUIRE_NOTHROW(sqlite::execute(writer, "COMMIT"));
+        REQUIRE(count_rows(reader) == 2);
+    }
+
+    SECTION("WAL readers see a snapshot while a writer commits") {
+        sqlite::dbconnection writer = sqlite::dbconnection::shared_memory("wal");
+        sqlite::dbconnection reader = sqlite::dbconnection::shared_memory("wal");
+
+        {
+            sqlite::statement mode(writer, "PRAGMA journal_mode=WAL");
+            REQUIRE(mode.step() == true);
+            REQUIRE(mode.get_string(0) == "wal");
+        }
+
+        sqlite::execute(writer, "CREATE TABLE test (id INTEGER PRIMARY KEY, value TEXT)");
+        sqlite::execute(writer, "INSERT INTO test (value) VALUES ('a')");
+
+        sqlite::execute(reader, "BEGIN");
+        REQUIRE(count_rows(reader) == 1);
+        sqlite::execute(writer, "INSERT INTO test (value) VALUES ('b')");
+        REQUIRE(count_rows(reader) == 1);
+        sqlite::execute(reader, "COMMIT");
+        REQUIRE(count_rows(reader) == 2);
+    }
+
+    SECTION("WAL readers run concurrently with a writer") {
+        sqlite::dbconnection setup = sqlite::dbconnection::shared_memory("concurrent");
+        sqlite::statement(setup, "PRAGMA journal_mode=WAL").step();
+        sqlite::execute(setup, "CREATE TABLE test (id INTEGER PRIMARY KEY, value TEXT)");
+
+        const int rows = 500;
+        std::atomic<bool> done(false);
+        std::atomic<int> failures(0);
+        std::vector<std::thread> readers;
+        for (int i = 0; i < 3; ++i) {
+            readers.emplace_back([&]() {
+                sqlite::dbconnection connection = sqlite::dbconnection::shared_memory("concurrent");
+                int last = 0;
+                while (!done) {
+                    const int current = count_rows(connection);
+                    if (current < last) {
+                        ++failures;
+                    }
+                    last = current;
+                }
+            });
+        }
+
+        std::thread writer([&]() {
+            sqlite::dbconnection connection = sqlite::dbconnection::shared_memory("concurrent");
+            for (int i = 0; i < rows; ++i) {
+                sqlite::execute(connection, "INSERT INTO test (value) VALUES (?)", std::to_string(i));
+            }
+            done = true;
+        });
+
+        writer.join();
+        for (std::thread& reader : readers) {
+            reader.join();
+        }
+        REQUIRE(failures == 0);
+        REQUIRE(count_rows(setup) == rows);
+    }
+}
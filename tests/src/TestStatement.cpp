@@ -1,6 +1,8 @@
 #include "catch.hpp"
 #include "SQLiteXX.h"
 
+#include <cstring>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
@@ -446,3 +448,92 @@ TEST_CASE("UTF16 Support", "[Statement]") {
     REQUIRE(query.get_u16string(1) == u"second");
     REQUIRE(query.get_double(2) == 2.0);
 }
+
+TEST_CASE("Binding owned values", "[Statement]") {
+    sqlite::dbconnection connection = sqlite::dbconnection::memory();
+    REQUIRE(sqlite::execute(connection, "CREATE TABLE test (id INTEGER PRIMARY KEY, value)") == 0);
+
+    sqlite::statement insert(connection, "INSERT INTO test VALUES (NULL, ?)");
+    sqlite::statement query(connection, "SELECT value FROM test ORDER BY id DESC LIMIT 1");
+
+    SECTION("Moved string") {
+        std::string value(4096, 'x');
+        insert.bind(1, std::move(value));
+        REQUIRE(insert.execute() == 1);
+
+        // The bound value must stay alive across a reset.
+        insert.reset();
+        REQUIRE(insert.execute() == 1);
+
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_type(0) == sqlite::datatype::text);
+        REQUIRE(query.get_string(0) == std::string(4096, 'x'));
+    }
+
+    SECTION("Moved byte vector") {
+        std::vector<uint8_t> value = {0, 1, 2, 3, 4};
+        insert.bind(1, std::move(value));
+        REQUIRE(insert.execute() == 1);
+
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_type(0) == sqlite::datatype::blob);
+        REQUIRE(query.get_bytes(0) == 5);
+        const sqlite::blob result = query.get_blob(0);
+        REQUIRE(memcmp(result.data(), "\0\1\2\3\4", 5) == 0);
+    }
+
+    SECTION("Moved blob") {
+        insert.bind(1, sqlite::blob("bl\0b", 4));
+        REQUIRE(insert.execute() == 1);
+
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_type(0) == sqlite::datatype::blob);
+        REQUIRE(query.get_bytes(0) == 4);
+    }
+
+    SECTION("Buffer handed to SQLite") {
+        std::unique_ptr<char[]> text(new char[5]);
+        memcpy(text.get(), "hello", 5);
+        insert.bind(1, std::move(text), 5, sqlite::datatype::text);
+        REQUIRE(insert.execute() == 1);
+
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_type(0) == sqlite::datatype::text);
+        REQUIRE(query.get_string(0) == std::string("hello"));
+
+        query.reset();
+        insert.reset();
+        std::unique_ptr<char[]> buffer(new char[3]);
+        memcpy(buffer.get(), "abc", 3);
+        insert.bind(1, std::move(buffer), 3);
+        REQUIRE(insert.execute() == 1);
+
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_type(0) == sqlite::datatype::blob);
+        REQUIRE(query.get_bytes(0) == 3);
+    }
+
+    SECTION("Buffer with invalid type") {
+        std::unique_ptr<char[]> buffer(new char[3]);
+        REQUIRE_THROWS_AS(insert.bind(1, std::move(buffer), 3, sqlite::datatype::integer), sqlite::SQLiteXXException);
+    }
+
+    SECTION("Owned value bound to an invalid index") {
+        REQUIRE_THROWS_AS(insert.bind(2, std::string("two")), sqlite::exception);
+
+        std::unique_ptr<char[]> buffer(new char[3]);
+        REQUIRE_THROWS_AS(insert.bind(2, std::move(buffer), 3), sqlite::exception);
+    }
+
+    SECTION("Owned values through bind_all and clear_bindings") {
+        insert.bind_all(std::string("first"));
+        REQUIRE(insert.execute() == 1);
+
+        insert.reset();
+        insert.clear_bindings();
+        REQUIRE(insert.execute() == 1);
+
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_type(0) == sqlite::datatype::null);
+    }
+}
@@ -0,0 +1,74 @@
+#include "catch.hpp"
+#include "SQLiteXX.h"
+
+#include <string>
+
+TEST_CASE("Connection status counters", "[Status]") {
+    sqlite::dbconnection connection = sqlite::dbconnection::memory();
+
+    REQUIRE(sqlite::execute(connection, "CREATE TABLE test (id INTEGER PRIMARY KEY, value TEXT)") == 0);
+    for (int i = 0; i < 100; ++i) {
+        REQUIRE(sqlite::execute(connection, "INSERT INTO test VALUES (NULL, ?)", std::to_string(i)) == 1);
+    }
+
+    SECTION("Snapshot reports memory usage") {
+        sqlite::statement query(connection, "SELECT * FROM test");
+        REQUIRE(query.step() == true);
+
+        sqlite::dbconnection::status_counters status = connection.status();
+        REQUIRE(status.cache_used > 0);
+        REQUIRE(status.schema_used > 0);
+        REQUIRE(status.stmt_used > 0);
+        REQUIRE(status.deferred_fks == 0);
+    }
+
+    SECTION("Reset on read returns deltas") {
+        for (auto row : sqlite::statement(connection, "SELECT * FROM test")) {
+            (void)row;
+        }
+
+        sqlite::dbconnection::status_counters first = connection.status(true);
+        REQUIRE(first.cache_hit > 0);
+
+        sqlite::dbconnection::status_counters second = connection.status(true);
+        REQUIRE(second.cache_hit == 0);
+        REQUIRE(second.cache_miss == 0);
+        REQUIRE(second.cache_write == 0);
+
+        for (auto row : sqlite::statement(connection, "SELECT * FROM test")) {
+            (void)row;
+        }
+
+        sqlite::dbconnection::status_counters third = connection.status();
+        REQUIRE(third.cache_hit > 0);
+    }
+
+    SECTION("Deferred foreign keys") {
+        REQUIRE_NOTHROW(sqlite::execute(connection, "PRAGMA foreign_keys = ON"));
+        REQUIRE_NOTHROW(sqlite::execute(connection, "CREATE TABLE child (parent INTEGER REFERENCES test(id) DEFERRABLE INITIALLY DEFERRED)"));
+        REQUIRE_NOTHROW(sqlite::execute(connection, "BEGIN"));
+        REQUIRE(sqlite::execute(connection, "INSERT INTO child VALUES (1000)") == 1);
+
+        REQUIRE(connection.status().deferred_fks != 0);
+
+        REQUIRE_NOTHROW(sqlite::execute(connection, "ROLLBACK"));
+        REQUIRE(connection.status().deferred_fks == 0);
+    }
+}
+
+TEST_CASE("Global status counters", "[Status]") {
+    sqlite::dbconnection connection = sqlite::dbconnection::memory();
+    REQUIRE(sqlite::execute(connection, "CREATE TABLE test (id INTEGER PRIMARY KEY, value TEXT)") == 0);
+
+    sqlite::library_status status = sqlite::global_status();
+    REQUIRE(status.memory_used.current > 0);
+    REQUIRE(status.memory_used.highwater >= status.memory_used.current);
+    REQUIRE(status.malloc_count.current > 0);
+    REQUIRE(status.malloc_size.highwater > 0);
+
+    SECTION("Reset on read lowers highwater marks") {
+        sqlite::global_status(true);
+        sqlite::library_status afterReset = sqlite::global_status();
+        REQUIRE(afterReset.memory_used.highwater <= status.memory_used.highwater);
+    }
+}
@@ -4,6 +4,7 @@
 #include <cstdio>
 #include <iostream>
 #include <mutex>
+#include <set>
 #include <string>
 #include <thread>
 #include <vector>
@@ -327,3 +328,38 @@ TEST_CASE("Thread-local connection different transactions", "[Threading]") {
         }
     }
 }
+
+TEST_CASE("Sharing a memoized function between threads", "[Threading]") {
+    sqlite::dbconnection connection(":memory:", sqlite::openmode::read_write | sqlite::openmode::create | sqlite::openmode::full_mutex);
+
+    REQUIRE_NOTHROW(sqlite::execute(connection, "CREATE TABLE test (num INT)"));
+    REQUIRE(sqlite::execute(
+        connection,
+        "WITH RECURSIVE series(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM series WHERE x < 1000) "
+        "INSERT INTO test SELECT x % 50 FROM series") == 1000);
+
+    std::shared_ptr<const sqlite::memoization_counters> counters =
+        connection.create_memoized_function("square", [](int64_t x) -> int64_t { return x * x; }, 16);
+
+    std::vector<std::thread> threadpool;
+    std::vector<int64_t> sums(kNumberOfThreads, 0);
+    for (size_t i = 0; i < kNumberOfThreads; ++i) {
+        threadpool.push_back(std::thread([&connection, &sums, i]() {
+            for (int run = 0; run < 10; ++run) {
+                sqlite::statement query(connection, "SELECT sum(square(num)) FROM test");
+                query.step();
+                sums[i] += query.get_int64(0);
+            }
+        }));
+    }
+    for (size_t i = 0; i < threadpool.size(); ++i) {
+        threadpool[i].join();
+    }
+
+    sqlite::statement expected(connection, "SELECT sum(num * num) FROM test");
+    REQUIRE(expected.step() == true);
+    for (size_t i = 0; i < kNumberOfThreads; ++i) {
+        REQUIRE(sums[i] == 10 * expected.get_int64(0));
+    }
+    REQUIRE(counters->hits + counters->misses == 1000 * 10 * kNumberOfThreads);
+}
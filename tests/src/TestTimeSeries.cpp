@@ -0,0 +1,178 @@
+#include "catch.hpp"
+#include "SQLiteXX.h"
+#include "TestHelpers.h"
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+static std::vector<sqlite::timeseries_column> metric_columns() {
+    return {{"value", sqlite::datatype::floating}, {"count", sqlite::datatype::integer}};
+}
+
+static std::string plan_of(const sqlite::dbconnection& connection, const std::string& sql) {
+    std::string plan;
+    for (auto row : sqlite::statement(connection, "EXPLAIN QUERY PLAN " + sql)) {
+        plan += row.get_string(3) + "\n";
+    }
+    return plan;
+}
+
+TEST_CASE("Querying a time series", "[TimeSeries]") {
+    const std::string directory = fresh_directory("SQLiteXXTimeSeries");
+    std::shared_ptr<sqlite::timeseries_store> store = std::make_shared<sqlite::timeseries_store>(directory, metric_columns(), 100);
+
+    // Times 0, 10, 20, ... over ten segments, with every time appearing twice from 5000 on.
+    std::vector<int64_t> times;
+    std::vector<double> values;
+    std::vector<int64_t> counts;
+    for (int64_t i = 0; i < 1000; ++i) {
+        times.push_back(i < 500 ? i * 10 : 5000 + (i - 500) / 2 * 10);
+        values.push_back(i * 0.5);
+        counts.push_back(i);
+    }
+    REQUIRE_NOTHROW(store->append(times.size(), times.data(), {values.data(), counts.data()}));
+    REQUIRE(store->row_count() == 1000);
+
+    sqlite::dbconnection connection = sqlite::dbconnection::memory();
+    REQUIRE_NOTHROW(connection.create_timeseries_module("metrics", store));
+    sqlite::execute(connection, "CREATE VIRTUAL TABLE temp.metrics USING metrics");
+
+    SECTION("Full scan") {
+        sqlite::statement query(connection, "SELECT count(*), sum(count), typeof(time), typeof(value), typeof(count) FROM metrics");
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_int(0) == 1000);
+        REQUIRE(query.get_int(1) == 499500);
+        REQUIRE(query.get_string(2) == "integer");
+        REQUIRE(query.get_string(3) == "real");
+        REQUIRE(query.get_string(4) == "integer");
+    }
+
+    SECTION("Time ranges") {
+        sqlite::statement query(connection, "SELECT count(*), min(count), max(count) FROM metrics WHERE time >= ? AND time < ?", 990, 1500);
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_int(0) == 51);
+        REQUIRE(query.get_int(1) == 99);
+        REQUIRE(query.get_int(2) == 149);
+
+        sqlite::statement spanning(connection, "SELECT count(*) FROM metrics WHERE time > 4990.5 AND time <= 5010");
+        REQUIRE(spanning.step() == true);
+        REQUIRE(spanning.get_int(0) == 4);
+
+        sqlite::statement equal(connection, "SELECT count, rowid FROM metrics WHERE time = 5020");
+        REQUIRE(equal.step() == true);
+        REQUIRE(equal.get_int(0) == 504);
+        REQUIRE(equal.get_int(1) == 505);
+        REQUIRE(equal.step() == true);
+        REQUIRE(equal.get_int(0) == 505);
+        REQUIRE(equal.step() == false);
+
+        sqlite::statement empty(connection, "SELECT count(*) FROM metrics WHERE time > 20000 OR time < -1 OR time = 15");
+        REQUIRE(empty.step() == true);
+        REQUIRE(empty.get_int(0) == 0);
+    }
+
+    SECTION("Ordering by time needs no sorting") {
+        REQUIRE(plan_of(connection, "SELECT time FROM metrics WHERE time < 100 ORDER BY time").find("ORDER BY") == std::string::npos);
+        REQUIRE(plan_of(connection, "SELECT time FROM metrics ORDER BY time DESC").find("ORDER BY") != std::string::npos);
+    }
+
+    SECTION("Appending while a table is in use") {
+        store->append_row(20000, 1.5, 7);
+        store->append_row(20001, 2, 8.9);
+        sqlite::statement query(connection, "SELECT value, count FROM metrics WHERE time >= 20000");
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_double(0) == 1.5);
+        REQUIRE(query.get_int(1) == 7);
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_double(0) == 2.0);
+        REQUIRE(query.get_int(1) == 8);
+        REQUIRE(query.step() == false);
+    }
+
+    SECTION("Rows have to be appended in time order") {
+        REQUIRE_THROWS_AS(store->append_row(10, 1.0, 1), sqlite::SQLiteXXException);
+        const int64_t unordered[] = {30000, 29999};
+        const double twoValues[] = {1.0, 2.0};
+        const int64_t twoCounts[] = {1, 2};
+        REQUIRE_THROWS_AS(store->append(2, unordered, {twoValues, twoCounts}), sqlite::SQLiteXXException);
+        REQUIRE_THROWS_AS(store->append_row(30000, 1.0), sqlite::SQLiteXXException);
+        REQUIRE(store->row_count() == 1000);
+    }
+
+    connection = sqlite::dbconnection();
+    store.reset();
+    std::filesystem::remove_all(directory);
+}
+
+TEST_CASE("Reopening a time series", "[TimeSeries]") {
+    const std::string directory = fresh_directory("SQLiteXXTimeSeriesReopen");
+    {
+        sqlite::timeseries_store store(directory, metric_columns(), 16);
+        for (int64_t i = 0; i < 40; ++i) {
+            store.append_row(i, i * 1.5, i);
+        }
+        store.flush();
+    }
+
+    REQUIRE_THROWS_AS(sqlite::timeseries_store(directory, metric_columns(), 32), sqlite::SQLiteXXException);
+    REQUIRE_THROWS_AS(sqlite::timeseries_store(directory, {{"value", sqlite::datatype::floating}}, 16), sqlite::SQLiteXXException);
+    REQUIRE_THROWS_AS(sqlite::timeseries_store(directory, {{"name", sqlite::datatype::text}}, 16), sqlite::SQLiteXXException);
+
+    {
+        sqlite::timeseries_store store(directory, metric_columns(), 16);
+        REQUIRE(store.row_count() == 40);
+        store.append_row(40, 60.0, 40);
+        REQUIRE(store.row_count() == 41);
+        REQUIRE_THROWS_AS(store.append_row(39, 0.0, 0), sqlite::SQLiteXXException);
+    }
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST_CASE("Failed appends add no rows", "[TimeSeries]") {
+    const std::string directory = fresh_directory("SQLiteXXTimeSeriesFailedAppend");
+    sqlite::timeseries_store store(directory, metric_columns(), 16);
+    for (int64_t i = 0; i < 10; ++i) {
+        store.append_row(i, i * 1.5, i);
+    }
+
+    // 30 more rows need the segments 2 and 3, and a directory in place of segment 3 can not be mapped.
+    std::filesystem::create_directories(directory + "/segment-000003.ts");
+    std::vector<int64_t> times;
+    std::vector<double> values;
+    std::vector<int64_t> counts;
+    for (int64_t i = 10; i < 40; ++i) {
+        times.push_back(i);
+        values.push_back(i * 1.5);
+        counts.push_back(i);
+    }
+    REQUIRE_THROWS_AS(store.append(times.size(), times.data(), {values.data(), counts.data()}), sqlite::SQLiteXXException);
+    REQUIRE(store.row_count() == 10);
+    REQUIRE_FALSE(std::filesystem::exists(directory + "/segment-000002.ts"));
+
+    std::filesystem::remove_all(directory + "/segment-000003.ts");
+    REQUIRE_NOTHROW(store.append(times.size(), times.data(), {values.data(), counts.data()}));
+    REQUIRE(store.row_count() == 40);
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST_CASE("Time series column names are quoted", "[TimeSeries]") {
+    const std::string directory = fresh_directory("SQLiteXXTimeSeriesQuoted");
+    std::shared_ptr<sqlite::timeseries_store> store = std::make_shared<sqlite::timeseries_store>(
+        directory, std::vector<sqlite::timeseries_column>({{"say \"hi\"", sqlite::datatype::integer}}), 16);
+    store->append_row(1, 42);
+
+    sqlite::dbconnection connection = sqlite::dbconnection::memory();
+    connection.create_timeseries_module("quoted", store);
+    sqlite::execute(connection, "CREATE VIRTUAL TABLE temp.quoted USING quoted");
+    sqlite::statement query(connection, "SELECT \"say \"\"hi\"\"\" FROM quoted");
+    REQUIRE(query.step() == true);
+    REQUIRE(query.get_int(0) == 42);
+
+    connection = sqlite::dbconnection();
+    store.reset();
+    std::filesystem::remove_all(directory);
+}
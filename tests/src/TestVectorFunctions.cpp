@@ -0,0 +1,124 @@
+#include "catch.hpp"
+#include "SQLiteXX.h"
+
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static sqlite::blob to_blob(const std::vector<float>& values) {
+    return sqlite::blob(values.data(), static_cast<int>(values.size() * sizeof(float)));
+}
+
+static double reference_dot(const std::vector<float>& a, const std::vector<float>& b) {
+    double sum = 0.0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        sum += static_cast<double>(a[i]) * b[i];
+    }
+    return sum;
+}
+
+static double reference_l2(const std::vector<float>& a, const std::vector<float>& b) {
+    double sum = 0.0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        const double difference = static_cast<double>(a[i]) - b[i];
+        sum += difference * difference;
+    }
+    return std::sqrt(sum);
+}
+
+static std::vector<float> make_vector(const size_t size, const int seed) {
+    std::vector<float> values(size);
+    for (size_t i = 0; i < size; ++i) {
+        values[i] = static_cast<float>(((static_cast<int>(i) * 37 + seed * 11) % 101) - 50) / 25.0f;
+    }
+    return values;
+}
+
+static std::vector<sqlite::vector_isa> supported_isas() {
+    std::vector<sqlite::vector_isa> isas = {sqlite::vector_isa::scalar};
+    for (sqlite::vector_isa isa : {sqlite::vector_isa::sse2, sqlite::vector_isa::avx2, sqlite::vector_isa::avx512}) {
+        if (static_cast<int>(isa) <= static_cast<int>(sqlite::supported_vector_isa())) {
+            isas.push_back(isa);
+        }
+    }
+    return isas;
+}
+
+TEST_CASE("Vector functions", "[VectorFunctions]") {
+    sqlite::dbconnection connection = sqlite::dbconnection::memory();
+    REQUIRE_NOTHROW(connection.create_vector_functions());
+    const sqlite::vector_isa original = sqlite::active_vector_isa();
+
+    SECTION("Results match a double precision reference for every instruction set") {
+        sqlite::statement query(connection, "SELECT vec_dot(?1, ?2), vec_l2(?1, ?2), vec_cosine(?1, ?2), vec_norm(?1)");
+
+        for (sqlite::vector_isa isa : supported_isas()) {
+            sqlite::use_vector_isa(isa);
+            // Sizes around the 4, 8 and 16 float widths of the kernels exercise every tail.
+            for (size_t size : {1, 3, 4, 7, 8, 15, 16, 17, 31, 33, 128, 1000}) {
+                const std::vector<float> a = make_vector(size, 1);
+                const std::vector<float> b = make_vector(size, 2);
+
+                query.reset();
+                query.bind(1, to_blob(a));
+                query.bind(2, to_blob(b));
+                REQUIRE(query.step() == true);
+
+                const double dot = reference_dot(a, b);
+                const double normA = std::sqrt(reference_dot(a, a));
+                const double normB = std::sqrt(reference_dot(b, b));
+                REQUIRE(query.get_double(0) == Approx(dot).epsilon(1e-4).margin(1e-3));
+                REQUIRE(query.get_double(1) == Approx(reference_l2(a, b)).epsilon(1e-4));
+                REQUIRE(query.get_double(2) == Approx(dot / (normA * normB)).epsilon(1e-4).margin(1e-4));
+                REQUIRE(query.get_double(3) == Approx(normA).epsilon(1e-4));
+            }
+        }
+    }
+
+    SECTION("Unaligned blobs") {
+        // A statically bound blob is read in place, so starting it one byte into a buffer misaligns it.
+        std::vector<unsigned char> bytes(1 + 33 * sizeof(float));
+        const std::vector<float> a = make_vector(33, 3);
+        std::memcpy(bytes.data() + 1, a.data(), a.size() * sizeof(float));
+
+        sqlite::statement query(connection, "SELECT vec_dot(?1, ?1)");
+        query.bind(1, bytes.data() + 1, static_cast<int>(a.size() * sizeof(float)), sqlite::bindtype::statically);
+        for (sqlite::vector_isa isa : supported_isas()) {
+            sqlite::use_vector_isa(isa);
+            query.reset();
+            REQUIRE(query.step() == true);
+            REQUIRE(query.get_double(0) == Approx(reference_dot(a, a)).epsilon(1e-4));
+        }
+    }
+
+    SECTION("NULL and zero vectors") {
+        const std::vector<float> zero(8, 0.0f);
+        sqlite::statement query(connection, "SELECT vec_dot(NULL, ?1), vec_norm(NULL), vec_cosine(?1, ?1), vec_norm(?1)");
+        query.bind(1, to_blob(zero));
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_type(0) == sqlite::datatype::null);
+        REQUIRE(query.get_type(1) == sqlite::datatype::null);
+        REQUIRE(query.get_type(2) == sqlite::datatype::null);
+        REQUIRE(query.get_double(3) == 0.0);
+    }
+
+    SECTION("Invalid vectors") {
+        sqlite::statement mismatched(connection, "SELECT vec_dot(?1, ?2)");
+        mismatched.bind(1, to_blob(make_vector(4, 1)));
+        mismatched.bind(2, to_blob(make_vector(5, 1)));
+        REQUIRE_THROWS_AS(mismatched.step(), sqlite::exception);
+
+        sqlite::statement partial(connection, "SELECT vec_norm(x'010203')");
+        REQUIRE_THROWS_AS(partial.step(), sqlite::exception);
+    }
+
+    sqlite::use_vector_isa(original);
+}
+
+TEST_CASE("Selecting an unsupported vector instruction set", "[VectorFunctions]") {
+    if (sqlite::supported_vector_isa() != sqlite::vector_isa::avx512) {
+        REQUIRE_THROWS_AS(sqlite::use_vector_isa(sqlite::vector_isa::avx512), sqlite::SQLiteXXException);
+    }
+    REQUIRE(sqlite::active_vector_isa() == sqlite::supported_vector_isa());
+}
@@ -0,0 +1,321 @@
+#include "catch.hpp"
+#include "SQLiteXX.h"
+
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+// Numbers from 1 to a limit given as module argument, with equality on the value pushed down.
+class NumbersTable {
+    public:
+    explicit NumbersTable(const std::vector<std::string>& arguments) :
+        m_limit(arguments.empty() ? 10 : std::stoll(arguments[0]))
+    {
+        if (m_limit < 0) {
+            throw std::invalid_argument("limit must not be negative");
+        }
+    }
+
+    std::string schema() const {
+        return "CREATE TABLE x(value INTEGER)";
+    }
+
+    void best_index(sqlite::index_info& info) const {
+        info.set_estimated_cost(static_cast<double>(m_limit));
+        for (int i = 0; i < info.constraint_count(); ++i) {
+            const sqlite::index_info::constraint term = info.get_constraint(i);
+            if (term.usable && term.column == 0 && term.op == sqlite::constraint_op::eq) {
+                info.use_constraint(i, 0);
+                info.set_index_number(1);
+                info.set_estimated_cost(1);
+                break;
+            }
+        }
+    }
+
+    class cursor {
+        public:
+        explicit cursor(const NumbersTable& table) :
+            m_table(&table),
+            m_current(0),
+            m_last(0)
+        {}
+
+        void filter(int index_number, std::string_view, sqlite::value_span arguments) {
+            m_current = 1;
+            m_last = m_table->m_limit;
+            if (index_number == 1) {
+                const int64_t wanted = arguments[0].as_int64();
+                m_current = std::max<int64_t>(wanted, 1);
+                m_last = std::min(wanted, m_last);
+            }
+        }
+
+        void next() {
+            ++m_current;
+        }
+
+        bool eof() const {
+            return m_current > m_last;
+        }
+
+        void column(sqlite3_context* context, int) const {
+            sqlite::return_result(context, m_current);
+        }
+
+        int64_t rowid() const {
+            return m_current;
+        }
+
+        private:
+        const NumbersTable* m_table;
+        int64_t m_current;
+        int64_t m_last;
+    };
+
+    cursor open() const {
+        return cursor(*this);
+    }
+
+    private:
+    int64_t m_limit;
+};
+
+TEST_CASE("Creating a virtual table module", "[VirtualTable]") {
+    sqlite::dbconnection connection = sqlite::dbconnection::memory();
+    REQUIRE_NOTHROW(connection.create_module<NumbersTable>("numbers"));
+
+    SECTION("Module arguments") {
+        REQUIRE_NOTHROW(sqlite::execute(connection, "CREATE VIRTUAL TABLE temp.hundred USING numbers(100)"));
+        sqlite::statement query(connection, "SELECT count(*), sum(value) FROM hundred");
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_int(0) == 100);
+        REQUIRE(query.get_int(1) == 5050);
+    }
+
+    SECTION("Constraint pushdown") {
+        REQUIRE_NOTHROW(sqlite::execute(connection, "CREATE VIRTUAL TABLE temp.hundred USING numbers(100)"));
+        sqlite::statement query(connection, "SELECT value FROM hundred WHERE value = ?", 42);
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_int(0) == 42);
+        REQUIRE(query.step() == false);
+    }
+
+    SECTION("Exceptions become errors") {
+        REQUIRE_THROWS_AS(sqlite::execute(connection, "CREATE VIRTUAL TABLE temp.broken USING numbers(-1)"), sqlite::exception);
+    }
+}
+
+struct Person {
+    int64_t id;
+    std::string name;
+    double height;
+    int age;
+};
+
+static std::string plan_of(const sqlite::dbconnection& connection, const std::string& sql) {
+    std::string plan;
+    for (auto row : sqlite::statement(connection, "EXPLAIN QUERY PLAN " + sql)) {
+        plan += row.get_string(3) + "\n";
+    }
+    return plan;
+}
+
+TEST_CASE("Exposing a range as a virtual table", "[VirtualTable]") {
+    sqlite::dbconnection connection = sqlite::dbconnection::memory();
+
+    std::vector<Person> people;
+    for (int i = 0; i < 1000; ++i) {
+        people.push_back(Person{i * 2, "person" + std::to_string(i), 1.5 + i / 1000.0, 20 + i % 50});
+    }
+
+    REQUIRE_NOTHROW(connection.create_range_module("people", people, {
+        {"id", &Person::id, true},
+        {"name", &Person::name},
+        {"height", &Person::height, true},
+        {"age", &Person::age},
+        {"label", [](const Person& person) { return person.name + "!"; }},
+        {"initial", [](const Person& person) { return std::string_view(person.name).substr(0, 1); }}
+    }));
+    REQUIRE_NOTHROW(sqlite::execute(connection, "CREATE VIRTUAL TABLE temp.people USING people"));
+
+    SECTION("Full scan") {
+        sqlite::statement query(connection, "SELECT count(*), sum(age), min(name), max(label) FROM people");
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_int(0) == 1000);
+        int64_t ages = 0;
+        for (const Person& person : people) {
+            ages += person.age;
+        }
+        REQUIRE(query.get_int64(1) == ages);
+        REQUIRE(query.get_string(2) == "person0");
+        REQUIRE(query.get_string(3) == "person999!");
+    }
+
+    SECTION("Equality on a sorted column uses binary search") {
+        const std::string sql = "SELECT name, initial, rowid FROM people WHERE id = 500";
+        REQUIRE(plan_of(connection, sql).find("INDEX 2:e") != std::string::npos);
+
+        sqlite::statement query(connection, sql);
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_string(0) == "person250");
+        REQUIRE(query.get_string(1) == "p");
+        REQUIRE(query.get_int(2) == 250);
+        REQUIRE(query.step() == false);
+
+        sqlite::statement missing(connection, "SELECT count(*) FROM people WHERE id = 501");
+        REQUIRE(missing.step() == true);
+        REQUIRE(missing.get_int(0) == 0);
+    }
+
+    SECTION("Ranges on sorted columns") {
+        sqlite::statement query(connection, "SELECT count(*), min(id), max(id) FROM people WHERE id > 10 AND id <= 20");
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_int(0) == 5);
+        REQUIRE(query.get_int(1) == 12);
+        REQUIRE(query.get_int(2) == 20);
+
+        sqlite::statement real(connection, "SELECT count(*) FROM people WHERE height >= 1.9995");
+        REQUIRE(real.step() == true);
+        REQUIRE(real.get_int(0) == 500);
+
+        // Numeric affinity applies to text values compared with numeric columns.
+        sqlite::statement text(connection, "SELECT count(*) FROM people WHERE id < '10'");
+        REQUIRE(text.step() == true);
+        REQUIRE(text.get_int(0) == 5);
+
+        sqlite::statement null(connection, "SELECT count(*) FROM people WHERE id > NULL");
+        REQUIRE(null.step() == true);
+        REQUIRE(null.get_int(0) == 0);
+    }
+
+    SECTION("Rowid lookups") {
+        sqlite::statement query(connection, "SELECT id FROM people WHERE rowid = 999");
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_int(0) == 1998);
+        REQUIRE(query.step() == false);
+
+        sqlite::statement range(connection, "SELECT count(*) FROM people WHERE rowid >= 995.5 AND rowid < 2000");
+        REQUIRE(range.step() == true);
+        REQUIRE(range.get_int(0) == 4);
+    }
+
+    SECTION("ORDER BY on sorted columns needs no sorting") {
+        const std::string sql = "SELECT id FROM people WHERE id < 10 ORDER BY id DESC";
+        REQUIRE(plan_of(connection, sql).find("ORDER BY") == std::string::npos);
+
+        std::vector<int> ids;
+        for (auto row : sqlite::statement(connection, sql)) {
+            ids.push_back(row.get_int(0));
+        }
+        REQUIRE(ids == std::vector<int>({8, 6, 4, 2, 0}));
+
+        REQUIRE(plan_of(connection, "SELECT id FROM people ORDER BY age").find("ORDER BY") != std::string::npos);
+    }
+
+    SECTION("Constraints on other columns are checked by SQLite") {
+        sqlite::statement query(connection, "SELECT count(*) FROM people WHERE age = 20 AND name LIKE 'PERSON1%'");
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_int(0) == 2);
+    }
+}
+
+TEST_CASE("Creating a table-valued function", "[VirtualTable]") {
+    sqlite::dbconnection connection = sqlite::dbconnection::memory();
+
+    REQUIRE_NOTHROW(connection.create_table_function("split", {"part"}, [](const std::string& text, const std::string& separator) {
+        std::vector<std::string> parts;
+        std::string::size_type start = 0;
+        std::string::size_type end;
+        while ((end = text.find(separator, start)) != std::string::npos) {
+            parts.push_back(text.substr(start, end - start));
+            start = end + separator.size();
+        }
+        parts.push_back(text.substr(start));
+        return parts;
+    }, {"text", "separator"}));
+
+    std::shared_ptr<int> generated = std::make_shared<int>(0);
+    REQUIRE_NOTHROW(connection.create_table_function("series", {"value", "square"}, [generated](int64_t first, int64_t last) {
+        return [generated, current = first, last]() mutable -> std::optional<std::tuple<int64_t, double>> {
+            if (current > last) {
+                return std::nullopt;
+            }
+            ++*generated;
+            const int64_t value = current++;
+            return std::make_tuple(value, static_cast<double>(value) * value);
+        };
+    }));
+
+    SECTION("Splitting text") {
+        std::vector<std::string> parts;
+        for (auto row : sqlite::statement(connection, "SELECT part FROM split(?, ',')", "a,bb,,c")) {
+            parts.push_back(row.get_string(0));
+        }
+        REQUIRE(parts == std::vector<std::string>({"a", "bb", "", "c"}));
+    }
+
+    SECTION("Arguments are hidden columns") {
+        sqlite::statement query(connection, "SELECT part, text, separator FROM split WHERE text = 'x-y' AND separator = '-'");
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_string(0) == "x");
+        REQUIRE(query.get_string(1) == "x-y");
+        REQUIRE(query.get_string(2) == "-");
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_string(0) == "y");
+        REQUIRE(query.step() == false);
+    }
+
+    SECTION("Typed output columns") {
+        sqlite::statement query(connection, "SELECT typeof(value), typeof(square), sum(square) FROM series(1, 10)");
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_string(0) == "integer");
+        REQUIRE(query.get_string(1) == "real");
+        REQUIRE(query.get_double(2) == 385.0);
+    }
+
+    SECTION("Rows are produced lazily") {
+        sqlite::statement query(connection, "SELECT value FROM series(1, 1000000000) LIMIT 3");
+        int rows = 0;
+        while (query.step()) {
+            ++rows;
+        }
+        REQUIRE(rows == 3);
+        REQUIRE(*generated <= 4);
+    }
+
+    SECTION("Arguments from a joined table") {
+        sqlite::execute(connection, "CREATE TABLE lists(id INTEGER PRIMARY KEY, items TEXT)");
+        sqlite::execute(connection, "INSERT INTO lists(items) VALUES('a;b;c'), ('d'), ('e;f')");
+        sqlite::statement query(connection, "SELECT lists.id, count(*) FROM lists, split(lists.items, ';') GROUP BY lists.id ORDER BY lists.id");
+        std::vector<int> counts;
+        while (query.step()) {
+            counts.push_back(query.get_int(1));
+        }
+        REQUIRE(counts == std::vector<int>({3, 1, 2}));
+    }
+
+    SECTION("Missing arguments are errors") {
+        REQUIRE_THROWS_AS(sqlite::execute(connection, "SELECT * FROM split('a,b')"), sqlite::exception);
+    }
+
+    SECTION("Names with quotes") {
+        REQUIRE_NOTHROW(connection.create_table_function("quoted", {"say \"hi\""}, [](const std::string& text) {
+            return std::vector<std::string>({text});
+        }, {"the \"text\""}));
+        sqlite::statement query(connection, "SELECT \"say \"\"hi\"\"\", \"the \"\"text\"\"\" FROM quoted('hello')");
+        REQUIRE(query.step() == true);
+        REQUIRE(query.get_string(0) == "hello");
+        REQUIRE(query.get_string(1) == "hello");
+    }
+
+    SECTION("Names have to match the callable") {
+        REQUIRE_THROWS_AS(connection.create_table_function("pairs", {"only"}, [](int) { return std::vector<std::pair<int, int>>(); }), sqlite::SQLiteXXException);
+        REQUIRE_THROWS_AS(connection.create_table_function("pairs", {"a", "b"}, [](int) { return std::vector<std::pair<int, int>>(); }, {"x", "y"}), sqlite::SQLiteXXException);
+    }
+}
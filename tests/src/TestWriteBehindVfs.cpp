@@ -0,0 +1,230 @@
+#include "catch.hpp"
+#include "SQLiteXX.h"
+#include "TestHelpers.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+static sqlite::dbconnection open_with(const std::string& filename, const std::string& vfs) {
+    return sqlite::dbconnection(filename, sqlite::openmode::read_write | sqlite::openmode::create, std::chrono::seconds(10), vfs);
+}
+
+/** A VFS under the write-behind VFS that fails journal and WAL writes or slows down journal syncs on request. */
+class faulty_vfs : public sqlite::vfs_shim {
+    public:
+    explicit faulty_vfs(std::string name) :
+        sqlite::vfs_shim(std::move(name))
+    {}
+
+    std::atomic<bool> fail_writes{false};
+    std::atomic<int> failed_writes{0};
+    std::atomic<int> sync_delay_ms{0};
+    std::atomic<int> delayed_syncs{0};
+
+    protected:
+    std::unique_ptr<sqlite::vfs_file> wrap(sqlite3_file* file, const char*, const int flags) override {
+        return std::unique_ptr<sqlite::vfs_file>(new faulty_file(file, sqlite::file_kind_of(flags), *this));
+    }
+
+    private:
+    class faulty_file : public sqlite::vfs_file {
+        public:
+        faulty_file(sqlite3_file* base, const sqlite::file_kind kind, faulty_vfs& vfs) :
+            sqlite::vfs_file(base, kind),
+            m_vfs(vfs)
+        {}
+
+        int write(const void* buffer, const int amount, const int64_t offset) override {
+            if (m_vfs.fail_writes && (kind() == sqlite::file_kind::journal || kind() == sqlite::file_kind::wal)) {
+                ++m_vfs.failed_writes;
+                return SQLITE_IOERR_WRITE;
+            }
+            return sqlite::vfs_file::write(buffer, amount, offset);
+        }
+
+        int sync(const int flags) override {
+            if (m_vfs.sync_delay_ms > 0 && kind() == sqlite::file_kind::journal) {
+                ++m_vfs.delayed_syncs;
+                std::this_thread::sleep_for(std::chrono::milliseconds(m_vfs.sync_delay_ms));
+            }
+            return sqlite::vfs_file::sync(flags);
+        }
+
+        private:
+        faulty_vfs& m_vfs;
+    };
+};
+
+TEST_CASE("Writing journals behind", "[WriteBehindVfs]") {
+    const std::string filename = fresh_database("SQLiteXXWriteBehindVfs");
+    sqlite::write_behind_vfs vfs("test-write-behind");
+
+    for (const std::string mode : {"DELETE", "TRUNCATE", "PERSIST", "WAL"}) {
+        SECTION("Journal mode " + mode) {
+            {
+                sqlite::dbconnection connection = open_with(filename, vfs.name());
+                sqlite::statement(connection, "PRAGMA journal_mode=" + mode).step();
+                sqlite::execute(connection, "PRAGMA synchronous=FULL");
+                sqlite::execute(connection, "CREATE TABLE test (id INTEGER PRIMARY KEY, value TEXT)");
+                for (int i = 0; i < 100; ++i) {
+                    sqlite::execute(connection, "INSERT INTO test (value) VALUES (?)", std::string(500, 'a'));
+                }
+
+                // A rolled back transaction is undone from the journal written behind.
+                sqlite::execute(connection, "BEGIN");
+                sqlite::execute(connection, "UPDATE test SET value = 'b'");
+                sqlite::execute(connection, "DELETE FROM test WHERE id > 50");
+                sqlite::execute(connection, "ROLLBACK");
+
+                REQUIRE(count_rows(connection, "test WHERE value = 'b'") == 0);
+                REQUIRE(count_rows(connection) == 100);
+                REQUIRE(integrity(connection) == "ok");
+            }
+
+            const sqlite::write_behind_stats stats = vfs.stats();
+            REQUIRE(stats.writes > 100);
+            REQUIRE(stats.sync_requests >= 100);
+
+            sqlite::dbconnection plain(filename);
+            REQUIRE(count_rows(plain) == 100);
+        }
+    }
+
+    SECTION("Readers see commits of a writer") {
+        sqlite::dbconnection writer = open_with(filename, vfs.name());
+        sqlite::statement(writer, "PRAGMA journal_mode=WAL").step();
+        sqlite::execute(writer, "CREATE TABLE test (id INTEGER PRIMARY KEY, value TEXT)");
+        sqlite::dbconnection reader = open_with(filename, vfs.name());
+        sqlite::dbconnection plain(filename);
+
+        for (int i = 1; i <= 20; ++i) {
+            sqlite::execute(writer, "INSERT INTO test (value) VALUES ('a')");
+            REQUIRE(count_rows(reader) == i);
+            REQUIRE(count_rows(plain) == i);
+        }
+    }
+}
+
+TEST_CASE("Writers sharing a write-behind VFS", "[WriteBehindVfs]") {
+    const std::string filename = fresh_database("SQLiteXXWriteBehindVfsThreads");
+    sqlite::write_behind_vfs vfs("test-write-behind-threads");
+    const int threads = 4;
+    const int count = 50;
+
+    for (const std::string mode : {"DELETE", "WAL"}) {
+        SECTION("Journal mode " + mode) {
+            {
+                sqlite::dbconnection connection = open_with(filename, vfs.name());
+                sqlite::statement(connection, "PRAGMA journal_mode=" + mode).step();
+                sqlite::execute(connection, "CREATE TABLE test (id INTEGER PRIMARY KEY, value TEXT)");
+            }
+
+            std::vector<std::thread> writers;
+            for (int i = 0; i < threads; ++i) {
+                writers.emplace_back([&, i]() {
+                    sqlite::dbconnection connection = open_with(filename, vfs.name());
+                    sqlite::execute(connection, "PRAGMA synchronous=FULL");
+                    for (int j = 0; j < count; ++j) {
+                        sqlite::execute(connection, "INSERT INTO test (value) VALUES (?)", "thread" + std::to_string(i));
+                    }
+                });
+            }
+            for (std::thread& writer : writers) {
+                writer.join();
+            }
+
+            sqlite::dbconnection connection(filename);
+            REQUIRE(count_rows(connection) == threads * count);
+            for (int i = 0; i < threads; ++i) {
+                REQUIRE(count_rows(connection, "test WHERE value = 'thread" + std::to_string(i) + "'") == count);
+            }
+            REQUIRE(integrity(connection) == "ok");
+        }
+    }
+}
+
+TEST_CASE("Syncs requested while the I/O thread is busy are shared", "[WriteBehindVfs]") {
+    const std::string blocked = fresh_database("SQLiteXXWriteBehindVfsBlocked");
+    const std::string filename = fresh_database("SQLiteXXWriteBehindVfsShared");
+    faulty_vfs slow("test-write-behind-slow");
+    sqlite::write_behind_vfs vfs("test-write-behind-over-slow", slow.name());
+    for (const std::string& database : {blocked, filename}) {
+        sqlite::dbconnection connection = open_with(database, vfs.name());
+        sqlite::execute(connection, "CREATE TABLE test (value TEXT)");
+    }
+
+    // Handles of one WAL, as a committing connection and a checkpointing connection hold them,
+    // and the journal of another database whose slow sync keeps the I/O thread busy.
+    sqlite3_vfs* shim = sqlite3_vfs_find(vfs.name().c_str());
+    const std::string journal = blocked + "-journal";
+    const std::string wal = filename + "-wal";
+    const int flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE;
+    std::vector<std::unique_ptr<char[]>> storage;
+    std::vector<sqlite3_file*> files;
+    for (const auto& opened : {std::make_pair(&journal, SQLITE_OPEN_MAIN_JOURNAL), std::make_pair(&wal, SQLITE_OPEN_WAL),
+                               std::make_pair(&wal, SQLITE_OPEN_WAL)}) {
+        storage.emplace_back(new char[static_cast<std::size_t>(shim->szOsFile)]);
+        files.push_back(reinterpret_cast<sqlite3_file*>(storage.back().get()));
+        REQUIRE(shim->xOpen(shim, opened.first->c_str(), files.back(), flags | opened.second, nullptr) == SQLITE_OK);
+    }
+
+    slow.sync_delay_ms = 300;
+    const sqlite::write_behind_stats before = vfs.stats();
+
+    std::vector<int> results(files.size(), SQLITE_ERROR);
+    std::vector<std::thread> syncing;
+    for (std::size_t i = 0; i < files.size(); ++i) {
+        syncing.emplace_back([&, i]() {
+            results[i] = files[i]->pMethods->xSync(files[i], SQLITE_SYNC_NORMAL);
+        });
+        if (i == 0) {
+            while (slow.delayed_syncs == 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+    }
+    for (std::thread& thread : syncing) {
+        thread.join();
+    }
+    for (sqlite3_file* file : files) {
+        REQUIRE(file->pMethods->xClose(file) == SQLITE_OK);
+    }
+
+    REQUIRE(results == std::vector<int>(files.size(), SQLITE_OK));
+    const sqlite::write_behind_stats after = vfs.stats();
+    REQUIRE(slow.delayed_syncs == 1);
+    REQUIRE(after.sync_requests - before.sync_requests == 3);
+    REQUIRE(after.syncs - before.syncs == 2);
+}
+
+TEST_CASE("Failed writes behind fail the commit", "[WriteBehindVfs]") {
+    const std::string filename = fresh_database("SQLiteXXWriteBehindVfsFaults");
+    faulty_vfs faults("test-write-behind-faults");
+    sqlite::write_behind_vfs vfs("test-write-behind-over-faults", faults.name());
+
+    for (const std::string mode : {"DELETE", "WAL"}) {
+        SECTION("Journal mode " + mode) {
+            sqlite::dbconnection connection = open_with(filename, vfs.name());
+            sqlite::statement(connection, "PRAGMA journal_mode=" + mode).step();
+            // No sync follows the writes of these commits that could report the error.
+            sqlite::execute(connection, mode == "WAL" ? "PRAGMA synchronous=NORMAL" : "PRAGMA synchronous=OFF");
+            sqlite::execute(connection, "CREATE TABLE test (id INTEGER PRIMARY KEY, value TEXT)");
+            sqlite::execute(connection, "INSERT INTO test (value) VALUES ('kept')");
+
+            faults.fail_writes = true;
+            REQUIRE_THROWS_AS(sqlite::execute(connection, "UPDATE test SET value = 'lost'"), sqlite::exception);
+            faults.fail_writes = false;
+
+            REQUIRE(faults.failed_writes > 0);
+            REQUIRE(count_rows(connection, "test WHERE value = 'kept'") == 1);
+            REQUIRE(integrity(connection) == "ok");
+
+            sqlite::execute(connection, "INSERT INTO test (value) VALUES ('after')");
+            REQUIRE(count_rows(connection) == 2);
+        }
+    }
+}